@@ -178,7 +178,8 @@ def makeArmSystem(mem_mode, machine_type, num_cpus=1, mdesc=None,
                   dtb_filename=None, bare_metal=False, cmdline=None,
                   external_memory="", ruby=False, security=False,
                   vio_9p=None, bootloader=None, num_nics=1, num_loadgens=0,
-                  load_generator_type="Simple", **loadgen_kwargs):
+                  load_generator_type="Simple", pcie_link=False,
+                  **loadgen_kwargs):
     assert machine_type
 
     pci_devices = []
@@ -193,13 +194,39 @@ def makeArmSystem(mem_mode, machine_type, num_cpus=1, mdesc=None,
     for i in range(num_nics):
         nics.append(IGbE_e1000(adq_idx=i))
 
+    # A sharded generator drives every NIC from one SimObject, with one
+    # port per NIC, instead of one generator per NIC.
+    sharded = loadgen_kwargs.get('loadgen_sharded', False) and \
+        load_generator_type == "Simple"
+
     for i in range(num_loadgens):
-        if load_generator_type == "Simple":
+        if sharded and loadgens:
+            # Further ports of the shared generator.
+            pass
+        elif load_generator_type == "Simple":
             loadgens.append(LoadGenerator(packet_rate = loadgen_kwargs['packet_rate'],
                                           packet_size = loadgen_kwargs['packet_size'],
                                           start_tick = loadgen_kwargs['loadgen_start'],
                                           stop_tick = loadgen_kwargs['loadgen_stop'],
-                                          mode = loadgen_kwargs['loadgen_mode']))
+                                          mode = loadgen_kwargs['loadgen_mode'],
+                                          arrival = loadgen_kwargs.get('loadgen_arrival', "Fixed"),
+                                          arrival_trace = loadgen_kwargs.get('loadgen_arrival_trace', ""),
+                                          arrival_seed = loadgen_kwargs.get('loadgen_seed', 1) + i,
+                                          closed_loop_outstanding = loadgen_kwargs.get('loadgen_outstanding', 1),
+                                          num_flows = loadgen_kwargs.get('loadgen_flows', 0),
+                                          flow_size_dist = loadgen_kwargs.get('loadgen_flow_size_dist', "Fixed"),
+                                          flow_size = loadgen_kwargs.get('loadgen_flow_size', 1000),
+                                          rss_queues = loadgen_kwargs.get('loadgen_rss_queues', 1),
+                                          search_loss_target = loadgen_kwargs.get('loadgen_loss_target', 0.001),
+                                          search_p99_slo = loadgen_kwargs.get('loadgen_p99_slo', 0),
+                                          send_window = loadgen_kwargs.get('loadgen_send_window', '0ns'),
+                                          app = loadgen_kwargs.get('loadgen_app', "Raw"),
+                                          memcached_protocol = loadgen_kwargs.get('loadgen_memcached_protocol', "Binary"),
+                                          memcached_keyspace = loadgen_kwargs.get('loadgen_memcached_keyspace', 2000),
+                                          memcached_populated = loadgen_kwargs.get('loadgen_memcached_keyspace', 2000) // 2,
+                                          memcached_key_size = loadgen_kwargs.get('loadgen_memcached_key_size', "10-100-0.9"),
+                                          memcached_value_size = loadgen_kwargs.get('loadgen_memcached_value_size', "100-1000-0.9"),
+                                          memcached_get_ratio = loadgen_kwargs.get('loadgen_memcached_get_ratio', 0.9)))
         elif load_generator_type == "Pcap":
             loadgens.append(LoadGeneratorPcap(pcap_filename = loadgen_kwargs['loadgen_pcap_filename'],
                                               stack_mode = loadgen_kwargs['loadgen_stack_mode'],
@@ -208,12 +235,15 @@ def makeArmSystem(mem_mode, machine_type, num_cpus=1, mdesc=None,
                                               replay_mode = loadgen_kwargs['loadgen_replay_mode'],
                                               packet_rate = loadgen_kwargs['loadgen_packet_rate'],
                                               increment_interval = loadgen_kwargs['loadgen_increment_interval'],
-                                              port_filter = loadgen_kwargs['loadgen_port_filter']))
+                                              port_filter = loadgen_kwargs['loadgen_port_filter'],
+                                              pcap_index = loadgen_kwargs.get('loadgen_pcap_index', False),
+                                              loop_trace = loadgen_kwargs.get('loadgen_loop_trace', False),
+                                              match_mode = loadgen_kwargs.get('loadgen_match_mode', 'Fifo')))
         else:
             fatal("Unknown type of the load generator")
         links.append(EtherLink(speed = '1000Gbps'))
         links[i].int0 = nics[i].interface
-        links[i].int1 = loadgens[i].interface
+        links[i].int1 = loadgens[0 if sharded else i].interface
     
     self.nics = nics
 
@@ -374,6 +404,14 @@ def makeArmSystem(mem_mode, machine_type, num_cpus=1, mdesc=None,
             dev, self.iobus,
             dma_ports=self._dma_ports if ruby else None)
 
+    if pcie_link:
+        # Put a PCIe link in front of the DMA port of the NICs and the IDE
+        # controller
+        ide = getattr(self.realview, "ide", getattr(self, "pci_ide", None))
+        for dev in nics + ([ide] if ide else []):
+            dev.pcie_link = PcieLink()
+            dev.pcie_link.insert(dev, self._dma_ports if ruby else None)
+
     self.terminal = Terminal()
     self.vncserver = VncServer()
 
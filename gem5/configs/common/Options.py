@@ -105,6 +105,9 @@ class ListPlatform(argparse.Action):
 def addNoISAOptions(parser):
     parser.add_argument("--perf-io", type=str, default="False")
     parser.add_argument("--num-nics", type=int, default=1)
+    parser.add_argument("--pcie-link", action="store_true",
+                        help="Put a PCIe link in front of the DMA port of "
+                        "the NICs and the IDE controller")
     # For all loadgens:
     parser.add_argument("--num-loadgens", type=int, default=0)
     parser.add_argument("--loadgen-type", type=str, default="Simple")
@@ -114,12 +117,52 @@ def addNoISAOptions(parser):
     # For Simple loadgen:
     parser.add_argument("--loadgen-mode", type=str, default="Static")
     parser.add_argument("--packet-size", type=int, default=128)
+    parser.add_argument("--loadgen-arrival", type=str, default="Fixed",
+                        help="Fixed/Poisson/MMPP/Trace/ClosedLoop")
+    parser.add_argument("--loadgen-arrival-trace", type=str, default="")
+    parser.add_argument("--loadgen-seed", type=int, default=1)
+    parser.add_argument("--loadgen-outstanding", type=int, default=1)
+    parser.add_argument("--loadgen-flows", type=int, default=0,
+                        help="Concurrent UDP flows per load generator")
+    parser.add_argument("--loadgen-flow-size-dist", type=str, default="Fixed",
+                        help="Fixed/Exponential/Pareto")
+    parser.add_argument("--loadgen-flow-size", type=int, default=1000)
+    parser.add_argument("--loadgen-rss-queues", type=int, default=1)
+    parser.add_argument("--loadgen-loss-target", type=float, default=0.001,
+                        help="Search mode: acceptable fraction of lost packets")
+    parser.add_argument("--loadgen-p99-slo", type=int, default=0,
+                        help="Search mode: p99 latency SLO in ticks, 0 disables")
+    parser.add_argument("--loadgen-sharded", action="store_true",
+                        help="Drive all NICs from a single load generator")
+    parser.add_argument("--loadgen-send-window", type=str, default="0ns",
+                        help="Batch sends due within this window into one event")
+    parser.add_argument("--loadgen-app", type=str, default="Raw",
+                        choices=["Raw", "Memcached"],
+                        help="Send raw frames or synthesised memcached requests")
+    parser.add_argument("--loadgen-memcached-protocol", type=str,
+                        default="Binary", choices=["Binary", "Ascii"])
+    parser.add_argument("--loadgen-memcached-keyspace", type=int, default=2000)
+    parser.add_argument("--loadgen-memcached-key-size", type=str,
+                        default="10-100-0.9",
+                        help="Key size distribution, <min-max-skew>")
+    parser.add_argument("--loadgen-memcached-value-size", type=str,
+                        default="100-1000-0.9",
+                        help="Value size distribution, <min-max-skew>")
+    parser.add_argument("--loadgen-memcached-get-ratio", type=float,
+                        default=0.9)
     # For Pcap loadgen:
     parser.add_argument("--loadgen-stack", type=str, default="KernelStack")
     parser.add_argument("--loadgen_pcap_filename", type=str, default="")
     parser.add_argument("--loadgen-replymode", type=str, default="ReplyAndAdjustThroughput")
     parser.add_argument("--loadgen-port-filter", type=int, default=1)
     parser.add_argument("--loadgen-increment-interval", type=int, default=1)
+    parser.add_argument("--loadgen-pcap-index", action="store_true",
+                        help="Replay from a pre-filtered pcap index")
+    parser.add_argument("--loadgen-loop-trace", action="store_true",
+                        help="Restart the pcap trace when it runs out")
+    parser.add_argument("--loadgen-match-mode", type=str, default="Fifo",
+                        choices=["Fifo", "RequestId"],
+                        help="How pcap responses are matched to requests")
 
     parser.add_argument("-n", "--num-cpus", type=int, default=1)
     parser.add_argument("--sys-voltage", action="store", type=str,
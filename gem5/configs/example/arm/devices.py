@@ -445,8 +445,11 @@ class SimpleSystem(BaseSimpleSystem):
         self.realview.attachIO(self.iobus)
         self.system_port = self.membus.cpu_side_ports
 
-    def attach_pci(self, dev):
+    def attach_pci(self, dev, pcie_link=False):
         self.realview.attachPciDevice(dev, self.iobus)
+        if pcie_link:
+            dev.pcie_link = PcieLink()
+            dev.pcie_link.insert(dev)
 
 def idioSystem(BaseSystem, caches, mem_size, num_cores, idio, send_prefetch_hint, send_header_only, platform=None, **kwargs):
     """
@@ -497,8 +500,11 @@ def idioSystem(BaseSystem, caches, mem_size, num_cores, idio, send_prefetch_hint
             self._clusters = []
             self._num_cpus = 0
 
-        def attach_pci(self, dev):
+        def attach_pci(self, dev, pcie_link=False):
             self.realview.attachPciDevice(dev, self.iobus)
+            if pcie_link:
+                dev.pcie_link = PcieLink()
+                dev.pcie_link.insert(dev)
 
         def connect(self):
             self.iobridge.mem_side_port = self.iobus.cpu_side_ports
@@ -569,32 +575,35 @@ def idioSystem(BaseSystem, caches, mem_size, num_cores, idio, send_prefetch_hint
             for cluster in self._clusters:
                 cluster.connectMemSide(cluster_mem_bus)
 
+            # The steering registers sit in 0x1c180000-0x1c18ffff, the free
+            # slot after the RTC in the CS3 peripheral block, which the I/O
+            # bridge routes to the I/O bus
+            ddio_pio_addr = 0x1c180000
+
             if idio:
                 self.ddio_xbar = DdioBridge(do_not_pass_to_mlc = 0,
                                                 snoop_via_memside = 0,
                                                 normal_DMA_mode = 0,
-                                                ddio_option_app0 = 0,
-                                                ddio_option_app1 = 0,
-                                                ddio_option_app2 = 0,
-                                                ddio_option_app3 = 0,
                                                 dynamic_ddio = 0,
-                                                window_size = 0,
-                                                threshhold_otf = 0,
-                                                threshhold_gradchange = 0,
-                                                threshhold_abs = 0,
                                                 mlc_share = 0,
                                                 send_prefetch_hint = send_prefetch_hint,
-                                                send_header_only = send_header_only)
+                                                send_header_only = send_header_only,
+                                                pio_addr = ddio_pio_addr)
+                self.ddio_xbar.pio = self.iobus.mem_side_ports
 
                 self.iocache.mem_side = self.ddio_xbar.cpuside
                 self.ddio_xbar.llcside = self.toL3Bus.slave
                 self.ddio_xbar.memside = self.membus.slave
 
-                #test_sys.l3.otfport = test_sys.ddio_xbar.otfport
+                self.l3.ddio_bridge = self.ddio_xbar
 
                 #if options.share_l2 == 0: self._clusters
                 for i in range(0, num_cores):
                     self.ddio_xbar.mlcside = self.cpus[i].toL2Bus.slave
+                    # The L2 reports as the MLC of its mlcside port
+                    self.cpus[i].l2cache.ddio_bridge = self.ddio_xbar
+                    self.cpus[i].l2cache.is_mlc = True
+                    self.cpus[i].l2cache.mlc_idx = i
                     #test_sys.cpu[i].l2cache.otfport = test_sys.ddio_xbar.otfport
                 #else:
                 #    for i in range(0, options.num_cpus / 2):
@@ -605,28 +614,26 @@ def idioSystem(BaseSystem, caches, mem_size, num_cores, idio, send_prefetch_hint
                 self.ddio_xbar = DdioBridge(do_not_pass_to_mlc = 1,
                                                 snoop_via_memside = 0,
                                                 normal_DMA_mode = 0,
-                                                ddio_option_app0 = 0,
-                                                ddio_option_app1 = 0,
-                                                ddio_option_app2 = 0,
-                                                ddio_option_app3 = 0,
                                                 dynamic_ddio = 0,
-                                                window_size = 0,
-                                                threshhold_otf = 0,
-                                                threshhold_gradchange = 0,
-                                                threshhold_abs = 0,
                                                 mlc_share = 0,
                                                 send_prefetch_hint = send_prefetch_hint,
-                                                send_header_only = send_header_only)
+                                                send_header_only = send_header_only,
+                                                pio_addr = ddio_pio_addr)
+                self.ddio_xbar.pio = self.iobus.mem_side_ports
 
                 self.iocache.mem_side = self.ddio_xbar.cpuside
-                self.ddio_xbar.llcside = self.toL3bus.slave
+                self.ddio_xbar.llcside = self.toL3Bus.slave
                 self.ddio_xbar.memside = self.membus.slave
 
-                #test_sys.l3.otfport = test_sys.ddio_xbar.otfport
+                self.l3.ddio_bridge = self.ddio_xbar
 
                 #if options.share_l2 == 0:
                 for i in range(0, num_cores):
                     self.ddio_xbar.mlcside = self.cpus[i].toL2Bus.slave
+                    # The L2 reports as the MLC of its mlcside port
+                    self.cpus[i].l2cache.ddio_bridge = self.ddio_xbar
+                    self.cpus[i].l2cache.is_mlc = True
+                    self.cpus[i].l2cache.mlc_idx = i
                     #test_sys.cpu[i].l2cache.otfport = test_sys.ddio_xbar.otfport
                 #else:
                 #    for i in range(0, options.num_cpus / 2):
@@ -656,6 +663,9 @@ class ArmRubySystem(BaseSimpleSystem):
             for i, cpu in enumerate(cluster.cpus):
                 self.ruby._cpu_ports[i].connectCpuPorts(cpu)
 
-    def attach_pci(self, dev):
+    def attach_pci(self, dev, pcie_link=False):
         self.realview.attachPciDevice(dev, self.iobus,
             dma_ports=self._dma_ports)
+        if pcie_link:
+            dev.pcie_link = PcieLink()
+            dev.pcie_link.insert(dev, self._dma_ports)
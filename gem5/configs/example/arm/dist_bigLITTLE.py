@@ -88,6 +88,9 @@ def addOptions(parser):
     parser.add_argument("--etherdump", action="store", type=str, default="",
                         help="Specify the filename to dump a pcap capture of"\
                         " the ethernet traffic")
+    parser.add_argument("--pcie-link", action="store_true",
+                        help="Put a PCIe link in front of the DMA port of "
+                        "the NIC")
     # Used by util/dist/gem5-dist.sh
     parser.add_argument("--checkpoint-dir", type=str,
                         default=m5.options.outdir,
@@ -97,7 +100,7 @@ def addOptions(parser):
 def addEthernet(system, options):
     # create NIC
     dev = IGbE_e1000()
-    system.attach_pci(dev)
+    system.attach_pci(dev, pcie_link=options.pcie_link)
     system.ethernet = dev
 
     # create distributed ethernet link
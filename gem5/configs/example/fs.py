@@ -102,6 +102,7 @@ def build_test_system(np):
                 vio_9p=args.vio_9p,
                 bootloader=args.bootloader,
                 num_nics=args.num_nics,
+                pcie_link=args.pcie_link,
                 # Loadgens.
                 num_loadgens=args.num_loadgens,
                 load_generator_type="Simple",
@@ -109,7 +110,25 @@ def build_test_system(np):
                 loadgen_stop=args.loadgen_stop,
                 packet_rate=args.packet_rate,
                 packet_size=args.packet_size,
-                loadgen_mode=args.loadgen_mode
+                loadgen_mode=args.loadgen_mode,
+                loadgen_arrival=args.loadgen_arrival,
+                loadgen_arrival_trace=args.loadgen_arrival_trace,
+                loadgen_seed=args.loadgen_seed,
+                loadgen_outstanding=args.loadgen_outstanding,
+                loadgen_flows=args.loadgen_flows,
+                loadgen_flow_size_dist=args.loadgen_flow_size_dist,
+                loadgen_flow_size=args.loadgen_flow_size,
+                loadgen_rss_queues=args.loadgen_rss_queues,
+                loadgen_loss_target=args.loadgen_loss_target,
+                loadgen_p99_slo=args.loadgen_p99_slo,
+                loadgen_sharded=args.loadgen_sharded,
+                loadgen_send_window=args.loadgen_send_window,
+                loadgen_app=args.loadgen_app,
+                loadgen_memcached_protocol=args.loadgen_memcached_protocol,
+                loadgen_memcached_keyspace=args.loadgen_memcached_keyspace,
+                loadgen_memcached_key_size=args.loadgen_memcached_key_size,
+                loadgen_memcached_value_size=args.loadgen_memcached_value_size,
+                loadgen_memcached_get_ratio=args.loadgen_memcached_get_ratio
             )
         elif args.loadgen_type == "Pcap":
             test_sys = makeArmSystem(
@@ -126,6 +145,7 @@ def build_test_system(np):
                 vio_9p=args.vio_9p,
                 bootloader=args.bootloader,
                 num_nics=args.num_nics,
+                pcie_link=args.pcie_link,
                 # Loadgens.
                 num_loadgens=args.num_loadgens,
                 loadgen_stack_mode=args.loadgen_stack,
@@ -136,7 +156,10 @@ def build_test_system(np):
                 loadgen_replay_mode=args.loadgen_replymode,
                 loadgen_packet_rate=args.packet_rate,
                 loadgen_increment_interval=args.loadgen_increment_interval,
-                loadgen_port_filter=args.loadgen_port_filter
+                loadgen_port_filter=args.loadgen_port_filter,
+                loadgen_pcap_index=args.loadgen_pcap_index,
+                loadgen_loop_trace=args.loadgen_loop_trace,
+                loadgen_match_mode=args.loadgen_match_mode
             )
         else:
             fatal("Unknown type of the load generator")
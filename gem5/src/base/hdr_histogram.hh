@@ -0,0 +1,133 @@
+#ifndef __BASE_HDR_HISTOGRAM_HH__
+#define __BASE_HDR_HISTOGRAM_HH__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "base/bitfield.hh"
+#include "base/logging.hh"
+
+namespace gem5
+{
+
+/**
+ * Log-linear histogram in the spirit of HdrHistogram. Values below
+ * 2^precision are recorded exactly; larger values fall into buckets
+ * whose width is a power of two, with 2^(precision - 1) linear
+ * sub-buckets per power of two. The relative error of any reported
+ * value is therefore bounded by 2^-(precision - 1), independently of
+ * the magnitude, and the whole 64-bit range is covered with a fixed
+ * amount of memory.
+ */
+class HdrHistogram
+{
+  private:
+    unsigned precision;
+    uint64_t subBuckets;
+    uint64_t halfSubBuckets;
+
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t minValue;
+    uint64_t maxValue;
+    double sum;
+
+    size_t
+    index(uint64_t value) const
+    {
+        if (value < subBuckets)
+            return value;
+        const unsigned shift = findMsbSet(value) - (precision - 1);
+        const uint64_t mantissa = value >> shift;
+        return subBuckets + (shift - 1) * halfSubBuckets +
+            (mantissa - halfSubBuckets);
+    }
+
+    /** Largest value that maps to the same bucket as idx. */
+    uint64_t
+    highestEquivalent(size_t idx) const
+    {
+        if (idx < subBuckets)
+            return idx;
+        const uint64_t rel = idx - subBuckets;
+        const unsigned shift = rel / halfSubBuckets + 1;
+        const uint64_t mantissa = rel % halfSubBuckets + halfSubBuckets;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+  public:
+    /**
+     * @param _precision Number of significant bits kept per value,
+     *        between 2 and 16.
+     */
+    HdrHistogram(unsigned _precision = 8)
+    {
+        init(_precision);
+    }
+
+    void
+    init(unsigned _precision)
+    {
+        fatal_if(_precision < 2 || _precision > 16,
+                 "HdrHistogram precision must be between 2 and 16 bits");
+        precision = _precision;
+        subBuckets = 1ULL << precision;
+        halfSubBuckets = subBuckets >> 1;
+        counts.assign(subBuckets + (64 - precision) * halfSubBuckets, 0);
+        reset();
+    }
+
+    void
+    reset()
+    {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+        minValue = std::numeric_limits<uint64_t>::max();
+        maxValue = 0;
+        sum = 0;
+    }
+
+    void
+    sample(uint64_t value, uint64_t count = 1)
+    {
+        counts[index(value)] += count;
+        total += count;
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+        sum += double(value) * count;
+    }
+
+    uint64_t size() const { return total; }
+    uint64_t min() const { return total ? minValue : 0; }
+    uint64_t max() const { return maxValue; }
+    double mean() const { return total ? sum / total : 0; }
+
+    /**
+     * Value below or at which the given fraction of the samples fall.
+     * The result is the upper end of the matching bucket, clamped to
+     * the largest recorded value.
+     * @param q Quantile in [0, 1], e.g. 0.99 for p99.
+     */
+    uint64_t
+    percentile(double q) const
+    {
+        if (total == 0)
+            return 0;
+        q = std::min(std::max(q, 0.0), 1.0);
+        uint64_t rank = std::max<uint64_t>(1, std::ceil(q * total));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen >= rank)
+                return std::min(highestEquivalent(i), maxValue);
+        }
+        return maxValue;
+    }
+};
+
+} // namespace gem5
+
+#endif // __BASE_HDR_HISTOGRAM_HH__
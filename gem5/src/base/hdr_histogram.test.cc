@@ -0,0 +1,89 @@
+#include <gtest/gtest-spi.h>
+#include <gtest/gtest.h>
+
+#include "base/gtest/logging.hh"
+#include "base/hdr_histogram.hh"
+
+using namespace gem5;
+
+/** An empty histogram reports zero for every query. */
+TEST(HdrHistogramTest, Empty)
+{
+    HdrHistogram hist;
+    ASSERT_EQ(hist.size(), 0);
+    ASSERT_EQ(hist.min(), 0);
+    ASSERT_EQ(hist.max(), 0);
+    ASSERT_EQ(hist.percentile(0.99), 0);
+}
+
+/** Values below 2^precision are recorded exactly. */
+TEST(HdrHistogramTest, ExactSmallValues)
+{
+    HdrHistogram hist(8);
+    for (uint64_t v = 1; v <= 100; v++)
+        hist.sample(v);
+
+    ASSERT_EQ(hist.size(), 100);
+    ASSERT_EQ(hist.min(), 1);
+    ASSERT_EQ(hist.max(), 100);
+    ASSERT_EQ(hist.percentile(0.5), 50);
+    ASSERT_EQ(hist.percentile(0.9), 90);
+    ASSERT_EQ(hist.percentile(0.99), 99);
+    ASSERT_EQ(hist.percentile(1.0), 100);
+    ASSERT_DOUBLE_EQ(hist.mean(), 50.5);
+}
+
+/** Large values stay within the relative error bound. */
+TEST(HdrHistogramTest, BoundedRelativeError)
+{
+    const unsigned precision = 8;
+    HdrHistogram hist(precision);
+    const double bound = 1.0 / (1 << (precision - 1));
+
+    for (uint64_t v = 1000; v < (1ULL << 62); v = v * 3 + 7) {
+        hist.reset();
+        hist.sample(v);
+        hist.sample(v + 1);
+        uint64_t p = hist.percentile(0.5);
+        ASSERT_GE(p, v);
+        ASSERT_LE(double(p - v) / v, bound);
+    }
+}
+
+/** The tail is resolved even when it is a tiny fraction of samples. */
+TEST(HdrHistogramTest, Tail)
+{
+    HdrHistogram hist;
+    hist.sample(1000000, 9999);
+    hist.sample(50000000, 1);
+
+    ASSERT_LE(hist.percentile(0.99), 1000000 * 1.01);
+    ASSERT_EQ(hist.percentile(0.9999), hist.percentile(0.99));
+    ASSERT_EQ(hist.percentile(1.0), 50000000);
+}
+
+/** The full 64-bit range can be recorded. */
+TEST(HdrHistogramTest, MaxValue)
+{
+    HdrHistogram hist;
+    hist.sample(std::numeric_limits<uint64_t>::max());
+    ASSERT_EQ(hist.percentile(1.0), std::numeric_limits<uint64_t>::max());
+}
+
+TEST(HdrHistogramTest, Reset)
+{
+    HdrHistogram hist;
+    hist.sample(42, 10);
+    hist.reset();
+    ASSERT_EQ(hist.size(), 0);
+    ASSERT_EQ(hist.percentile(0.5), 0);
+}
+
+/** Precision outside the supported range is rejected. */
+TEST(HdrHistogramDeathTest, BadPrecision)
+{
+    gtestLogOutput.str("");
+    EXPECT_ANY_THROW(HdrHistogram hist(1));
+    ASSERT_NE(gtestLogOutput.str().find("precision must be between"),
+        std::string::npos);
+}
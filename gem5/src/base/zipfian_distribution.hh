@@ -0,0 +1,83 @@
+#ifndef __BASE_ZIPFIAN_DISTRIBUTION_HH__
+#define __BASE_ZIPFIAN_DISTRIBUTION_HH__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "base/logging.hh"
+
+namespace gem5
+{
+
+/**
+ * Zipfian distributed integers in [a, b], following Gray et al., "Quickly
+ * Generating Billion-Record Synthetic Databases" as popularised by YCSB.
+ * This is the same generator as the zipfian_int_distribution used by the
+ * memcached client, so workloads synthesised in the simulator match the
+ * recorded ones. Smaller values are more likely; theta sets the skew,
+ * from uniform-like at 0 towards 1.
+ */
+class ZipfianDistribution
+{
+  private:
+    uint64_t a;
+    uint64_t b;
+    double theta;
+    double zetaN;
+    double alpha;
+    double eta;
+
+    static double
+    zeta(uint64_t n, double theta)
+    {
+        double sum = 0;
+        for (uint64_t i = 1; i <= n; i++)
+            sum += std::pow(1.0 / i, theta);
+        return sum;
+    }
+
+  public:
+    /**
+     * @param _a Smallest value.
+     * @param _b Largest value, at least _a.
+     * @param _theta Skew in [0, 1).
+     */
+    ZipfianDistribution(uint64_t _a, uint64_t _b, double _theta)
+        : a(_a), b(_b), theta(_theta)
+    {
+        fatal_if(b < a, "Zipfian range [%d, %d] is empty", a, b);
+        fatal_if(theta < 0 || theta >= 1,
+                 "Zipfian skew must be in [0, 1), got %f", theta);
+        const uint64_t n = b - a + 1;
+        zetaN = zeta(n, theta);
+        alpha = 1 / (1 - theta);
+        eta = n > 2 ?
+            (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta(2, theta) / zetaN) :
+            0;
+    }
+
+    uint64_t min() const { return a; }
+    uint64_t max() const { return b; }
+
+    template <typename URNG>
+    uint64_t
+    operator()(URNG &gen)
+    {
+        std::uniform_real_distribution<double> dist(0, 1);
+        const double u = dist(gen);
+        const double uz = u * zetaN;
+        if (uz < 1.0)
+            return a;
+        if (uz < 1.0 + std::pow(0.5, theta))
+            return a + 1;
+        const uint64_t n = b - a + 1;
+        return std::min<uint64_t>(b,
+                a + uint64_t(n * std::pow(eta * u - eta + 1, alpha)));
+    }
+};
+
+} // namespace gem5
+
+#endif // __BASE_ZIPFIAN_DISTRIBUTION_HH__
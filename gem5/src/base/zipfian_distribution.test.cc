@@ -0,0 +1,77 @@
+#include <gtest/gtest-spi.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "base/gtest/logging.hh"
+#include "base/zipfian_distribution.hh"
+
+using namespace gem5;
+
+/** Every sample falls inside the configured range. */
+TEST(ZipfianDistributionTest, Range)
+{
+    std::mt19937_64 gen(1);
+    ZipfianDistribution dist(10, 100, 0.9);
+    for (int i = 0; i < 100000; i++) {
+        uint64_t v = dist(gen);
+        ASSERT_GE(v, 10);
+        ASSERT_LE(v, 100);
+    }
+}
+
+/** A single-value range always returns that value. */
+TEST(ZipfianDistributionTest, SingleValue)
+{
+    std::mt19937_64 gen(1);
+    ZipfianDistribution dist(42, 42, 0.5);
+    for (int i = 0; i < 100; i++)
+        ASSERT_EQ(dist(gen), 42);
+}
+
+/** The smallest value has probability 1 / zeta(n, theta). */
+TEST(ZipfianDistributionTest, HeadProbability)
+{
+    std::mt19937_64 gen(7);
+    const uint64_t n = 1000;
+    const double theta = 0.9;
+    ZipfianDistribution dist(1, n, theta);
+
+    double zeta = 0;
+    for (uint64_t i = 1; i <= n; i++)
+        zeta += std::pow(1.0 / i, theta);
+
+    const int samples = 200000;
+    int head = 0;
+    for (int i = 0; i < samples; i++)
+        head += dist(gen) == 1;
+    ASSERT_NEAR(double(head) / samples, 1 / zeta, 0.005);
+}
+
+/** Higher skew concentrates more samples on the small values. */
+TEST(ZipfianDistributionTest, Skew)
+{
+    std::mt19937_64 gen(3);
+    ZipfianDistribution low(0, 999, 0.1);
+    ZipfianDistribution high(0, 999, 0.99);
+
+    const int samples = 100000;
+    double low_sum = 0, high_sum = 0;
+    for (int i = 0; i < samples; i++) {
+        low_sum += low(gen);
+        high_sum += high(gen);
+    }
+    ASSERT_LT(high_sum, low_sum / 2);
+    // Close to uniform for a small skew.
+    ASSERT_NEAR(low_sum / samples, 500, 100);
+}
+
+/** Skew outside [0, 1) is rejected. */
+TEST(ZipfianDistributionDeathTest, BadSkew)
+{
+    gtestLogOutput.str("");
+    EXPECT_ANY_THROW(ZipfianDistribution dist(1, 10, 1.0));
+    ASSERT_NE(gtestLogOutput.str().find("Zipfian skew must be in"),
+        std::string::npos);
+}
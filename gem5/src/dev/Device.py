@@ -96,6 +96,11 @@ class DmaDevice(PioDevice):
         "Substream identifier used by an IOMMU to distinguish amongst "
         "several devices attached to it")
 
+    dma_max_outstanding = Param.Unsigned(0, "Most DMA packets in flight, "
+        "0 for no limit")
+    dma_write_combine = Param.Bool(True, "Issue adjacent buffers of a "
+        "scatter-gather DMA write as one request")
+
     def addIommuProperty(self, state, node):
         """
         This method takes an FdtState and a FdtNode as parameters, and
@@ -50,6 +50,7 @@
 #include "debug/DMA.hh"
 #include "debug/Drain.hh"
 #include "sim/clocked_object.hh"
+#include "sim/stats.hh"
 #include "sim/system.hh"
 
 // SHIN. debug
@@ -59,12 +60,41 @@
 namespace gem5
 {
 
+DmaStats::DmaStats(statistics::Group *parent)
+    : statistics::Group(parent, "dma"),
+      ADD_STAT(readBytes, statistics::units::Byte::get(),
+               "Number of bytes read by DMA"),
+      ADD_STAT(writeBytes, statistics::units::Byte::get(),
+               "Number of bytes written by DMA"),
+      ADD_STAT(readBandwidth, statistics::units::Rate<
+                    statistics::units::Byte, statistics::units::Second>::get(),
+               "DMA read bandwidth", readBytes / simSeconds),
+      ADD_STAT(writeBandwidth, statistics::units::Rate<
+                    statistics::units::Byte, statistics::units::Second>::get(),
+               "DMA write bandwidth", writeBytes / simSeconds),
+      ADD_STAT(latency, statistics::units::Tick::get(),
+               "Time from queueing a DMA request to its last response"),
+      ADD_STAT(windowStalls, statistics::units::Count::get(),
+               "Number of times sending waited for the outstanding "
+               "request window"),
+      ADD_STAT(sgTransfers, statistics::units::Count::get(),
+               "Number of scatter-gather transfers"),
+      ADD_STAT(combinedSegments, statistics::units::Count::get(),
+               "Number of scatter-gather segments combined into the "
+               "request of the previous segment")
+{
+    latency.init(16);
+}
+
 DmaPort::DmaPort(ClockedObject *dev, System *s,
-                 uint32_t sid, uint32_t ssid)
+                 uint32_t sid, uint32_t ssid, unsigned max_outstanding,
+                 bool write_combine, DmaStats *stats)
     : RequestPort(dev->name() + ".dma", dev),
       device(dev), sys(s), requestorId(s->getRequestorId(dev)),
       sendEvent([this]{ sendDma(); }, dev->name()),
-      defaultSid(sid), defaultSSid(ssid), cacheLineSize(s->cacheLineSize())
+      defaultSid(sid), defaultSSid(ssid), cacheLineSize(s->cacheLineSize()),
+      window(max_outstanding), writeCombine(write_combine),
+      stats(stats)
 { }
 
 void
@@ -97,14 +127,32 @@ DmaPort::handleResp(DmaReqState *state, Addr addr, Addr size, Tick delay)
     state->numBytes += size;
     assert(state->totBytes >= state->numBytes);
 
+    if (stats) {
+        if (MemCmd(state->cmd).isRead())
+            stats->readBytes += size;
+        else
+            stats->writeBytes += size;
+    }
+
     // If we have reached the total number of bytes for this DMA request,
     // then signal the completion and delete the sate.
     if (state->totBytes == state->numBytes) {
         assert(pendingCount != 0);
         pendingCount--;
-        if (state->completionEvent) {
-            delay += state->delay;
-            device->schedule(state->completionEvent, curTick() + delay);
+        if (stats)
+            stats->latency.sample(curTick() + delay - state->issued);
+
+        Event *event = state->completionEvent;
+        Tick event_delay = state->delay;
+        // A scatter-gather transfer completes with its last request
+        if (state->sg && state->sg->requestDone()) {
+            event = state->sg->completionEvent;
+            event_delay = state->sg->delay;
+            delete state->sg;
+        }
+        if (event) {
+            delay += event_delay;
+            device->schedule(event, curTick() + delay);
         }
         delete state;
     }
@@ -128,12 +176,18 @@ DmaPort::DmaReqState::createPacket()
     if(is_ddio_req)
     {
         pkt->setDdioPrefetchId(adq_idx);
-        pkt->setDdioPrefetchDestination(adq_idx);
         pkt->setDdioPkt();
 
-        if(adq_idx > -1)
-            pkt->setPrefetchHintPkt();
-        if(gen.isHead())
+        if (ddioFlag.bypassLlc) {
+            pkt->setDdioPrefetchDestination(Packet::DdioMemoryDestination);
+        } else if (ddioFlag.bypassMlc) {
+            pkt->setDdioPrefetchDestination(-1);
+        } else {
+            pkt->setDdioPrefetchDestination(adq_idx);
+            if(adq_idx > -1)
+                pkt->setPrefetchHintPkt();
+        }
+        if(ddioFlag.segmented ? ddioFlag.header : gen.isHead())
         {
             pkt->setDdioHeader();
             //DPRINTF(AdaptiveDdioOtf, "Allow MLC DDIO for mlc %d, pkt %s\n", qnum, pkt->print());
@@ -158,11 +212,20 @@ DmaPort::recvTimingResp(PacketPtr pkt)
 
     handleRespPacket(pkt);
 
+    // Carry on sending if the window was holding us back
+    const bool window_full = window.received();
+    if (window_full && !transmitList.empty() && !inRetry &&
+        !sendEvent.scheduled()) {
+        device->schedule(sendEvent, device->clockEdge());
+    }
+
     return true;
 }
 
 DmaDevice::DmaDevice(const Params &p)
-    : PioDevice(p), dmaPort(this, sys, p.sid, p.ssid)
+    : PioDevice(p), dmaStats(this),
+      dmaPort(this, sys, p.sid, p.ssid, p.dma_max_outstanding,
+              p.dma_write_combine, &dmaStats)
 { }
 
 void
@@ -223,7 +286,8 @@ DmaPort::ddioActionAdq(Packet::Command cmd, Addr addr, int size, Event *event,
     // i.e. cache line size.
     transmitList.push_back(
             new DmaReqState(cmd, addr, cacheLineSize, size,
-                data, flag, requestorId, sid, ssid, event, delay, is_ddio, qnum));
+                data, flag, requestorId, sid, ssid, event, delay, is_ddio, qnum,
+                structDdioFlag));
     pendingCount++;
 
     // In zero time, also initiate the sending of the packets for the request
@@ -232,6 +296,52 @@ DmaPort::ddioActionAdq(Packet::Command cmd, Addr addr, int size, Event *event,
     sendDma();
 }
 
+void
+DmaPort::dmaActionSg(Packet::Command cmd, const std::vector<DmaSegment> &segs,
+                     Event *event, Tick delay, Request::Flags flag,
+                     bool is_ddio, int qnum)
+{
+    DPRINTF(DMA, "Starting scatter-gather DMA of %d segments\n", segs.size());
+    assert(!segs.empty());
+
+    // Queue every request before sending any, in atomic mode the first
+    // one would otherwise complete the transfer on its own
+    std::vector<DmaReqState *> states;
+    auto *sg = new DmaSgState{event, delay};
+    const bool combine = writeCombine && MemCmd(cmd).isWrite();
+    for (const auto &run : dmaSgRuns(segs, combine)) {
+        const DmaSegment &seg = segs[run.first];
+        uint8_t *data = seg.data;
+        std::unique_ptr<uint8_t[]> combined;
+        if (run.end - run.first > 1) {
+            combined.reset(new uint8_t[run.size]);
+            data = combined.get();
+            for (size_t j = run.first; j < run.end; j++) {
+                std::memcpy(data, segs[j].data, segs[j].size);
+                data += segs[j].size;
+            }
+            data = combined.get();
+            if (stats)
+                stats->combinedSegments += run.end - run.first - 1;
+        }
+
+        auto *state = new DmaReqState(cmd, seg.addr, cacheLineSize, run.size,
+                data, flag, requestorId, defaultSid, defaultSSid, nullptr, 0,
+                is_ddio, qnum, seg.ddioFlag);
+        state->combined = std::move(combined);
+        state->sg = sg;
+        sg->pending++;
+        states.push_back(state);
+    }
+
+    if (stats)
+        stats->sgTransfers++;
+
+    transmitList.insert(transmitList.end(), states.begin(), states.end());
+    pendingCount += states.size();
+    sendDma();
+}
+
 void
 DmaPort::ddioActionAdq(Packet::Command cmd, Addr addr, int size, Event *event,
                    uint8_t *data, Tick delay, AdaptiveDdioFlag structDdioFlag, 
@@ -290,6 +400,7 @@ DmaPort::trySendTimingReq()
     if (!sendTimingReq(pkt))
         inRetry = pkt;
     if (!inRetry) {
+        window.sent();
         // If that was the last packet from this request, pop it from the list.
         if (last)
             transmitList.pop_front();
@@ -412,6 +523,15 @@ DmaPort::sendDma()
             return;
         }
 
+        // The next packet goes out with the response that frees a slot
+        if (window.full()) {
+            DPRINTF(DMA, "%d packets outstanding, waiting for a response\n",
+                    window.outstanding());
+            if (stats)
+                stats->windowStalls++;
+            return;
+        }
+
         trySendTimingReq();
     } else if (sys->isAtomicMode()) {
         const bool bypass = sys->bypassCaches();
@@ -43,10 +43,13 @@
 
 #include <deque>
 #include <memory>
+#include <vector>
 
 #include "base/addr_range_map.hh"
 #include "base/chunk_generator.hh"
 #include "base/circlebuf.hh"
+#include "base/statistics.hh"
+#include "dev/dma_sg.hh"
 #include "dev/io_device.hh"
 #include "mem/backdoor.hh"
 #include "params/DmaDevice.hh"
@@ -56,10 +59,19 @@
 namespace gem5
 {
 
-struct AdaptiveDdioFlag {
-    bool bypassMlc = false;
-    bool bypassLlc = false;
-    bool bypassCache = false;
+/** DMA traffic of one device. */
+struct DmaStats : public statistics::Group
+{
+    DmaStats(statistics::Group *parent);
+
+    statistics::Scalar readBytes;
+    statistics::Scalar writeBytes;
+    statistics::Formula readBandwidth;
+    statistics::Formula writeBandwidth;
+    statistics::Histogram latency;
+    statistics::Scalar windowStalls;
+    statistics::Scalar sgTransfers;
+    statistics::Scalar combinedSegments;
 };
 
 class ClockedObject;
@@ -122,13 +134,25 @@ class DmaPort : public RequestPort, public Drainable
         // SHIN. For DDIO/IDIO requests
         bool is_ddio_req = false;
         int adq_idx = -1;         // -1 is for Not IDIO mode (legacy DDIO)
+        const AdaptiveDdioFlag ddioFlag;
+
+        /** Buffer of writes combined from several segments. */
+        std::unique_ptr<uint8_t[]> combined;
+
+        /** Scatter-gather transfer the request belongs to, if any. */
+        DmaSgState *sg = nullptr;
+
+        /** When the request was queued. */
+        const Tick issued;
 
         DmaReqState(Packet::Command _cmd, Addr addr, Addr chunk_sz, Addr tb,
                     uint8_t *_data, Request::Flags _flags, RequestorID _id,
-                    uint32_t _sid, uint32_t _ssid, Event *ce, Tick _delay, bool _is_ddio_req, int _adq_idx)
+                    uint32_t _sid, uint32_t _ssid, Event *ce, Tick _delay, bool _is_ddio_req, int _adq_idx,
+                    AdaptiveDdioFlag _ddio_flag = AdaptiveDdioFlag())
             : completionEvent(ce), totBytes(tb), delay(_delay),
               gen(addr, tb, chunk_sz), data(_data), flags(_flags), id(_id),
-              sid(_sid), ssid(_ssid), cmd(_cmd), is_ddio_req(_is_ddio_req), adq_idx(_adq_idx)
+              sid(_sid), ssid(_ssid), cmd(_cmd), is_ddio_req(_is_ddio_req), adq_idx(_adq_idx),
+              ddioFlag(_ddio_flag), issued(curTick())
         {}
 
         PacketPtr createPacket();
@@ -187,6 +211,15 @@ class DmaPort : public RequestPort, public Drainable
 
     const int cacheLineSize;
 
+    /** Packets sent and still waiting for their response, capped in
+     * timing mode. */
+    DmaWindow window;
+
+    /** Issue adjacent segments of a scatter-gather write as one request. */
+    const bool writeCombine;
+
+    DmaStats *const stats;
+
   protected:
 
     bool recvTimingResp(PacketPtr pkt) override;
@@ -194,7 +227,9 @@ class DmaPort : public RequestPort, public Drainable
 
   public:
 
-    DmaPort(ClockedObject *dev, System *s, uint32_t sid=0, uint32_t ssid=0);
+    DmaPort(ClockedObject *dev, System *s, uint32_t sid=0, uint32_t ssid=0,
+            unsigned max_outstanding=0, bool write_combine=false,
+            DmaStats *stats=nullptr);
 
     void
     dmaAction(Packet::Command cmd, Addr addr, int size, Event *event,
@@ -237,6 +272,16 @@ class DmaPort : public RequestPort, public Drainable
                    AdaptiveDdioFlag structDdioFlag, 
                    Request::Flags flag=0, bool is_ddio=false, int qnum=-1);
 
+    /**
+     * Transfer a list of buffers as one operation, event is scheduled
+     * once all of them are done. Adjacent writes placed the same way are
+     * combined into one request if the port does write combining.
+     */
+    void
+    dmaActionSg(Packet::Command cmd, const std::vector<DmaSegment> &segs,
+                Event *event, Tick delay, Request::Flags flag=0,
+                bool is_ddio=false, int qnum=-1);
+
     bool dmaPending() const { return pendingCount > 0; }
 
     DrainState drain() override;
@@ -245,6 +290,7 @@ class DmaPort : public RequestPort, public Drainable
 class DmaDevice : public PioDevice
 {
    protected:
+    DmaStats dmaStats;
     DmaPort dmaPort;
 
   public:
@@ -283,6 +329,30 @@ class DmaDevice : public PioDevice
         dmaPort.dmaAction(MemCmd::ReadReq, addr, size, event, data, delay);
     }
 
+    void
+    dmaWriteSg(const std::vector<DmaSegment> &segs, Event *event,
+               Tick delay=0)
+    {
+        dmaPort.dmaActionSg(MemCmd::WriteReq, segs, event, delay);
+    }
+
+    void
+    dmaReadSg(const std::vector<DmaSegment> &segs, Event *event,
+              Tick delay=0)
+    {
+        dmaPort.dmaActionSg(MemCmd::ReadReq, segs, event, delay);
+    }
+
+    /** A scatter-gather IDIO write, each segment is placed by its own
+     * DDIO flags. */
+    void
+    IdioWriteSg(const std::vector<DmaSegment> &segs, Event *event,
+                Tick delay=0, int qnum=-1)
+    {
+        dmaPort.dmaActionSg(MemCmd::WriteReq, segs, event, delay, 0, true,
+                            qnum);
+    }
+
 
     // SHIN. Add DDIO/IDIO R/W
     void ddioWrite(Addr addr, int size, Event *event, uint8_t *data,
@@ -0,0 +1,128 @@
+#ifndef __DEV_DMA_SG_HH__
+#define __DEV_DMA_SG_HH__
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "base/types.hh"
+
+namespace gem5
+{
+
+class Event;
+
+struct AdaptiveDdioFlag {
+    bool bypassMlc = false;
+    bool bypassLlc = false;
+    bool bypassCache = false;
+    // The device places each segment (header, payload, descriptors) with
+    // its own request: only mark the lines as packet header if header is
+    // set, rather than the first line of every request
+    bool segmented = false;
+    bool header = false;
+
+    bool
+    operator==(const AdaptiveDdioFlag &o) const
+    {
+        return bypassMlc == o.bypassMlc && bypassLlc == o.bypassLlc &&
+            bypassCache == o.bypassCache && segmented == o.segmented &&
+            header == o.header;
+    }
+};
+
+/** One buffer of a scatter-gather DMA transfer. */
+struct DmaSegment
+{
+    Addr addr;
+    int size;
+    uint8_t *data;
+    /** Where a DDIO write of the segment goes */
+    AdaptiveDdioFlag ddioFlag = {};
+};
+
+/** Segments [first, end) of a transfer that go out as one request. */
+struct DmaSgRun
+{
+    size_t first;
+    size_t end;
+    Addr size;
+};
+
+/**
+ * Split a scatter-gather transfer into requests. With combining, a run
+ * of segments that follow each other in memory and are placed the same
+ * way goes out as one request, a line shared by two of them is then
+ * written once.
+ */
+inline std::vector<DmaSgRun>
+dmaSgRuns(const std::vector<DmaSegment> &segs, bool combine)
+{
+    std::vector<DmaSgRun> runs;
+    for (size_t i = 0; i < segs.size();) {
+        assert(segs[i].size > 0);
+        DmaSgRun run{i, i + 1, Addr(segs[i].size)};
+        while (combine && run.end < segs.size() && segs[i].data &&
+               segs[run.end].data &&
+               segs[run.end].addr == segs[i].addr + run.size &&
+               segs[run.end].ddioFlag == segs[i].ddioFlag) {
+            run.size += segs[run.end].size;
+            run.end++;
+        }
+        runs.push_back(run);
+        i = run.end;
+    }
+    return runs;
+}
+
+/** Completion of a scatter-gather transfer, once all its requests are
+ * done, in whatever order their responses come back. */
+struct DmaSgState
+{
+    Event *completionEvent;
+    Tick delay;
+    unsigned pending = 0;
+
+    /** A request is done, returns true for the last one. */
+    bool
+    requestDone()
+    {
+        assert(pending);
+        return --pending == 0;
+    }
+};
+
+/** The packets a DMA port has in flight, capped in timing mode. */
+class DmaWindow
+{
+  private:
+    /** Most packets in flight, 0 for no limit */
+    const unsigned limit;
+    unsigned inFlight = 0;
+
+  public:
+    explicit DmaWindow(unsigned _limit) : limit(_limit) {}
+
+    unsigned outstanding() const { return inFlight; }
+
+    bool full() const { return limit && inFlight >= limit; }
+
+    void sent() { inFlight++; }
+
+    /**
+     * A response came back.
+     * @return true if the window was holding sending back
+     */
+    bool
+    received()
+    {
+        assert(inFlight);
+        const bool was_full = full();
+        inFlight--;
+        return was_full;
+    }
+};
+
+} // namespace gem5
+
+#endif // __DEV_DMA_SG_HH__
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <vector>
+
+#include "dev/dma_sg.hh"
+
+using namespace gem5;
+
+TEST(DmaSgTest, RunsWithoutCombining)
+{
+    uint8_t buf[256];
+    std::vector<DmaSegment> segs = {
+        {0x1000, 64, buf}, {0x1040, 64, buf + 64}, {0x2000, 16, buf + 128}};
+    auto runs = dmaSgRuns(segs, false);
+    ASSERT_EQ(3, runs.size());
+    for (size_t i = 0; i < runs.size(); i++) {
+        EXPECT_EQ(i, runs[i].first);
+        EXPECT_EQ(i + 1, runs[i].end);
+        EXPECT_EQ(segs[i].size, runs[i].size);
+    }
+}
+
+TEST(DmaSgTest, CombinesAdjacentSegments)
+{
+    uint8_t buf[256];
+    std::vector<DmaSegment> segs = {
+        {0x1000, 20, buf}, {0x1014, 30, buf + 20}, {0x1032, 14, buf + 50},
+        {0x2000, 16, buf + 64}};
+    auto runs = dmaSgRuns(segs, true);
+    ASSERT_EQ(2, runs.size());
+    EXPECT_EQ(0, runs[0].first);
+    EXPECT_EQ(3, runs[0].end);
+    EXPECT_EQ(64, runs[0].size);
+    EXPECT_EQ(3, runs[1].first);
+    EXPECT_EQ(16, runs[1].size);
+}
+
+TEST(DmaSgTest, KeepsDifferentPlacementsApart)
+{
+    uint8_t buf[128];
+    AdaptiveDdioFlag header;
+    header.segmented = true;
+    header.header = true;
+    std::vector<DmaSegment> segs = {
+        {0x1000, 64, buf, header}, {0x1040, 64, buf + 64}};
+    EXPECT_EQ(2, dmaSgRuns(segs, true).size());
+
+    // Without data to copy there is nothing to combine
+    segs = {{0x1000, 64, nullptr}, {0x1040, 64, nullptr}};
+    EXPECT_EQ(2, dmaSgRuns(segs, true).size());
+}
+
+TEST(DmaSgTest, CompletesWithLastRequestInAnyOrder)
+{
+    DmaSgState sg{nullptr, 0};
+    sg.pending = 3;
+    EXPECT_FALSE(sg.requestDone());
+    EXPECT_FALSE(sg.requestDone());
+    EXPECT_TRUE(sg.requestDone());
+}
+
+TEST(DmaSgTest, UnlimitedWindow)
+{
+    DmaWindow window(0);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_FALSE(window.full());
+        window.sent();
+    }
+    EXPECT_FALSE(window.received());
+    EXPECT_EQ(999, window.outstanding());
+}
+
+/**
+ * Send packets through a window with responses coming back out of
+ * order: never more than the limit is in flight, and a response asks
+ * to resume sending exactly when the window was holding it back.
+ */
+TEST(DmaSgTest, WindowLimitsInFlight)
+{
+    const unsigned limit = 4;
+    DmaWindow window(limit);
+    std::deque<int> in_flight;
+    int to_send = 50, next = 0;
+    unsigned resumes = 0, stalls = 0;
+    bool stalled = false;
+
+    while (to_send || !in_flight.empty()) {
+        while (to_send && !window.full()) {
+            window.sent();
+            in_flight.push_back(next++);
+            to_send--;
+            ASSERT_LE(window.outstanding(), limit);
+        }
+        if (to_send && window.full() && !stalled) {
+            stalls++;
+            stalled = true;
+        }
+
+        // Respond to every other packet from the back first
+        if (in_flight.size() > 1 && next % 2)
+            in_flight.pop_back();
+        else
+            in_flight.pop_front();
+        // The port only resumes when there is something left to send
+        const bool resume = window.received() && to_send;
+        EXPECT_EQ(stalled, resume);
+        if (resume) {
+            resumes++;
+            stalled = false;
+        }
+    }
+    EXPECT_EQ(0, window.outstanding());
+    EXPECT_EQ(stalls, resumes);
+    EXPECT_GT(stalls, 0);
+}
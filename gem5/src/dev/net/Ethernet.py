@@ -152,6 +152,18 @@ class EtherDevice(PciDevice):
 
     interface = EtherInt("Ethernet Interface")
 
+class DdioTarget(Enum): vals = ['MLC', 'LLC', 'DRAM']
+
+class DdioPlacement(SimObject):
+    type = 'DdioPlacement'
+    cxx_header = "dev/net/ddio_placement.hh"
+    cxx_class = 'gem5::DdioPlacement'
+
+    header = Param.DdioTarget('MLC', "Where packet headers are written")
+    payload = Param.DdioTarget('LLC', "Where packet payloads are written")
+    descriptor = Param.DdioTarget('LLC', "Where descriptor writebacks and "
+        "completions are written")
+
 class IGbE(EtherDevice):
     # Base class for two IGbE adapters listed above
     type = 'IGbE'
@@ -190,6 +202,56 @@ class IGbE(EtherDevice):
     # SHIN ddio
     adq_idx = Param.Int('-1', "target mlc")
 
+    num_queues = Param.Unsigned(1, "Number of receive/transmit queue pairs")
+    queue_adq_idx = VectorParam.Int([],
+        "Target mlc of each queue pair, adq_idx for all queues if empty")
+
+    skip_idle_ticks = Param.Bool(True, "Don't schedule state machine ticks "
+        "that would find nothing to do")
+
+    desc_batching = Param.Bool(False, "Fetch and write back descriptors in "
+        "cache line bursts, coalescing writebacks")
+    desc_wb_threshold = Param.Unsigned(8, "Used descriptors a coalesced "
+        "writeback waits for")
+    desc_wb_timeout = Param.Latency('2us', "Longest a used descriptor waits "
+        "for a coalesced writeback")
+
+    ddio_placement = VectorParam.DdioPlacement([], "Where each queue "
+        "places headers, payloads and descriptors, one entry applies to all "
+        "queues. Every request goes to the queue's MLC if empty")
+    ddio_touch_caches = VectorParam.SimObject([], "Caches, from the cores "
+        "outwards, whose demand hits count core touches of placed lines. A "
+        "miss in the last one counts as a touch in memory")
+    ddio_touch_window = Param.Latency('1ms', "Placed lines no core touched "
+        "for this long count as untouched and are no longer tracked")
+
+    adaptive_itr = Param.Bool(False, "Adapt the interrupt throttling "
+        "interval to the traffic, like the igb/ixgbe dynamic ITR. Overrides "
+        "what the driver writes to ITR at the next interrupt")
+
+    num_vfs = Param.Unsigned(0, "Number of SR-IOV style virtual functions. "
+        "Each has a 16KiB register window in BAR3, see enable_vfs()")
+    vf_queues = Param.Unsigned(1, "Queue pairs of each virtual function")
+    vf_mac = VectorParam.EthernetAddr([], "MAC address of each virtual "
+        "function")
+    vf_vlan = VectorParam.UInt16([], "VLAN ID of each virtual function, 0 "
+        "for untagged. All are untagged if empty")
+    vf_adq_idx = VectorParam.Int([], "Target mlc of the queues of each "
+        "virtual function, adq_idx for all of them if empty")
+
+    def enable_vfs(self, macs, vlans=[], adq_idx=[], queues=1):
+        """Give the device a virtual function per MAC address and map
+        their register windows."""
+        self.num_vfs = len(macs)
+        self.vf_queues = queues
+        self.vf_mac = macs
+        self.vf_vlan = vlans
+        self.vf_adq_idx = adq_idx
+        size = 0x4000
+        while size < 0x4000 * len(macs):
+            size *= 2
+        self.BAR3 = PciMemBar(size=size)
+
 class IGbE_e1000(IGbE):
     # Older Intel 8254x based gigabit ethernet adapter
     # Uses Intel e1000 driver
@@ -0,0 +1,125 @@
+#ifndef __DEV_NET_ADAPTIVE_ITR_HH__
+#define __DEV_NET_ADAPTIVE_ITR_HH__
+
+#include <algorithm>
+#include <cstdint>
+
+namespace gem5
+{
+
+/**
+ * Dynamic interrupt throttling as done by the Linux igb/ixgbe drivers.
+ * The traffic carried by each interrupt moves the device between three
+ * latency classes, each with its own interrupt rate: small, sparse
+ * packets get the lowest latency and bulk transfers the fewest
+ * interrupts. Like igb_set_itr(), the rate rises to a new class at once
+ * and falls towards it in steps.
+ */
+class AdaptiveItr
+{
+  public:
+    enum Latency
+    {
+        LowestLatency,
+        LowLatency,
+        BulkLatency,
+    };
+
+    /** Interrupts per second of each latency class. */
+    static constexpr unsigned Rates[] = {70000, 20000, 4000};
+
+  private:
+    Latency rxLatency;
+    Latency txLatency;
+    unsigned rate;
+
+  public:
+    AdaptiveItr()
+        : rxLatency(LowLatency), txLatency(LowLatency),
+          rate(Rates[LowLatency])
+    {}
+
+    /**
+     * Next latency class given the traffic of one interrupt interval,
+     * following igb_update_itr().
+     */
+    static Latency
+    classify(Latency cur, uint64_t packets, uint64_t bytes)
+    {
+        if (packets == 0)
+            return cur;
+
+        const uint64_t avg = bytes / packets;
+        switch (cur) {
+          case LowestLatency:
+            // TSO and jumbo frames
+            if (avg > 8000)
+                return BulkLatency;
+            if (packets < 5 && bytes > 512)
+                return LowLatency;
+            return cur;
+          case LowLatency:
+            if (bytes > 10000) {
+                if (avg > 8000 || packets < 10 || avg > 1200)
+                    return BulkLatency;
+                if (packets > 35)
+                    return LowestLatency;
+            } else if (avg > 2000) {
+                return BulkLatency;
+            } else if (packets <= 2 && bytes < 512) {
+                return LowestLatency;
+            }
+            return cur;
+          case BulkLatency:
+            if (bytes > 25000) {
+                if (packets > 35)
+                    return LowLatency;
+            } else if (bytes < 1500) {
+                return LowLatency;
+            }
+            return cur;
+        }
+        return cur;
+    }
+
+    /**
+     * Account the traffic of the interval that just ended.
+     * Receive and transmit keep their own class and the one asking for
+     * fewer interrupts wins.
+     * @return the interrupt rate to throttle to, per second
+     */
+    unsigned
+    update(uint64_t rx_packets, uint64_t rx_bytes,
+           uint64_t tx_packets, uint64_t tx_bytes)
+    {
+        rxLatency = classify(rxLatency, rx_packets, rx_bytes);
+        txLatency = classify(txLatency, tx_packets, tx_bytes);
+
+        // igb steps a longer interval in as
+        // max(new * old / (new + old / 4), new / 4), which for the rates
+        // is min(old + new / 4, 4 * new)
+        const unsigned target = Rates[current()];
+        rate = target >= rate ? target :
+            std::min(rate + target / 4, 4 * target);
+        return rate;
+    }
+
+    Latency current() const { return std::max(rxLatency, txLatency); }
+    Latency rxCurrent() const { return rxLatency; }
+    Latency txCurrent() const { return txLatency; }
+    unsigned currentRate() const { return rate; }
+
+    /** Restore a state saved from rxCurrent(), txCurrent() and
+     * currentRate(). */
+    void
+    set(Latency rx, Latency tx, unsigned r)
+    {
+        rxLatency = rx;
+        txLatency = tx;
+        rate = r;
+    }
+};
+
+} // namespace gem5
+
+#endif // __DEV_NET_ADAPTIVE_ITR_HH__
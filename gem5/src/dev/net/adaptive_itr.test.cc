@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include "dev/net/adaptive_itr.hh"
+
+using namespace gem5;
+
+/** Starts in the low latency class, like the drivers. */
+TEST(AdaptiveItrTest, Initial)
+{
+    AdaptiveItr itr;
+    ASSERT_EQ(itr.current(), AdaptiveItr::LowLatency);
+    ASSERT_EQ(itr.currentRate(), 20000);
+}
+
+/** Idle intervals leave the class alone. */
+TEST(AdaptiveItrTest, NoPackets)
+{
+    for (auto l : {AdaptiveItr::LowestLatency, AdaptiveItr::LowLatency,
+                   AdaptiveItr::BulkLatency})
+        ASSERT_EQ(AdaptiveItr::classify(l, 0, 0), l);
+}
+
+TEST(AdaptiveItrTest, Classify)
+{
+    // A couple of tiny packets per interrupt asks for low latency
+    ASSERT_EQ(AdaptiveItr::classify(AdaptiveItr::LowLatency, 2, 128),
+              AdaptiveItr::LowestLatency);
+    // Many full sized frames are bulk
+    ASSERT_EQ(AdaptiveItr::classify(AdaptiveItr::LowLatency, 20, 30000),
+              AdaptiveItr::BulkLatency);
+    // Small frames that add up to little keep the class
+    ASSERT_EQ(AdaptiveItr::classify(AdaptiveItr::LowLatency, 64, 64 * 100),
+              AdaptiveItr::LowLatency);
+    // Many small frames move to the lowest class
+    ASSERT_EQ(AdaptiveItr::classify(AdaptiveItr::LowLatency, 200, 200 * 64),
+              AdaptiveItr::LowestLatency);
+    // Bulk only goes back once the traffic gets light
+    ASSERT_EQ(AdaptiveItr::classify(AdaptiveItr::BulkLatency, 10, 20000),
+              AdaptiveItr::BulkLatency);
+    ASSERT_EQ(AdaptiveItr::classify(AdaptiveItr::BulkLatency, 1, 64),
+              AdaptiveItr::LowLatency);
+    // TSO sized packets leave the lowest class straight for bulk
+    ASSERT_EQ(AdaptiveItr::classify(AdaptiveItr::LowestLatency, 1, 9000),
+              AdaptiveItr::BulkLatency);
+}
+
+/**
+ * The rate rises at once, and falls in steps as igb_set_itr() does on
+ * the interval, no further than four times the new rate.
+ */
+TEST(AdaptiveItrTest, RateSmoothing)
+{
+    AdaptiveItr itr;
+    ASSERT_EQ(itr.update(20, 30000, 0, 0), 4 * 4000);
+    ASSERT_EQ(itr.current(), AdaptiveItr::BulkLatency);
+    ASSERT_EQ(itr.update(20, 30000, 0, 0), 4 * 4000);
+
+    ASSERT_EQ(itr.update(1, 64, 0, 0), 20000);
+    ASSERT_EQ(itr.current(), AdaptiveItr::LowLatency);
+    ASSERT_EQ(itr.update(1, 64, 1, 64), 70000);
+    ASSERT_EQ(itr.current(), AdaptiveItr::LowestLatency);
+
+    // Stepping towards a close class adds a quarter of it at a time
+    itr.set(AdaptiveItr::LowLatency, AdaptiveItr::LowLatency, 30000);
+    ASSERT_EQ(itr.update(10, 1000, 0, 0), 30000 + 20000 / 4);
+}
+
+/** The direction asking for fewer interrupts wins. */
+TEST(AdaptiveItrTest, RxTx)
+{
+    AdaptiveItr itr;
+    ASSERT_EQ(itr.update(2, 128, 20, 30000), 4 * 4000);
+    ASSERT_EQ(itr.current(), AdaptiveItr::BulkLatency);
+}
@@ -0,0 +1,114 @@
+#include "dev/net/arrival_process.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#include "base/logging.hh"
+
+namespace gem5
+{
+
+static constexpr double kTicksPerSecond = 1e12;
+
+double
+exponentialSample(Random &rng, double mean)
+{
+    std::exponential_distribution<double> dist(1.0 / mean);
+    return dist(rng.gen);
+}
+
+Tick
+FixedArrival::next(double rate)
+{
+    return kTicksPerSecond / rate;
+}
+
+Tick
+PoissonArrival::next(double rate)
+{
+    // Never return 0 so two sends do not land on the same tick.
+    return std::max<Tick>(1,
+            std::llround(exponentialSample(rng, kTicksPerSecond / rate)));
+}
+
+MmppArrival::MmppArrival(Random &_rng, Tick mean_on, Tick mean_off)
+    : rng(_rng), meanOn(mean_on), meanOff(mean_off), onRemaining(0)
+{
+    fatal_if(mean_on == 0, "MMPP arrival process needs a non-zero on time");
+    onRemaining = std::llround(exponentialSample(rng, meanOn));
+}
+
+Tick
+MmppArrival::next(double rate)
+{
+    const double mean_gap = kTicksPerSecond / rate;
+    Tick gap = 0;
+    while (true) {
+        Tick d = std::max<Tick>(1,
+                std::llround(exponentialSample(rng, mean_gap)));
+        if (d <= onRemaining) {
+            onRemaining -= d;
+            return gap + d;
+        }
+        // The on period ends before the next arrival. Exponential gaps
+        // are memoryless, so skip the off period and redraw.
+        gap += onRemaining;
+        if (meanOff > 0)
+            gap += std::llround(exponentialSample(rng, meanOff));
+        onRemaining = std::llround(exponentialSample(rng, meanOn));
+    }
+}
+
+void
+MmppArrival::serialize(CheckpointOut &cp) const
+{
+    SERIALIZE_SCALAR(onRemaining);
+}
+
+void
+MmppArrival::unserialize(CheckpointIn &cp)
+{
+    UNSERIALIZE_SCALAR(onRemaining);
+}
+
+TraceArrival::TraceArrival(const std::string &filename)
+    : pos(0)
+{
+    std::ifstream in(filename);
+    fatal_if(!in, "Failed to open inter-arrival trace %s", filename);
+
+    Tick gap;
+    while (in >> gap)
+        gaps.push_back(gap);
+
+    fatal_if(gaps.empty(), "Inter-arrival trace %s is empty", filename);
+    inform("Loaded %d inter-arrival times from %s", gaps.size(), filename);
+}
+
+Tick
+TraceArrival::next(double rate)
+{
+    Tick gap = gaps[pos];
+    if (++pos == gaps.size())
+        pos = 0;
+    return gap;
+}
+
+void
+TraceArrival::serialize(CheckpointOut &cp) const
+{
+    SERIALIZE_SCALAR(pos);
+}
+
+void
+TraceArrival::unserialize(CheckpointIn &cp)
+{
+    UNSERIALIZE_SCALAR(pos);
+    fatal_if(pos >= gaps.size(),
+             "Checkpointed trace position %d is past the end of the trace",
+             pos);
+}
+
+} // namespace gem5
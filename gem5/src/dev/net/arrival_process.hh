@@ -0,0 +1,110 @@
+#ifndef __DEV_NET_ARRIVAL_PROCESS_HH__
+#define __DEV_NET_ARRIVAL_PROCESS_HH__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/random.hh"
+#include "base/types.hh"
+#include "sim/serialize.hh"
+
+namespace gem5
+{
+
+/**
+ * Inter-arrival time generator used by the load generators. The rate is
+ * passed in on every call so that rate-changing modes (e.g. Increment)
+ * keep working with any arrival process. Processes with state of their
+ * own checkpoint it so a restored run continues the same arrival stream.
+ */
+class ArrivalProcess : public Serializable
+{
+  public:
+    virtual ~ArrivalProcess() = default;
+
+    /**
+     * Ticks until the next packet should be sent.
+     * @param rate Current mean offered load in packets per second.
+     */
+    virtual Tick next(double rate) = 0;
+
+    virtual std::string name() const = 0;
+
+    void serialize(CheckpointOut &cp) const override {}
+    void unserialize(CheckpointIn &cp) override {}
+};
+
+/** Deterministic spacing of 1/rate, the original loadgen behaviour. */
+class FixedArrival : public ArrivalProcess
+{
+  public:
+    Tick next(double rate) override;
+    std::string name() const override { return "Fixed"; }
+};
+
+/** Exponentially distributed inter-arrivals with mean 1/rate. */
+class PoissonArrival : public ArrivalProcess
+{
+  private:
+    Random &rng;
+
+  public:
+    PoissonArrival(Random &_rng) : rng(_rng) {}
+
+    Tick next(double rate) override;
+    std::string name() const override { return "Poisson"; }
+};
+
+/**
+ * Two-state Markov-modulated Poisson process. In the on state packets
+ * arrive as a Poisson process at the current rate, in the off state
+ * nothing is sent. State holding times are exponentially distributed.
+ */
+class MmppArrival : public ArrivalProcess
+{
+  private:
+    Random &rng;
+    const double meanOn;
+    const double meanOff;
+
+    /** Ticks left in the current on period. */
+    Tick onRemaining;
+
+  public:
+    MmppArrival(Random &_rng, Tick mean_on, Tick mean_off);
+
+    Tick next(double rate) override;
+    std::string name() const override { return "MMPP"; }
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+};
+
+/**
+ * Replays inter-arrival times read from a text file, one value in ticks
+ * per line. The trace wraps around when it is exhausted. The rate
+ * argument is ignored.
+ */
+class TraceArrival : public ArrivalProcess
+{
+  private:
+    std::vector<Tick> gaps;
+    size_t pos;
+
+  public:
+    TraceArrival(const std::string &filename);
+
+    Tick next(double rate) override;
+    std::string name() const override { return "Trace"; }
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+};
+
+/** Draw an exponentially distributed sample with the given mean. */
+double exponentialSample(Random &rng, double mean);
+
+} // namespace gem5
+
+#endif // __DEV_NET_ARRIVAL_PROCESS_HH__
@@ -0,0 +1,41 @@
+#include "dev/net/ddio_placement.hh"
+
+namespace gem5
+{
+
+const char *
+DdioPlacement::segmentName(Segment s)
+{
+    static const char *names[NumSegments] = {
+        "header", "payload", "descriptor"
+    };
+    return names[s];
+}
+
+DdioPlacement::DdioPlacement(const Params &p)
+    : SimObject(p), targets{p.header, p.payload, p.descriptor}
+{}
+
+AdaptiveDdioFlag
+DdioPlacement::flags(Segment s) const
+{
+    AdaptiveDdioFlag flag;
+    flag.segmented = true;
+    flag.header = s == Header;
+    switch (targets[s]) {
+      case enums::MLC:
+        break;
+      case enums::LLC:
+        flag.bypassMlc = true;
+        break;
+      case enums::DRAM:
+        flag.bypassMlc = true;
+        flag.bypassLlc = true;
+        break;
+      default:
+        panic("Unknown DDIO target %d\n", targets[s]);
+    }
+    return flag;
+}
+
+} // namespace gem5
@@ -0,0 +1,50 @@
+#ifndef __DEV_NET_DDIO_PLACEMENT_HH__
+#define __DEV_NET_DDIO_PLACEMENT_HH__
+
+#include "dev/dma_device.hh"
+#include "enums/DdioTarget.hh"
+#include "params/DdioPlacement.hh"
+#include "sim/sim_object.hh"
+
+namespace gem5
+{
+
+/**
+ * Where a receive queue writes each part of its traffic. Headers, payloads
+ * and descriptors are written with separate DMA requests and each can go
+ * to the queue's MLC, to the LLC or straight to memory. Keeping only the
+ * headers in the MLC lets the core parse packets from its L2 without the
+ * payload pushing its working set out.
+ */
+class DdioPlacement : public SimObject
+{
+  public:
+    enum Segment
+    {
+        Header,
+        Payload,
+        Descriptor,
+        NumSegments
+    };
+
+    static const char *segmentName(Segment s);
+
+  private:
+    enums::DdioTarget targets[NumSegments];
+
+  public:
+    PARAMS(DdioPlacement);
+    DdioPlacement(const Params &p);
+
+    enums::DdioTarget target(Segment s) const { return targets[s]; }
+
+    /**
+     * DMA flags that steer a segment to its target. Requests for a queue
+     * without an MLC (adq_idx -1) end up in the LLC when targeting the MLC.
+     */
+    AdaptiveDdioFlag flags(Segment s) const;
+};
+
+} // namespace gem5
+
+#endif // __DEV_NET_DDIO_PLACEMENT_HH__
@@ -0,0 +1,90 @@
+#ifndef __DEV_NET_DESC_WB_BATCH_HH__
+#define __DEV_NET_DESC_WB_BATCH_HH__
+
+#include <algorithm>
+
+#include "base/types.hh"
+
+namespace gem5
+{
+
+/**
+ * When a descriptor cache writes its used descriptors back. A writeback
+ * asked for while another is in flight follows it once it completes, as
+ * does the rest of one that reached the end of the ring. With batching
+ * on, used descriptors are held back until threshold of them are used or
+ * the oldest has waited the timeout. A writeback that is to follow the
+ * one in flight was decided on already, and is not held back again.
+ */
+class DescWbBatch
+{
+  private:
+    const bool batching;
+    const unsigned threshold;
+
+    /** Another writeback is to follow the one in flight */
+    bool more = false;
+
+    /** Alignment mask of the writeback in flight, then of the next one */
+    Addr mask = 0;
+
+  public:
+    DescWbBatch(bool _batching, unsigned _threshold)
+        : batching(_batching), threshold(_threshold)
+    {}
+
+    bool moreToWb() const { return more; }
+    Addr alignment() const { return mask; }
+
+    /**
+     * A writeback aligned to a_mask is asked for with none in flight.
+     * @return false to hold it back, otherwise true with a_mask widened
+     * to whole cache lines when batching
+     */
+    bool
+    issue(unsigned used, Addr &a_mask, Addr line_mask) const
+    {
+        if (!batching || more)
+            return true;
+        if (used < threshold)
+            return false;
+        a_mask = std::max(a_mask, line_mask);
+        return true;
+    }
+
+    /** A writeback aligned to a_mask starts. */
+    void
+    start(Addr a_mask)
+    {
+        more = false;
+        mask = a_mask;
+    }
+
+    /** The writeback stops at the end of the ring, the rest follows. */
+    void wrapped() { more = true; }
+
+    /**
+     * A writeback aligned to a_mask is asked for while one is in flight.
+     * It follows if it is less restrictive, and always if the timeout
+     * asks for it.
+     */
+    void
+    defer(Addr a_mask, bool timed_out)
+    {
+        if (a_mask < mask || timed_out) {
+            more = true;
+            mask = std::min(a_mask, mask);
+        }
+    }
+
+    void
+    restore(bool _more, Addr a_mask)
+    {
+        more = _more;
+        mask = a_mask;
+    }
+};
+
+} // namespace gem5
+
+#endif // __DEV_NET_DESC_WB_BATCH_HH__
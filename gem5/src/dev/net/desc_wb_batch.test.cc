@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include "dev/net/desc_wb_batch.hh"
+
+using namespace gem5;
+
+namespace
+{
+
+/** Descriptors per cache line, less one */
+const Addr LineMask = 3;
+
+} // anonymous namespace
+
+TEST(DescWbBatchTest, NoBatching)
+{
+    DescWbBatch wb(false, 4);
+    Addr mask = 0;
+    EXPECT_TRUE(wb.issue(1, mask, LineMask));
+    EXPECT_EQ(0, mask);
+}
+
+TEST(DescWbBatchTest, HoldsUntilThreshold)
+{
+    DescWbBatch wb(true, 4);
+    Addr mask = 0;
+    EXPECT_FALSE(wb.issue(0, mask, LineMask));
+    EXPECT_FALSE(wb.issue(3, mask, LineMask));
+
+    // A full batch goes out in whole cache lines
+    EXPECT_TRUE(wb.issue(4, mask, LineMask));
+    EXPECT_EQ(LineMask, mask);
+}
+
+TEST(DescWbBatchTest, DeferLessRestrictive)
+{
+    DescWbBatch wb(true, 4);
+    wb.start(LineMask);
+
+    // As restrictive as the writeback in flight, nothing to add
+    wb.defer(LineMask, false);
+    EXPECT_FALSE(wb.moreToWb());
+
+    wb.defer(1, false);
+    EXPECT_TRUE(wb.moreToWb());
+    EXPECT_EQ(1, wb.alignment());
+}
+
+/**
+ * The timeout fires while a batch is in flight: the writeback it asks
+ * for goes out as soon as the batch completes, without waiting for the
+ * threshold or another timeout.
+ */
+TEST(DescWbBatchTest, TimeoutThenRetry)
+{
+    DescWbBatch wb(true, 4);
+    Addr mask = 0;
+    ASSERT_TRUE(wb.issue(4, mask, LineMask));
+    wb.start(mask);
+
+    wb.defer(0, true);
+    EXPECT_TRUE(wb.moreToWb());
+    EXPECT_EQ(0, wb.alignment());
+
+    // The batch completed with one descriptor used since
+    mask = wb.alignment();
+    EXPECT_TRUE(wb.issue(1, mask, LineMask));
+    EXPECT_EQ(0, mask);
+    wb.start(mask);
+    EXPECT_FALSE(wb.moreToWb());
+
+    // Then batching starts over
+    EXPECT_FALSE(wb.issue(1, mask, LineMask));
+}
+
+/** Also when the writeback in flight is not aligned itself. */
+TEST(DescWbBatchTest, TimeoutDuringUnalignedWriteback)
+{
+    DescWbBatch wb(true, 4);
+    wb.start(0);
+    wb.defer(0, false);
+    EXPECT_FALSE(wb.moreToWb());
+    wb.defer(0, true);
+    EXPECT_TRUE(wb.moreToWb());
+
+    Addr mask = wb.alignment();
+    EXPECT_TRUE(wb.issue(2, mask, LineMask));
+    EXPECT_EQ(0, mask);
+}
+
+TEST(DescWbBatchTest, RestOfWrappedWriteback)
+{
+    DescWbBatch wb(true, 4);
+    Addr mask = 0;
+    ASSERT_TRUE(wb.issue(6, mask, LineMask));
+    wb.start(mask);
+    wb.wrapped();
+    EXPECT_TRUE(wb.moreToWb());
+
+    // The rest follows with the alignment of the batch
+    mask = wb.alignment();
+    EXPECT_TRUE(wb.issue(2, mask, LineMask));
+    EXPECT_EQ(LineMask, mask);
+}
@@ -0,0 +1,81 @@
+#ifndef __DEV_NET_DROP_CLASSIFIER_HH__
+#define __DEV_NET_DROP_CLASSIFIER_HH__
+
+namespace gem5
+{
+
+/**
+ * Attributes packets dropped on a full RX FIFO to what held the FIFO up.
+ * The state is the congestion seen at the last packet arrival, one bit
+ * per resource; a drop is blamed on:
+ *
+ *  - the core if the RX ring is full, or was full at the previous
+ *    arrival without the FIFO overflowing (the FIFO backed up behind
+ *    the ring),
+ *  - TX backpressure if both rings are full, unless only the RX ring was
+ *    full at the previous arrival,
+ *  - DMA otherwise, the FIFO did not drain fast enough by itself.
+ */
+class DropClassifier
+{
+  public:
+    enum StateBits
+    {
+        TxRingFull = 1,
+        RxRingFull = 2,
+        RxFifoFull = 4,
+    };
+
+    static constexpr unsigned NumStates = 8;
+
+    enum Cause
+    {
+        NoDrop,
+        DmaBound,
+        CoreBound,
+        TxBound,
+    };
+
+  private:
+    unsigned cur;
+
+  public:
+    DropClassifier() : cur(0) {}
+
+    static unsigned
+    encode(bool rx_fifo_full, bool rx_ring_full, bool tx_ring_full)
+    {
+        return (rx_fifo_full ? RxFifoFull : 0) |
+            (rx_ring_full ? RxRingFull : 0) | (tx_ring_full ? TxRingFull : 0);
+    }
+
+    /**
+     * Account a packet arrival.
+     * @return why the packet was dropped, NoDrop if the FIFO took it
+     */
+    Cause
+    update(bool rx_fifo_full, bool rx_ring_full, bool tx_ring_full)
+    {
+        const unsigned prev = cur;
+        cur = encode(rx_fifo_full, rx_ring_full, tx_ring_full);
+        if (!rx_fifo_full)
+            return NoDrop;
+
+        const bool ring_backlog =
+            (prev & (RxRingFull | RxFifoFull)) == RxRingFull;
+        if (!rx_ring_full)
+            return ring_backlog ? CoreBound : DmaBound;
+        if (!tx_ring_full)
+            return CoreBound;
+        return prev == RxRingFull ? CoreBound : TxBound;
+    }
+
+    unsigned state() const { return cur; }
+
+    /** Restore a state saved from state(). */
+    void set(unsigned s) { cur = s % NumStates; }
+};
+
+} // namespace gem5
+
+#endif // __DEV_NET_DROP_CLASSIFIER_HH__
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include "dev/net/drop_classifier.hh"
+
+using namespace gem5;
+
+namespace
+{
+
+DropClassifier::Cause
+classify(unsigned prev, unsigned cur)
+{
+    DropClassifier c;
+    c.set(prev);
+    return c.update(cur & DropClassifier::RxFifoFull,
+                    cur & DropClassifier::RxRingFull,
+                    cur & DropClassifier::TxRingFull);
+}
+
+} // anonymous namespace
+
+/** Packets that fit in the FIFO are never drops. */
+TEST(DropClassifierTest, NoDrop)
+{
+    for (unsigned prev = 0; prev < DropClassifier::NumStates; prev++) {
+        for (unsigned cur = 0; cur < DropClassifier::RxFifoFull; cur++)
+            ASSERT_EQ(classify(prev, cur), DropClassifier::NoDrop);
+    }
+}
+
+/** The state is the congestion seen at the last arrival. */
+TEST(DropClassifierTest, State)
+{
+    DropClassifier c;
+    ASSERT_EQ(c.state(), 0);
+    c.update(false, true, true);
+    ASSERT_EQ(c.state(),
+              DropClassifier::RxRingFull | DropClassifier::TxRingFull);
+    c.update(true, false, false);
+    ASSERT_EQ(c.state(), DropClassifier::RxFifoFull);
+}
+
+/** Every transition into a drop state, as attributed by the original
+ * eight state machine of the IGbE model. */
+TEST(DropClassifierTest, Attribution)
+{
+    const auto D = DropClassifier::DmaBound;
+    const auto C = DropClassifier::CoreBound;
+    const auto T = DropClassifier::TxBound;
+    // Rows: previous state; columns: FIFO full with nothing else, with
+    // the TX ring full, with the RX ring full, with both rings full
+    const DropClassifier::Cause expected[8][4] = {
+        {D, D, C, T},
+        {D, D, C, T},
+        {C, C, C, C},
+        {C, C, C, T},
+        {D, D, C, T},
+        {D, D, C, T},
+        {D, D, C, T},
+        {D, D, C, T},
+    };
+    for (unsigned prev = 0; prev < DropClassifier::NumStates; prev++) {
+        for (unsigned i = 0; i < 4; i++) {
+            ASSERT_EQ(classify(prev, DropClassifier::RxFifoFull | i),
+                      expected[prev][i]) << "prev " << prev << " cur " << i;
+        }
+    }
+}
@@ -36,6 +36,7 @@
 #include <cassert>
 #include <iosfwd>
 #include <memory>
+#include <vector>
 
 #include "base/types.hh"
 #include "sim/serialize.hh"
@@ -89,6 +90,57 @@ class EthPacketData
 
 typedef std::shared_ptr<EthPacketData> EthPacketPtr;
 
+/*
+ * Recycling pool of fixed capacity packets. The pool keeps a reference
+ * to every packet it hands out, and a packet becomes free again once the
+ * pool holds the only remaining reference, i.e. once every EthPacketPtr
+ * given to the rest of the simulator has been dropped. In steady state
+ * neither the packet, its data buffer nor the shared_ptr control block
+ * is allocated again. Consumers see ordinary EthPacketData objects.
+ *
+ * Packets are handed out in a round robin over the pool, which grows by
+ * a block of packets when the ones it probes are all in use, and gives
+ * its last block back once that block stays unused for two sweeps.
+ */
+class EthPacketPool
+{
+  private:
+    /** Capacity of every buffer in the pool. */
+    const unsigned bufSize;
+
+    std::vector<EthPacketPtr> packets;
+
+    /** Next slot to probe for a free packet. */
+    size_t cursor;
+
+    /** Sweeps in a row that found the last block unused. */
+    unsigned idleSweeps;
+
+    /** Slots probed before the pool is grown instead. */
+    static constexpr size_t maxProbes = 8;
+
+    /** Move the cursor on, and shrink the pool when it is due. */
+    void advance();
+
+  public:
+    /** Number of packets the pool grows and shrinks by. */
+    static constexpr size_t blockSize = 64;
+
+    explicit EthPacketPool(unsigned buf_size)
+        : bufSize(buf_size), cursor(0), idleSweeps(0)
+    { }
+
+    /**
+     * Get a packet with room for at least size bytes. Its length and
+     * simLength are reset, the data buffer content is left undefined.
+     * Requests larger than the pool buffers get a fresh packet.
+     */
+    EthPacketPtr get(unsigned size);
+
+    /** Number of packets owned by the pool. */
+    size_t size() const { return packets.size(); }
+};
+
 } // namespace gem5
 
 #endif // __DEV_NET_ETHERPKT_HH__
@@ -0,0 +1,61 @@
+#include <algorithm>
+
+#include "dev/net/etherpkt.hh"
+
+namespace gem5
+{
+
+void
+EthPacketPool::advance()
+{
+    if (++cursor == packets.size())
+        cursor = 0;
+
+    // The last block was handed out a sweep ago when the cursor gets to
+    // it. If none of it came into use since, the rest of the pool is
+    // enough for what is in flight.
+    if (packets.size() <= blockSize || cursor != packets.size() - blockSize)
+        return;
+    const bool idle = std::all_of(packets.end() - blockSize, packets.end(),
+        [](const EthPacketPtr &pkt) { return pkt.use_count() == 1; });
+    if (!idle) {
+        idleSweeps = 0;
+        return;
+    }
+    if (++idleSweeps < 2)
+        return;
+
+    packets.resize(packets.size() - blockSize);
+    cursor = 0;
+    idleSweeps = 0;
+}
+
+EthPacketPtr
+EthPacketPool::get(unsigned size)
+{
+    if (size > bufSize)
+        return std::make_shared<EthPacketData>(size);
+
+    const size_t probes = std::min(packets.size(), maxProbes);
+    for (size_t i = 0; i < probes; i++) {
+        if (packets[cursor].use_count() == 1) {
+            EthPacketPtr pkt = packets[cursor];
+            advance();
+            pkt->length = 0;
+            pkt->simLength = 0;
+            return pkt;
+        }
+        advance();
+    }
+
+    // Everything probed is still in flight, add a block at the end and
+    // carry on from there.
+    cursor = packets.size();
+    for (size_t i = 0; i < blockSize; i++)
+        packets.push_back(std::make_shared<EthPacketData>(bufSize));
+    EthPacketPtr pkt = packets[cursor];
+    advance();
+    return pkt;
+}
+
+} // namespace gem5
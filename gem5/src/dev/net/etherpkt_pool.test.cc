@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <vector>
+
+#include "dev/net/etherpkt.hh"
+
+using namespace gem5;
+
+TEST(EthPacketPoolTest, ReusesReleasedPackets)
+{
+    EthPacketPool pool(1500);
+    EXPECT_EQ(0, pool.size());
+
+    EthPacketPtr pkt = pool.get(64);
+    ASSERT_TRUE(pkt);
+    EXPECT_EQ(EthPacketPool::blockSize, pool.size());
+    EXPECT_EQ(1500, pkt->bufLength);
+    EthPacketData *first = pkt.get();
+    pkt->length = 64;
+    pkt->simLength = 64;
+    pkt.reset();
+
+    // Every packet gets used again without the pool growing, and comes
+    // back cleared
+    std::set<EthPacketData *> seen;
+    for (size_t i = 0; i < 4 * EthPacketPool::blockSize; i++) {
+        pkt = pool.get(1500);
+        EXPECT_EQ(0, pkt->length);
+        EXPECT_EQ(0, pkt->simLength);
+        seen.insert(pkt.get());
+        pkt.reset();
+    }
+    EXPECT_EQ(EthPacketPool::blockSize, pool.size());
+    EXPECT_EQ(EthPacketPool::blockSize, seen.size());
+    EXPECT_TRUE(seen.count(first));
+}
+
+TEST(EthPacketPoolTest, HeldPacketsAreNotReused)
+{
+    EthPacketPool pool(1500);
+    std::vector<EthPacketPtr> held;
+    std::set<EthPacketData *> distinct;
+    for (size_t i = 0; i < EthPacketPool::blockSize + 1; i++) {
+        held.push_back(pool.get(1500));
+        distinct.insert(held.back().get());
+    }
+    EXPECT_EQ(held.size(), distinct.size());
+    // The pool grows by whole blocks
+    EXPECT_EQ(2 * EthPacketPool::blockSize, pool.size());
+
+    // A packet held outside the pool is not handed out again
+    EthPacketPtr kept = held[0];
+    held.clear();
+    for (size_t i = 0; i < 4 * EthPacketPool::blockSize; i++)
+        EXPECT_NE(kept.get(), pool.get(1500).get());
+}
+
+TEST(EthPacketPoolTest, ShrinksOnceReleased)
+{
+    EthPacketPool pool(1500);
+    std::vector<EthPacketPtr> held;
+    for (size_t i = 0; i < 3 * EthPacketPool::blockSize; i++)
+        held.push_back(pool.get(1500));
+    EXPECT_EQ(3 * EthPacketPool::blockSize, pool.size());
+
+    // With a few packets in flight, the pool goes back to one block
+    held.clear();
+    for (size_t i = 0; i < 20 * EthPacketPool::blockSize; i++) {
+        held.push_back(pool.get(1500));
+        if (held.size() > 4)
+            held.erase(held.begin());
+    }
+    EXPECT_EQ(EthPacketPool::blockSize, pool.size());
+}
+
+TEST(EthPacketPoolTest, OversizedPacketsBypassThePool)
+{
+    EthPacketPool pool(64);
+    EthPacketPtr pkt = pool.get(1500);
+    EXPECT_EQ(1500, pkt->bufLength);
+    EXPECT_EQ(0, pool.size());
+}
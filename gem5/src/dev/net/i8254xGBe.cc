@@ -43,7 +43,9 @@
 #include <memory>
 
 #include "base/inet.hh"
+#include "base/intmath.hh"
 #include "base/trace.hh"
+#include "dev/net/rss.hh"
 #include "debug/Drain.hh"
 #include "debug/EthernetAll.hh"
 #include "mem/packet.hh"
@@ -61,22 +63,91 @@ using namespace igbreg;
 using namespace networking;
 
 IGbE::IGbE(const Params &p)
-    : EtherDevice(p), adq(p.adq_idx), etherInt(NULL),      // SHIN. add adq
-      rxFifo(p.rx_fifo_size), txFifo(p.tx_fifo_size), inTick(false),
-      rxTick(false), txTick(false), txFifoTick(false), rxDmaPacket(false),
+    : EtherDevice(p), etherInt(NULL),
+      numPfQueues(p.num_queues), numVfs(p.num_vfs), vfQueues(p.vf_queues),
+      numQueues(numPfQueues + numVfs * vfQueues), queueRegs(numQueues),
+      vfRegs(numVfs),
+      rxFifo(p.rx_fifo_size), txFifo(p.tx_fifo_size), txPacket(numQueues),
+      rxQueue(0), rxRssHash(0), rxRssType(RSS_TYPE_NONE), txQueue(0),
+      inTick(false),
+      rxTick(false), txTick(false), txFifoTick(false),
+      skipIdleTicks(p.skip_idle_ticks), rxDmaPacket(false),
+      adaptiveItr(p.adaptive_itr), itrRxPackets(0), itrRxBytes(0),
+      itrTxPackets(0), itrTxBytes(0), queueIntPending(0),
+      queueIntTick(numQueues, 0), dropStateSince(0),
       pktOffset(0), fetchDelay(p.fetch_delay), wbDelay(p.wb_delay),
       fetchCompDelay(p.fetch_comp_delay), wbCompDelay(p.wb_comp_delay),
       rxWriteDelay(p.rx_write_delay), txReadDelay(p.tx_read_delay),
+      descBatching(p.desc_batching), descWbThreshold(p.desc_wb_threshold),
+      descWbTimeout(p.desc_wb_timeout),
+      ddioPlacement(p.ddio_placement),
+      ddioTouchWindow(p.ddio_touch_window), placedSweepSize(1024),
       rdtrEvent([this]{ rdtrProcess(); }, name()),
       radvEvent([this]{ radvProcess(); }, name()),
       tadvEvent([this]{ tadvProcess(); }, name()),
       tidvEvent([this]{ tidvProcess(); }, name()),
       tickEvent([this]{ tick(); }, name()),
       interEvent([this]{ delayIntEvent(); }, name()),
-      rxDescCache(this, name()+".RxDesc", p.rx_desc_cache_size),
-      txDescCache(this, name()+".TxDesc", p.tx_desc_cache_size),
-      lastInterrupt(0)
+      igbeStats(this), lastInterrupt(0)
 {
+    fatal_if(numPfQueues == 0 || numQueues > MAX_QUEUES,
+             "%s: num_queues must be at least 1 and there can be at most %d "
+             "queues, VF queues included", name(), MAX_QUEUES);
+    fatal_if(!p.queue_adq_idx.empty() &&
+             p.queue_adq_idx.size() != numPfQueues,
+             "%s: queue_adq_idx has %d entries for %d queues", name(),
+             p.queue_adq_idx.size(), numPfQueues);
+    fatal_if(numVfs > MAX_VFS, "%s: at most %d virtual functions", name(),
+             MAX_VFS);
+    fatal_if(vfQueues == 0 || vfQueues > MAX_VF_QUEUES,
+             "%s: vf_queues must be between 1 and %d", name(),
+             MAX_VF_QUEUES);
+    fatal_if(p.vf_mac.size() != numVfs,
+             "%s: vf_mac has %d entries for %d virtual functions", name(),
+             p.vf_mac.size(), numVfs);
+    fatal_if(!p.vf_vlan.empty() && p.vf_vlan.size() != numVfs,
+             "%s: vf_vlan has %d entries for %d virtual functions", name(),
+             p.vf_vlan.size(), numVfs);
+    fatal_if(!p.vf_adq_idx.empty() && p.vf_adq_idx.size() != numVfs,
+             "%s: vf_adq_idx has %d entries for %d virtual functions",
+             name(), p.vf_adq_idx.size(), numVfs);
+    fatal_if(numVfs && (!BARs[VF_BAR] || BARs[VF_BAR]->isIo() ||
+                        BARs[VF_BAR]->size() < numVfs * VF_BAR_STRIDE),
+             "%s: %d virtual functions need BAR%d to be a memory BAR of at "
+             "least %d bytes", name(), numVfs, VF_BAR,
+             numVfs * VF_BAR_STRIDE);
+    fatal_if(descBatching && (descWbThreshold == 0 ||
+             descWbThreshold > std::min(p.rx_desc_cache_size,
+                                        p.tx_desc_cache_size)),
+             "%s: desc_wb_threshold must be between 1 and the descriptor "
+             "cache size", name());
+    fatal_if(ddioPlacement.size() > 1 && ddioPlacement.size() != numQueues,
+             "%s: ddio_placement has %d entries for %d queues", name(),
+             ddioPlacement.size(), numQueues);
+    if (ddioPlacement.size() == 1)
+        ddioPlacement.resize(numQueues, ddioPlacement.front());
+
+    for (unsigned vf = 0; vf < numVfs; vf++)
+        vfSwitch.add(p.vf_mac[vf], p.vf_vlan.empty() ? 0 : p.vf_vlan[vf]);
+
+    // Queue 0 keeps the original names so single queue configurations
+    // look the same as before. VF queues go to the core of their VF.
+    for (unsigned q = 0; q < numQueues; q++) {
+        int vf = queueVf(q);
+        int queue_adq = p.adq_idx;
+        if (vf != VfSwitch::Pf && !p.vf_adq_idx.empty())
+            queue_adq = p.vf_adq_idx[vf];
+        else if (vf == VfSwitch::Pf && !p.queue_adq_idx.empty())
+            queue_adq = p.queue_adq_idx[q];
+        std::string suffix = q ? csprintf("%d", q) : "";
+        rxDescCache.emplace_back(new RxDescCache(this,
+                name() + ".RxDesc" + suffix, p.rx_desc_cache_size, q,
+                queue_adq));
+        txDescCache.emplace_back(new TxDescCache(this,
+                name() + ".TxDesc" + suffix, p.tx_desc_cache_size, q,
+                queue_adq));
+    }
+
     etherInt = new IGbEInt(name() + ".int", this);
 
     // Initialized internal registers per Intel documentation
@@ -92,13 +163,39 @@ IGbE::IGbE(const Params &p)
     regs.eecd.ee_type(1);
     regs.imr = 0;
     regs.iam = 0;
-    regs.rxdctl.gran(1);
-    regs.rxdctl.wthresh(1);
+    for (auto &qr : queueRegs) {
+        qr.rxdctl.gran(1);
+        qr.rxdctl.wthresh(1);
+    }
     regs.fcrth(1);
-    regs.tdwba = 0;
     regs.rlpml = 0;
     regs.sw_fw_sync = 0;
 
+    // RSS is off until the driver enables it in MRQC, but the redirection
+    // table and key come up spread over the queues with the default key
+    rss::RedirectionTable reta(RETA_SIZE, numPfQueues);
+    for (int x = 0; x < RETA_SIZE; x++)
+        regs.reta[x] = reta[x];
+    memcpy(regs.rssrk, rss::DefaultKey, RSS_KEY_SIZE);
+
+    // Each queue pair gets its own interrupt vector, VFs allocate theirs
+    // in their own VTIVAR
+    regs.gpie = 0;
+    regs.eicr = 0;
+    regs.eims = 0;
+    regs.eiac = 0;
+    regs.eiam = 0;
+    memset(regs.ivar, 0, sizeof(regs.ivar));
+    for (unsigned q = 0; q < numPfQueues; q++) {
+        unsigned shift = q < IVAR_REGS ? 0 : 16;
+        uint32_t entry = IVAR_VALID | q;
+        regs.ivar[q % IVAR_REGS] |= (entry | entry << 8) << shift;
+    }
+
+    // The adaptive ITR throttles from the start
+    if (adaptiveItr)
+        regs.itr.interval(itrInterval(itrModel.currentRate()));
+
     regs.pba.rxa(0x30);
     regs.pba.txa(0x10);
 
@@ -141,6 +238,131 @@ IGbE::init()
     PciDevice::init();
 }
 
+void
+IGbE::regProbeListeners()
+{
+    PciDevice::regProbeListeners();
+
+    const auto &caches = params().ddio_touch_caches;
+    for (unsigned l = 0; l < caches.size(); l++) {
+        ProbeManager *pm = caches[l]->getProbeManager();
+        touchListeners.emplace_back(new TouchListener(*this, pm, "Hit",
+                                                      l, false));
+        touchListeners.emplace_back(new TouchListener(*this, pm, "Miss",
+                                                      l, true));
+    }
+}
+
+AdaptiveDdioFlag
+IGbE::getAdaptiveDdioFlag(void *opts)
+{
+    return opts ? *static_cast<AdaptiveDdioFlag *>(opts) :
+        AdaptiveDdioFlag();
+}
+
+void
+IGbE::placeWrite(DdioPlacement::Segment seg, unsigned q, int adq,
+                 Addr addr, int size, Event *event, uint8_t *data,
+                 Tick delay)
+{
+    if (ddioPlacement.empty()) {
+        IdioWrite(addr, size, event, data, delay, 0, adq);
+        return;
+    }
+
+    AdaptiveDdioFlag flag = ddioPlacement[q]->flags(seg);
+    IdioWrite(addr, size, event, data, delay, &flag, adq);
+    accountPlaced(seg, addr, size);
+}
+
+void
+IGbE::placeWriteSg(const std::vector<DdioPlacement::Segment> &kinds,
+                   unsigned q, int adq, std::vector<DmaSegment> segs,
+                   Event *event, Tick delay)
+{
+    assert(kinds.size() == segs.size());
+    if (!ddioPlacement.empty()) {
+        for (size_t i = 0; i < segs.size(); i++)
+            segs[i].ddioFlag = ddioPlacement[q]->flags(kinds[i]);
+    }
+    IdioWriteSg(segs, event, delay, adq);
+
+    if (ddioPlacement.empty())
+        return;
+    for (size_t i = 0; i < segs.size(); i++)
+        accountPlaced(kinds[i], segs[i].addr, segs[i].size);
+}
+
+void
+IGbE::accountPlaced(DdioPlacement::Segment seg, Addr addr, int size)
+{
+    const Addr line_size = sys->cacheLineSize();
+    for (Addr line = addr & ~(line_size - 1); line < addr + size;
+         line += line_size) {
+        igbeStats.ddioPlacedLines[seg]++;
+        if (touchListeners.empty())
+            continue;
+        // Rewriting a line nobody read means the earlier copy was wasted
+        auto placed = placedLines.emplace(line,
+                                          PlacedLine{uint8_t(seg), curTick()});
+        if (!placed.second) {
+            igbeStats.ddioUntouchedLines[placed.first->second.seg]++;
+            placed.first->second = {uint8_t(seg), curTick()};
+        }
+    }
+
+    if (placedLines.size() >= placedSweepSize)
+        sweepPlacedLines();
+}
+
+void
+IGbE::sweepPlacedLines()
+{
+    for (auto it = placedLines.begin(); it != placedLines.end();) {
+        if (curTick() - it->second.when > ddioTouchWindow) {
+            igbeStats.ddioUntouchedLines[it->second.seg]++;
+            it = placedLines.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // Sweep again once the map doubles, which keeps the cost per
+    // placed line constant
+    placedSweepSize = std::max<size_t>(1024, 2 * placedLines.size());
+}
+
+void
+IGbE::ddioTouch(const PacketPtr &pkt, unsigned level, bool miss)
+{
+    // Only demand accesses of the cores, not DMA, writebacks or prefetches
+    if (!pkt->req->hasContextId() || pkt->req->isPrefetch() ||
+        !(pkt->isRead() || pkt->isWrite())) {
+        return;
+    }
+
+    // Misses in the inner caches are looked up again further out, only
+    // a miss in the last cache goes to memory
+    const unsigned levels = touchListeners.size() / 2;
+    if (miss && level != levels - 1)
+        return;
+
+    auto placed = placedLines.find(pkt->getBlockAddr(sys->cacheLineSize()));
+    if (placed == placedLines.end())
+        return;
+
+    igbeStats.ddioTouches[placed->second.seg][miss ? levels : level]++;
+    placedLines.erase(placed);
+}
+
+std::string
+IGbE::queueName(unsigned q) const
+{
+    int vf = queueVf(q);
+    if (vf == VfSwitch::Pf)
+        return csprintf("queue%d", q);
+    return csprintf("vf%d_queue%d", vf, q - vfFirstQueue(vf));
+}
+
 Port &
 IGbE::getPort(const std::string &if_name, PortID idx)
 {
@@ -168,6 +390,196 @@ IGbE::writeConfig(PacketPtr pkt)
 // Handy macro for range-testing register access addresses
 #define IN_RANGE(val, base, len) (val >= base && val < (base + len))
 
+// RETA and RSSRK pack four byte wide entries into each register
+static uint32_t
+readTableReg(const uint8_t *table, Addr offset)
+{
+    return table[offset] | table[offset + 1] << 8 |
+        table[offset + 2] << 16 | (uint32_t)table[offset + 3] << 24;
+}
+
+static void
+writeTableReg(uint8_t *table, Addr offset, uint32_t val)
+{
+    for (int x = 0; x < 4; x++)
+        table[offset + x] = val >> (8 * x);
+}
+
+bool
+IGbE::queueRegister(Addr daddr, Addr &reg, unsigned &q, unsigned first,
+                    unsigned count) const
+{
+    Addr base, offset;
+    unsigned queue;
+    if (IN_RANGE(daddr, REG_RDBAL, QUEUE_BANK0_SIZE * QUEUE_STRIDE)) {
+        base = REG_RDBAL;
+        queue = (daddr - REG_RDBAL) / QUEUE_STRIDE;
+        offset = (daddr - REG_RDBAL) % QUEUE_STRIDE;
+    } else if (IN_RANGE(daddr, REG_TDBAL, QUEUE_BANK0_SIZE * QUEUE_STRIDE)) {
+        base = REG_TDBAL;
+        queue = (daddr - REG_TDBAL) / QUEUE_STRIDE;
+        offset = (daddr - REG_TDBAL) % QUEUE_STRIDE;
+    } else if (IN_RANGE(daddr, REG_RXQ_BANK1,
+                        MAX_QUEUES * QUEUE_BANK1_STRIDE)) {
+        base = REG_RDBAL;
+        queue = (daddr - REG_RXQ_BANK1) / QUEUE_BANK1_STRIDE;
+        offset = (daddr - REG_RXQ_BANK1) % QUEUE_BANK1_STRIDE;
+    } else if (IN_RANGE(daddr, REG_TXQ_BANK1,
+                        MAX_QUEUES * QUEUE_BANK1_STRIDE)) {
+        base = REG_TDBAL;
+        queue = (daddr - REG_TXQ_BANK1) / QUEUE_BANK1_STRIDE;
+        offset = (daddr - REG_TXQ_BANK1) % QUEUE_BANK1_STRIDE;
+    } else {
+        return false;
+    }
+
+    if (queue >= count)
+        return false;
+
+    switch (base + offset) {
+      case REG_RDBAL:
+      case REG_RDBAH:
+      case REG_RDLEN:
+      case REG_SRRCTL:
+      case REG_RDH:
+      case REG_RDT:
+      case REG_RXDCTL:
+      case REG_TDBAL:
+      case REG_TDBAH:
+      case REG_TDLEN:
+      case REG_TDH:
+      case REG_TDT:
+      case REG_TXDCTL:
+      case REG_TDWBAL:
+      case REG_TDWBAH:
+        reg = base + offset;
+        q = first + queue;
+        return true;
+      default:
+        return false;
+    }
+}
+
+bool
+IGbE::vfRegister(Addr daddr, unsigned &vf, Addr &reg, unsigned &q) const
+{
+    vf = daddr / VF_BAR_STRIDE;
+    reg = daddr % VF_BAR_STRIDE;
+    if (vf >= numVfs)
+        return false;
+    return queueRegister(reg, reg, q, vfFirstQueue(vf), vfQueues);
+}
+
+Tick
+IGbE::vfRead(PacketPtr pkt, unsigned vf, Addr daddr)
+{
+    DPRINTF(Ethernet, "Read VF %d register %#X\n", vf, daddr);
+
+    if (vf >= numVfs) {
+        warn_once("%s: read of unmapped VF register window %d\n", name(),
+                  vf);
+        pkt->setLE<uint32_t>(0);
+        pkt->makeAtomicResponse();
+        return pioDelay;
+    }
+
+    VfRegs &vr = vfRegs[vf];
+    switch (daddr) {
+      case REG_VTCTRL:
+        pkt->setLE<uint32_t>(vr.ctrl);
+        break;
+      case REG_VTSTATUS:
+        // The VFs see the link of the port
+        pkt->setLE<uint32_t>(regs.sts());
+        break;
+      case REG_VTEICR:
+        // One bit per vector, cleared by the read
+        pkt->setLE<uint32_t>(vr.eicr);
+        vr.eicr = 0;
+        chkInterrupt();
+        break;
+      case REG_VTEIMS:
+        pkt->setLE<uint32_t>(vr.eims);
+        break;
+      case REG_VTEIAC:
+        pkt->setLE<uint32_t>(vr.eiac);
+        break;
+      case REG_VTEIAM:
+        pkt->setLE<uint32_t>(vr.eiam);
+        break;
+      case REG_VTIVAR:
+        pkt->setLE<uint32_t>(vr.ivar);
+        break;
+      case REG_VTIVAR_MISC:
+        pkt->setLE<uint32_t>(vr.ivarMisc);
+        break;
+      default:
+        panic("Read request to unknown VF register number: %#x\n", daddr);
+    }
+
+    pkt->makeAtomicResponse();
+    return pioDelay;
+}
+
+Tick
+IGbE::vfWrite(PacketPtr pkt, unsigned vf, Addr daddr)
+{
+    uint32_t val = pkt->getLE<uint32_t>();
+    DPRINTF(Ethernet, "Wrote VF %d register %#X value %#X\n", vf, daddr,
+            val);
+
+    if (vf >= numVfs) {
+        warn_once("%s: write to unmapped VF register window %d\n", name(),
+                  vf);
+        pkt->makeAtomicResponse();
+        return pioDelay;
+    }
+
+    VfRegs &vr = vfRegs[vf];
+    switch (daddr) {
+      case REG_VTCTRL:
+        vr.ctrl = val;
+        break;
+      case REG_VTSTATUS:
+        break;
+      case REG_VTEICS:
+        DPRINTF(EthernetIntr, "Posting interrupt because of VF %d EICS "
+                "write\n", vf);
+        vr.eicr |= val & mask(MAX_VF_VECTORS);
+        chkInterrupt();
+        break;
+      case REG_VTEICR:
+        vr.eicr &= ~val;
+        chkInterrupt();
+        break;
+      case REG_VTEIMS:
+        vr.eims |= val & mask(MAX_VF_VECTORS);
+        chkInterrupt();
+        break;
+      case REG_VTEIMC:
+        vr.eims &= ~val;
+        chkInterrupt();
+        break;
+      case REG_VTEIAC:
+        vr.eiac = val;
+        break;
+      case REG_VTEIAM:
+        vr.eiam = val;
+        break;
+      case REG_VTIVAR:
+        vr.ivar = val;
+        break;
+      case REG_VTIVAR_MISC:
+        vr.ivarMisc = val;
+        break;
+      default:
+        panic("Write request to unknown VF register number: %#x\n", daddr);
+    }
+
+    pkt->makeAtomicResponse();
+    return pioDelay;
+}
+
 Tick
 IGbE::read(PacketPtr pkt)
 {
@@ -177,12 +589,25 @@ IGbE::read(PacketPtr pkt)
     if (!getBAR(pkt->getAddr(), bar, daddr))
         panic("Invalid PCI memory access to unmapped memory.\n");
 
-    // Only Memory register BAR is allowed
-    assert(bar == 0);
+    // Only the memory register BAR and the VF BAR are allowed
+    assert(bar == 0 || (numVfs && bar == VF_BAR));
 
     // Only 32bit accesses allowed
     assert(pkt->getSize() == 4);
 
+    // The ring registers of every queue are handled as the queue 0 ones,
+    // whether the PF or a VF accesses them
+    Addr reg = daddr;
+    unsigned q = 0;
+    if (bar == VF_BAR) {
+        unsigned vf;
+        if (!vfRegister(daddr, vf, reg, q))
+            return vfRead(pkt, vf, reg);
+    } else {
+        queueRegister(daddr, reg, q, 0, numPfQueues);
+    }
+    QueueRegs &qr = queueRegs[q];
+
     DPRINTF(Ethernet, "Read device register %#X\n", daddr);
 
     //
@@ -190,7 +615,7 @@ IGbE::read(PacketPtr pkt)
     //
 
 
-    switch (daddr) {
+    switch (reg) {
       case REG_CTRL:
         pkt->setLE<uint32_t>(regs.ctrl());
         break;
@@ -222,9 +647,25 @@ IGbE::read(PacketPtr pkt)
         chkInterrupt();
         break;
       case REG_EICR:
-        // This is only useful for MSI, but the driver reads it every time
-        // Just don't do anything
-        pkt->setLE<uint32_t>(0);
+        // One bit per queue vector, cleared by the read
+        pkt->setLE<uint32_t>(regs.eicr);
+        regs.eicr = 0;
+        chkInterrupt();
+        break;
+      case REG_EIMS:
+        pkt->setLE<uint32_t>(regs.eims);
+        break;
+      case REG_EIAC:
+        pkt->setLE<uint32_t>(regs.eiac);
+        break;
+      case REG_EIAM:
+        pkt->setLE<uint32_t>(regs.eiam);
+        break;
+      case REG_GPIE:
+        pkt->setLE<uint32_t>(regs.gpie);
+        break;
+      case REG_MRQC:
+        pkt->setLE<uint32_t>(regs.mrqc());
         break;
       case REG_ITR:
         pkt->setLE<uint32_t>(regs.itr());
@@ -254,27 +695,28 @@ IGbE::read(PacketPtr pkt)
         pkt->setLE<uint32_t>(regs.fcrth());
         break;
       case REG_RDBAL:
-        pkt->setLE<uint32_t>(regs.rdba.rdbal());
+        pkt->setLE<uint32_t>(qr.rdba.rdbal());
         break;
       case REG_RDBAH:
-        pkt->setLE<uint32_t>(regs.rdba.rdbah());
+        pkt->setLE<uint32_t>(qr.rdba.rdbah());
         break;
       case REG_RDLEN:
-        pkt->setLE<uint32_t>(regs.rdlen());
+        pkt->setLE<uint32_t>(qr.rdlen());
         break;
       case REG_SRRCTL:
-        pkt->setLE<uint32_t>(regs.srrctl());
+        pkt->setLE<uint32_t>(qr.srrctl());
         break;
       case REG_RDH:
-        pkt->setLE<uint32_t>(regs.rdh());
+        pkt->setLE<uint32_t>(qr.rdh());
         break;
       case REG_RDT:
-        pkt->setLE<uint32_t>(regs.rdt());
+        pkt->setLE<uint32_t>(qr.rdt());
         break;
       case REG_RDTR:
         pkt->setLE<uint32_t>(regs.rdtr());
         if (regs.rdtr.fpd()) {
-            rxDescCache.writeback(0);
+            for (auto &cache : rxDescCache)
+                cache->writeback(0);
             DPRINTF(EthernetIntr,
                     "Posting interrupt because of RDTR.FPD write\n");
             postInterrupt(IT_RXT);
@@ -282,43 +724,43 @@ IGbE::read(PacketPtr pkt)
         }
         break;
       case REG_RXDCTL:
-        pkt->setLE<uint32_t>(regs.rxdctl());
+        pkt->setLE<uint32_t>(qr.rxdctl());
         break;
       case REG_RADV:
         pkt->setLE<uint32_t>(regs.radv());
         break;
       case REG_TDBAL:
-        pkt->setLE<uint32_t>(regs.tdba.tdbal());
+        pkt->setLE<uint32_t>(qr.tdba.tdbal());
         break;
       case REG_TDBAH:
-        pkt->setLE<uint32_t>(regs.tdba.tdbah());
+        pkt->setLE<uint32_t>(qr.tdba.tdbah());
         break;
       case REG_TDLEN:
-        pkt->setLE<uint32_t>(regs.tdlen());
+        pkt->setLE<uint32_t>(qr.tdlen());
         break;
       case REG_TDH:
-        pkt->setLE<uint32_t>(regs.tdh());
+        pkt->setLE<uint32_t>(qr.tdh());
         break;
       case REG_TXDCA_CTL:
         pkt->setLE<uint32_t>(regs.txdca_ctl());
         break;
       case REG_TDT:
-        pkt->setLE<uint32_t>(regs.tdt());
+        pkt->setLE<uint32_t>(qr.tdt());
         break;
       case REG_TIDV:
         pkt->setLE<uint32_t>(regs.tidv());
         break;
       case REG_TXDCTL:
-        pkt->setLE<uint32_t>(regs.txdctl());
+        pkt->setLE<uint32_t>(qr.txdctl());
         break;
       case REG_TADV:
         pkt->setLE<uint32_t>(regs.tadv());
         break;
       case REG_TDWBAL:
-        pkt->setLE<uint32_t>(regs.tdwba & mask(32));
+        pkt->setLE<uint32_t>(qr.tdwba & mask(32));
         break;
       case REG_TDWBAH:
-        pkt->setLE<uint32_t>(regs.tdwba >> 32);
+        pkt->setLE<uint32_t>(qr.tdwba >> 32);
         break;
       case REG_RXCSUM:
         pkt->setLE<uint32_t>(regs.rxcsum());
@@ -346,7 +788,14 @@ IGbE::read(PacketPtr pkt)
         pkt->setLE<uint32_t>(regs.imr);
         break;
       default:
-        if (!IN_RANGE(daddr, REG_VFTA, VLAN_FILTER_TABLE_SIZE*4) &&
+        if (IN_RANGE(daddr, REG_RETA, RETA_SIZE))
+            pkt->setLE<uint32_t>(readTableReg(regs.reta, daddr - REG_RETA));
+        else if (IN_RANGE(daddr, REG_RSSRK, RSS_KEY_SIZE))
+            pkt->setLE<uint32_t>(readTableReg(regs.rssrk,
+                                              daddr - REG_RSSRK));
+        else if (IN_RANGE(daddr, REG_IVAR0, IVAR_REGS*4))
+            pkt->setLE<uint32_t>(regs.ivar[(daddr - REG_IVAR0) / 4]);
+        else if (!IN_RANGE(daddr, REG_VFTA, VLAN_FILTER_TABLE_SIZE*4) &&
             !IN_RANGE(daddr, REG_RAL, RCV_ADDRESS_TABLE_SIZE*8) &&
             !IN_RANGE(daddr, REG_MTA, MULTICAST_TABLE_SIZE*4) &&
             !IN_RANGE(daddr, REG_CRCERRS, STATS_REGS_SIZE))
@@ -370,12 +819,22 @@ IGbE::write(PacketPtr pkt)
     if (!getBAR(pkt->getAddr(), bar, daddr))
         panic("Invalid PCI memory access to unmapped memory.\n");
 
-    // Only Memory register BAR is allowed
-    assert(bar == 0);
+    // Only the memory register BAR and the VF BAR are allowed
+    assert(bar == 0 || (numVfs && bar == VF_BAR));
 
     // Only 32bit accesses allowed
     assert(pkt->getSize() == sizeof(uint32_t));
 
+    Addr reg = daddr;
+    unsigned q = 0;
+    if (bar == VF_BAR) {
+        unsigned vf;
+        if (!vfRegister(daddr, vf, reg, q))
+            return vfWrite(pkt, vf, reg);
+    } else {
+        queueRegister(daddr, reg, q, 0, numPfQueues);
+    }
+
     DPRINTF(Ethernet, "Wrote device register %#X value %#X\n",
             daddr, pkt->getLE<uint32_t>());
 
@@ -389,7 +848,9 @@ IGbE::write(PacketPtr pkt)
     Regs::RCTL oldrctl;
     Regs::TCTL oldtctl;
 
-    switch (daddr) {
+    QueueRegs &qr = queueRegs[q];
+
+    switch (reg) {
       case REG_CTRL:
         regs.ctrl = val;
         if (regs.ctrl.tfce())
@@ -507,6 +968,11 @@ IGbE::write(PacketPtr pkt)
         chkInterrupt();
         break;
       case REG_ITR:
+        // The adaptive ITR sets the interval again on the next interrupt,
+        // what the driver writes only holds until then
+        if (adaptiveItr)
+            warn_once("IGbE: adaptive ITR overrides the interval the "
+                      "driver writes to ITR\n");
         regs.itr = val;
         break;
       case REG_ICS:
@@ -524,11 +990,44 @@ IGbE::write(PacketPtr pkt)
       case REG_IAM:
         regs.iam = val;
         break;
+      case REG_EICS:
+        DPRINTF(EthernetIntr, "Posting interrupt because of EICS write\n");
+        regs.eicr |= val;
+        chkInterrupt();
+        break;
+      case REG_EICR:
+        regs.eicr &= ~val;
+        chkInterrupt();
+        break;
+      case REG_EIMS:
+        regs.eims |= val;
+        chkInterrupt();
+        break;
+      case REG_EIMC:
+        regs.eims &= ~val;
+        chkInterrupt();
+        break;
+      case REG_EIAC:
+        regs.eiac = val;
+        break;
+      case REG_EIAM:
+        regs.eiam = val;
+        break;
+      case REG_GPIE:
+        regs.gpie = val;
+        break;
+      case REG_MRQC:
+        regs.mrqc = val;
+        if (regs.mrqc.mrqe() && !regs.mrqc.rss())
+            warn("MRQC mode %d not supported, only RSS\n",
+                 regs.mrqc.mrqe());
+        break;
       case REG_RCTL:
         oldrctl = regs.rctl;
         regs.rctl = val;
         if (regs.rctl.rst()) {
-            rxDescCache.reset();
+            for (auto &cache : rxDescCache)
+                cache->reset();
             DPRINTF(EthernetSM, "RXS: Got RESET!\n");
             rxFifo.clear();
             regs.rctl.rst(0);
@@ -544,12 +1043,16 @@ IGbE::write(PacketPtr pkt)
         regs.tctl = val;
         oldtctl = regs.tctl;
         regs.tctl = val;
-        if (regs.tctl.en())
+        if (regs.tctl.en()) {
             txTick = true;
-        restartClock();
+            for (auto &cache : txDescCache)
+                cache->active = true;
+        }
         if (regs.tctl.en() && !oldtctl.en()) {
-            txDescCache.reset();
+            for (auto &cache : txDescCache)
+                cache->reset();
         }
+        restartClock();
         break;
       case REG_PBA:
         regs.pba.rxa(val);
@@ -567,9 +1070,6 @@ IGbE::write(PacketPtr pkt)
       case REG_TIPG:
         ; // We don't care, so don't store anything
         break;
-      case REG_IVAR0:
-        warn("Writing to IVAR0, ignoring...\n");
-        break;
       case REG_FCRTL:
         regs.fcrtl = val;
         break;
@@ -577,30 +1077,31 @@ IGbE::write(PacketPtr pkt)
         regs.fcrth = val;
         break;
       case REG_RDBAL:
-        regs.rdba.rdbal( val & ~mask(4));
-        rxDescCache.areaChanged();
+        qr.rdba.rdbal( val & ~mask(4));
+        rxDescCache[q]->areaChanged();
         break;
       case REG_RDBAH:
-        regs.rdba.rdbah(val);
-        rxDescCache.areaChanged();
+        qr.rdba.rdbah(val);
+        rxDescCache[q]->areaChanged();
         break;
       case REG_RDLEN:
-        regs.rdlen = val & ~mask(7);
-        rxDescCache.areaChanged();
+        qr.rdlen = val & ~mask(7);
+        rxDescCache[q]->areaChanged();
         break;
       case REG_SRRCTL:
-        regs.srrctl = val;
+        qr.srrctl = val;
         break;
       case REG_RDH:
-        regs.rdh = val;
-        rxDescCache.areaChanged();
+        qr.rdh = val;
+        rxDescCache[q]->areaChanged();
         break;
       case REG_RDT:
-        regs.rdt = val;
+        qr.rdt = val;
+        queuePolled(q);
         DPRINTF(EthernetSM, "RXS: RDT Updated.\n");
         if (drainState() == DrainState::Running) {
             DPRINTF(EthernetSM, "RXS: RDT Fetching Descriptors!\n");
-            rxDescCache.fetchDescriptors();
+            rxDescCache[q]->fetchDescriptors();
         } else {
             DPRINTF(EthernetSM, "RXS: RDT NOT Fetching Desc b/c draining!\n");
         }
@@ -612,23 +1113,23 @@ IGbE::write(PacketPtr pkt)
         regs.radv = val;
         break;
       case REG_RXDCTL:
-        regs.rxdctl = val;
+        qr.rxdctl = val;
         break;
       case REG_TDBAL:
-        regs.tdba.tdbal( val & ~mask(4));
-        txDescCache.areaChanged();
+        qr.tdba.tdbal( val & ~mask(4));
+        txDescCache[q]->areaChanged();
         break;
       case REG_TDBAH:
-        regs.tdba.tdbah(val);
-        txDescCache.areaChanged();
+        qr.tdba.tdbah(val);
+        txDescCache[q]->areaChanged();
         break;
       case REG_TDLEN:
-        regs.tdlen = val & ~mask(7);
-        txDescCache.areaChanged();
+        qr.tdlen = val & ~mask(7);
+        txDescCache[q]->areaChanged();
         break;
       case REG_TDH:
-        regs.tdh = val;
-        txDescCache.areaChanged();
+        qr.tdh = val;
+        txDescCache[q]->areaChanged();
         break;
       case REG_TXDCA_CTL:
         regs.txdca_ctl = val;
@@ -636,11 +1137,12 @@ IGbE::write(PacketPtr pkt)
             panic("No support for DCA\n");
         break;
       case REG_TDT:
-        regs.tdt = val;
+        qr.tdt = val;
+        queuePolled(q);
         DPRINTF(EthernetSM, "TXS: TX Tail pointer updated\n");
         if (drainState() == DrainState::Running) {
             DPRINTF(EthernetSM, "TXS: TDT Fetching Descriptors!\n");
-            txDescCache.fetchDescriptors();
+            txDescCache[q]->fetchDescriptors();
         } else {
             DPRINTF(EthernetSM, "TXS: TDT NOT Fetching Desc b/c draining!\n");
         }
@@ -649,22 +1151,22 @@ IGbE::write(PacketPtr pkt)
         regs.tidv = val;
         break;
       case REG_TXDCTL:
-        regs.txdctl = val;
+        qr.txdctl = val;
         break;
       case REG_TADV:
         regs.tadv = val;
         break;
       case REG_TDWBAL:
-        regs.tdwba &= ~mask(32);
-        regs.tdwba |= val;
-        txDescCache.completionWriteback(regs.tdwba & ~mask(1),
-                                        regs.tdwba & mask(1));
+        qr.tdwba &= ~mask(32);
+        qr.tdwba |= val;
+        txDescCache[q]->completionWriteback(qr.tdwba & ~mask(1),
+                                        qr.tdwba & mask(1));
         break;
       case REG_TDWBAH:
-        regs.tdwba &= mask(32);
-        regs.tdwba |= (uint64_t)val << 32;
-        txDescCache.completionWriteback(regs.tdwba & ~mask(1),
-                                        regs.tdwba & mask(1));
+        qr.tdwba &= mask(32);
+        qr.tdwba |= (uint64_t)val << 32;
+        txDescCache[q]->completionWriteback(qr.tdwba & ~mask(1),
+                                        qr.tdwba & mask(1));
         break;
       case REG_RXCSUM:
         regs.rxcsum = val;
@@ -689,12 +1191,22 @@ IGbE::write(PacketPtr pkt)
         regs.sw_fw_sync = val;
         break;
       default:
-        if (!IN_RANGE(daddr, REG_VFTA, VLAN_FILTER_TABLE_SIZE*4) &&
+        if (IN_RANGE(daddr, REG_RETA, RETA_SIZE))
+            writeTableReg(regs.reta, daddr - REG_RETA, val);
+        else if (IN_RANGE(daddr, REG_RSSRK, RSS_KEY_SIZE))
+            writeTableReg(regs.rssrk, daddr - REG_RSSRK, val);
+        else if (IN_RANGE(daddr, REG_IVAR0, IVAR_REGS*4))
+            regs.ivar[(daddr - REG_IVAR0) / 4] = val;
+        else if (!IN_RANGE(daddr, REG_VFTA, VLAN_FILTER_TABLE_SIZE*4) &&
             !IN_RANGE(daddr, REG_RAL, RCV_ADDRESS_TABLE_SIZE*8) &&
             !IN_RANGE(daddr, REG_MTA, MULTICAST_TABLE_SIZE*4))
             panic("Write request to unknown register number: %#x\n", daddr);
     };
 
+    // A register write may have given a skipped tick something to do
+    if (idleTickPending())
+        restartClock();
+
     pkt->makeAtomicResponse();
     return pioDelay;
 }
@@ -709,7 +1221,12 @@ IGbE::postInterrupt(IntTypes t, bool now)
         return;
 
     regs.icr = regs.icr() | t;
+    scheduleInterrupt(now);
+}
 
+void
+IGbE::scheduleInterrupt(bool now)
+{
     Tick itr_interval = sim_clock::as_int::ns * 256 * regs.itr.interval();
     DPRINTF(EthernetIntr,
             "EINT: postInterrupt() curTick(): %d itr: %d interval: %d\n",
@@ -732,6 +1249,61 @@ IGbE::postInterrupt(IntTypes t, bool now)
     }
 }
 
+void
+IGbE::postQueueInterrupt(IntTypes t, unsigned q, bool tx)
+{
+    if (tx)
+        igbeStats.txQueueInterrupts[q]++;
+    else
+        igbeStats.rxQueueInterrupts[q]++;
+
+    queueIntPending |= 1 << q;
+
+    // A VF only has its extended cause register, the legacy causes
+    // belong to the PF
+    int vf = queueVf(q);
+    if (vf != VfSwitch::Pf) {
+        int vector = vfQueueVector(vf, q - vfFirstQueue(vf), tx);
+        if (vector < 0)
+            return;
+        vfRegs[vf].eicr |= 1 << vector;
+        scheduleInterrupt(false);
+        return;
+    }
+
+    int vector = queueVector(q, tx);
+    if (vector >= 0)
+        regs.eicr |= 1 << vector;
+
+    // Without an MSI-X table all vectors share the interrupt line, the
+    // driver tells them apart through EICR
+    postInterrupt(t);
+}
+
+int
+IGbE::queueVector(unsigned q, bool tx) const
+{
+    // Each IVAR register holds the RX and TX entries of queue n in its
+    // low half and of queue n + 8 in its high half
+    unsigned shift = (q < IVAR_REGS ? 0 : 16) + (tx ? 8 : 0);
+    uint8_t entry = regs.ivar[q % IVAR_REGS] >> shift;
+    if (!(entry & IVAR_VALID))
+        return -1;
+    int vector = entry & mask(5);
+    return vector < MAX_VECTORS ? vector : -1;
+}
+
+int
+IGbE::vfQueueVector(unsigned vf, unsigned q, bool tx) const
+{
+    unsigned shift = q * 16 + (tx ? 8 : 0);
+    uint8_t entry = vfRegs[vf].ivar >> shift;
+    if (!(entry & IVAR_VALID))
+        return -1;
+    int vector = entry & mask(2);
+    return vector < MAX_VF_VECTORS ? vector : -1;
+}
+
 void
 IGbE::delayIntEvent()
 {
@@ -749,7 +1321,7 @@ IGbE::cpuPostInt()
 
     etherDeviceStats.postedInterrupts++;
 
-    if (!(regs.icr() & regs.imr)) {
+    if (!intPending()) {
         DPRINTF(Ethernet, "Interrupt Masked. Not Posting\n");
         return;
     }
@@ -785,6 +1357,44 @@ IGbE::cpuPostInt()
     intrPost();
 
     lastInterrupt = curTick();
+    interruptDelivered();
+}
+
+void
+IGbE::interruptDelivered()
+{
+    for (unsigned q = 0; q < numQueues; q++) {
+        if (!(queueIntPending & (1 << q)))
+            continue;
+        igbeStats.queueInterrupts[q]++;
+        if (!queueIntTick[q])
+            queueIntTick[q] = curTick();
+    }
+    queueIntPending = 0;
+
+    if (!adaptiveItr)
+        return;
+
+    unsigned rate = itrModel.update(itrRxPackets, itrRxBytes,
+                                    itrTxPackets, itrTxBytes);
+    itrRxPackets = itrRxBytes = itrTxPackets = itrTxBytes = 0;
+
+    const uint32_t interval = itrInterval(rate);
+    if (interval == regs.itr.interval())
+        return;
+    regs.itr.interval(interval);
+    igbeStats.itrUpdates++;
+    DPRINTF(EthernetIntr, "EINT: Adaptive ITR now %d interrupts/s, "
+            "interval %d\n", rate, regs.itr.interval());
+}
+
+void
+IGbE::queuePolled(unsigned q)
+{
+    if (queueIntTick[q]) {
+        igbeStats.intPollLatency[q].sample(curTick() - queueIntTick[q]);
+        queueIntTick[q] = 0;
+    }
 }
 
 void
@@ -805,7 +1415,7 @@ IGbE::chkInterrupt()
     DPRINTF(Ethernet, "Checking interrupts icr: %#x imr: %#x\n", regs.icr(),
             regs.imr);
     // Check if we need to clear the cpu interrupt
-    if (!(regs.icr() & regs.imr)) {
+    if (!intPending()) {
         DPRINTF(Ethernet, "Mask cleaned all interrupts\n");
         if (interEvent.scheduled())
             deschedule(interEvent);
@@ -815,7 +1425,7 @@ IGbE::chkInterrupt()
     DPRINTF(Ethernet, "ITR = %#X itr.interval = %#X\n",
             regs.itr(), regs.itr.interval());
 
-    if (regs.icr() & regs.imr) {
+    if (intPending()) {
         if (regs.itr.interval() == 0)  {
             cpuPostInt();
         } else {
@@ -835,10 +1445,14 @@ IGbE::chkInterrupt()
 ///////////////////////////// IGbE::DescCache //////////////////////////////
 
 template<class T>
-IGbE::DescCache<T>::DescCache(IGbE *i, const std::string n, int s)
-    : igbe(i), _name(n), cachePnt(0), size(s), curFetching(0),
-      wbOut(0), moreToWb(false), wbAlignment(0), pktPtr(NULL),
+IGbE::DescCache<T>::DescCache(IGbE *i, const std::string n, int s,
+                              unsigned q, int a)
+    : igbe(i), _name(n), queue(q), adq(a), cachePnt(0), size(s),
+      curFetching(0),
+      wbOut(0), wbBatch(i->descBatching, i->descWbThreshold), pktPtr(NULL),
+      fetchDmas(nullptr), wbDmas(nullptr),
       wbDelayEvent([this]{ writeback1(); }, n),
+      wbTimeoutEvent([this]{ wbTimeout(); }, n),
       fetchDelayEvent([this]{ fetchDescriptors1(); }, n),
       fetchEvent([this]{ fetchComplete(); }, n),
       wbEvent([this]{ wbComplete(); }, n)
@@ -868,24 +1482,42 @@ IGbE::DescCache<T>::areaChanged()
 template<class T>
 void
 IGbE::DescCache<T>::writeback(Addr aMask)
+{
+    if (!wbOut && !wbBatch.issue(usedCache.size(), aMask, lineMask())) {
+        DPRINTF(EthernetDesc, "Coalescing writeback of %d descriptors\n",
+                usedCache.size());
+        if (usedCache.size() && !wbTimeoutEvent.scheduled())
+            igbe->schedule(wbTimeoutEvent, curTick() + igbe->descWbTimeout);
+        return;
+    }
+    issueWriteback(aMask);
+}
+
+template<class T>
+void
+IGbE::DescCache<T>::wbTimeout()
+{
+    DPRINTF(EthernetDesc, "Coalesced writeback timed out\n");
+    issueWriteback(0, true);
+}
+
+template<class T>
+void
+IGbE::DescCache<T>::issueWriteback(Addr aMask, bool timed_out)
 {
     int curHead = descHead();
     int max_to_wb = usedCache.size();
 
-    // Check if this writeback is less restrictive that the previous
-    // and if so setup another one immediately following it
+    // Check if this writeback is less restrictive that the previous, or
+    // timed out, and if so setup another one immediately following it
     if (wbOut) {
-        if (aMask < wbAlignment) {
-            moreToWb = true;
-            wbAlignment = aMask;
-        }
+        wbBatch.defer(aMask, timed_out);
         DPRINTF(EthernetDesc,
                 "Writing back already in process, returning\n");
         return;
     }
 
-    moreToWb = false;
-    wbAlignment = aMask;
+    wbBatch.start(aMask);
 
 
     DPRINTF(EthernetDesc, "Writing back descriptors head: %d tail: "
@@ -895,11 +1527,11 @@ IGbE::DescCache<T>::writeback(Addr aMask)
 
     if (max_to_wb + curHead >= descLen()) {
         max_to_wb = descLen() - curHead;
-        moreToWb = true;
+        wbBatch.wrapped();
         // this is by definition aligned correctly
-    } else if (wbAlignment != 0) {
+    } else if (wbBatch.alignment() != 0) {
         // align the wb point to the mask
-        max_to_wb = max_to_wb & ~wbAlignment;
+        max_to_wb = max_to_wb & ~wbBatch.alignment();
     }
 
     DPRINTF(EthernetDesc, "Writing back %d descriptors\n", max_to_wb);
@@ -909,6 +1541,11 @@ IGbE::DescCache<T>::writeback(Addr aMask)
 
     wbOut = max_to_wb;
 
+    // Everything waiting is going out, a new timeout starts with the next
+    // used descriptor
+    if (wbOut == int(usedCache.size()) && wbTimeoutEvent.scheduled())
+        igbe->deschedule(wbTimeoutEvent);
+
     assert(!wbDelayEvent.scheduled());
     igbe->schedule(wbDelayEvent, curTick() + igbe->wbDelay);
 }
@@ -933,14 +1570,16 @@ IGbE::DescCache<T>::writeback1()
 
 
     assert(wbOut);
+    (*wbDmas)[queue]++;
 
     // SHIN. Change to IDIO
     // igbe->dmaWrite(pciToDma(descBase() + descHead() * sizeof(T)),
     //                wbOut * sizeof(T), &wbEvent, (uint8_t*)wbBuf,
     //                igbe->wbCompDelay);
-    igbe->IdioWrite(pciToDma(descBase() + descHead() * sizeof(T)),
-                    wbOut * sizeof(T), &wbEvent, (uint8_t*)wbBuf,
-                    igbe->wbCompDelay, 0, igbe->adq);
+    igbe->placeWrite(DdioPlacement::Descriptor, queue, adq,
+                     pciToDma(descBase() + descHead() * sizeof(T)),
+                     wbOut * sizeof(T), &wbEvent, (uint8_t*)wbBuf,
+                     igbe->wbCompDelay);
 }
 
 template<class T>
@@ -968,6 +1607,12 @@ IGbE::DescCache<T>::fetchDescriptors()
 
     max_to_fetch = std::min(max_to_fetch, free_cache);
 
+    // End the burst on a cache line boundary if there is one in reach
+    if (igbe->descBatching) {
+        size_t end = (cachePnt + max_to_fetch) & ~lineMask();
+        if (end > cachePnt)
+            max_to_fetch = end - cachePnt;
+    }
 
     DPRINTF(EthernetDesc, "Fetching descriptors head: %d tail: "
             "%d len: %d cachePnt: %d max_to_fetch: %d descleft: %d\n",
@@ -1003,6 +1648,7 @@ IGbE::DescCache<T>::fetchDescriptors1()
             pciToDma(descBase() + cachePnt * sizeof(T)),
             curFetching * sizeof(T));
     assert(curFetching);
+    (*fetchDmas)[queue]++;
     igbe->dmaRead(pciToDma(descBase() + cachePnt * sizeof(T)),
                   curFetching * sizeof(T), &fetchEvent, (uint8_t*)fetchBuf,
                   igbe->fetchCompDelay);
@@ -1064,10 +1710,10 @@ IGbE::DescCache<T>::wbComplete()
 
     // If we still have more to wb, call wb now
     actionAfterWb();
-    if (moreToWb) {
-        moreToWb = false;
+    // The writeback to follow is not held back again
+    if (wbBatch.moreToWb()) {
         DPRINTF(EthernetDesc, "Writeback has more todo\n");
-        writeback(wbAlignment);
+        writeback(wbBatch.alignment());
     }
 
     if (!wbOut)
@@ -1090,6 +1736,9 @@ IGbE::DescCache<T>::reset()
 
     cachePnt = 0;
 
+    if (wbTimeoutEvent.scheduled())
+        igbe->deschedule(wbTimeoutEvent);
+
 }
 
 template<class T>
@@ -1099,6 +1748,8 @@ IGbE::DescCache<T>::serialize(CheckpointOut &cp) const
     SERIALIZE_SCALAR(cachePnt);
     SERIALIZE_SCALAR(curFetching);
     SERIALIZE_SCALAR(wbOut);
+    bool moreToWb = wbBatch.moreToWb();
+    Addr wbAlignment = wbBatch.alignment();
     SERIALIZE_SCALAR(moreToWb);
     SERIALIZE_SCALAR(wbAlignment);
 
@@ -1123,6 +1774,10 @@ IGbE::DescCache<T>::serialize(CheckpointOut &cp) const
     if (wbDelayEvent.scheduled())
         wb_delay = wbDelayEvent.when();
     SERIALIZE_SCALAR(wb_delay);
+    Tick wb_timeout = 0;
+    if (wbTimeoutEvent.scheduled())
+        wb_timeout = wbTimeoutEvent.when();
+    SERIALIZE_SCALAR(wb_timeout);
 
 
 }
@@ -1134,8 +1789,11 @@ IGbE::DescCache<T>::unserialize(CheckpointIn &cp)
     UNSERIALIZE_SCALAR(cachePnt);
     UNSERIALIZE_SCALAR(curFetching);
     UNSERIALIZE_SCALAR(wbOut);
+    bool moreToWb;
+    Addr wbAlignment;
     UNSERIALIZE_SCALAR(moreToWb);
     UNSERIALIZE_SCALAR(wbAlignment);
+    wbBatch.restore(moreToWb, wbAlignment);
 
     typename CacheType::size_type usedCacheSize;
     UNSERIALIZE_SCALAR(usedCacheSize);
@@ -1162,19 +1820,24 @@ IGbE::DescCache<T>::unserialize(CheckpointIn &cp)
         igbe->schedule(fetchDelayEvent, fetch_delay);
     if (wb_delay)
         igbe->schedule(wbDelayEvent, wb_delay);
+    Tick wb_timeout = 0;
+    UNSERIALIZE_OPT_SCALAR(wb_timeout);
+    if (wb_timeout)
+        igbe->schedule(wbTimeoutEvent, wb_timeout);
 
 
 }
 
 ///////////////////////////// IGbE::RxDescCache //////////////////////////////
 
-IGbE::RxDescCache::RxDescCache(IGbE *i, const std::string n, int s)
-    : DescCache<RxDesc>(i, n, s), pktDone(false), splitCount(0),
-    pktEvent([this]{ pktComplete(); }, n),
-    pktHdrEvent([this]{ pktSplitDone(); }, n),
-    pktDataEvent([this]{ pktSplitDone(); }, n)
+IGbE::RxDescCache::RxDescCache(IGbE *i, const std::string n, int s,
+                               unsigned q, int a)
+    : DescCache<RxDesc>(i, n, s, q, a), pktDone(false),
+    pktEvent([this]{ pktComplete(); }, n)
 
 {
+    fetchDmas = &igbe->igbeStats.rxDescFetchDmas;
+    wbDmas = &igbe->igbeStats.rxDescWbDmas;
     annSmFetch = "RX Desc Fetch";
     annSmWb = "RX Desc Writeback";
     annUnusedDescQ = "RX Unused Descriptors";
@@ -1184,21 +1847,6 @@ IGbE::RxDescCache::RxDescCache(IGbE *i, const std::string n, int s)
     annDescQ = "RX Descriptors";
 }
 
-void
-IGbE::RxDescCache::pktSplitDone()
-{
-    splitCount++;
-    DPRINTF(EthernetDesc,
-            "Part of split packet done: splitcount now %d\n", splitCount);
-    assert(splitCount <= 2);
-    if (splitCount != 2)
-        return;
-    splitCount = 0;
-    DPRINTF(EthernetDesc,
-            "Part of split packet done: calling pktComplete()\n");
-    pktComplete();
-}
-
 int
 IGbE::RxDescCache::writePacket(EthPacketPtr packet, int pkt_offset)
 {
@@ -1211,7 +1859,7 @@ IGbE::RxDescCache::writePacket(EthPacketPtr packet, int pkt_offset)
     unsigned buf_len, hdr_len;
 
     RxDesc *desc = unusedCache.front();
-    switch (igbe->regs.srrctl.desctype()) {
+    switch (qregs().srrctl.desctype()) {
       case RXDT_LEGACY:
         assert(pkt_offset == 0);
         bytesCopied = packet->length;
@@ -1227,18 +1875,38 @@ IGbE::RxDescCache::writePacket(EthPacketPtr packet, int pkt_offset)
       case RXDT_ADV_ONEBUF:
         assert(pkt_offset == 0);
         bytesCopied = packet->length;
-        buf_len = igbe->regs.rctl.lpe() ? igbe->regs.srrctl.bufLen() :
+        buf_len = igbe->regs.rctl.lpe() ? qregs().srrctl.bufLen() :
             igbe->regs.rctl.descSize();
         DPRINTF(EthernetDesc, "Packet Length: %d srrctl: %#x Desc Size: %d\n",
-                packet->length, igbe->regs.srrctl(), buf_len);
+                packet->length, qregs().srrctl(), buf_len);
         assert(packet->length < buf_len);
-        // SHIN. Change to IDIO
-        // igbe->dmaWrite(pciToDma(desc->adv_read.pkt),
-        //                packet->length, &pktEvent, packet->data,
-        //                igbe->rxWriteDelay);
-        igbe->IdioWrite(pciToDma(desc->adv_read.pkt),
-                       packet->length, &pktEvent, packet->data,
-                       igbe->rxWriteDelay, 0, igbe->adq);
+        if (igbe->ddioPlacement.empty()) {
+            // Without placement policies the frame goes out in one write
+            // straight from the packet, its first line marked as header
+            igbe->placeWrite(DdioPlacement::Payload, queue, adq,
+                             pciToDma(desc->adv_read.pkt), packet->length,
+                             &pktEvent, packet->data, igbe->rxWriteDelay);
+        } else {
+            // The lines holding the protocol headers are placed as the
+            // header, the first line of a packet that does not decode
+            const Addr buf = pciToDma(desc->adv_read.pkt);
+            const Addr line_size = igbe->sys->cacheLineSize();
+            const int hdr = std::max(hsplit(pktPtr), 1);
+            const int hdr_bytes = std::min<int>(packet->length,
+                roundUp(buf + hdr, line_size) - buf);
+
+            std::vector<DdioPlacement::Segment> kinds =
+                {DdioPlacement::Header};
+            std::vector<DmaSegment> segs = {{buf, hdr_bytes, packet->data}};
+            if (hdr_bytes < packet->length) {
+                kinds.push_back(DdioPlacement::Payload);
+                segs.push_back({buf + hdr_bytes,
+                                int(packet->length) - hdr_bytes,
+                                packet->data + hdr_bytes});
+            }
+            igbe->placeWriteSg(kinds, queue, adq, segs, &pktEvent,
+                               igbe->rxWriteDelay);
+        }
 
         desc->adv_wb.header_len = htole(0);
         desc->adv_wb.sph = htole(0);
@@ -1247,14 +1915,14 @@ IGbE::RxDescCache::writePacket(EthPacketPtr packet, int pkt_offset)
       case RXDT_ADV_SPLIT_A:
         int split_point;
 
-        buf_len = igbe->regs.rctl.lpe() ? igbe->regs.srrctl.bufLen() :
+        buf_len = igbe->regs.rctl.lpe() ? qregs().srrctl.bufLen() :
             igbe->regs.rctl.descSize();
-        hdr_len = igbe->regs.rctl.lpe() ? igbe->regs.srrctl.hdrLen() : 0;
+        hdr_len = igbe->regs.rctl.lpe() ? qregs().srrctl.hdrLen() : 0;
         DPRINTF(EthernetDesc,
                 "lpe: %d Packet Length: %d offset: %d srrctl: %#x "
                 "hdr addr: %#x Hdr Size: %d desc addr: %#x Desc Size: %d\n",
                 igbe->regs.rctl.lpe(), packet->length, pkt_offset,
-                igbe->regs.srrctl(), desc->adv_read.hdr, hdr_len,
+                qregs().srrctl(), desc->adv_read.hdr, hdr_len,
                 desc->adv_read.pkt, buf_len);
 
         split_point = hsplit(pktPtr);
@@ -1267,9 +1935,10 @@ IGbE::RxDescCache::writePacket(EthPacketPtr packet, int pkt_offset)
             // igbe->dmaWrite(pciToDma(desc->adv_read.hdr),
             //                packet->length, &pktEvent, packet->data,
             //                igbe->rxWriteDelay);
-            igbe->IdioWrite(pciToDma(desc->adv_read.hdr),
-                           packet->length, &pktEvent, packet->data,
-                           igbe->rxWriteDelay, 0, igbe->adq);
+            igbe->placeWrite(DdioPlacement::Header, queue, adq,
+                             pciToDma(desc->adv_read.hdr),
+                             packet->length, &pktEvent, packet->data,
+                             igbe->rxWriteDelay);
 
             desc->adv_wb.header_len = htole((uint16_t)packet->length);
             desc->adv_wb.sph = htole(0);
@@ -1289,10 +1958,11 @@ IGbE::RxDescCache::writePacket(EthPacketPtr packet, int pkt_offset)
                 //                max_to_copy, &pktEvent,
                 //                packet->data + pkt_offset, igbe->rxWriteDelay);
 
-                igbe->IdioWrite(pciToDma(desc->adv_read.pkt),
-                               max_to_copy, &pktEvent,
-                               packet->data + pkt_offset, igbe->rxWriteDelay,
-                               0, igbe->adq);
+                igbe->placeWrite(DdioPlacement::Payload, queue, adq,
+                                 pciToDma(desc->adv_read.pkt),
+                                 max_to_copy, &pktEvent,
+                                 packet->data + pkt_offset,
+                                 igbe->rxWriteDelay);
 
                 desc->adv_wb.header_len = htole(0);
                 desc->adv_wb.pkt_len = htole((uint16_t)max_to_copy);
@@ -1304,21 +1974,21 @@ IGbE::RxDescCache::writePacket(EthPacketPtr packet, int pkt_offset)
 
                 DPRINTF(EthernetDesc, "Hdr split: splitting at %d\n",
                         split_point);
-                // SHIN
-                // igbe->dmaWrite(pciToDma(desc->adv_read.hdr),
-                //                split_point, &pktHdrEvent,
-                //                packet->data, igbe->rxWriteDelay);
-                // igbe->dmaWrite(pciToDma(desc->adv_read.pkt),
-                //                max_to_copy, &pktDataEvent,
-                //                packet->data + split_point, igbe->rxWriteDelay);
-                igbe->IdioWrite(pciToDma(desc->adv_read.hdr),
-                               split_point, &pktHdrEvent,
-                               packet->data, igbe->rxWriteDelay,
-                               0, igbe->adq);
-                igbe->IdioWrite(pciToDma(desc->adv_read.pkt),
-                               max_to_copy, &pktDataEvent,
-                               packet->data + split_point, igbe->rxWriteDelay,
-                               0, igbe->adq);
+                // Header and data go out as one transfer that completes
+                // once both are written
+                std::vector<DdioPlacement::Segment> kinds =
+                    {DdioPlacement::Header};
+                std::vector<DmaSegment> segs =
+                    {{pciToDma(desc->adv_read.hdr), split_point,
+                      packet->data}};
+                if (max_to_copy) {
+                    kinds.push_back(DdioPlacement::Payload);
+                    segs.push_back({pciToDma(desc->adv_read.pkt),
+                                    max_to_copy,
+                                    packet->data + split_point});
+                }
+                igbe->placeWriteSg(kinds, queue, adq, segs, &pktEvent,
+                                   igbe->rxWriteDelay);
                 desc->adv_wb.header_len = htole(split_point);
                 desc->adv_wb.sph = 1;
                 desc->adv_wb.pkt_len = htole((uint16_t)(max_to_copy));
@@ -1330,7 +2000,7 @@ IGbE::RxDescCache::writePacket(EthPacketPtr packet, int pkt_offset)
         break;
       default:
         panic("Unimplemnted RX receive buffer type: %d\n",
-              igbe->regs.srrctl.desctype());
+              qregs().srrctl.desctype());
     }
     return bytesCopied;
 
@@ -1422,7 +2092,7 @@ IGbE::RxDescCache::pktComplete()
         DPRINTF(EthernetSM, "Proccesing Non-Ip packet\n");
     }
 
-    switch (igbe->regs.srrctl.desctype()) {
+    switch (qregs().srrctl.desctype()) {
       case RXDT_LEGACY:
         desc->legacy.len = htole((uint16_t)(pktPtr->length + crcfixup));
         desc->legacy.status = htole(status);
@@ -1432,11 +2102,10 @@ IGbE::RxDescCache::pktComplete()
         break;
       case RXDT_ADV_SPLIT_A:
       case RXDT_ADV_ONEBUF:
-        desc->adv_wb.rss_type = htole(0);
+        desc->adv_wb.rss_type = htole(igbe->rxRssType);
         desc->adv_wb.pkt_type = htole(ptype);
         if (igbe->regs.rxcsum.pcsd()) {
-            // no rss support right now
-            desc->adv_wb.rss_hash = htole(0);
+            desc->adv_wb.rss_hash = htole(igbe->rxRssHash);
         } else {
             desc->adv_wb.id = htole(ip_id);
             desc->adv_wb.csum = htole(csum);
@@ -1448,7 +2117,7 @@ IGbE::RxDescCache::pktComplete()
         break;
       default:
         panic("Unimplemnted RX receive buffer type %d\n",
-              igbe->regs.srrctl.desctype());
+              qregs().srrctl.desctype());
     }
 
     DPRINTF(EthernetDesc, "Descriptor complete w0: %#x w1: %#x\n",
@@ -1478,7 +2147,7 @@ IGbE::RxDescCache::pktComplete()
         if (!igbe->regs.rdtr.delay() && !igbe->regs.radv.idv()) {
             DPRINTF(EthernetSM,
                     "RXS: Receive interrupt delay disabled, posting IT_RXT\n");
-            igbe->postInterrupt(IT_RXT);
+            igbe->postQueueInterrupt(IT_RXT, queue, false);
         }
 
         // If the packet is small enough, interrupt appropriately
@@ -1486,15 +2155,15 @@ IGbE::RxDescCache::pktComplete()
         if (pktPtr->length <= igbe->regs.rsrpd.idv()) {
             DPRINTF(EthernetSM,
                     "RXS: Posting IT_SRPD beacuse small packet received\n");
-            igbe->postInterrupt(IT_SRPD);
+            igbe->postQueueInterrupt(IT_SRPD, queue, false);
         }
         bytesCopied = 0;
     }
 
     pktPtr = NULL;
+    pktDone = true;
     igbe->checkDrain();
     enableSm();
-    pktDone = true;
 
     DPRINTF(EthernetDesc, "Processing of this descriptor complete\n");
     DPRINTF(EthernetDpdk, "Processing of this descriptor complete\n");
@@ -1525,8 +2194,7 @@ bool
 IGbE::RxDescCache::hasOutstandingEvents()
 {
     return pktEvent.scheduled() || wbEvent.scheduled() ||
-        fetchEvent.scheduled() || pktHdrEvent.scheduled() ||
-        pktDataEvent.scheduled();
+        fetchEvent.scheduled();
 
 }
 
@@ -1535,7 +2203,6 @@ IGbE::RxDescCache::serialize(CheckpointOut &cp) const
 {
     DescCache<RxDesc>::serialize(cp);
     SERIALIZE_SCALAR(pktDone);
-    SERIALIZE_SCALAR(splitCount);
     SERIALIZE_SCALAR(bytesCopied);
 }
 
@@ -1544,24 +2211,27 @@ IGbE::RxDescCache::unserialize(CheckpointIn &cp)
 {
     DescCache<RxDesc>::unserialize(cp);
     UNSERIALIZE_SCALAR(pktDone);
-    UNSERIALIZE_SCALAR(splitCount);
     UNSERIALIZE_SCALAR(bytesCopied);
 }
 
 
 ///////////////////////////// IGbE::TxDescCache //////////////////////////////
 
-IGbE::TxDescCache::TxDescCache(IGbE *i, const std::string n, int s)
-    : DescCache<TxDesc>(i,n, s), pktDone(false), isTcp(false),
+IGbE::TxDescCache::TxDescCache(IGbE *i, const std::string n, int s,
+                               unsigned q, int a)
+    : DescCache<TxDesc>(i, n, s, q, a), pktDone(false), isTcp(false),
       pktWaiting(false), pktMultiDesc(false),
       completionAddress(0), completionEnabled(false),
       useTso(false), tsoHeaderLen(0), tsoMss(0), tsoTotalLen(0), tsoUsedLen(0),
       tsoPrevSeq(0), tsoPktPayloadBytes(0), tsoLoadedHeader(false),
       tsoPktHasHeader(false), tsoDescBytesUsed(0), tsoCopyBytes(0), tsoPkts(0),
+      active(false),
     pktEvent([this]{ pktComplete(); }, n),
     headerEvent([this]{ headerComplete(); }, n),
     nullEvent([this]{ nullCallback(); }, n)
 {
+    fetchDmas = &igbe->igbeStats.txDescFetchDmas;
+    wbDmas = &igbe->igbeStats.txDescWbDmas;
     annSmFetch = "TX Desc Fetch";
     annSmWb = "TX Desc Writeback";
     annUnusedDescQ = "TX Unused Descriptors";
@@ -1942,14 +2612,14 @@ IGbE::TxDescCache::pktComplete()
     pktPtr = NULL;
     tsoPktHasHeader = false;
 
-    if (igbe->regs.txdctl.wthresh() == 0) {
+    if (qregs().txdctl.wthresh() == 0) {
         DPRINTF(EthernetDesc, "WTHRESH == 0, writing back descriptor\n");
         writeback(0);
-    } else if (!igbe->regs.txdctl.gran() && igbe->regs.txdctl.wthresh() <=
+    } else if (!qregs().txdctl.gran() && qregs().txdctl.wthresh() <=
                descInBlock(usedCache.size())) {
         DPRINTF(EthernetDesc, "used > WTHRESH, writing back descriptor\n");
         writeback((igbe->cacheBlockSize()-1)>>4);
-    } else if (igbe->regs.txdctl.wthresh() <= usedCache.size()) {
+    } else if (qregs().txdctl.wthresh() <= usedCache.size()) {
         DPRINTF(EthernetDesc, "used > WTHRESH, writing back descriptor\n");
         writeback((igbe->cacheBlockSize()-1)>>4);
     }
@@ -1963,17 +2633,18 @@ IGbE::TxDescCache::actionAfterWb()
 {
     DPRINTF(EthernetDesc, "actionAfterWb() completionEnabled: %d\n",
             completionEnabled);
-    igbe->postInterrupt(igbreg::IT_TXDW);
+    igbe->postQueueInterrupt(igbreg::IT_TXDW, queue, true);
     if (completionEnabled) {
-        descEnd = igbe->regs.tdh();
+        descEnd = qregs().tdh();
         DPRINTF(EthernetDesc,
                 "Completion writing back value: %d to addr: %#x\n", descEnd,
                 completionAddress);
         // SHIN.
         // igbe->dmaWrite(pciToDma(mbits(completionAddress, 63, 2)),
         //                sizeof(descEnd), &nullEvent, (uint8_t*)&descEnd, 0);
-        igbe->IdioWrite(pciToDma(mbits(completionAddress, 63, 2)),
-                       sizeof(descEnd), &nullEvent, (uint8_t*)&descEnd, 0, 0, igbe->adq);
+        igbe->placeWrite(DdioPlacement::Descriptor, queue, adq,
+                         pciToDma(mbits(completionAddress, 63, 2)),
+                         sizeof(descEnd), &nullEvent, (uint8_t*)&descEnd, 0);
     }
 }
 
@@ -2049,6 +2720,7 @@ void
 IGbE::TxDescCache::enableSm()
 {
     if (igbe->drainState() != DrainState::Draining) {
+        active = true;
         igbe->txTick = true;
         igbe->restartClock();
     }
@@ -2064,26 +2736,223 @@ IGbE::TxDescCache::hasOutstandingEvents()
 
 ///////////////////////////////////// IGbE /////////////////////////////////
 
+IGbE::IGbEStats::IGbEStats(IGbE *igbe)
+    : statistics::Group(igbe, "IGbE"),
+      ADD_STAT(rxQueuePackets, statistics::units::Count::get(),
+               "Number of packets written to each receive queue"),
+      ADD_STAT(txQueuePackets, statistics::units::Count::get(),
+               "Number of packets sent from each transmit queue"),
+      ADD_STAT(rxQueueDrops, statistics::units::Count::get(),
+               "Number of packets dropped because a receive queue with "
+               "SRRCTL.DROP_EN set ran out of descriptors"),
+      ADD_STAT(rxQueueInterrupts, statistics::units::Count::get(),
+               "Number of interrupts posted by each receive queue"),
+      ADD_STAT(txQueueInterrupts, statistics::units::Count::get(),
+               "Number of interrupts posted by each transmit queue"),
+      ADD_STAT(rssHashed, statistics::units::Count::get(),
+               "Number of packets accepted into the RX FIFO that were "
+               "steered by their RSS hash"),
+      ADD_STAT(skippedTicks, statistics::units::Count::get(),
+               "Number of state machine ticks not scheduled because they "
+               "would have found nothing to do"),
+      ADD_STAT(rxDescFetchDmas, statistics::units::Count::get(),
+               "Number of DMA reads fetching receive descriptors"),
+      ADD_STAT(rxDescWbDmas, statistics::units::Count::get(),
+               "Number of DMA writes writing back receive descriptors"),
+      ADD_STAT(txDescFetchDmas, statistics::units::Count::get(),
+               "Number of DMA reads fetching transmit descriptors"),
+      ADD_STAT(txDescWbDmas, statistics::units::Count::get(),
+               "Number of DMA writes writing back transmit descriptors"),
+      ADD_STAT(queueInterrupts, statistics::units::Count::get(),
+               "Number of interrupts to the CPU carrying work of each "
+               "queue"),
+      ADD_STAT(queueInterruptRate, statistics::units::Rate<
+                    statistics::units::Count, statistics::units::Second>::get(),
+               "Interrupts per second of each queue",
+               queueInterrupts / simSeconds),
+      ADD_STAT(packetsPerInterrupt, statistics::units::Ratio::get(),
+               "Packets received and sent per interrupt of each queue",
+               (rxQueuePackets + txQueuePackets) / queueInterrupts),
+      ADD_STAT(intPollLatency, statistics::units::Tick::get(),
+               "Time from an interrupt to the driver returning buffers "
+               "of the queue"),
+      ADD_STAT(itrUpdates, statistics::units::Count::get(),
+               "Number of interrupt throttling changes by the adaptive ITR"),
+      ADD_STAT(dropStateResidency, statistics::units::Tick::get(),
+               "Time spent in each congestion state of the drop "
+               "classifier"),
+      ADD_STAT(ddioPlacedLines, statistics::units::Count::get(),
+               "Number of cache lines of each segment written under a "
+               "placement policy"),
+      ADD_STAT(ddioUntouchedLines, statistics::units::Count::get(),
+               "Number of placed lines rewritten, or left for longer than "
+               "the touch window, before any core touched them"),
+      ADD_STAT(ddioTouches, statistics::units::Count::get(),
+               "Number of placed lines first touched by a core, by where "
+               "the core found them"),
+      ADD_STAT(switchedPackets, statistics::units::Count::get(),
+               "Number of transmitted frames switched to one of our own "
+               "functions instead of the wire"),
+      ADD_STAT(switchedDrops, statistics::units::Count::get(),
+               "Number of frames between functions dropped on a full or "
+               "disabled receive side"),
+      igbe(igbe)
+{
+    for (auto *vec : {&rxQueuePackets, &txQueuePackets, &rxQueueDrops,
+                      &rxQueueInterrupts, &txQueueInterrupts,
+                      &rxDescFetchDmas, &rxDescWbDmas, &txDescFetchDmas,
+                      &txDescWbDmas, &queueInterrupts}) {
+        vec->init(igbe->numQueues);
+        for (unsigned q = 0; q < igbe->numQueues; q++)
+            vec->subname(q, igbe->queueName(q));
+    }
+
+    // Up to 100us in 1us buckets
+    intPollLatency.init(igbe->numQueues, 0, 100 * sim_clock::as_int::us,
+                        sim_clock::as_int::us);
+    for (unsigned q = 0; q < igbe->numQueues; q++) {
+        queueInterruptRate.subname(q, igbe->queueName(q));
+        packetsPerInterrupt.subname(q, igbe->queueName(q));
+        intPollLatency.subname(q, igbe->queueName(q));
+    }
+
+    dropStateResidency.init(DropClassifier::NumStates);
+    const char *drop_states[] = {
+        "clear", "txRingFull", "rxRingFull", "rxTxRingFull", "rxFifoFull",
+        "rxFifoTxRingFull", "rxFifoRxRingFull", "allFull"
+    };
+    for (unsigned i = 0; i < DropClassifier::NumStates; i++)
+        dropStateResidency.subname(i, drop_states[i]);
+
+    const auto &caches = igbe->params().ddio_touch_caches;
+    ddioPlacedLines.init(DdioPlacement::NumSegments);
+    ddioUntouchedLines.init(DdioPlacement::NumSegments);
+    ddioTouches.init(DdioPlacement::NumSegments, caches.size() + 1);
+    for (unsigned i = 0; i < DdioPlacement::NumSegments; i++) {
+        auto seg = DdioPlacement::segmentName(DdioPlacement::Segment(i));
+        ddioPlacedLines.subname(i, seg);
+        ddioUntouchedLines.subname(i, seg);
+        ddioTouches.subname(i, seg);
+    }
+    for (unsigned l = 0; l < caches.size(); l++)
+        ddioTouches.ysubname(l, caches[l]->name());
+    ddioTouches.ysubname(caches.size(), "memory");
+
+    // Skipping ticks must leave the other stats as they were, and without
+    // skipping this one does not show either
+    skippedTicks.flags(statistics::nozero);
+}
+
+void
+IGbE::IGbEStats::preDumpStats()
+{
+    statistics::Group::preDumpStats();
+    igbe->updateDropResidency();
+}
+
+void
+IGbE::IGbEStats::resetStats()
+{
+    statistics::Group::resetStats();
+    igbe->dropStateSince = curTick();
+}
+
 void
 IGbE::restartClock()
 {
-    if (!tickEvent.scheduled() && (rxTick || txTick || txFifoTick) &&
-        drainState() == DrainState::Running)
-        schedule(tickEvent, clockEdge(Cycles(1)));
+    if (tickEvent.scheduled() || drainState() != DrainState::Running)
+        return;
+
+    // A skipped tick that is still to come runs now that there may be
+    // something for it to do, with whatever it would have run anyway
+    const bool resumed = idleTickPending();
+    uint32_t tx_queues = 0;
+    const Tick when = idleTick.wake(curTick(), clockEdge(Cycles(1)),
+                                    rxTick, txTick, tx_queues);
+    for (unsigned q = 0; q < numQueues; q++) {
+        if (tx_queues & (1 << q))
+            txDescCache[q]->active = true;
+    }
+
+    if (!rxTick && !txTick && !txFifoTick)
+        return;
+
+    if (skipIdleTicks && !txFifoTick && rxIdle() && txIdle()) {
+        if (!resumed)
+            igbeStats.skippedTicks++;
+        skipTick(when);
+        return;
+    }
+    schedule(tickEvent, when);
+}
+
+bool
+IGbE::rxIdle()
+{
+    RxDescCache &cache = *rxDescCache[rxQueue];
+    return rxTickIdle({rxTick, bool(regs.rctl.en()), cache.packetReady(),
+                       rxDmaPacket, rxFifo.empty(),
+                       bool(cache.descUnused())});
+}
+
+bool
+IGbE::txIdle()
+{
+    if (!txTick || !regs.tctl.en())
+        return true;
+
+    // Every queue being served is only waiting on packet DMA
+    for (unsigned q = 0; q < numQueues; q++) {
+        TxDescCache &cache = *txDescCache[q];
+        if (!txQueueTickIdle({cache.active,
+                              bool(queueRegs[q].txdctl.lwthresh()),
+                              bool(txPacket[q]), cache.packetReady(),
+                              cache.packetWaiting()}))
+            return false;
+    }
+    return true;
+}
+
+void
+IGbE::skipTick(Tick when)
+{
+    DPRINTF(EthernetSM, "Nothing to do, skipping tick at %d\n", when);
+    uint32_t tx_queues = 0;
+    if (txTick && regs.tctl.en()) {
+        for (unsigned q = 0; q < numQueues; q++) {
+            if (txDescCache[q]->active)
+                tx_queues |= 1 << q;
+            txDescCache[q]->active = false;
+        }
+    }
+    idleTick.skip(when, rxTick, txTick, tx_queues);
+    rxTick = false;
+    txTick = false;
+}
+
+bool
+IGbE::hasOutstandingEvents()
+{
+    for (unsigned q = 0; q < numQueues; q++) {
+        if (rxDescCache[q]->hasOutstandingEvents() ||
+            txDescCache[q]->hasOutstandingEvents())
+            return true;
+    }
+    return false;
 }
 
 DrainState
 IGbE::drain()
 {
     unsigned int count(0);
-    if (rxDescCache.hasOutstandingEvents() ||
-        txDescCache.hasOutstandingEvents()) {
+    if (hasOutstandingEvents()) {
         count++;
     }
 
     txFifoTick = false;
     txTick = false;
     rxTick = false;
+    idleTick.clear();
 
     if (tickEvent.scheduled())
         deschedule(tickEvent);
@@ -2103,6 +2972,8 @@ IGbE::drainResume()
     txFifoTick = true;
     txTick = true;
     rxTick = true;
+    for (auto &cache : txDescCache)
+        cache->active = true;
 
     restartClock();
     DPRINTF(EthernetSM, "resuming from drain");
@@ -2117,8 +2988,8 @@ IGbE::checkDrain()
     txFifoTick = false;
     txTick = false;
     rxTick = false;
-    if (!rxDescCache.hasOutstandingEvents() &&
-        !txDescCache.hasOutstandingEvents()) {
+    idleTick.clear();
+    if (!hasOutstandingEvents()) {
         DPRINTF(Drain, "IGbE done draining, processing drain event\n");
         signalDrainDone();
     }
@@ -2134,80 +3005,108 @@ IGbE::txStateMachine()
         return;
     }
 
+    // Serve the queues round robin. A queue keeps the state machine while
+    // it is working on a packet and hands it on once the packet is in the
+    // FIFO or it has nothing left to do.
+    for (unsigned n = 0; n < numQueues; n++) {
+        unsigned q = txQueue;
+        bool sent = false;
+        if (txDescCache[q]->active) {
+            sent = txQueueStateMachine(q);
+            if (txDescCache[q]->active && !sent)
+                return;
+        }
+        txQueue = (txQueue + 1) % numQueues;
+        if (sent)
+            return;
+    }
+
+    txTick = false;
+}
+
+bool
+IGbE::txQueueStateMachine(unsigned q)
+{
+    TxDescCache &cache = *txDescCache[q];
+    EthPacketPtr &packet = txPacket[q];
+
     // If we have a packet available and it's length is not 0 (meaning it's not
     // a multidescriptor packet) put it in the fifo, otherwise an the next
     // iteration we'll get the rest of the data
-    if (txPacket && txDescCache.packetAvailable()
-        && !txDescCache.packetMultiDesc() && txPacket->length) {
+    if (packet && cache.packetAvailable()
+        && !cache.packetMultiDesc() && packet->length) {
         DPRINTF(EthernetSM, "TXS: packet placed in TX FIFO\n");
         DPRINTF(EthernetDpdk, "TXS: packet placed in TX FIFO\n");
 #ifndef NDEBUG
         bool success =
 #endif
-            txFifo.push(txPacket);
+            txFifo.push(packet);
         txFifoTick = true && drainState() != DrainState::Draining;
         assert(success);
-        txPacket = NULL;
-        txDescCache.writeback((cacheBlockSize()-1)>>4);
-        return;
+        itrTxPackets++;
+        itrTxBytes += packet->length;
+        packet = NULL;
+        igbeStats.txQueuePackets[q]++;
+        cache.writeback((cacheBlockSize()-1)>>4);
+        return true;
     }
 
     // Only support descriptor granularity
-    if (regs.txdctl.lwthresh() &&
-        txDescCache.descLeft() < (regs.txdctl.lwthresh() * 8)) {
+    if (queueRegs[q].txdctl.lwthresh() &&
+        cache.descLeft() < (queueRegs[q].txdctl.lwthresh() * 8)) {
         DPRINTF(EthernetSM, "TXS: LWTHRESH caused posting of TXDLOW\n");
-        postInterrupt(IT_TXDLOW);
+        postQueueInterrupt(IT_TXDLOW, q, true);
     }
 
-    if (!txPacket) {
-        txPacket = std::make_shared<EthPacketData>(16384);
+    if (!packet) {
+        packet = std::make_shared<EthPacketData>(16384);
     }
 
-    if (!txDescCache.packetWaiting()) {
-        if (txDescCache.descLeft() == 0) {
+    if (!cache.packetWaiting()) {
+        if (cache.descLeft() == 0) {
             etherDeviceStats.txRingBufferFull++;
-            postInterrupt(IT_TXQE);
-            txDescCache.writeback(0);
-            txDescCache.fetchDescriptors();
+            postQueueInterrupt(IT_TXQE, q, true);
+            cache.writeback(0);
+            cache.fetchDescriptors();
             DPRINTF(EthernetSM, "TXS: No descriptors left in ring, forcing "
                     "writeback stopping ticking and posting TXQE\n");
             DPRINTF(EthernetDpdk, "TXS: No descriptors left in ring, forcing "
                     "writeback stopping ticking and posting TXQE\n");
-            txTick = false;
-            return;
+            cache.active = false;
+            return false;
         }
 
 
-        if (!(txDescCache.descUnused())) {
-            txDescCache.fetchDescriptors();
+        if (!(cache.descUnused())) {
+            cache.fetchDescriptors();
             etherDeviceStats.txDescCacheFullCount++;
             DPRINTF(EthernetSM, "TXS: No descriptors available in cache, "
                     "fetching and stopping ticking\n");
             DPRINTF(EthernetDpdk, "TXS: No descriptors available in cache, "
                     "fetching and stopping ticking\n");
-            txTick = false;
-            return;
+            cache.active = false;
+            return false;
         }
 
 
-        txDescCache.processContextDesc();
-        if (txDescCache.packetWaiting()) {
+        cache.processContextDesc();
+        if (cache.packetWaiting()) {
             DPRINTF(EthernetSM,
                     "TXS: Fetching TSO header, stopping ticking\n");
             DPRINTF(EthernetDpdk,
                     "TXS: Fetching TSO header, stopping ticking\n");
-            txTick = false;
-            return;
+            cache.active = false;
+            return false;
         }
 
-        unsigned size = txDescCache.getPacketSize(txPacket);
+        unsigned size = cache.getPacketSize(packet);
         if (size > 0 && txFifo.avail() > size) {
             DPRINTF(EthernetSM, "TXS: Reserving %d bytes in FIFO and "
                     "beginning DMA of next packet\n", size);
             DPRINTF(EthernetDpdk, "TXS: Reserving %d bytes in FIFO and "
                     "beginning DMA of next packet\n", size);
             txFifo.reserve(size);
-            txDescCache.getPacketData(txPacket);
+            cache.getPacketData(packet);
         } else if (size == 0) {
             DPRINTF(EthernetSM, "TXS: getPacketSize returned: %d\n", size);
             DPRINTF(EthernetSM,
@@ -2215,336 +3114,102 @@ IGbE::txStateMachine()
             DPRINTF(EthernetDpdk, "TXS: getPacketSize returned: %d\n", size);
             DPRINTF(EthernetDpdk,
                     "TXS: No packets to get, writing back used descriptors\n");
-            txDescCache.writeback(0);
+            cache.writeback(0);
         } else {
             etherDeviceStats.txFifoFullCount++;
             DPRINTF(EthernetSM, "TXS: FIFO full, stopping ticking until space "
                     "available in FIFO\n");
             DPRINTF(EthernetDpdk, "TXS: FIFO full, stopping ticking until space "
                     "available in FIFO\n");
-            txTick = false;
+            cache.active = false;
         }
 
 
-        return;
+        return false;
     }
     DPRINTF(EthernetSM, "TXS: Nothing to do, stopping ticking\n");
     DPRINTF(EthernetDpdk, "TXS: Nothing to do, stopping ticking\n");
-    txTick = false;
+    cache.active = false;
+    return false;
 }
 
-char currState = 'A', nextState;
 void
-IGbE::updateDropFSM(int rxFifoFull, int rxRingFull, int txRingFull, int txFifoFull)
+IGbE::classifyDrop(bool rx_fifo_full, bool rx_ring_full, bool tx_ring_full)
 {
-    // State Encoding: rxFifoFull,rxRingFull,txRingFull
-    // 000 -> "A" || 001 -> "B" || 010 -> "C" || 011 = "D"
-    // 100 -> "E" || 101 -> "F" || 110 -> "G" || 111 = "H"
-    
-    switch(currState) {
-        case 'A':
-            if(!rxFifoFull && !rxRingFull && txRingFull) {
-                nextState = 'B';
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && !txRingFull){
-                nextState = 'C';
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(rxFifoFull && !rxRingFull && !txRingFull){
-                nextState = 'E';
-                etherDeviceStats.dmaDrops++;
-            }
-            else if(rxFifoFull && !rxRingFull && txRingFull){
-                nextState = 'F';
-                etherDeviceStats.dmaDrops++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'G';
-                etherDeviceStats.coreDrops++;
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && txRingFull) {
-                nextState = 'D';
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && txRingFull) {
-                nextState = 'H';
-                etherDeviceStats.txDrops++;
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else
-                nextState = 'A';
-            break;
-        case 'B':
-            if(!rxFifoFull && !rxRingFull && !txRingFull)
-                nextState = 'A';
-            else if(!rxFifoFull && rxRingFull && !txRingFull){
-                nextState = 'C';
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(rxFifoFull && !rxRingFull && !txRingFull){
-                nextState = 'E';
-                etherDeviceStats.dmaDrops++; //confirm-done
-            }
-            else if(rxFifoFull && !rxRingFull && txRingFull){
-                nextState = 'F';
-                etherDeviceStats.dmaDrops++; //confirm-done
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'G';
-                etherDeviceStats.coreDrops++;
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && txRingFull) {
-                nextState = 'D';
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && txRingFull) {
-                nextState = 'H';
-                etherDeviceStats.txDrops++; //initially txDrops
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else {
-                nextState = 'B';
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            break;
-        case 'C':
-            if(!rxFifoFull && !rxRingFull && !txRingFull)
-                nextState = 'A';
-            else if(!rxFifoFull && !rxRingFull && txRingFull) {
-                nextState = 'B';
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && !rxRingFull && !txRingFull){
-                nextState = 'E';
-                etherDeviceStats.coreDrops++;
-            }
-            else if(rxFifoFull && !rxRingFull && txRingFull){
-                nextState = 'F';
-                etherDeviceStats.coreDrops++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'G';
-                // if(txDescCache.descLeft() == 1024 || (!txDescCache.descUnused() && txDescCache.descLeft()))
-                //     etherDeviceStats.txDrops++;
-                // else
-                etherDeviceStats.coreDrops++;
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && txRingFull) {
-                nextState = 'D';
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && txRingFull) {
-                nextState = 'H';
-                etherDeviceStats.coreDrops++;
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }   
-            else {
-                nextState = 'C';
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            break;
-        case 'D':
-            if(!rxFifoFull && !rxRingFull && !txRingFull)
-                nextState = 'A';
-            else if(!rxFifoFull && !rxRingFull && txRingFull) {
-                nextState = 'B';
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && !rxRingFull && !txRingFull){
-                nextState = 'E';
-                etherDeviceStats.coreDrops++; //confirm-done (initially txDrops)
-            }
-            else if(rxFifoFull && !rxRingFull && txRingFull){
-                nextState = 'F';
-                etherDeviceStats.coreDrops++; //confirm-done (initially txDrops)
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'G';
-                etherDeviceStats.coreDrops++; //confirm-done (initially txDrops)
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'C';
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && txRingFull) {
-                nextState = 'H';
-                etherDeviceStats.txDrops++;
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }   
-            else {
-                nextState = 'D';
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            break;
-        case 'E':
-            if(!rxFifoFull && !rxRingFull && !txRingFull)
-                nextState = 'A';
-            else if(!rxFifoFull && !rxRingFull && txRingFull) {
-                nextState = 'B';
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && txRingFull){
-                nextState = 'D';
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && !rxRingFull && txRingFull){
-                nextState = 'F';
-                etherDeviceStats.dmaDrops++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'G';
-                etherDeviceStats.coreDrops++;
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'C';
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && txRingFull) {
-                nextState = 'H';
-                etherDeviceStats.txDrops++; //confirm-done (initially txDrops)
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }   
-            else{
-                nextState = 'E';
-                etherDeviceStats.dmaDrops++;
-            }  
-            break;
-        case 'F':
-            if(!rxFifoFull && !rxRingFull && !txRingFull)
-                nextState = 'A';
-            else if(!rxFifoFull && !rxRingFull && txRingFull) {
-                nextState = 'B';
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && txRingFull){
-                nextState = 'D';
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && !rxRingFull && !txRingFull){
-                nextState = 'E';
-                etherDeviceStats.dmaDrops++;
-            }
-            else if(rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'G';
-                etherDeviceStats.coreDrops++;
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'C';
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && txRingFull) {
-                nextState = 'H';
-                etherDeviceStats.txDrops++; //confirm-done (initially txDrops)
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }   
-            else{
-                nextState = 'F';
-                etherDeviceStats.dmaDrops++;
-                // etherDeviceStats.txRingBufferFull++;
-            }  
-            break;
-        case 'G':
-            if(!rxFifoFull && !rxRingFull && !txRingFull)
-                nextState = 'A';
-            else if(!rxFifoFull && !rxRingFull && txRingFull) {
-                nextState = 'B';
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && txRingFull){
-                nextState = 'D';
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && !rxRingFull && !txRingFull){
-                nextState = 'E';
-                etherDeviceStats.dmaDrops++; //confirm-done (initially dmaDrops++)
-            }
-            else if(rxFifoFull && !rxRingFull && txRingFull) {
-                nextState = 'F';
-                etherDeviceStats.dmaDrops++; //confirm-done (initially dmaDrops++)
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'C';
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && txRingFull) {
-                nextState = 'H';
-                etherDeviceStats.txDrops++;
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }   
-            else{
-                nextState = 'G';
-                etherDeviceStats.coreDrops++;
-                // etherDeviceStats.rxRingBufferFull++;
-            }  
-            break;
-        case 'H':
-            if(!rxFifoFull && !rxRingFull && !txRingFull)
-                nextState = 'A';
-            else if(!rxFifoFull && !rxRingFull && txRingFull) {
-                nextState = 'B';
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && txRingFull){
-                nextState = 'D';
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(rxFifoFull && !rxRingFull && !txRingFull){
-                nextState = 'E';
-                etherDeviceStats.dmaDrops++;
-            }
-            else if(rxFifoFull && !rxRingFull && txRingFull) {
-                nextState = 'F';
-                etherDeviceStats.dmaDrops++; //confirm-done (initially dmaDrops)
-                // etherDeviceStats.txRingBufferFull++;
-            }
-            else if(!rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'C';
-                // etherDeviceStats.rxRingBufferFull++;
-            }
-            else if(rxFifoFull && rxRingFull && !txRingFull) {
-                nextState = 'G';
-                etherDeviceStats.coreDrops++; //confirm-done
-                // etherDeviceStats.rxRingBufferFull++;
-            }   
-            else{
-                nextState = 'H';
-                etherDeviceStats.txDrops++;
-                // etherDeviceStats.rxRingBufferFull++;
-                // etherDeviceStats.txRingBufferFull++;
-            }  
-            break;
+    updateDropResidency();
+    switch (dropClassifier.update(rx_fifo_full, rx_ring_full, tx_ring_full)) {
+      case DropClassifier::DmaBound:
+        etherDeviceStats.dmaDrops++;
+        break;
+      case DropClassifier::CoreBound:
+        etherDeviceStats.coreDrops++;
+        break;
+      case DropClassifier::TxBound:
+        etherDeviceStats.txDrops++;
+        break;
+      case DropClassifier::NoDrop:
+        break;
     }
-    currState = nextState;
 }
 
+void
+IGbE::updateDropResidency()
+{
+    igbeStats.dropStateResidency[dropClassifier.state()] +=
+        curTick() - dropStateSince;
+    dropStateSince = curTick();
+}
+
+unsigned
+IGbE::rssQueue(EthPacketPtr pkt, uint32_t &hash, uint8_t &type)
+{
+    hash = 0;
+    type = RSS_TYPE_NONE;
+    if (!regs.mrqc.rss())
+        return 0;
+
+    IpPtr ip(pkt);
+    if (!ip)
+        return 0;
+
+    // Fragments are hashed on the addresses only, as the ports are not
+    // in every fragment
+    bool fragment = (ip->frag_flags() & 0x1) || ip->frag_off();
+    TcpPtr tcp(ip);
+    UdpPtr udp(ip);
+    if (tcp && !fragment && regs.mrqc.tcpipv4()) {
+        hash = rss::hashIPv4(regs.rssrk, ip->src(), ip->dst(),
+                             tcp->sport(), tcp->dport());
+        type = RSS_TYPE_TCP_IPV4;
+    } else if (udp && !fragment && regs.mrqc.udpipv4()) {
+        hash = rss::hashIPv4(regs.rssrk, ip->src(), ip->dst(),
+                             udp->sport(), udp->dport());
+        type = RSS_TYPE_UDP_IPV4;
+    } else if (regs.mrqc.ipv4()) {
+        hash = rss::hashIPv4(regs.rssrk, ip->src(), ip->dst(), 0, 0, false);
+        type = RSS_TYPE_IPV4;
+    } else {
+        return 0;
+    }
+
+    // The low seven bits of the hash index the redirection table
+    return regs.reta[hash & (RETA_SIZE - 1)] % numPfQueues;
+}
+
+unsigned
+IGbE::rxSteer(EthPacketPtr pkt, uint32_t &hash, uint8_t &type)
+{
+    unsigned q = rssQueue(pkt, hash, type);
+    if (!numVfs)
+        return q;
+
+    int vf = vfSwitch.lookup(pkt->data, pkt->length);
+    if (vf == VfSwitch::Pf)
+        return q;
+
+    // The VF spreads its traffic over its queues with the same hash
+    return vfFirstQueue(vf) + hash % vfQueues;
+}
 
 bool
 IGbE::ethRxPkt(EthPacketPtr pkt)
@@ -2556,15 +3221,6 @@ IGbE::ethRxPkt(EthPacketPtr pkt)
     DPRINTF(Ethernet, "RxFIFO: Receiving packet from wire\n");
     DPRINTF(EthernetDpdk, "RxFIFO: Receiving packet from wire\n");
 
-    // set rxFifoFull, txRingFull, rxRingFull
-    // int rxRingFull = (rxDescCache.descLeft() == 0 ? 1 : 0);
-    // int txRingFull = ((!txDescCache.packetWaiting() && txDescCache.descLeft() == 0) ? 1 : 0);
-    // int rxFifoFull = (rxFifo.full() ? 1 : 0);
-    // int rxFifoFull = (!rxFifo.push(pkt) ? 1 : 0);
-    // call updateDropFSM(rxFifo.full(), txRingFull)
-    // updateDropFSM(rxFifoFull, rxRingFull, txRingFull);
-
-
     if (!regs.rctl.en()) {
         etherDeviceStats.rxdisabledDrops++;
         DPRINTF(Ethernet, "RxFIFO: RX not enabled, dropping\n");
@@ -2581,22 +3237,31 @@ IGbE::ethRxPkt(EthPacketPtr pkt)
                 "RXS: received packet into fifo, starting ticking\n");
         restartClock();
     }
-    int rxRingFull = ((rxDescCache.descLeft() == 0) ? 1 : 0); // RX Path: CPU Produces Descriptors and NIC Consumes/Uses
-    int txRingFull = ((!txDescCache.packetWaiting() && txDescCache.descLeft() == 1024) ? 1 : 0); // TX Path: CPU Produces Packets and NIC Consumes/Uses
-    int rxFifoFull = 0;
-    int txFifoFull = 0;
+    // Look at the rings of the queue pair the packet is steered to
+    unsigned q = 0;
+    uint8_t rss_type = RSS_TYPE_NONE;
+    if (numQueues > 1 || regs.mrqc.rss()) {
+        uint32_t hash;
+        q = rxSteer(pkt, hash, rss_type);
+    }
+    // RX path: the CPU produces descriptors and the NIC consumes them.
+    // TX path: the CPU produces packets and the NIC consumes them.
+    bool rx_ring_full = rxDescCache[q]->descLeft() == 0;
+    bool tx_ring_full = !txDescCache[q]->packetWaiting() &&
+        txDescCache[q]->descLeft() == 1024;
     if (!rxFifo.push(pkt)) {
-        rxFifoFull = 1;
         etherDeviceStats.rxFifoFullCount++;
-        updateDropFSM(rxFifoFull, rxRingFull, txRingFull, txFifoFull);
+        classifyDrop(true, rx_ring_full, tx_ring_full);
         DPRINTF(Ethernet, "RxFIFO: Packet won't fit in fifo... dropped\n");
         DPRINTF(EthernetDpdk, "RxFIFO: Packet won't fit in fifo... dropped\n");
         postInterrupt(IT_RXO, true);
         return false;
     }
-    // else
-        // rxFifoFull=0;
-    updateDropFSM(rxFifoFull, rxRingFull, txRingFull, txFifoFull);
+    classifyDrop(false, rx_ring_full, tx_ring_full);
+    // The packet is steered again once it reaches the head of the FIFO,
+    // count it once here
+    if (rss_type != RSS_TYPE_NONE)
+        igbeStats.rssHashed++;
     return true;
 }
 
@@ -2610,38 +3275,43 @@ IGbE::rxStateMachine()
         DPRINTF(EthernetDpdk, "RXS: RX disabled, stopping ticking\n");
         return;
     }
+
+    // The queue of the packet being written, or of the next one to go
+    RxDescCache *cache = rxDescCache[rxQueue].get();
+    QueueRegs *qr = &queueRegs[rxQueue];
+
     // If the packet is done check for interrupts/descriptors/etc
-    if (rxDescCache.packetDone()) {
+    if (cache->packetDone()) {
         rxDmaPacket = false;
         DPRINTF(EthernetSM, "RXS: Packet completed DMA to memory\n");
         DPRINTF(EthernetDpdk, "RXS: Packet completed DMA to memory\n");
-        int descLeft = rxDescCache.descLeft();
+        int descLeft = cache->descLeft();
         DPRINTF(EthernetSM, "RXS: descLeft: %d rdmts: %d rdlen: %d\n",
-                descLeft, regs.rctl.rdmts(), regs.rdlen());
+                descLeft, regs.rctl.rdmts(), qr->rdlen());
         DPRINTF(EthernetDpdk, "RXS: descLeft: %d rdmts: %d rdlen: %d\n",
-                descLeft, regs.rctl.rdmts(), regs.rdlen());
+                descLeft, regs.rctl.rdmts(), qr->rdlen());
 
         // rdmts 2->1/8, 1->1/4, 0->1/2
         int ratio = (1ULL << (regs.rctl.rdmts() + 1));
-        if (descLeft * ratio <= regs.rdlen()) {
+        if (descLeft * ratio <= qr->rdlen()) {
             DPRINTF(Ethernet, "RXS: Interrupting (RXDMT) "
                     "because of descriptors left\n");
             DPRINTF(EthernetDpdk, "RXS: Interrupting (RXDMT) "
                     "because of descriptors left\n");
-            rxDescCache.writeback(0);
+            cache->writeback(0);
          }
 
         if (descLeft < 32)
         {
-            rxDescCache.writeback(0);
+            cache->writeback(0);
         }
 
         if (rxFifo.empty())
-            rxDescCache.writeback(0);
+            cache->writeback(0);
 
         if (descLeft == 0) {
             etherDeviceStats.rxRingBufferFull++;
-            rxDescCache.writeback(0);
+            cache->writeback(0);
             DPRINTF(EthernetSM, "RXS: No descriptors left in ring, forcing"
                     " writeback and stopping ticking\n");
             DPRINTF(EthernetDpdk, "RXS: No descriptors left in ring, forcing"
@@ -2650,31 +3320,31 @@ IGbE::rxStateMachine()
         }
 
         // only support descriptor granulaties
-        assert(regs.rxdctl.gran());
+        assert(qr->rxdctl.gran());
 
-        if (regs.rxdctl.wthresh() >= rxDescCache.descUsed()) {
+        if (qr->rxdctl.wthresh() >= cache->descUsed()) {
             DPRINTF(EthernetSM,
                     "RXS: Writing back because WTHRESH >= descUsed\n");
             DPRINTF(EthernetDpdk,
                     "RXS: Writing back because WTHRESH >= descUsed\n");
-            if (regs.rxdctl.wthresh() < (cacheBlockSize()>>4))
-                rxDescCache.writeback(regs.rxdctl.wthresh()-1);
+            if (qr->rxdctl.wthresh() < (cacheBlockSize()>>4))
+                cache->writeback(qr->rxdctl.wthresh()-1);
             else
-                rxDescCache.writeback((cacheBlockSize()-1)>>4);
+                cache->writeback((cacheBlockSize()-1)>>4);
         }
 
-        if ((rxDescCache.descUnused() < regs.rxdctl.pthresh()) &&
-            ((rxDescCache.descLeft() - rxDescCache.descUnused()) >
-             regs.rxdctl.hthresh())) {
+        if ((cache->descUnused() < qr->rxdctl.pthresh()) &&
+            ((cache->descLeft() - cache->descUnused()) >
+             qr->rxdctl.hthresh())) {
             DPRINTF(EthernetSM, "RXS: Fetching descriptors because "
                     "descUnused < PTHRESH\n");
             DPRINTF(EthernetDpdk, "RXS: Fetching descriptors because "
                     "descUnused < PTHRESH\n");
-            rxDescCache.fetchDescriptors();
+            cache->fetchDescriptors();
         }
         
-        if (rxDescCache.descUnused() == 0) {
-            rxDescCache.fetchDescriptors();
+        if (cache->descUnused() == 0) {
+            cache->fetchDescriptors();
             etherDeviceStats.rxDescCacheFullCount++;
             DPRINTF(EthernetSM, "RXS: No descriptors available in cache, "
                     "fetching descriptors and stopping ticking\n");
@@ -2694,8 +3364,27 @@ IGbE::rxStateMachine()
         return;
     }
 
-    if (!rxDescCache.descUnused()) {
-        rxDescCache.fetchDescriptors();
+    // Steer the packet at the head of the FIFO, a packet spanning several
+    // descriptors stays on the queue it started on
+    if (!pktOffset && !rxFifo.empty()) {
+        rxQueue = rxSteer(rxFifo.front(), rxRssHash, rxRssType);
+        cache = rxDescCache[rxQueue].get();
+        qr = &queueRegs[rxQueue];
+    }
+
+    // A queue that is out of descriptors drops its packets rather than
+    // holding up the other queues, if the driver asked for it
+    if (qr->srrctl.drop_en() && !pktOffset && !rxFifo.empty() &&
+        cache->descLeft() == 0) {
+        DPRINTF(EthernetSM, "RXS: Queue %d has no descriptors, dropping\n",
+                rxQueue);
+        igbeStats.rxQueueDrops[rxQueue]++;
+        rxFifo.pop();
+        return;
+    }
+
+    if (!cache->descUnused()) {
+        cache->fetchDescriptors();
         etherDeviceStats.rxDescCacheFullCount++;
         DPRINTF(EthernetSM, "RXS: No descriptors available in cache, "
                 "stopping ticking\n");
@@ -2714,17 +3403,20 @@ IGbE::rxStateMachine()
         return;
     }
 
-    EthPacketPtr pkt;
-    pkt = rxFifo.front();
-
+    // The ring slot keeps the packet alive until it is popped, and the
+    // descriptor cache holds its own reference for the DMA
+    const EthPacketPtr &pkt = rxFifo.front();
 
-    pktOffset = rxDescCache.writePacket(pkt, pktOffset);
+    pktOffset = cache->writePacket(pkt, pktOffset);
     DPRINTF(EthernetSM, "RXS: Writing packet into memory\n");
     DPRINTF(EthernetDpdk, "RXS: Writing packet into memory\n");
     if (pktOffset == pkt->length) {
         DPRINTF(EthernetSM, "RXS: Removing packet from FIFO\n");
         DPRINTF(EthernetDpdk, "RXS: Removing packet from FIFO\n");
         pktOffset = 0;
+        igbeStats.rxQueuePackets[rxQueue]++;
+        itrRxPackets++;
+        itrRxBytes += pkt->length;
         rxFifo.pop();
     }
 
@@ -2742,6 +3434,14 @@ IGbE::txWire()
     if (txFifo.empty())
         return;
 
+    // Frames between our own functions never reach the wire
+    if (numVfs && vfSwitch.isLocal(txFifo.front()->data,
+                                   txFifo.front()->length, macAddr)) {
+        switchLocal(txFifo.front());
+        txFifo.pop();
+        txFifoTick = drainState() != DrainState::Draining;
+        return;
+    }
 
     if (etherInt->sendPacket(txFifo.front())) {
         if (debug::EthernetSM) {
@@ -2766,6 +3466,20 @@ IGbE::txWire()
     }
 }
 
+void
+IGbE::switchLocal(EthPacketPtr pkt)
+{
+    if (!regs.rctl.en() || !rxFifo.push(pkt)) {
+        DPRINTF(Ethernet, "Switch: dropping frame between functions\n");
+        igbeStats.switchedDrops++;
+        return;
+    }
+
+    DPRINTF(EthernetSM, "Switch: frame between functions into RxFIFO\n");
+    igbeStats.switchedPackets++;
+    rxTick = drainState() != DrainState::Draining;
+}
+
 void
 IGbE::tick()
 {
@@ -2788,8 +3502,14 @@ IGbE::tick()
     while (txFifoTick)
         txWire();
 
-    if (rxTick || txTick || txFifoTick)
-        schedule(tickEvent, curTick() + clockPeriod());
+    if (rxTick || txTick || txFifoTick) {
+        if (skipIdleTicks && !txFifoTick && rxIdle() && txIdle()) {
+            igbeStats.skippedTicks++;
+            skipTick(curTick() + clockPeriod());
+        } else {
+            schedule(tickEvent, curTick() + clockPeriod());
+        }
+    }
 
     inTick = false;
 }
@@ -2801,8 +3521,13 @@ IGbE::ethTxDone()
     // fifo to send another packet
     // tx sm to put more data into the fifo
     txFifoTick = true && drainState() != DrainState::Draining;
-    if (txDescCache.descLeft() != 0 && drainState() != DrainState::Draining)
-        txTick = true;
+    for (auto &cache : txDescCache) {
+        if (cache->descLeft() != 0 &&
+            drainState() != DrainState::Draining) {
+            cache->active = true;
+            txTick = true;
+        }
+    }
 
     if (!inTick)
         restartClock();
@@ -2815,6 +3540,7 @@ IGbE::serialize(CheckpointOut &cp) const
     PciDevice::serialize(cp);
 
     regs.serialize(cp);
+    queueRegs[0].serialize(cp);
     SERIALIZE_SCALAR(eeOpBits);
     SERIALIZE_SCALAR(eeAddrBits);
     SERIALIZE_SCALAR(eeDataBits);
@@ -2826,10 +3552,10 @@ IGbE::serialize(CheckpointOut &cp) const
     rxFifo.serialize("rxfifo", cp);
     txFifo.serialize("txfifo", cp);
 
-    bool txPktExists = txPacket != nullptr;
+    bool txPktExists = txPacket[0] != nullptr;
     SERIALIZE_SCALAR(txPktExists);
     if (txPktExists)
-        txPacket->serialize("txpacket", cp);
+        txPacket[0]->serialize("txpacket", cp);
 
     Tick rdtr_time = 0, radv_time = 0, tidv_time = 0, tadv_time = 0,
         inter_time = 0;
@@ -2855,9 +3581,44 @@ IGbE::serialize(CheckpointOut &cp) const
     SERIALIZE_SCALAR(inter_time);
 
     SERIALIZE_SCALAR(pktOffset);
-
-    txDescCache.serializeSection(cp, "TxDescCache");
-    rxDescCache.serializeSection(cp, "RxDescCache");
+    SERIALIZE_SCALAR(rxQueue);
+    SERIALIZE_SCALAR(rxRssHash);
+    SERIALIZE_SCALAR(rxRssType);
+    SERIALIZE_SCALAR(txQueue);
+
+    int itr_rx_latency = itrModel.rxCurrent();
+    int itr_tx_latency = itrModel.txCurrent();
+    unsigned itr_rate = itrModel.currentRate();
+    SERIALIZE_SCALAR(itr_rx_latency);
+    SERIALIZE_SCALAR(itr_tx_latency);
+    SERIALIZE_SCALAR(itr_rate);
+    SERIALIZE_SCALAR(itrRxPackets);
+    SERIALIZE_SCALAR(itrRxBytes);
+    SERIALIZE_SCALAR(itrTxPackets);
+    SERIALIZE_SCALAR(itrTxBytes);
+    SERIALIZE_SCALAR(queueIntPending);
+    SERIALIZE_CONTAINER(queueIntTick);
+
+    unsigned drop_state = dropClassifier.state();
+    SERIALIZE_SCALAR(drop_state);
+
+    txDescCache[0]->serializeSection(cp, "TxDescCache");
+    rxDescCache[0]->serializeSection(cp, "RxDescCache");
+
+    // The other queues each get a section of their own
+    for (unsigned q = 1; q < numQueues; q++) {
+        ScopedCheckpointSection sec(cp, csprintf("queue%d", q));
+        queueRegs[q].serialize(cp);
+        bool txPktExists = txPacket[q] != nullptr;
+        SERIALIZE_SCALAR(txPktExists);
+        if (txPktExists)
+            txPacket[q]->serialize("txpacket", cp);
+        txDescCache[q]->serializeSection(cp, "TxDescCache");
+        rxDescCache[q]->serializeSection(cp, "RxDescCache");
+    }
+
+    for (unsigned vf = 0; vf < numVfs; vf++)
+        vfRegs[vf].serializeSection(cp, csprintf("vf%d", vf));
 }
 
 void
@@ -2866,6 +3627,7 @@ IGbE::unserialize(CheckpointIn &cp)
     PciDevice::unserialize(cp);
 
     regs.unserialize(cp);
+    queueRegs[0].unserialize(cp);
     UNSERIALIZE_SCALAR(eeOpBits);
     UNSERIALIZE_SCALAR(eeAddrBits);
     UNSERIALIZE_SCALAR(eeDataBits);
@@ -2880,13 +3642,15 @@ IGbE::unserialize(CheckpointIn &cp)
     bool txPktExists;
     UNSERIALIZE_SCALAR(txPktExists);
     if (txPktExists) {
-        txPacket = std::make_shared<EthPacketData>(16384);
-        txPacket->unserialize("txpacket", cp);
+        txPacket[0] = std::make_shared<EthPacketData>(16384);
+        txPacket[0]->unserialize("txpacket", cp);
     }
 
     rxTick = true;
     txTick = true;
     txFifoTick = true;
+    for (auto &cache : txDescCache)
+        cache->active = true;
 
     Tick rdtr_time, radv_time, tidv_time, tadv_time, inter_time;
     UNSERIALIZE_SCALAR(rdtr_time);
@@ -2911,9 +3675,59 @@ IGbE::unserialize(CheckpointIn &cp)
         schedule(interEvent, inter_time);
 
     UNSERIALIZE_SCALAR(pktOffset);
+    // Checkpoints from before multiple queues only have queue 0
+    UNSERIALIZE_OPT_SCALAR(rxQueue);
+    UNSERIALIZE_OPT_SCALAR(rxRssHash);
+    UNSERIALIZE_OPT_SCALAR(rxRssType);
+    UNSERIALIZE_OPT_SCALAR(txQueue);
+    fatal_if(rxQueue >= numQueues || txQueue >= numQueues,
+             "Checkpoint of %s uses more queues than num_queues", name());
+
+    int itr_rx_latency = itrModel.rxCurrent();
+    int itr_tx_latency = itrModel.txCurrent();
+    unsigned itr_rate = itrModel.currentRate();
+    UNSERIALIZE_OPT_SCALAR(itr_rx_latency);
+    UNSERIALIZE_OPT_SCALAR(itr_tx_latency);
+    UNSERIALIZE_OPT_SCALAR(itr_rate);
+    itrModel.set(AdaptiveItr::Latency(itr_rx_latency),
+                 AdaptiveItr::Latency(itr_tx_latency), itr_rate);
+    UNSERIALIZE_OPT_SCALAR(itrRxPackets);
+    UNSERIALIZE_OPT_SCALAR(itrRxBytes);
+    UNSERIALIZE_OPT_SCALAR(itrTxPackets);
+    UNSERIALIZE_OPT_SCALAR(itrTxBytes);
+    // Interrupts the driver has yet to poll after, so intPollLatency
+    // goes on from the times they were posted at
+    UNSERIALIZE_OPT_SCALAR(queueIntPending);
+    if (cp.entryExists(Serializable::currentSection(), "queueIntTick")) {
+        UNSERIALIZE_CONTAINER(queueIntTick);
+        fatal_if(queueIntTick.size() != numQueues,
+                 "Checkpoint of %s has %d queues, num_queues is %d",
+                 name(), queueIntTick.size(), numQueues);
+    }
+
+    unsigned drop_state = 0;
+    UNSERIALIZE_OPT_SCALAR(drop_state);
+    dropClassifier.set(drop_state);
+    dropStateSince = curTick();
+
+    txDescCache[0]->unserializeSection(cp, "TxDescCache");
+    rxDescCache[0]->unserializeSection(cp, "RxDescCache");
+
+    for (unsigned q = 1; q < numQueues; q++) {
+        ScopedCheckpointSection sec(cp, csprintf("queue%d", q));
+        queueRegs[q].unserialize(cp);
+        bool txPktExists;
+        UNSERIALIZE_SCALAR(txPktExists);
+        if (txPktExists) {
+            txPacket[q] = std::make_shared<EthPacketData>(16384);
+            txPacket[q]->unserialize("txpacket", cp);
+        }
+        txDescCache[q]->unserializeSection(cp, "TxDescCache");
+        rxDescCache[q]->unserializeSection(cp, "RxDescCache");
+    }
 
-    txDescCache.unserializeSection(cp, "TxDescCache");
-    rxDescCache.unserializeSection(cp, "RxDescCache");
+    for (unsigned vf = 0; vf < numVfs; vf++)
+        vfRegs[vf].unserializeSection(cp, csprintf("vf%d", vf));
 }
 
 } // namespace gem5
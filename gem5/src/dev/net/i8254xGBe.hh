@@ -35,21 +35,32 @@
 
 #include <cstdint>
 #include <deque>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "base/inet.hh"
+#include "base/statistics.hh"
 #include "base/trace.hh"
 #include "base/types.hh"
 #include "debug/EthernetDesc.hh"
 #include "debug/EthernetIntr.hh"
 #include "dev/net/etherdevice.hh"
 #include "dev/net/etherint.hh"
+#include "dev/net/adaptive_itr.hh"
+#include "dev/net/ddio_placement.hh"
+#include "dev/net/desc_wb_batch.hh"
+#include "dev/net/drop_classifier.hh"
 #include "dev/net/etherpkt.hh"
 #include "dev/net/i8254xGBe_defs.hh"
+#include "dev/net/idle_tick.hh"
 #include "dev/net/pktfifo.hh"
+#include "dev/net/vf_switch.hh"
 #include "dev/pci/device.hh"
 #include "params/IGbE.hh"
 #include "sim/eventq.hh"
+#include "sim/probe/probe.hh"
 #include "sim/serialize.hh"
 
 namespace gem5
@@ -60,24 +71,46 @@ class IGbEInt;
 class IGbE : public EtherDevice
 {
   private:
-    // SHIN
-    int adq = -1;
     IGbEInt *etherInt;
 
     // device registers
     igbreg::Regs regs;
 
+    // Number of receive/transmit queue pairs of the physical function
+    // and of each virtual function. The VF queues follow the PF ones.
+    const unsigned numPfQueues;
+    const unsigned numVfs;
+    const unsigned vfQueues;
+
+    // Number of receive/transmit queue pairs and their ring registers,
+    // queue 0 answers at the legacy register addresses
+    const unsigned numQueues;
+    std::vector<igbreg::QueueRegs> queueRegs;
+
+    // Interrupt registers of each virtual function, and the switch that
+    // sorts frames between the functions
+    std::vector<igbreg::VfRegs> vfRegs;
+    VfSwitch vfSwitch;
+
     // eeprom data, status and control bits
     int eeOpBits, eeAddrBits, eeDataBits;
     uint8_t eeOpcode, eeAddr;
     uint16_t flash[igbreg::EEPROM_SIZE];
 
     // packet fifos
-    PacketFifo rxFifo;
-    PacketFifo txFifo;
+    PacketRing rxFifo;
+    PacketRing txFifo;
+
+    // Packet that each queue is currently putting into the txFifo
+    std::vector<EthPacketPtr> txPacket;
 
-    // Packet that we are currently putting into the txFifo
-    EthPacketPtr txPacket;
+    // Queue and RSS hash of the packet at the head of the rxFifo
+    unsigned rxQueue;
+    uint32_t rxRssHash;
+    uint8_t rxRssType;
+
+    // Next queue the TX state machine serves, round robin
+    unsigned txQueue;
 
     // Should to Rx/Tx State machine tick?
     bool inTick;
@@ -85,8 +118,30 @@ class IGbE : public EtherDevice
     bool txTick;
     bool txFifoTick;
 
+    // A tick the state machines would have spent finding nothing to do is
+    // not scheduled, idleTick keeps it so a wakeup can bring it back
+    // exactly as it was.
+    const bool skipIdleTicks;
+    IdleTick idleTick;
+
     bool rxDmaPacket;
 
+    // Dynamic interrupt throttling and the traffic since the last
+    // interrupt that drives it
+    const bool adaptiveItr;
+    AdaptiveItr itrModel;
+    uint64_t itrRxPackets, itrRxBytes;
+    uint64_t itrTxPackets, itrTxBytes;
+
+    // Queues with work behind the next interrupt, and when each queue was
+    // first interrupted without the driver having polled it since
+    uint32_t queueIntPending;
+    std::vector<Tick> queueIntTick;
+
+    // Why packets are dropped, per device
+    DropClassifier dropClassifier;
+    Tick dropStateSince;
+
     // Number of bytes copied from current RX packet
     unsigned pktOffset;
 
@@ -95,9 +150,89 @@ class IGbE : public EtherDevice
     Tick fetchCompDelay, wbCompDelay;
     Tick rxWriteDelay, txReadDelay;
 
+    // Cache line bursts for descriptor DMA, and how long writebacks are
+    // held back to coalesce them
+    const bool descBatching;
+    const unsigned descWbThreshold;
+    const Tick descWbTimeout;
+
+    // Placement policy of each queue, empty for the legacy steering of
+    // every request to the queue's MLC
+    std::vector<DdioPlacement *> ddioPlacement;
+
+    // Lines written under a placement policy that no core has touched
+    // yet, the segment they hold and when. Not checkpointed, tracking
+    // starts over after a restore
+    struct PlacedLine
+    {
+        uint8_t seg;
+        Tick when;
+    };
+    std::unordered_map<Addr, PlacedLine> placedLines;
+
+    // Lines untouched for this long are given up on, the map is swept for
+    // them once it grows past placedSweepSize
+    const Tick ddioTouchWindow;
+    size_t placedSweepSize;
+
+    /** Count the lines untouched for longer than the window as untouched
+     * and stop tracking them. */
+    void sweepPlacedLines();
+
+    /** Reports the demand hits or misses of one cache to ddioTouch(). */
+    class TouchListener : public ProbeListenerArgBase<PacketPtr>
+    {
+      private:
+        IGbE &igbe;
+        const unsigned level;
+        const bool miss;
+
+      public:
+        TouchListener(IGbE &_igbe, ProbeManager *pm, const std::string &name,
+                      unsigned _level, bool _miss)
+            : ProbeListenerArgBase(pm, name), igbe(_igbe), level(_level),
+              miss(_miss)
+        {}
+
+        void
+        notify(const PacketPtr &pkt) override
+        {
+            igbe.ddioTouch(pkt, level, miss);
+        }
+    };
+
+    std::vector<std::unique_ptr<TouchListener>> touchListeners;
+
+    /** Write one segment of queue q's traffic where the queue's placement
+     * policy puts it, or to the MLC adq without a policy.
+     */
+    void placeWrite(DdioPlacement::Segment seg, unsigned q, int adq,
+                    Addr addr, int size, Event *event, uint8_t *data,
+                    Tick delay);
+
+    /** Write several segments of queue q's traffic as one scatter-gather
+     * transfer, event is scheduled once all of them are written.
+     * @param kinds what each of segs holds
+     */
+    void placeWriteSg(const std::vector<DdioPlacement::Segment> &kinds,
+                      unsigned q, int adq, std::vector<DmaSegment> segs,
+                      Event *event, Tick delay);
+
+    /** Count the lines of a placed segment. */
+    void accountPlaced(DdioPlacement::Segment seg, Addr addr, int size);
+
+    /** Count the first core access to a placed line.
+     * @param level the index of the cache in ddio_touch_caches
+     * @param miss whether the access missed in that cache
+     */
+    void ddioTouch(const PacketPtr &pkt, unsigned level, bool miss);
+
+    AdaptiveDdioFlag getAdaptiveDdioFlag(void *opts) override;
+
     // Event and function to deal with RDTR timer expiring
     void rdtrProcess() {
-        rxDescCache.writeback(0);
+        for (auto &cache : rxDescCache)
+            cache->writeback(0);
         DPRINTF(EthernetIntr,
                 "Posting RXT interrupt because RDTR timer expired\n");
         postInterrupt(igbreg::IT_RXT);
@@ -107,7 +242,8 @@ class IGbE : public EtherDevice
 
     // Event and function to deal with RADV timer expiring
     void radvProcess() {
-        rxDescCache.writeback(0);
+        for (auto &cache : rxDescCache)
+            cache->writeback(0);
         DPRINTF(EthernetIntr,
                 "Posting RXT interrupt because RADV timer expired\n");
         postInterrupt(igbreg::IT_RXT);
@@ -117,7 +253,8 @@ class IGbE : public EtherDevice
 
     // Event and function to deal with TADV timer expiring
     void tadvProcess() {
-        txDescCache.writeback(0);
+        for (auto &cache : txDescCache)
+            cache->writeback(0);
         DPRINTF(EthernetIntr,
                 "Posting TXDW interrupt because TADV timer expired\n");
         postInterrupt(igbreg::IT_TXDW);
@@ -127,7 +264,8 @@ class IGbE : public EtherDevice
 
     // Event and function to deal with TIDV timer expiring
     void tidvProcess() {
-        txDescCache.writeback(0);
+        for (auto &cache : txDescCache)
+            cache->writeback(0);
         DPRINTF(EthernetIntr,
                 "Posting TXDW interrupt because TIDV timer expired\n");
         postInterrupt(igbreg::IT_TXDW);
@@ -138,12 +276,50 @@ class IGbE : public EtherDevice
     void tick();
     EventFunctionWrapper tickEvent;
 
+    /** Would the next RX state machine tick do nothing but stop? */
+    bool rxIdle();
+    /** Would the next TX state machine tick do nothing but stop? */
+    bool txIdle();
+
+    /** Is a skipped tick still to come? */
+    bool idleTickPending() const { return idleTick.pending(curTick()); }
+
+    /** Skip the tick at when, stopping the state machines the way it
+     * would have.
+     */
+    void skipTick(Tick when);
+
+    /** Is the RX state machine ticking, counting a skipped tick? */
+    bool
+    rxTicking() const
+    {
+        return rxTick || idleTick.rxPending(curTick());
+    }
+    /** Is the TX state machine serving queue q, counting a skipped tick? */
+    bool
+    txTicking(unsigned q) const
+    {
+        return txDescCache[q]->active ||
+            idleTick.txQueuePending(q, curTick());
+    }
+
 
     uint64_t macAddr;
 
     void rxStateMachine();
     void txStateMachine();
-    void updateDropFSM(int rxFifoFull, int rxRingFull, int txRingFull, int txFifoFull);
+    /** Run the TX state machine for one queue.
+     * @return true if a packet was placed in the txFifo
+     */
+    bool txQueueStateMachine(unsigned q);
+
+    /** Blame a packet dropped on a full RX FIFO on its cause and track the
+     * congestion state.
+     */
+    void classifyDrop(bool rx_fifo_full, bool rx_ring_full,
+                      bool tx_ring_full);
+    /** Add the time since the last update to the current drop state */
+    void updateDropResidency();
     void txWire();
 
     /** Write an interrupt into the interrupt pending register and check mask
@@ -153,6 +329,97 @@ class IGbE : public EtherDevice
      */
     void postInterrupt(igbreg::IntTypes t, bool now = false);
 
+    /** Post an interrupt on behalf of a queue, flagging the queue's vector
+     * in the extended interrupt cause register as well.
+     * @param t the type of interrupt we are posting
+     * @param q the queue the interrupt is for
+     * @param tx whether it is the transmit or the receive side of the queue
+     */
+    void postQueueInterrupt(igbreg::IntTypes t, unsigned q, bool tx);
+
+    /** Interrupt vector allocated to a queue in IVAR, -1 if none */
+    int queueVector(unsigned q, bool tx) const;
+
+    /** Interrupt vector allocated to queue q of a VF in its VTIVAR,
+     * -1 if none
+     */
+    int vfQueueVector(unsigned vf, unsigned q, bool tx) const;
+
+    /** Deliver the pending interrupt causes now or once the ITR allows.
+     * @param now should we ignore the interrupt limiting timer
+     */
+    void scheduleInterrupt(bool now);
+
+    /** Any unmasked legacy or extended interrupt cause pending? */
+    bool intPending() const
+    {
+        if ((regs.icr._data & regs.imr) || (regs.eicr & regs.eims))
+            return true;
+        for (auto &vr : vfRegs) {
+            if (vr.eicr & vr.eims)
+                return true;
+        }
+        return false;
+    }
+
+    /** First queue of a virtual function */
+    unsigned
+    vfFirstQueue(unsigned vf) const
+    {
+        return numPfQueues + vf * vfQueues;
+    }
+
+    /** The virtual function a queue belongs to, VfSwitch::Pf for the
+     * physical function's queues.
+     */
+    int
+    queueVf(unsigned q) const
+    {
+        return q < numPfQueues ? VfSwitch::Pf : (q - numPfQueues) / vfQueues;
+    }
+
+    /** Stat and debug name of a queue */
+    std::string queueName(unsigned q) const;
+
+    /** Compute the RSS hash of a packet and pick its receive queue.
+     * Packets are steered to queue 0 unless MRQC enables RSS.
+     * @param pkt the received packet
+     * @param hash the Toeplitz hash, 0 if the packet was not hashed
+     * @param type the RSS type to report in the descriptor
+     * @return the receive queue
+     */
+    unsigned rssQueue(EthPacketPtr pkt, uint32_t &hash, uint8_t &type);
+
+    /** Pick the receive queue of a packet: the switch picks the function
+     * by destination address and VLAN, RSS the queue of the function.
+     * @return the receive queue
+     */
+    unsigned rxSteer(EthPacketPtr pkt, uint32_t &hash, uint8_t &type);
+
+    /** Translate the address of a ring register of queue q > 0 to the
+     * matching queue 0 address.
+     * @param first the queue the registers of queue 0 belong to
+     * @param count the number of queues at daddr
+     * @return true if daddr is a ring register of an enabled queue
+     */
+    bool queueRegister(Addr daddr, Addr &reg, unsigned &q, unsigned first,
+                       unsigned count) const;
+
+    /** Split an offset into the VF BAR into the VF and the offset into
+     * its window, translating ring registers like queueRegister().
+     * @return true if daddr is a ring register of one of the VF's queues
+     */
+    bool vfRegister(Addr daddr, unsigned &vf, Addr &reg, unsigned &q) const;
+
+    /** Access a VF register other than the ring registers. */
+    Tick vfRead(PacketPtr pkt, unsigned vf, Addr daddr);
+    Tick vfWrite(PacketPtr pkt, unsigned vf, Addr daddr);
+
+    /** Hand a transmitted frame for one of our functions to the receive
+     * side instead of the wire.
+     */
+    void switchLocal(EthPacketPtr pkt);
+
     /** Check and see if changes to the mask register have caused an interrupt
      * to need to be sent or perhaps removed an interrupt cause.
      */
@@ -171,6 +438,23 @@ class IGbE : public EtherDevice
 
     Tick intClock() { return sim_clock::as_int::ns * 1024; }
 
+    /** ITR interval, in 256ns units, for a rate in interrupts/s */
+    static uint32_t
+    itrInterval(unsigned rate)
+    {
+        return sim_clock::as_int::s / rate / (sim_clock::as_int::ns * 256);
+    }
+
+    /** Record an interrupt reaching the CPU for the queues behind it and
+     * let the adaptive ITR adjust the throttling interval.
+     */
+    void interruptDelivered();
+
+    /** The driver handed buffers of queue q back, closing the poll of
+     * the last interrupt.
+     */
+    void queuePolled(unsigned q);
+
     /** This function is used to restart the clock so it can handle things like
      * draining and resume in one place. */
     void restartClock();
@@ -180,6 +464,9 @@ class IGbE : public EtherDevice
      */
     void checkDrain();
 
+    /** Does any queue still have descriptor or packet DMA in flight? */
+    bool hasOutstandingEvents();
+
     template<class T>
     class DescCache : public Serializable
     {
@@ -206,6 +493,12 @@ class IGbE : public EtherDevice
         // Name of this  descriptor cache
         std::string _name;
 
+        // Queue this cache belongs to and where its DMA is steered to
+        unsigned queue;
+        int adq;
+
+        igbreg::QueueRegs &qregs() const { return igbe->queueRegs[queue]; }
+
         // How far we've cached
         int cachePnt;
 
@@ -218,12 +511,9 @@ class IGbE : public EtherDevice
         // How many descriptors we are currently writing back
         int wbOut;
 
-        // if the we wrote back to the end of the descriptor ring and are going
-        // to have to wrap and write more
-        bool moreToWb;
-
-        // What the alignment is of the next descriptor writeback
-        Addr wbAlignment;
+        // If another writeback is to follow the one in flight, and the
+        // alignment of the next descriptor writeback
+        DescWbBatch wbBatch;
 
         /** The packet that is currently being dmad to memory if any */
         EthPacketPtr pktPtr;
@@ -231,12 +521,26 @@ class IGbE : public EtherDevice
         /** Shortcut for DMA address translation */
         Addr pciToDma(Addr a) { return igbe->pciToDma(a); }
 
+        /** Descriptor DMA transactions of this cache, per queue */
+        statistics::Vector *fetchDmas;
+        statistics::Vector *wbDmas;
+
+        /** Mask of the descriptor index within a cache line */
+        Addr
+        lineMask() const
+        {
+            return igbe->cacheBlockSize() / sizeof(T) - 1;
+        }
+
+        /** Write back without coalescing, see writeback() */
+        void issueWriteback(Addr aMask, bool timed_out = false);
+
       public:
         /** Annotate sm*/
         std::string annSmFetch, annSmWb, annUnusedDescQ, annUsedCacheQ,
             annUsedDescQ, annUnusedCacheQ, annDescQ;
 
-        DescCache(IGbE *i, const std::string n, int s);
+        DescCache(IGbE *i, const std::string n, int s, unsigned q, int a);
         virtual ~DescCache();
 
         std::string name() { return _name; }
@@ -247,10 +551,19 @@ class IGbE : public EtherDevice
          */
         void areaChanged();
 
+        /** Write back used descriptors, aligning the count to aMask + 1.
+         * When descriptor batching is on, nothing is written until
+         * descWbThreshold descriptors are used or the oldest of them has
+         * waited descWbTimeout, and then whole cache lines are written.
+         */
         void writeback(Addr aMask);
         void writeback1();
         EventFunctionWrapper wbDelayEvent;
 
+        /** Write back whatever coalesced writeback is still waiting */
+        void wbTimeout();
+        EventFunctionWrapper wbTimeoutEvent;
+
         /** Fetch a chunk of descriptors into the descriptor cache.
          * Calls fetchComplete when the memory system returns the data
          */
@@ -308,28 +621,26 @@ class IGbE : public EtherDevice
     class RxDescCache : public DescCache<igbreg::RxDesc>
     {
       protected:
-        Addr descBase() const override { return igbe->regs.rdba(); }
-        long descHead() const override { return igbe->regs.rdh(); }
-        long descLen() const override { return igbe->regs.rdlen() >> 4; }
-        long descTail() const override { return igbe->regs.rdt(); }
-        void updateHead(long h) override { igbe->regs.rdh(h); }
+        Addr descBase() const override { return qregs().rdba(); }
+        long descHead() const override { return qregs().rdh(); }
+        long descLen() const override { return qregs().rdlen() >> 4; }
+        long descTail() const override { return qregs().rdt(); }
+        void updateHead(long h) override { qregs().rdh(h); }
         void enableSm() override;
         void fetchAfterWb() override {
-            if (!igbe->rxTick && igbe->drainState() == DrainState::Running)
+            if (!igbe->rxTicking() &&
+                igbe->drainState() == DrainState::Running)
                 fetchDescriptors();
         }
 
         bool pktDone;
 
-        /** Variable to head with header/data completion events */
-        int splitCount;
-
         /** Bytes of packet that have been copied, so we know when to
             set EOP */
         unsigned bytesCopied;
 
       public:
-        RxDescCache(IGbE *i, std::string n, int s);
+        RxDescCache(IGbE *i, std::string n, int s, unsigned q, int a);
 
         /** Write the given packet into the buffer(s) pointed to by the
          * descriptor and update the book keeping. Should only be called when
@@ -349,13 +660,10 @@ class IGbE : public EtherDevice
          */
         bool packetDone();
 
-        EventFunctionWrapper pktEvent;
+        /** Has packet DMA completed without packetDone() being asked yet? */
+        bool packetReady() const { return pktDone; }
 
-        // Event to handle issuing header and data write at the same time
-        // and only callking pktComplete() when both are completed
-        void pktSplitDone();
-        EventFunctionWrapper pktHdrEvent;
-        EventFunctionWrapper pktDataEvent;
+        EventFunctionWrapper pktEvent;
 
         bool hasOutstandingEvents() override;
 
@@ -364,20 +672,21 @@ class IGbE : public EtherDevice
     };
     friend class RxDescCache;
 
-    RxDescCache rxDescCache;
+    std::vector<std::unique_ptr<RxDescCache>> rxDescCache;
 
     class TxDescCache  : public DescCache<igbreg::TxDesc>
     {
       protected:
-        Addr descBase() const override { return igbe->regs.tdba(); }
-        long descHead() const override { return igbe->regs.tdh(); }
-        long descTail() const override { return igbe->regs.tdt(); }
-        long descLen() const override { return igbe->regs.tdlen() >> 4; }
-        void updateHead(long h) override { igbe->regs.tdh(h); }
+        Addr descBase() const override { return qregs().tdba(); }
+        long descHead() const override { return qregs().tdh(); }
+        long descTail() const override { return qregs().tdt(); }
+        long descLen() const override { return qregs().tdlen() >> 4; }
+        void updateHead(long h) override { qregs().tdh(h); }
         void enableSm() override;
         void actionAfterWb() override;
         void fetchAfterWb() override {
-            if (!igbe->txTick && igbe->drainState() == DrainState::Running)
+            if (!igbe->txTicking(queue) &&
+                igbe->drainState() == DrainState::Running)
                 fetchDescriptors();
         }
 
@@ -408,7 +717,10 @@ class IGbE : public EtherDevice
         int tsoPkts;
 
       public:
-        TxDescCache(IGbE *i, std::string n, int s);
+        TxDescCache(IGbE *i, std::string n, int s, unsigned q, int a);
+
+        /** Should the TX state machine serve this queue? */
+        bool active;
 
         /** Tell the cache to DMA a packet from main memory into its buffer and
          * return the size the of the packet to reserve space in tx fifo.
@@ -433,6 +745,9 @@ class IGbE : public EtherDevice
          */
         bool packetAvailable();
 
+        /** Same as packetAvailable() without consuming the packet. */
+        bool packetReady() const { return pktDone; }
+
         /** Ask if we are still waiting for the packet to be transfered.
          * @return packet still in transit.
          */
@@ -476,7 +791,40 @@ class IGbE : public EtherDevice
 
     friend class TxDescCache;
 
-    TxDescCache txDescCache;
+    std::vector<std::unique_ptr<TxDescCache>> txDescCache;
+
+    struct IGbEStats : public statistics::Group
+    {
+        IGbEStats(IGbE *igbe);
+
+        statistics::Vector rxQueuePackets;
+        statistics::Vector txQueuePackets;
+        statistics::Vector rxQueueDrops;
+        statistics::Vector rxQueueInterrupts;
+        statistics::Vector txQueueInterrupts;
+        statistics::Scalar rssHashed;
+        statistics::Scalar skippedTicks;
+        statistics::Vector rxDescFetchDmas;
+        statistics::Vector rxDescWbDmas;
+        statistics::Vector txDescFetchDmas;
+        statistics::Vector txDescWbDmas;
+        statistics::Vector queueInterrupts;
+        statistics::Formula queueInterruptRate;
+        statistics::Formula packetsPerInterrupt;
+        statistics::VectorDistribution intPollLatency;
+        statistics::Scalar itrUpdates;
+        statistics::Vector dropStateResidency;
+        statistics::Vector ddioPlacedLines;
+        statistics::Vector ddioUntouchedLines;
+        statistics::Vector2d ddioTouches;
+        statistics::Scalar switchedPackets;
+        statistics::Scalar switchedDrops;
+
+        void preDumpStats() override;
+        void resetStats() override;
+
+        IGbE *igbe;
+    } igbeStats;
 
   public:
     PARAMS(IGbE);
@@ -484,6 +832,7 @@ class IGbE : public EtherDevice
     IGbE(const Params &params);
     ~IGbE();
     void init() override;
+    void regProbeListeners() override;
 
     Port &getPort(const std::string &if_name,
                   PortID idx=InvalidPortID) override;
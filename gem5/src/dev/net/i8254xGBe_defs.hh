@@ -62,6 +62,12 @@ const uint32_t REG_FCTTV    = 0x00170;
 const uint32_t REG_TIPG     = 0x00410;
 const uint32_t REG_AIFS     = 0x00458;
 const uint32_t REG_LEDCTL   = 0x00e00;
+const uint32_t REG_GPIE     = 0x01514;
+const uint32_t REG_EICS     = 0x01520;
+const uint32_t REG_EIMS     = 0x01524;
+const uint32_t REG_EIMC     = 0x01528;
+const uint32_t REG_EIAC     = 0x0152C;
+const uint32_t REG_EIAM     = 0x01530;
 const uint32_t REG_EICR     = 0x01580;
 const uint32_t REG_IVAR0    = 0x01700;
 const uint32_t REG_FCRTL    = 0x02160;
@@ -95,6 +101,9 @@ const uint32_t REG_MTA      = 0x05200;
 const uint32_t REG_RAL      = 0x05400;
 const uint32_t REG_RAH      = 0x05404;
 const uint32_t REG_VFTA     = 0x05600;
+const uint32_t REG_MRQC     = 0x05818;
+const uint32_t REG_RETA     = 0x05C00;
+const uint32_t REG_RSSRK    = 0x05C80;
 
 const uint32_t REG_WUC      = 0x05800;
 const uint32_t REG_WUFC     = 0x05808;
@@ -114,6 +123,46 @@ const uint8_t RCV_ADDRESS_TABLE_SIZE    = 24;
 const uint8_t MULTICAST_TABLE_SIZE      = 128;
 const uint32_t STATS_REGS_SIZE           = 0x228;
 
+// Multiple queues, laid out like the 82576. Queues 1-3 repeat the ring
+// registers of queue 0 every 0x100 bytes, the others live in a second
+// bank with 0x40 bytes per queue.
+const uint8_t MAX_QUEUES                = 16;
+const uint32_t QUEUE_STRIDE             = 0x100;
+const uint32_t REG_RXQ_BANK1            = 0x0C000;
+const uint32_t REG_TXQ_BANK1            = 0x0E000;
+const uint32_t QUEUE_BANK1_STRIDE       = 0x40;
+const uint8_t QUEUE_BANK0_SIZE          = 4;
+const uint8_t RETA_SIZE                 = 128;
+const uint8_t RSS_KEY_SIZE              = 40;
+const uint8_t IVAR_REGS                 = 8;
+const uint8_t IVAR_VALID                = 0x80;
+const uint8_t MAX_VECTORS               = 25;
+
+// Virtual functions, laid out like the 82576 VF. Each VF has a 16KB
+// register window in the VF BAR, with its rings at the queue 0 addresses
+// and its own interrupt registers.
+const uint8_t MAX_VFS                   = 7;
+const uint8_t MAX_VF_QUEUES             = 2;
+const uint8_t MAX_VF_VECTORS            = 3;
+const uint8_t VF_BAR                    = 3;
+const uint32_t VF_BAR_STRIDE            = 0x4000;
+const uint32_t REG_VTCTRL   = 0x00000;
+const uint32_t REG_VTSTATUS = 0x00008;
+const uint32_t REG_VTEICS   = 0x01520;
+const uint32_t REG_VTEIMS   = 0x01524;
+const uint32_t REG_VTEIMC   = 0x01528;
+const uint32_t REG_VTEIAC   = 0x0152C;
+const uint32_t REG_VTEIAM   = 0x01530;
+const uint32_t REG_VTEICR   = 0x01580;
+const uint32_t REG_VTIVAR   = 0x01700;
+const uint32_t REG_VTIVAR_MISC = 0x01740;
+
+// RSS types reported in advanced receive descriptors
+const uint8_t RSS_TYPE_NONE     = 0x0;
+const uint8_t RSS_TYPE_TCP_IPV4 = 0x1;
+const uint8_t RSS_TYPE_IPV4     = 0x2;
+const uint8_t RSS_TYPE_UDP_IPV4 = 0x7;
+
 
 // Registers in that are accessed in the PHY
 const uint8_t PHY_PSTATUS       = 0x1;
@@ -593,7 +642,6 @@ struct Regs : public Serializable
         ADD_FIELD64(rdbal,0,32); // base address of rx descriptor ring
         ADD_FIELD64(rdbah,32,32); // base address of rx descriptor ring
     };
-    RDBA rdba;
 
     struct RDLEN : public Reg<uint32_t>
     {
@@ -601,7 +649,6 @@ struct Regs : public Serializable
         using Reg<uint32_t>::operator=;
         ADD_FIELD32(len,7,13); // number of bytes in the descriptor buffer
     };
-    RDLEN rdlen;
 
     struct SRRCTL : public Reg<uint32_t>
     {
@@ -611,10 +658,10 @@ struct Regs : public Serializable
         ADD_FIELD32(hdrlen, 8, 8); // guess based on header, not documented
         ADD_FIELD32(desctype, 25,3); // type of descriptor 000 legacy, 001 adv,
                                      //101 hdr split
+        ADD_FIELD32(drop_en, 31,1);  // drop packets when the ring is empty
         unsigned bufLen() { return pktlen() << 10; }
         unsigned hdrLen() { return hdrlen() << 6; }
     };
-    SRRCTL srrctl;
 
     struct RDH : public Reg<uint32_t>
     {
@@ -622,7 +669,6 @@ struct Regs : public Serializable
         using Reg<uint32_t>::operator=;
         ADD_FIELD32(rdh,0,16); // head of the descriptor ring
     };
-    RDH rdh;
 
     struct RDT : public Reg<uint32_t>
     {
@@ -630,7 +676,6 @@ struct Regs : public Serializable
         using Reg<uint32_t>::operator=;
         ADD_FIELD32(rdt,0,16); // tail of the descriptor ring
     };
-    RDT rdt;
 
     struct RDTR : public Reg<uint32_t>
     {
@@ -652,7 +697,6 @@ struct Regs : public Serializable
         ADD_FIELD32(wthresh,16,6);  // writeback threshold
         ADD_FIELD32(gran,24,1);     // granularity 0 = desc, 1 = cacheline
     };
-    RXDCTL rxdctl;
 
     struct RADV : public Reg<uint32_t>
     {
@@ -677,7 +721,6 @@ struct Regs : public Serializable
         ADD_FIELD64(tdbal,0,32); // base address of transmit descriptor ring
         ADD_FIELD64(tdbah,32,32); // base address of transmit descriptor ring
     };
-    TDBA tdba;
 
     struct TDLEN : public Reg<uint32_t>
     {
@@ -685,7 +728,6 @@ struct Regs : public Serializable
         using Reg<uint32_t>::operator=;
         ADD_FIELD32(len,7,13); // number of bytes in the descriptor buffer
     };
-    TDLEN tdlen;
 
     struct TDH : public Reg<uint32_t>
     {
@@ -693,7 +735,6 @@ struct Regs : public Serializable
         using Reg<uint32_t>::operator=;
         ADD_FIELD32(tdh,0,16); // head of the descriptor ring
     };
-    TDH tdh;
 
     struct TXDCA_CTL : public Reg<uint32_t>
     {
@@ -711,7 +752,6 @@ struct Regs : public Serializable
         using Reg<uint32_t>::operator=;
         ADD_FIELD32(tdt,0,16); // tail of the descriptor ring
     };
-    TDT tdt;
 
     struct TIDV : public Reg<uint32_t>
     {
@@ -736,7 +776,6 @@ struct Regs : public Serializable
         ADD_FIELD32(lwthresh,25,7); // xmit descriptor low thresh, interrupt
                                     // below this level
     };
-    TXDCTL txdctl;
 
     struct TADV : public Reg<uint32_t>
     {
@@ -755,7 +794,6 @@ struct Regs : public Serializable
         ADD_FIELD64(tdwbah,32,32); // base address of transmit descriptor ring
     };
     TDWBA tdwba;*/
-    uint64_t tdwba;
 
     struct RXCSUM : public Reg<uint32_t>
     {
@@ -851,6 +889,32 @@ struct Regs : public Serializable
 
     uint32_t sw_fw_sync;
 
+    struct MRQC : public Reg<uint32_t>
+    {
+        // 0x5818 MRQC Register
+        using Reg<uint32_t>::operator=;
+        ADD_FIELD32(mrqe,0,3);      // multiple receive queues enable
+        ADD_FIELD32(tcpipv4,16,1);  // hash TCP/IPv4 ports
+        ADD_FIELD32(ipv4,17,1);     // hash IPv4 addresses
+        ADD_FIELD32(udpipv4,22,1);  // hash UDP/IPv4 ports
+        bool rss() { return mrqe() == 2 || mrqe() == 5; }
+    };
+    MRQC mrqc;
+
+    // 0x5C00 RETA, four one byte queue indices per register
+    uint8_t reta[RETA_SIZE];
+    // 0x5C80 RSSRK, ten registers holding the hash key
+    uint8_t rssrk[RSS_KEY_SIZE];
+
+    // Extended interrupt cause, mask and auto clear/mask registers
+    uint32_t gpie;
+    uint32_t eicr;
+    uint32_t eims;
+    uint32_t eiac;
+    uint32_t eiam;
+    // 0x1700 IVAR, queue to interrupt vector allocation
+    uint32_t ivar[IVAR_REGS];
+
     void serialize(CheckpointOut &cp) const override
     {
         paramOut(cp, "ctrl", ctrl._data);
@@ -869,25 +933,12 @@ struct Regs : public Serializable
         paramOut(cp, "pba", pba._data);
         paramOut(cp, "fcrtl", fcrtl._data);
         paramOut(cp, "fcrth", fcrth._data);
-        paramOut(cp, "rdba", rdba._data);
-        paramOut(cp, "rdlen", rdlen._data);
-        paramOut(cp, "srrctl", srrctl._data);
-        paramOut(cp, "rdh", rdh._data);
-        paramOut(cp, "rdt", rdt._data);
         paramOut(cp, "rdtr", rdtr._data);
-        paramOut(cp, "rxdctl", rxdctl._data);
         paramOut(cp, "radv", radv._data);
         paramOut(cp, "rsrpd", rsrpd._data);
-        paramOut(cp, "tdba", tdba._data);
-        paramOut(cp, "tdlen", tdlen._data);
-        paramOut(cp, "tdh", tdh._data);
         paramOut(cp, "txdca_ctl", txdca_ctl._data);
-        paramOut(cp, "tdt", tdt._data);
         paramOut(cp, "tidv", tidv._data);
-        paramOut(cp, "txdctl", txdctl._data);
         paramOut(cp, "tadv", tadv._data);
-        //paramOut(cp, "tdwba", tdwba._data);
-        SERIALIZE_SCALAR(tdwba);
         paramOut(cp, "rxcsum", rxcsum._data);
         SERIALIZE_SCALAR(rlpml);
         paramOut(cp, "rfctl", rfctl._data);
@@ -895,6 +946,15 @@ struct Regs : public Serializable
         paramOut(cp, "swsm", swsm._data);
         paramOut(cp, "fwsm", fwsm._data);
         SERIALIZE_SCALAR(sw_fw_sync);
+        paramOut(cp, "mrqc", mrqc._data);
+        SERIALIZE_ARRAY(reta, RETA_SIZE);
+        SERIALIZE_ARRAY(rssrk, RSS_KEY_SIZE);
+        SERIALIZE_SCALAR(gpie);
+        SERIALIZE_SCALAR(eicr);
+        SERIALIZE_SCALAR(eims);
+        SERIALIZE_SCALAR(eiac);
+        SERIALIZE_SCALAR(eiam);
+        SERIALIZE_ARRAY(ivar, IVAR_REGS);
     }
 
     void unserialize(CheckpointIn &cp) override
@@ -915,25 +975,12 @@ struct Regs : public Serializable
         paramIn(cp, "pba", pba._data);
         paramIn(cp, "fcrtl", fcrtl._data);
         paramIn(cp, "fcrth", fcrth._data);
-        paramIn(cp, "rdba", rdba._data);
-        paramIn(cp, "rdlen", rdlen._data);
-        paramIn(cp, "srrctl", srrctl._data);
-        paramIn(cp, "rdh", rdh._data);
-        paramIn(cp, "rdt", rdt._data);
         paramIn(cp, "rdtr", rdtr._data);
-        paramIn(cp, "rxdctl", rxdctl._data);
         paramIn(cp, "radv", radv._data);
         paramIn(cp, "rsrpd", rsrpd._data);
-        paramIn(cp, "tdba", tdba._data);
-        paramIn(cp, "tdlen", tdlen._data);
-        paramIn(cp, "tdh", tdh._data);
         paramIn(cp, "txdca_ctl", txdca_ctl._data);
-        paramIn(cp, "tdt", tdt._data);
         paramIn(cp, "tidv", tidv._data);
-        paramIn(cp, "txdctl", txdctl._data);
         paramIn(cp, "tadv", tadv._data);
-        UNSERIALIZE_SCALAR(tdwba);
-        //paramIn(cp, "tdwba", tdwba._data);
         paramIn(cp, "rxcsum", rxcsum._data);
         UNSERIALIZE_SCALAR(rlpml);
         paramIn(cp, "rfctl", rfctl._data);
@@ -941,6 +988,111 @@ struct Regs : public Serializable
         paramIn(cp, "swsm", swsm._data);
         paramIn(cp, "fwsm", fwsm._data);
         UNSERIALIZE_SCALAR(sw_fw_sync);
+        // Checkpoints from before multiple queues keep the reset values
+        if (optParamIn(cp, "mrqc", mrqc._data, false)) {
+            UNSERIALIZE_ARRAY(reta, RETA_SIZE);
+            UNSERIALIZE_ARRAY(rssrk, RSS_KEY_SIZE);
+            UNSERIALIZE_SCALAR(gpie);
+            UNSERIALIZE_SCALAR(eicr);
+            UNSERIALIZE_SCALAR(eims);
+            UNSERIALIZE_SCALAR(eiac);
+            UNSERIALIZE_SCALAR(eiam);
+            UNSERIALIZE_ARRAY(ivar, IVAR_REGS);
+        }
+    }
+};
+
+/** Ring registers of one receive/transmit queue pair */
+struct QueueRegs : public Serializable
+{
+    Regs::RDBA rdba;
+    Regs::RDLEN rdlen;
+    Regs::SRRCTL srrctl;
+    Regs::RDH rdh;
+    Regs::RDT rdt;
+    Regs::RXDCTL rxdctl;
+
+    Regs::TDBA tdba;
+    Regs::TDLEN tdlen;
+    Regs::TDH tdh;
+    Regs::TDT tdt;
+    Regs::TXDCTL txdctl;
+    uint64_t tdwba;
+
+    QueueRegs() : tdwba(0) {}
+
+    void serialize(CheckpointOut &cp) const override
+    {
+        paramOut(cp, "rdba", rdba._data);
+        paramOut(cp, "rdlen", rdlen._data);
+        paramOut(cp, "srrctl", srrctl._data);
+        paramOut(cp, "rdh", rdh._data);
+        paramOut(cp, "rdt", rdt._data);
+        paramOut(cp, "rxdctl", rxdctl._data);
+        paramOut(cp, "tdba", tdba._data);
+        paramOut(cp, "tdlen", tdlen._data);
+        paramOut(cp, "tdh", tdh._data);
+        paramOut(cp, "tdt", tdt._data);
+        paramOut(cp, "txdctl", txdctl._data);
+        SERIALIZE_SCALAR(tdwba);
+    }
+
+    void unserialize(CheckpointIn &cp) override
+    {
+        paramIn(cp, "rdba", rdba._data);
+        paramIn(cp, "rdlen", rdlen._data);
+        paramIn(cp, "srrctl", srrctl._data);
+        paramIn(cp, "rdh", rdh._data);
+        paramIn(cp, "rdt", rdt._data);
+        paramIn(cp, "rxdctl", rxdctl._data);
+        paramIn(cp, "tdba", tdba._data);
+        paramIn(cp, "tdlen", tdlen._data);
+        paramIn(cp, "tdh", tdh._data);
+        paramIn(cp, "tdt", tdt._data);
+        paramIn(cp, "txdctl", txdctl._data);
+        UNSERIALIZE_SCALAR(tdwba);
+    }
+};
+
+/** Interrupt registers of one virtual function */
+struct VfRegs : public Serializable
+{
+    uint32_t ctrl;
+    uint32_t eicr;
+    uint32_t eims;
+    uint32_t eiac;
+    uint32_t eiam;
+    // RX and TX entries of queue 0 in the low half, of queue 1 in the
+    // high half, like IVAR
+    uint32_t ivar;
+    uint32_t ivarMisc;
+
+    VfRegs()
+        : ctrl(0), eicr(0), eims(0), eiac(0), eiam(0),
+          ivar((IVAR_VALID | uint32_t(IVAR_VALID | 1) << 16) * 0x101),
+          ivarMisc(0)
+    {}
+
+    void serialize(CheckpointOut &cp) const override
+    {
+        SERIALIZE_SCALAR(ctrl);
+        SERIALIZE_SCALAR(eicr);
+        SERIALIZE_SCALAR(eims);
+        SERIALIZE_SCALAR(eiac);
+        SERIALIZE_SCALAR(eiam);
+        SERIALIZE_SCALAR(ivar);
+        SERIALIZE_SCALAR(ivarMisc);
+    }
+
+    void unserialize(CheckpointIn &cp) override
+    {
+        UNSERIALIZE_SCALAR(ctrl);
+        UNSERIALIZE_SCALAR(eicr);
+        UNSERIALIZE_SCALAR(eims);
+        UNSERIALIZE_SCALAR(eiac);
+        UNSERIALIZE_SCALAR(eiam);
+        UNSERIALIZE_SCALAR(ivar);
+        UNSERIALIZE_SCALAR(ivarMisc);
     }
 };
 
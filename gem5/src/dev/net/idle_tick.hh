@@ -0,0 +1,121 @@
+#ifndef __DEV_NET_IDLE_TICK_HH__
+#define __DEV_NET_IDLE_TICK_HH__
+
+#include <cstdint>
+
+#include "base/types.hh"
+
+namespace gem5
+{
+
+/** What the RX state machine has to go on at a tick. */
+struct RxTickState
+{
+    bool ticking;
+    bool enabled;
+    /** The descriptor cache has a written back packet to finish */
+    bool packetReady;
+    /** A packet is being written to memory */
+    bool dmaPacket;
+    bool fifoEmpty;
+    /** The descriptor cache holds descriptors to write packets with */
+    bool descUnused;
+};
+
+/** Would a tick of the RX state machine do nothing but stop it? */
+inline bool
+rxTickIdle(const RxTickState &s)
+{
+    if (!s.ticking || !s.enabled)
+        return true;
+
+    // Either waiting on packet DMA, or no packet to write with
+    // descriptors on hand
+    return !s.packetReady && (s.dmaPacket || (s.fifoEmpty && s.descUnused));
+}
+
+/** What a TX queue has to go on at a tick. */
+struct TxQueueTickState
+{
+    bool active;
+    /** TXDLOW is in use, it would be posted on each tick */
+    bool lowThreshold;
+    /** A packet of the queue is held for the TX FIFO */
+    bool packetHeld;
+    bool packetReady;
+    /** The packet is being read from memory */
+    bool packetWaiting;
+};
+
+/** Would a tick serving the queue do nothing but stop? */
+inline bool
+txQueueTickIdle(const TxQueueTickState &s)
+{
+    if (!s.active)
+        return true;
+    return !s.lowThreshold && s.packetHeld && !s.packetReady &&
+        s.packetWaiting;
+}
+
+/**
+ * A tick of the state machines that was not scheduled because it would
+ * only have stopped them. Until its time comes, it remembers what it
+ * would have stopped, so a wakeup can run it exactly as it would have.
+ */
+class IdleTick
+{
+  private:
+    Tick when = 0;
+    bool rx = false;
+    bool tx = false;
+    uint32_t txQueues = 0;
+
+  public:
+    /** Is the skipped tick still to come at now? */
+    bool pending(Tick now) const { return when && when >= now; }
+
+    bool rxPending(Tick now) const { return rx && pending(now); }
+
+    bool
+    txQueuePending(unsigned q, Tick now) const
+    {
+        return (txQueues & (1 << q)) && pending(now);
+    }
+
+    /** Skip the tick at _when, which would have stopped rx, tx and the
+     * TX queues in tx_queues. */
+    void
+    skip(Tick _when, bool _rx, bool _tx, uint32_t tx_queues)
+    {
+        when = _when;
+        rx = _rx;
+        tx = _tx;
+        txQueues = tx_queues;
+    }
+
+    void clear() { when = 0; }
+
+    /**
+     * Something woke the state machines at now. If the skipped tick is
+     * still to come, add what it would have run to rx, tx and tx_queues
+     * and run it at its own time, otherwise tick at next_edge.
+     * @return the time to tick at
+     */
+    Tick
+    wake(Tick now, Tick next_edge, bool &_rx, bool &_tx, uint32_t &tx_queues)
+    {
+        Tick at = next_edge;
+        if (pending(now)) {
+            at = when;
+            _rx = _rx || rx;
+            _tx = _tx || tx;
+            tx_queues |= txQueues;
+        }
+        clear();
+        return at;
+    }
+};
+
+} // namespace gem5
+
+#endif // __DEV_NET_IDLE_TICK_HH__
@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <vector>
+
+#include "dev/net/idle_tick.hh"
+
+using namespace gem5;
+
+namespace
+{
+
+/** RX waiting on the DMA of a packet */
+RxTickState
+rxWaitingOnDma()
+{
+    return {true, true, false, true, false, false};
+}
+
+/** A TX queue waiting on the DMA of a packet */
+TxQueueTickState
+txWaitingOnDma()
+{
+    return {true, false, true, false, true};
+}
+
+} // anonymous namespace
+
+TEST(IdleTickTest, RxSkipConditions)
+{
+    auto s = rxWaitingOnDma();
+    EXPECT_TRUE(rxTickIdle(s));
+
+    // A written back packet is finished on the next tick
+    s.packetReady = true;
+    EXPECT_FALSE(rxTickIdle(s));
+
+    // Nothing in the FIFO, descriptors on hand
+    s = {true, true, false, false, true, true};
+    EXPECT_TRUE(rxTickIdle(s));
+    // A packet to write
+    s.fifoEmpty = false;
+    EXPECT_FALSE(rxTickIdle(s));
+    // No descriptors to write an arriving packet with, fetch some
+    s.fifoEmpty = true;
+    s.descUnused = false;
+    EXPECT_FALSE(rxTickIdle(s));
+
+    // Stopped or disabled RX has nothing to run
+    s.ticking = false;
+    EXPECT_TRUE(rxTickIdle(s));
+    s = {true, false, true, false, false, false};
+    EXPECT_TRUE(rxTickIdle(s));
+}
+
+TEST(IdleTickTest, TxSkipConditions)
+{
+    auto s = txWaitingOnDma();
+    EXPECT_TRUE(txQueueTickIdle(s));
+
+    // TXDLOW would be posted on the tick
+    s.lowThreshold = true;
+    EXPECT_FALSE(txQueueTickIdle(s));
+
+    s = txWaitingOnDma();
+    s.packetReady = true;
+    EXPECT_FALSE(txQueueTickIdle(s));
+
+    s = txWaitingOnDma();
+    s.packetWaiting = false;
+    EXPECT_FALSE(txQueueTickIdle(s));
+
+    s = txWaitingOnDma();
+    s.packetHeld = false;
+    EXPECT_FALSE(txQueueTickIdle(s));
+
+    // A queue not being served does not keep the tick
+    s.active = false;
+    EXPECT_TRUE(txQueueTickIdle(s));
+}
+
+TEST(IdleTickTest, NothingSkipped)
+{
+    IdleTick idle;
+    EXPECT_FALSE(idle.pending(0));
+    EXPECT_FALSE(idle.pending(100));
+
+    bool rx = false, tx = true;
+    uint32_t queues = 0x2;
+    EXPECT_EQ(1000, idle.wake(500, 1000, rx, tx, queues));
+    EXPECT_FALSE(rx);
+    EXPECT_TRUE(tx);
+    EXPECT_EQ(0x2, queues);
+}
+
+/**
+ * A wakeup before the skipped tick would have run brings it back at its
+ * own time with what it would have run, as if it had been scheduled.
+ */
+TEST(IdleTickTest, WakeBeforeSkippedTick)
+{
+    IdleTick idle;
+    idle.skip(1000, true, true, 0x5);
+    EXPECT_TRUE(idle.pending(600));
+    EXPECT_TRUE(idle.rxPending(600));
+    EXPECT_TRUE(idle.txQueuePending(0, 600));
+    EXPECT_FALSE(idle.txQueuePending(1, 600));
+    EXPECT_TRUE(idle.txQueuePending(2, 600));
+
+    bool rx = false, tx = false;
+    uint32_t queues = 0x2;
+    EXPECT_EQ(1000, idle.wake(600, 1100, rx, tx, queues));
+    EXPECT_TRUE(rx);
+    EXPECT_TRUE(tx);
+    EXPECT_EQ(0x7, queues);
+
+    // It runs once
+    EXPECT_FALSE(idle.pending(600));
+}
+
+/** The skipped tick is still to come at its own time. */
+TEST(IdleTickTest, WakeAtSkippedTick)
+{
+    IdleTick idle;
+    idle.skip(1000, true, false, 0);
+    EXPECT_TRUE(idle.pending(1000));
+
+    bool rx = false, tx = false;
+    uint32_t queues = 0;
+    EXPECT_EQ(1000, idle.wake(1000, 1500, rx, tx, queues));
+    EXPECT_TRUE(rx);
+    EXPECT_FALSE(tx);
+}
+
+/** Once its time has passed, the skipped tick would have stopped
+ * everything and a wakeup starts over on the next edge. */
+TEST(IdleTickTest, WakeAfterSkippedTick)
+{
+    IdleTick idle;
+    idle.skip(1000, true, true, 0x1);
+    EXPECT_FALSE(idle.pending(1001));
+    EXPECT_FALSE(idle.rxPending(1001));
+    EXPECT_FALSE(idle.txQueuePending(0, 1001));
+
+    bool rx = false, tx = false;
+    uint32_t queues = 0;
+    EXPECT_EQ(1500, idle.wake(1001, 1500, rx, tx, queues));
+    EXPECT_FALSE(rx);
+    EXPECT_FALSE(tx);
+    EXPECT_EQ(0, queues);
+}
+
+TEST(IdleTickTest, Clear)
+{
+    IdleTick idle;
+    idle.skip(1000, true, true, 0x1);
+    idle.clear();
+    EXPECT_FALSE(idle.pending(500));
+    EXPECT_FALSE(idle.rxPending(500));
+}
+
+/**
+ * Run a device that ticks every period and waits on DMA in between,
+ * with and without skipping: every tick that does work runs at the same
+ * time either way, and skipping leaves out only ticks that would find
+ * nothing to do.
+ */
+TEST(IdleTickTest, SkippingKeepsBusyTicks)
+{
+    const Tick period = 10;
+    // Times DMA completions wake the device
+    const Tick wakeups[] = {35, 37, 95, 200, 203, 500, 515};
+
+    auto run = [&](bool skip, unsigned &ticks) {
+        std::vector<Tick> busy;
+        IdleTick idle;
+        Tick next = period;
+        bool rx = true, tx = false;
+        uint32_t queues = 0;
+        bool waiting = false;
+        size_t w = 0;
+        ticks = 0;
+        while (next || w < std::size(wakeups)) {
+            if (w < std::size(wakeups) && (!next || wakeups[w] < next)) {
+                const Tick now = wakeups[w++];
+                waiting = false;
+                if (!next) {
+                    rx = true;
+                    next = idle.wake(now, (now / period + 1) * period,
+                                     rx, tx, queues);
+                }
+                continue;
+            }
+            const Tick now = next;
+            ticks++;
+            next = 0;
+            if (!rx)
+                continue;
+            if (!waiting) {
+                // Start a DMA and wait for it
+                busy.push_back(now);
+                waiting = true;
+                next = now + period;
+            } else {
+                // Nothing to do, stop until the DMA completes
+                rx = false;
+            }
+            if (next && skip && rxTickIdle({rx, true, false, waiting,
+                                            false, false})) {
+                idle.skip(next, rx, tx, queues);
+                rx = false;
+                next = 0;
+            }
+        }
+        return busy;
+    };
+
+    unsigned ticks, skipped_ticks;
+    const auto busy = run(false, ticks);
+    const auto skipped_busy = run(true, skipped_ticks);
+    EXPECT_EQ(busy, skipped_busy);
+    EXPECT_LT(skipped_ticks, ticks);
+}
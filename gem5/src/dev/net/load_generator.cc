@@ -1,7 +1,15 @@
 #include "dev/net/load_generator.hh"
 #include <inttypes.h>
+#include <algorithm>
 #include "sim/sim_exit.hh"
+#include "sim/stat_control.hh"
+#include <arpa/inet.h>
+#include <net/ethernet.h>
 #include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include "base/cprintf.hh"
+#include "base/inet.hh"
 #include "base/trace.hh"
 #include "debug/LoadgenDebug.hh"
 #include "debug/LoadgenLatency.hh"
@@ -13,19 +21,50 @@ namespace gem5
         : statistics::Group(parent, "LoadGenerator"),
         ADD_STAT(sentPackets, statistics::units::Count::get(), "Number of Generated Packets"),
         ADD_STAT(recvPackets, statistics::units::Count::get(), "Number of Recieved Packets"),
-        ADD_STAT(latency, statistics::units::Second::get(), "Distribution of Latency in ms")
+        ADD_STAT(closedLoopTimeouts, statistics::units::Count::get(), "Number of ClosedLoop requests reissued after a timeout"),
+        ADD_STAT(flowsStarted, statistics::units::Count::get(), "Number of flows started in multi-flow mode"),
+        ADD_STAT(queuePackets, statistics::units::Count::get(), "Number of packets sent per target RSS queue"),
+        ADD_STAT(searchSteps, statistics::units::Count::get(), "Number of saturation search steps completed"),
+        ADD_STAT(searchStepRate, statistics::units::Rate<statistics::units::Count, statistics::units::Second>::get(), "Offered load of the last search step"),
+        ADD_STAT(searchStepLoss, statistics::units::Ratio::get(), "Fraction of packets lost in the last search step"),
+        ADD_STAT(searchStepP99, statistics::units::Tick::get(), "p99 latency of the last search step"),
+        ADD_STAT(saturationRate, statistics::units::Rate<statistics::units::Count, statistics::units::Second>::get(), "Highest offered load found to meet the loss target and SLO, 0 if none did"),
+        ADD_STAT(memcachedGets, statistics::units::Count::get(), "Number of memcached GET requests sent"),
+        ADD_STAT(memcachedSets, statistics::units::Count::get(), "Number of memcached SET requests sent"),
+        ADD_STAT(portSentPackets, statistics::units::Count::get(), "Number of Generated Packets per port"),
+        ADD_STAT(portRecvPackets, statistics::units::Count::get(), "Number of Recieved Packets per port"),
+        ADD_STAT(latency, statistics::units::Second::get(), "Distribution of Latency in ms"),
+        latencyPercentiles(this)
         {
             sentPackets.precision(0);
             recvPackets.precision(0);
+            closedLoopTimeouts.precision(0);
+            flowsStarted.precision(0);
+            searchSteps.precision(0);
+            searchStepRate.precision(0);
+            searchStepP99.precision(0);
+            saturationRate.precision(0);
+            memcachedGets.precision(0);
+            memcachedSets.precision(0);
             latency.init(100);
         }
 
 
-    LoadGenerator::LoadGenerator(const LoadGeneratorParams &p) : SimObject(p), loadgenId(p.loadgen_id), packetSize(p.packet_size), packetRate(p.packet_rate), 
+    LoadGenerator::LoadGenerator(const LoadGeneratorParams &p) : SimObject(p), sendWindow(p.send_window), loadgenId(p.loadgen_id), packetSize(p.packet_size), packetRate(p.packet_rate), 
     startTick(p.start_tick), stopTick(p.stop_tick), checkLossInterval(5000), incrementInterval(5e+8/(packetSize*8)),// Whats a good value for this?
     burstWidth(p.burst_width), burstGap(p.burst_gap), burstStartTick(0),
-    lastRxCount(0), lastTxCount(0),
-    sendPacketEvent([this]{sendPacket();}, name()), checkLossEvent([this]{checkLoss();}, name()), loadGeneratorStats(this)
+    lastRxCount(0), lastTxCount(0), started(false), restored(false),
+    sendPacketEvent([this]{sendPacket();}, name()), checkLossEvent([this]{checkLoss();}, name()),
+    packetPool(p.app == "Memcached" ? MaxFrameSize : packetSize), rng(p.arrival_seed), closedLoop(false), closedLoopOutstanding(p.closed_loop_outstanding),
+    closedLoopThinkTime(p.closed_loop_think_time), closedLoopTimeout(p.closed_loop_timeout), outstanding(0),
+    closedLoopTimeoutEvent([this]{closedLoopTimedOut();}, name()),
+    searchLow(p.search_min_rate), searchHigh(p.search_max_rate), searchFound(false),
+    searchFloor(false), searchLossTarget(p.search_loss_target),
+    searchP99Slo(p.search_p99_slo), searchWarmup(p.search_warmup), searchMeasure(p.search_measure),
+    searchDrain(p.search_drain), searchPrecision(p.search_precision), searchDumpStats(p.search_dump_stats),
+    searchExit(p.search_exit), searchPhase(SearchPhase::Done), measureStart(0), measureEnd(0),
+    searchTx(0), searchRx(0), searchEvent([this]{searchPhaseDone();}, name()),
+    multiFlow(p.num_flows > 0), memcachedPort(p.memcached_port), loadGeneratorStats(this)
     {
         if (p.mode == "Static")
             loadgenMode = Mode::Static;
@@ -33,36 +72,453 @@ namespace gem5
             loadgenMode = Mode::Increment;
         else if (p.mode == "Burst")
             loadgenMode = Mode::Burst;
+        else if (p.mode == "Search")
+            loadgenMode = Mode::Search;
+        else
+            fatal("Unknown loadgen mode %s", p.mode);
+
+        if (p.arrival == "Fixed")
+            arrival.reset(new FixedArrival());
+        else if (p.arrival == "Poisson")
+            arrival.reset(new PoissonArrival(rng));
+        else if (p.arrival == "MMPP")
+            arrival.reset(new MmppArrival(rng, p.mmpp_on_time, p.mmpp_off_time));
+        else if (p.arrival == "Trace")
+            arrival.reset(new TraceArrival(p.arrival_trace));
+        else if (p.arrival == "ClosedLoop")
+            closedLoop = true;
+        else
+            fatal("Unknown arrival process %s", p.arrival);
+
+        fatal_if(closedLoop && closedLoopOutstanding == 0,
+                 "ClosedLoop arrivals need at least one outstanding request");
+        fatal_if(closedLoop && loadgenMode == Mode::Search,
+                 "Search mode needs an open-loop arrival process");
+        fatal_if(loadgenMode == Mode::Search &&
+                 (searchLow < 1 || searchLow >= searchHigh),
+                 "Search mode needs 0 < search_min_rate < search_max_rate");
+
+        const unsigned num_ports = p.port_interface_connection_count;
+        warn_if(num_ports == 0, "%s has no connected interface, nothing will be sent", name());
+        fatal_if(num_ports + loadgenId > 0xff, "Too many ports for loadgen %d", loadgenId);
+
+        shards.resize(num_ports);
+        for (unsigned i = 0; i < num_ports; i++)
+        {
+            shards[i].port = i;
+            shards[i].interface = new LoadGenInt(csprintf("%s.interface%d", name(), i), this, i);
+            shards[i].nextSend = MaxTick;
+            shards[i].outstanding = 0;
+            shards[i].flowsCounted = 0;
+        }
+
+        loadGeneratorStats.portSentPackets.init(std::max(num_ports, 1u));
+        loadGeneratorStats.portRecvPackets.init(std::max(num_ports, 1u));
+        for (unsigned i = 0; i < num_ports; i++)
+        {
+            loadGeneratorStats.portSentPackets.subname(i, csprintf("port%d", i));
+            loadGeneratorStats.portRecvPackets.subname(i, csprintf("port%d", i));
+        }
+        if (num_ports > 1)
+        {
+            for (unsigned i = 0; i < num_ports; i++)
+                loadGeneratorStats.portLatency.emplace_back(new LoadgenLatencyStats(
+                    &loadGeneratorStats, csprintf("port%dLatency", i).c_str()));
+        }
+
+        in_addr src, dst;
+        fatal_if(!inet_aton(p.flow_src_ip.c_str(), &src), "Bad IP %s", p.flow_src_ip);
+        fatal_if(!inet_aton(p.flow_dst_ip.c_str(), &dst), "Bad IP %s", p.flow_dst_ip);
+        flowSrcIP = ntohl(src.s_addr);
+        flowDstIP = ntohl(dst.s_addr);
+
+        if (p.app == "Memcached")
+        {
+            MemcachedWorkload::Config cfg;
+            cfg.protocol = MemcachedWorkload::parseProtocol(p.memcached_protocol);
+            cfg.keyspace = p.memcached_keyspace;
+            cfg.populated = p.memcached_populated;
+            cfg.keySize = MemcachedWorkload::parseSizeDist(p.memcached_key_size);
+            cfg.valueSize = MemcachedWorkload::parseSizeDist(p.memcached_value_size);
+            cfg.getRatio = p.memcached_get_ratio;
+            cfg.maxRequestSize = MaxFrameSize - FlowHeaderSize;
+            memcached.reset(new MemcachedWorkload(cfg, rng));
+            requestMatcher.reset(new LoadgenRequestMatcher(this, 0, p.request_timeout, p.match_max_flows));
+        }
+        else if (p.app != "Raw")
+        {
+            fatal("Unknown loadgen app %s", p.app);
+        }
+
+        if (multiFlow)
+        {
+            fatal_if(!memcached && packetSize < FlowHeaderSize + sizeof(uint64_t),
+                     "Multi-flow packets need at least %d bytes",
+                     FlowHeaderSize + sizeof(uint64_t));
 
-        LoadGenerator::interface = new LoadGenInt("interface", this);
+            LoadgenFlowTable::Config cfg;
+            cfg.numFlows = p.num_flows;
+            cfg.sizeDist = LoadgenFlowTable::parseSizeDist(p.flow_size_dist);
+            cfg.meanSize = p.flow_size;
+            cfg.paretoShape = p.flow_pareto_shape;
+            cfg.numQueues = p.rss_queues;
+            cfg.retaSize = p.rss_reta_size;
+            cfg.targetQueues = p.target_queues;
+            cfg.srcIPBase = flowSrcIP;
+            cfg.dstIP = flowDstIP;
+            cfg.dstPort = memcached ? memcachedPort : p.flow_dst_port;
+            for (auto &shard : shards)
+                shard.flows.reset(new LoadgenFlowTable(cfg, rng));
+            loadGeneratorStats.queuePackets.init(p.rss_queues);
+        }
+        else
+        {
+            loadGeneratorStats.queuePackets.init(1);
+        }
     }
 
     Tick LoadGenerator::frequency()
     {
-        return (1e12/packetRate);
+        if (closedLoop)
+            return (1e12/packetRate);
+        return arrival->next(packetRate);
     }
 
     void LoadGenerator::startup()
     {
-        if (curTick() > stopTick) return;
+        if (restored || curTick() > stopTick) return;
         
-        if (curTick() > startTick)
-            schedule(sendPacketEvent, curTick() + 1);
+        Tick start = curTick() > startTick ? curTick() + 1 : startTick + 1;
+        if (closedLoop) {
+            for (auto &shard : shards)
+                for (unsigned i = 0; i < closedLoopOutstanding; i++)
+                    queueClosedLoopSend(start, shard.port);
+        } else {
+            if (loadgenMode == Mode::Search)
+                startSearchStep(start);
+            for (auto &shard : shards)
+                shard.nextSend = start;
+            scheduleSend();
+        }
+    }
+
+    void LoadGenerator::serialize(CheckpointOut &cp) const
+    {
+        SERIALIZE_SCALAR(started);
+
+        // The configured rate, so a restore with a different packet_rate
+        // can tell that it should move to a new load point.
+        const unsigned packetRateParam = params().packet_rate;
+        SERIALIZE_SCALAR(packetRateParam);
+        SERIALIZE_SCALAR(packetRate);
+        SERIALIZE_SCALAR(burstStartTick);
+        SERIALIZE_SCALAR(lastRxCount);
+        SERIALIZE_SCALAR(lastTxCount);
+        SERIALIZE_SCALAR(outstanding);
+
+        std::vector<Tick> nextSend;
+        std::vector<unsigned> portOutstanding;
+        for (const auto &shard : shards)
+        {
+            nextSend.push_back(shard.nextSend);
+            portOutstanding.push_back(shard.outstanding);
+        }
+        SERIALIZE_CONTAINER(nextSend);
+        SERIALIZE_CONTAINER(portOutstanding);
+
+        std::vector<Tick> closedLoopSendTicks;
+        std::vector<unsigned> closedLoopSendPorts;
+        for (const auto &send : closedLoopSends)
+        {
+            closedLoopSendTicks.push_back(send.first);
+            closedLoopSendPorts.push_back(send.second);
+        }
+        SERIALIZE_CONTAINER(closedLoopSendTicks);
+        SERIALIZE_CONTAINER(closedLoopSendPorts);
+
+        Tick checkLossTime = checkLossEvent.scheduled() ? checkLossEvent.when() : 0;
+        Tick closedLoopTimeoutTime = closedLoopTimeoutEvent.scheduled() ?
+            closedLoopTimeoutEvent.when() : 0;
+        SERIALIZE_SCALAR(checkLossTime);
+        SERIALIZE_SCALAR(closedLoopTimeoutTime);
+
+        SERIALIZE_SCALAR(searchLow);
+        SERIALIZE_SCALAR(searchHigh);
+        SERIALIZE_SCALAR(searchFound);
+        SERIALIZE_SCALAR(searchFloor);
+        SERIALIZE_ENUM(searchPhase);
+
+        rng.serializeSection(cp, "rng");
+        if (arrival)
+            arrival->serializeSection(cp, "arrival");
+        for (const auto &shard : shards)
+            if (shard.flows)
+                shard.flows->serializeSection(cp, csprintf("flows%d", shard.port));
+        if (memcached)
+        {
+            memcached->serializeSection(cp, "memcached");
+            requestMatcher->serializeSection(cp, "requestMatcher");
+        }
+    }
+
+    void LoadGenerator::unserialize(CheckpointIn &cp)
+    {
+        // Nothing was sent before the checkpoint, start afresh from the
+        // restored run's own start tick. Checkpoints that predate the key
+        // carry no load generator state either.
+        if (!UNSERIALIZE_OPT_SCALAR(started) || !started)
+            return;
+        restored = true;
+
+        unsigned packetRateParam;
+        UNSERIALIZE_SCALAR(packetRateParam);
+        UNSERIALIZE_SCALAR(packetRate);
+        if (packetRateParam != params().packet_rate)
+        {
+            inform("%s: restoring at %u pps instead of the checkpointed %u pps",
+                   name(), params().packet_rate, packetRate);
+            packetRate = params().packet_rate;
+        }
+        UNSERIALIZE_SCALAR(burstStartTick);
+        UNSERIALIZE_SCALAR(lastRxCount);
+        UNSERIALIZE_SCALAR(lastTxCount);
+        UNSERIALIZE_SCALAR(outstanding);
+
+        std::vector<Tick> nextSend;
+        std::vector<unsigned> portOutstanding;
+        UNSERIALIZE_CONTAINER(nextSend);
+        UNSERIALIZE_CONTAINER(portOutstanding);
+        fatal_if(nextSend.size() != shards.size(),
+                 "Checkpoint has %d loadgen ports, %d are connected",
+                 nextSend.size(), shards.size());
+        for (auto &shard : shards)
+        {
+            shard.nextSend = nextSend[shard.port];
+            shard.outstanding = portOutstanding[shard.port];
+        }
+
+        std::vector<Tick> closedLoopSendTicks;
+        std::vector<unsigned> closedLoopSendPorts;
+        UNSERIALIZE_CONTAINER(closedLoopSendTicks);
+        UNSERIALIZE_CONTAINER(closedLoopSendPorts);
+        closedLoopSends.clear();
+        for (size_t i = 0; i < closedLoopSendTicks.size(); i++)
+            closedLoopSends.emplace_back(closedLoopSendTicks[i], closedLoopSendPorts[i]);
+        // Older checkpoints may hold reissued requests behind later sends
+        std::stable_sort(closedLoopSends.begin(), closedLoopSends.end(),
+                         [](const auto &a, const auto &b) { return a.first < b.first; });
+
+        Tick checkLossTime;
+        Tick closedLoopTimeoutTime;
+        UNSERIALIZE_SCALAR(checkLossTime);
+        UNSERIALIZE_SCALAR(closedLoopTimeoutTime);
+
+        UNSERIALIZE_SCALAR(searchLow);
+        UNSERIALIZE_SCALAR(searchHigh);
+        UNSERIALIZE_OPT_SCALAR(searchFound);
+        UNSERIALIZE_OPT_SCALAR(searchFloor);
+        UNSERIALIZE_ENUM(searchPhase);
+
+        rng.unserializeSection(cp, "rng");
+        if (arrival)
+            arrival->unserializeSection(cp, "arrival");
+        for (auto &shard : shards)
+            if (shard.flows)
+                shard.flows->unserializeSection(cp, csprintf("flows%d", shard.port));
+        if (memcached)
+        {
+            memcached->unserializeSection(cp, "memcached");
+            requestMatcher->unserializeSection(cp, "requestMatcher");
+        }
+
+        if (checkLossTime)
+            schedule(checkLossEvent, checkLossTime);
+        if (closedLoopTimeoutTime)
+            schedule(closedLoopTimeoutEvent, closedLoopTimeoutTime);
+
+        if (closedLoop)
+        {
+            if (!closedLoopSends.empty())
+                schedule(sendPacketEvent, std::max(curTick(), closedLoopSends.front().first));
+        }
+        else if (searchPhase != SearchPhase::Done)
+        {
+            // The samples of the interrupted step are not checkpointed,
+            // so redo the step from its warm-up.
+            startSearchStep(curTick());
+            resumeSending(0);
+        }
+        else
+        {
+            scheduleSend();
+        }
+    }
+
+    void LoadGenerator::scheduleSend()
+    {
+        Tick next = MaxTick;
+        for (const auto &shard : shards)
+            next = std::min(next, shard.nextSend);
+
+        if (next == MaxTick)
+        {
+            if (sendPacketEvent.scheduled())
+                deschedule(sendPacketEvent);
+            return;
+        }
+        reschedule(sendPacketEvent, std::max(next, curTick()), true);
+    }
+
+    void LoadGenerator::resumeSending(Tick delay)
+    {
+        // Every port draws its own next arrival so they do not move in lockstep.
+        for (auto &shard : shards)
+            shard.nextSend = curTick() + delay + frequency();
+        scheduleSend();
+    }
+
+    void LoadGenerator::pauseSending()
+    {
+        for (auto &shard : shards)
+            shard.nextSend = MaxTick;
+        if (sendPacketEvent.scheduled())
+            deschedule(sendPacketEvent);
+    }
+
+    void LoadGenerator::startSearchStep(Tick when)
+    {
+        packetRate = searchFloor ? searchLow : (searchLow + searchHigh) / 2;
+        searchPhase = SearchPhase::Warmup;
+        schedule(searchEvent, when + searchWarmup);
+        DPRINTF(LoadgenDebug, "Search step at %u pps, interval [%.0f, %.0f]\n",
+                packetRate, searchLow, searchHigh);
+    }
+
+    void LoadGenerator::searchPhaseDone()
+    {
+        switch (searchPhase) {
+          case SearchPhase::Warmup:
+            searchPhase = SearchPhase::Measure;
+            searchTx = 0;
+            searchRx = 0;
+            searchLatency.reset();
+            measureStart = curTick();
+            schedule(searchEvent, curTick() + searchMeasure);
+            break;
+          case SearchPhase::Measure:
+            // Stop sending so late responses can be told apart from loss.
+            searchPhase = SearchPhase::Drain;
+            measureEnd = curTick();
+            pauseSending();
+            schedule(searchEvent, curTick() + searchDrain);
+            break;
+          case SearchPhase::Drain:
+            finishSearchStep();
+            break;
+          default:
+            panic("Unexpected saturation search phase");
+        }
+    }
+
+    void LoadGenerator::finishSearchStep()
+    {
+        const double loss = searchTx ? 1.0 - double(searchRx) / searchTx : 0;
+        const Tick p99 = searchLatency.percentile(0.99);
+        const bool pass = searchTx > 0 && loss <= searchLossTarget &&
+            (searchP99Slo == 0 || p99 <= searchP99Slo);
+        if (pass) {
+            searchLow = packetRate;
+            searchFound = true;
+        } else if (!searchFloor) {
+            searchHigh = packetRate;
+        }
+
+        DPRINTF(LoadgenDebug, "Search step %s at %u pps: Tx %lu, Rx %lu, loss %f, p99 %lu\n",
+                pass ? "passed" : "failed", packetRate, searchTx, searchRx, loss, p99);
+
+        loadGeneratorStats.searchSteps++;
+        loadGeneratorStats.searchStepRate = packetRate;
+        loadGeneratorStats.searchStepLoss = loss;
+        loadGeneratorStats.searchStepP99 = p99;
+        // 0 until a step meets the targets
+        loadGeneratorStats.saturationRate = searchFound ? searchLow : 0;
+        if (searchDumpStats)
+            statistics::schedStatEvent(true, true, curTick(), 0);
+
+        const bool converged = searchFloor ||
+            searchHigh - searchLow <= std::max(1.0, searchPrecision * searchHigh);
+        if (converged && !searchFound && !searchFloor)
+        {
+            // Every step failed, and search_min_rate itself is untested
+            searchFloor = true;
+            startSearchStep(curTick());
+        }
+        else if (converged)
+        {
+            searchPhase = SearchPhase::Done;
+            if (searchFound)
+                inform("%s: saturation search converged at %.0f pps", name(), searchLow);
+            else
+                warn("%s: saturation search found no rate meeting the targets, "
+                     "not even search_min_rate (%.0f pps)", name(), searchLow);
+            if (searchExit) {
+                exitSimLoop("Loadgen saturation search converged");
+                return;
+            }
+            // Keep offering the highest load that met the target.
+            packetRate = searchLow;
+        }
         else
-            schedule(sendPacketEvent, startTick + 1);
+        {
+            startSearchStep(curTick());
+        }
+
+        if (curTick() < stopTick)
+            resumeSending(0);
+    }
+
+    void LoadGenerator::queueClosedLoopSend(Tick when, unsigned port)
+    {
+        // Reissued requests go out now, ahead of sends still thinking.
+        // Sends due at the same tick keep the order they were queued in.
+        auto pos = std::upper_bound(closedLoopSends.begin(), closedLoopSends.end(),
+                                    when, [](Tick t, const auto &send) { return t < send.first; });
+        closedLoopSends.emplace(pos, when, port);
+        reschedule(sendPacketEvent, std::max(curTick(), closedLoopSends.front().first), true);
+    }
+
+    void LoadGenerator::closedLoopTimedOut()
+    {
+        // Responses for the outstanding requests were lost, put the
+        // missing requests back in flight so the loop does not stall.
+        unsigned lost = outstanding;
+        loadGeneratorStats.closedLoopTimeouts += lost;
+        outstanding = 0;
+        DPRINTF(LoadgenDebug, "ClosedLoop timeout, reissuing %u requests\n", lost);
+        for (auto &shard : shards)
+        {
+            for (unsigned i = 0; i < shard.outstanding; i++)
+                queueClosedLoopSend(curTick(), shard.port);
+            shard.outstanding = 0;
+        }
     }
 
     Port & LoadGenerator::getPort(const std::string &if_name, PortID idx)
     {
-        return *interface;
+        if (if_name == "interface")
+        {
+            panic_if(idx < 0 || idx >= shards.size(), "index out of bounds");
+            return *shards[idx].interface;
+        }
+        return SimObject::getPort(if_name, idx);
     }
 
-    void LoadGenerator::buildPacket(EthPacketPtr ethpacket)
+    void LoadGenerator::buildPacket(EthPacketPtr ethpacket, unsigned port)
     {
         // Build Packet header
         // DSTMAC 6 | SRCMAC 6 | LENGTH 2 | DATA
-        uint8_t dst_mac[6] = {0x00, 0x90, 0x00, 0x00, 0x00, 0x01 + loadgenId}; // Use paired NIC's MAC
-        uint8_t src_mac[6] = {0x00, 0x80, 0x00, 0x00, 0x00, 0x01 + loadgenId};
+        uint8_t dst_mac[6] = {0x00, 0x90, 0x00, 0x00, 0x00, uint8_t(0x01 + loadgenId + port)}; // Use paired NIC's MAC
+        uint8_t src_mac[6] = {0x00, 0x80, 0x00, 0x00, 0x00, uint8_t(0x01 + loadgenId + port)};
 
         uint16_t size = ethpacket->length;
 
@@ -77,40 +533,167 @@ namespace gem5
         memcpy(&(ethpacket->data[MACHeaderSize]), &timeStamp, sizeof(uint64_t));
     }
 
-    void LoadGenerator::sendPacket()
+    LoadgenFlow LoadGenerator::nextFlow(Shard &shard)
+    {
+        if (!shard.flows)
+            return {flowSrcIP, flowDstIP, uint16_t(FixedSrcPort + shard.port), memcachedPort, 0, 0};
+
+        const LoadgenFlow &flow = shard.flows->next();
+        loadGeneratorStats.queuePackets[flow.queue]++;
+        loadGeneratorStats.flowsStarted += shard.flows->flowsStarted() - shard.flowsCounted;
+        shard.flowsCounted = shard.flows->flowsStarted();
+        return flow;
+    }
+
+    void LoadGenerator::writeUdpHeaders(EthPacketPtr ethpacket, const LoadgenFlow &flow, unsigned port)
     {
+        // DSTMAC 6 | SRCMAC 6 | TYPE 2 | IPv4 20 | UDP 8
+        uint8_t *data = ethpacket->data;
+        uint8_t dst_mac[6] = {0x00, 0x90, 0x00, 0x00, 0x00, uint8_t(0x01 + loadgenId + port)};
+        uint8_t src_mac[6] = {0x00, 0x80, 0x00, 0x00, 0x00, uint8_t(0x01 + loadgenId + port)};
+        const uint16_t eth_type = htons(ETHERTYPE_IP);
+        memcpy(data, dst_mac, 6);
+        memcpy(data + 6, src_mac, 6);
+        memcpy(data + 12, &eth_type, 2);
+
+        const uint16_t ip_len = ethpacket->length - MACHeaderSize;
+        ip *iph = reinterpret_cast<ip *>(data + MACHeaderSize);
+        memset(iph, 0, sizeof(ip));
+        iph->ip_v = 4;
+        iph->ip_hl = sizeof(ip) / 4;
+        iph->ip_len = htons(ip_len);
+        iph->ip_ttl = 64;
+        iph->ip_p = IPPROTO_UDP;
+        iph->ip_src.s_addr = htonl(flow.srcIP);
+        iph->ip_dst.s_addr = htonl(flow.dstIP);
+
+        // No UDP checksum, which is allowed for IPv4.
+        udphdr *udp = reinterpret_cast<udphdr *>(data + MACHeaderSize + sizeof(ip));
+        udp->uh_sport = htons(flow.srcPort);
+        udp->uh_dport = htons(flow.dstPort);
+        udp->uh_ulen = htons(ip_len - sizeof(ip));
+        udp->uh_sum = 0;
+
+        networking::IpPtr ipp(ethpacket);
+        iph->ip_sum = networking::cksum(ipp);
+    }
+
+    void LoadGenerator::buildFlowPacket(EthPacketPtr ethpacket, Shard &shard)
+    {
+        // Build Packet header
+        // DSTMAC 6 | SRCMAC 6 | TYPE 2 | IPv4 20 | UDP 8 | TIMESTAMP | DATA
+        writeUdpHeaders(ethpacket, nextFlow(shard), shard.port);
+        uint64_t timeStamp = gem5::curTick();
+        memcpy(ethpacket->data + FlowHeaderSize, &timeStamp, sizeof(uint64_t));
+    }
+
+    EthPacketPtr LoadGenerator::buildMemcachedPacket(Shard &shard)
+    {
+        // DSTMAC 6 | SRCMAC 6 | TYPE 2 | IPv4 20 | UDP 8 | MEMCACHED REQUEST
+        EthPacketPtr ethpacket = packetPool.get(MaxFrameSize);
+        MemcachedWorkload::Op op;
+        ethpacket->length = FlowHeaderSize + memcached->next(ethpacket->data + FlowHeaderSize, op);
+        writeUdpHeaders(ethpacket, nextFlow(shard), shard.port);
+
+        if (op == MemcachedWorkload::Op::Get)
+            loadGeneratorStats.memcachedGets++;
+        else
+            loadGeneratorStats.memcachedSets++;
+        requestMatcher->sent(ethpacket, curTick());
+        return ethpacket;
+    }
+
+    void LoadGenerator::transmit(Shard &shard)
+    {
+        started = true;
         loadGeneratorStats.sentPackets++;
+        loadGeneratorStats.portSentPackets[shard.port]++;
         lastTxCount++;
+        if (searchPhase == SearchPhase::Measure)
+            searchTx++;
 
-        EthPacketPtr txPacket = std::make_shared<EthPacketData>(packetSize);
-        txPacket->length = packetSize;
-        buildPacket(txPacket);
-        interface->sendPacket(txPacket);
-        
-        if (curTick() < stopTick)
+        EthPacketPtr txPacket;
+        if (memcached)
         {
-            if (loadgenMode == Mode::Increment)
-            {
-                if (lastTxCount == checkLossInterval)
-                    // allow enough time for any in flight packets to be recieved
-                    schedule(checkLossEvent, curTick() + 100000000);
-                else
-                    schedule(sendPacketEvent, curTick() + frequency());
-            } else if (loadgenMode == Mode::Static)
+            txPacket = buildMemcachedPacket(shard);
+        }
+        else
+        {
+            txPacket = packetPool.get(packetSize);
+            txPacket->length = packetSize;
+            if (shard.flows)
+                buildFlowPacket(txPacket, shard);
+            else
+                buildPacket(txPacket, shard.port);
+        }
+        shard.interface->sendPacket(txPacket);
+    }
+
+    Tick LoadGenerator::nextSendTime(const Shard &shard)
+    {
+        if (curTick() >= stopTick)
+            return MaxTick;
+
+        switch (loadgenMode)
+        {
+          case Mode::Increment:
+            // Stop until sendPacket()'s loss check has run
+            if (checkLossEvent.scheduled() || lastTxCount >= checkLossInterval)
+                return MaxTick;
+            return shard.nextSend + frequency();
+          case Mode::Burst:
+            // Another port may already have started the gap.
+            if (curTick() < burstStartTick)
+                return burstStartTick;
+            if (curTick() - burstStartTick > burstWidth)
             {
-                schedule(sendPacketEvent, curTick() + frequency());
-            } else if (loadgenMode == Mode::Burst)
+                burstStartTick = curTick() + burstGap;
+                DPRINTF(LoadgenDebug, "Burst Ended, next Burst Starts at %lu \n", burstStartTick);
+                return burstStartTick;
+            }
+            return shard.nextSend + frequency();
+          default:
+            return shard.nextSend + frequency();
+        }
+    }
+
+    void LoadGenerator::sendPacket()
+    {
+        if (closedLoop)
+        {
+            Shard &shard = shards[closedLoopSends.front().second];
+            closedLoopSends.pop_front();
+            transmit(shard);
+            shard.outstanding++;
+            outstanding++;
+            if (curTick() >= stopTick) {
+                closedLoopSends.clear();
+                return;
+            }
+            if (!closedLoopSends.empty())
+                schedule(sendPacketEvent, std::max(curTick(), closedLoopSends.front().first));
+            reschedule(closedLoopTimeoutEvent, curTick() + closedLoopTimeout, true);
+            return;
+        }
+
+        // Send everything due within the window on every port, then wake
+        // up once for the earliest next send.
+        const Tick horizon = curTick() + sendWindow;
+        for (auto &shard : shards)
+        {
+            while (shard.nextSend <= horizon)
             {
-                if (curTick() - burstStartTick > burstWidth)
-                    {
-                        burstStartTick = curTick() + burstGap;
-                        DPRINTF(LoadgenDebug, "Burst Ended, next Burst Starts at %lu \n", burstStartTick);
-                        schedule(sendPacketEvent, burstStartTick);
-                    }
-                else 
-                    schedule(sendPacketEvent, curTick() + frequency());
+                transmit(shard);
+                shard.nextSend = nextSendTime(shard);
             }
         }
+        if (loadgenMode == Mode::Increment && lastTxCount >= checkLossInterval &&
+            !checkLossEvent.scheduled())
+        {
+            // allow enough time for any in flight packets to be recieved
+            schedule(checkLossEvent, curTick() + 100000000);
+        }
+        scheduleSend();
     }
 
     void LoadGenerator::checkLoss()
@@ -118,7 +701,7 @@ namespace gem5
         if (lastTxCount - lastRxCount < 10)
         {
             packetRate = packetRate + incrementInterval;
-            schedule(sendPacketEvent, curTick() + frequency());
+            resumeSending(0);
             DPRINTF(LoadgenDebug, "Rate Incremented, now sending packets at %u \n", packetRate);
             DPRINTF(LoadgenDebug, "Rx %lu, Tx %lu \n", lastRxCount, lastTxCount);
         }
@@ -128,7 +711,7 @@ namespace gem5
                 packetRate = packetRate - incrementInterval;
             
             // add extra delay to prevent previouse loss from affecting results
-            schedule(sendPacketEvent, curTick() + frequency() + 100000000);
+            resumeSending(100000000);
             DPRINTF(LoadgenDebug, "Loss Detected, now sending packets at %u \n", packetRate);
             DPRINTF(LoadgenDebug, "Rx %lu, Tx %lu \n", lastRxCount, lastTxCount);
         }
@@ -141,17 +724,50 @@ namespace gem5
         exitSimLoop("m5_exit by loadgen End Simulator.", 0, curTick(), 0, true);
     }
 
-    bool LoadGenerator::processRxPkt(EthPacketPtr pkt)
+    bool LoadGenerator::processRxPkt(EthPacketPtr pkt, unsigned port)
     {
         loadGeneratorStats.recvPackets++;
+        loadGeneratorStats.portRecvPackets[port]++;
         lastRxCount++;
 
         uint64_t sendTick;
-        memcpy(&sendTick, &(pkt->data[MACHeaderSize]), sizeof(uint64_t));
+        if (requestMatcher)
+        {
+            // Responses carry no timestamp, look up their request instead.
+            Tick latency;
+            if (!requestMatcher->received(pkt, curTick(), latency))
+                return true;
+            sendTick = curTick() - latency;
+        }
+        else
+        {
+            memcpy(&sendTick, &(pkt->data[timestampOffset()]), sizeof(uint64_t));
+        }
         
         float delta = float((gem5::curTick() - sendTick))/10.0e8;
         loadGeneratorStats.latency.sample(delta);
+        loadGeneratorStats.latencyPercentiles.sample(gem5::curTick() - sendTick);
+        if (!loadGeneratorStats.portLatency.empty())
+            loadGeneratorStats.portLatency[port]->sample(gem5::curTick() - sendTick);
+        if (loadgenMode == Mode::Search && sendTick >= measureStart &&
+            (searchPhase == SearchPhase::Measure || sendTick < measureEnd))
+        {
+            searchRx++;
+            searchLatency.sample(gem5::curTick() - sendTick);
+        }
         DPRINTF(LoadgenLatency, "Latency %f \n", delta);
+
+        if (closedLoop && shards[port].outstanding > 0)
+        {
+            shards[port].outstanding--;
+            outstanding--;
+            if (outstanding == 0 && closedLoopTimeoutEvent.scheduled())
+                deschedule(closedLoopTimeoutEvent);
+            else if (outstanding > 0)
+                reschedule(closedLoopTimeoutEvent, curTick() + closedLoopTimeout, true);
+            if (curTick() < stopTick)
+                queueClosedLoopSend(curTick() + closedLoopThinkTime, port);
+        }
         return true;
     }
 }
\ No newline at end of file
@@ -1,8 +1,19 @@
 #ifndef __LOAD_GENERATOR_HH__
 #define __LOAD_GENERATOR_HH__
 
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "params/LoadGenerator.hh"
+#include "base/random.hh"
+#include "dev/net/arrival_process.hh"
 #include "dev/net/etherint.hh"
+#include "dev/net/loadgen_flows.hh"
+#include "dev/net/loadgen_latency.hh"
+#include "dev/net/loadgen_request_matcher.hh"
+#include "dev/net/memcached_workload.hh"
 #include "sim/sim_object.hh"
 #include "base/statistics.hh"
 #include "sim/eventq.hh"
@@ -14,13 +25,40 @@ namespace gem5
     class LoadGenerator : public SimObject
     {
 
-        enum class Mode { Static, Increment, Burst};
+        enum class Mode { Static, Increment, Burst, Search};
+        enum class SearchPhase { Warmup, Measure, Drain, Done };
 
         private:
 
             static constexpr unsigned MACHeaderSize = 14;
+            // Ethernet + IPv4 + UDP headers of multi-flow packets.
+            static constexpr unsigned FlowHeaderSize = 42;
+            static constexpr unsigned MaxFrameSize = 1514;
+            // Source port of the single flow sent when there is no flow table.
+            static constexpr uint16_t FixedSrcPort = 10000;
             Mode loadgenMode;
-            LoadGenInt *interface;
+
+            // One shard per port, each paired with its own NIC. All shards
+            // are driven by a single send event.
+            struct Shard
+            {
+                unsigned port;
+                LoadGenInt *interface;
+                Tick nextSend;
+                unsigned outstanding;
+                // Multi-flow mode, null when sending the single raw flow.
+                std::unique_ptr<LoadgenFlowTable> flows;
+                uint64_t flowsCounted;
+            };
+            std::vector<Shard> shards;
+            // Sends due within this window of the send event go out with it.
+            const Tick sendWindow;
+            void transmit(Shard &shard);
+            Tick nextSendTime(const Shard &shard);
+            void resumeSending(Tick delay);
+            void pauseSending();
+            void scheduleSend();
+
             void sendPacket();
             void checkLoss();
             Tick frequency();
@@ -37,35 +75,121 @@ namespace gem5
             Tick burstStartTick;
             uint64_t lastRxCount;
             uint64_t lastTxCount;
+            // Whether any packet was sent yet, and whether the state came
+            // from a checkpoint (startup() must then leave it alone).
+            bool started;
+            bool restored;
             EventFunctionWrapper sendPacketEvent;
             EventFunctionWrapper checkLossEvent;
+            EthPacketPool packetPool;
+
+            // Arrival process, either an inter-arrival generator or
+            // closed loop (keep a fixed number of requests in flight).
+            Random rng;
+            std::unique_ptr<ArrivalProcess> arrival;
+            bool closedLoop;
+            const unsigned closedLoopOutstanding;
+            const Tick closedLoopThinkTime;
+            const Tick closedLoopTimeout;
+            unsigned outstanding;
+            std::deque<std::pair<Tick, unsigned>> closedLoopSends;
+            EventFunctionWrapper closedLoopTimeoutEvent;
+            void queueClosedLoopSend(Tick when, unsigned port);
+            void closedLoopTimedOut();
+
+            // Saturation search: binary search for the highest rate that
+            // meets the loss target and the p99 SLO. Every step warms up
+            // at the new rate, measures, then stops sending and drains.
+            double searchLow;
+            double searchHigh;
+            // A step passed, searchLow met the targets
+            bool searchFound;
+            // Nothing above search_min_rate passed, the last step tries
+            // search_min_rate itself
+            bool searchFloor;
+            const double searchLossTarget;
+            const Tick searchP99Slo;
+            const Tick searchWarmup;
+            const Tick searchMeasure;
+            const Tick searchDrain;
+            const double searchPrecision;
+            const bool searchDumpStats;
+            const bool searchExit;
+            SearchPhase searchPhase;
+            Tick measureStart;
+            Tick measureEnd;
+            uint64_t searchTx;
+            uint64_t searchRx;
+            HdrHistogram searchLatency;
+            EventFunctionWrapper searchEvent;
+            void startSearchStep(Tick when);
+            void searchPhaseDone();
+            void finishSearchStep();
+
+            bool multiFlow;
+            uint32_t flowSrcIP;
+            uint32_t flowDstIP;
+            LoadgenFlow nextFlow(Shard &shard);
+            void writeUdpHeaders(EthPacketPtr ethpacket, const LoadgenFlow &flow, unsigned port);
+            void buildFlowPacket(EthPacketPtr ethpacket, Shard &shard);
+
+            // Memcached requests instead of timestamped packets. Responses
+            // are matched to their request by the UDP frame request ID.
+            std::unique_ptr<MemcachedWorkload> memcached;
+            std::unique_ptr<LoadgenRequestMatcher> requestMatcher;
+            const uint16_t memcachedPort;
+            EthPacketPtr buildMemcachedPacket(Shard &shard);
+            unsigned timestampOffset() const
+            {
+                return multiFlow ? FlowHeaderSize : MACHeaderSize;
+            }
+
             struct LoadGeneratorStats : public statistics::Group
             {
                 LoadGeneratorStats(statistics::Group *parent);
                 statistics::Scalar sentPackets;
                 statistics::Scalar recvPackets;
+                statistics::Scalar closedLoopTimeouts;
+                statistics::Scalar flowsStarted;
+                statistics::Vector queuePackets;
+                statistics::Scalar searchSteps;
+                statistics::Scalar searchStepRate;
+                statistics::Scalar searchStepLoss;
+                statistics::Scalar searchStepP99;
+                statistics::Scalar saturationRate;
+                statistics::Scalar memcachedGets;
+                statistics::Scalar memcachedSets;
+                statistics::Vector portSentPackets;
+                statistics::Vector portRecvPackets;
                 statistics::Histogram latency;
+                LoadgenLatencyStats latencyPercentiles;
+                // Per-port latency, only kept with more than one port.
+                std::vector<std::unique_ptr<LoadgenLatencyStats>> portLatency;
             } loadGeneratorStats;
                         
         public:
+            PARAMS(LoadGenerator);
             LoadGenerator(const LoadGeneratorParams &p);
             Port & getPort(const std::string &if_name, PortID idx);
-            void buildPacket(EthPacketPtr ethpacket);
+            void buildPacket(EthPacketPtr ethpacket, unsigned port);
             void startup();
-            bool processRxPkt(EthPacketPtr pkt);
+            void serialize(CheckpointOut &cp) const override;
+            void unserialize(CheckpointIn &cp) override;
+            bool processRxPkt(EthPacketPtr pkt, unsigned port);
     };
 
     class LoadGenInt : public EtherInt
     {
         private:
             LoadGenerator* dev;
+            const unsigned port;
 
         public: 
-            LoadGenInt(const std::string &name, LoadGenerator *d)
-                : EtherInt(name), dev(d)
+            LoadGenInt(const std::string &name, LoadGenerator *d, unsigned p)
+                : EtherInt(name), dev(d), port(p)
             { }
 
-            virtual bool recvPacket(EthPacketPtr pkt) { return dev->processRxPkt(pkt); }
+            virtual bool recvPacket(EthPacketPtr pkt) { return dev->processRxPkt(pkt, port); }
             virtual void sendDone() { return; }
     }; 
 }
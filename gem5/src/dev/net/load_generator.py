@@ -1,6 +1,6 @@
 from m5.params import *
 from m5.SimObject import SimObject
-from m5.objects.Ethernet import EtherInt
+from m5.objects.Ethernet import VectorEtherInt
 
 
 class LoadGenerator(SimObject):
@@ -8,12 +8,84 @@ class LoadGenerator(SimObject):
     cxx_header = "dev/net/load_generator.hh"
     cxx_class = 'gem5::LoadGenerator'
 
-    interface = EtherInt("interface")
+    interface = VectorEtherInt(
+        "One port per paired NIC, all driven by this generator")
     start_tick =  Param.Tick(1,"Tick at whcih to start loadgenerator")
     stop_tick = Param.Tick(1, "Tick at which to stop loadgenerator")
     packet_size = Param.Int(64,"Packet size in bytes")
     packet_rate = Param.Int(100,"Number of packets per second to send")
-    loadgen_id = Param.Int(0, "For match NIC")
+    loadgen_id = Param.Int(0, "For match NIC, port i uses loadgen_id + i")
     burst_width = Param.Tick(1, "Width of a packet burst in picoseconds")
     burst_gap = Param.Tick(1, "Time of gap between bursts in picoseconds")
-    mode = Param.String("Increment", "LoadgenMode")
\ No newline at end of file
+    mode = Param.String("Increment",
+        "LoadgenMode: Static/Increment/Burst/Search")
+    arrival = Param.String("Fixed",
+        "Arrival process: Fixed/Poisson/MMPP/Trace/ClosedLoop")
+    arrival_seed = Param.UInt32(1, "Seed for the arrival process RNG")
+    arrival_trace = Param.String("",
+        "Inter-arrival trace for Trace arrivals, one tick value per line")
+    mmpp_on_time = Param.Tick(1000000000, "Mean MMPP on period in ticks")
+    mmpp_off_time = Param.Tick(1000000000, "Mean MMPP off period in ticks")
+    closed_loop_outstanding = Param.Unsigned(1,
+        "Requests kept in flight in ClosedLoop arrival mode")
+    closed_loop_think_time = Param.Tick(0,
+        "Delay between a response and the next request in ClosedLoop mode")
+    closed_loop_timeout = Param.Tick(100000000,
+        "Ticks without a response before lost ClosedLoop requests are reissued")
+    num_flows = Param.Unsigned(0,
+        "Concurrent UDP flows to emit, 0 sends the single raw frame flow")
+    flow_size_dist = Param.String("Fixed",
+        "Flow size distribution: Fixed/Exponential/Pareto")
+    flow_size = Param.Unsigned(1000, "Mean flow size in packets")
+    flow_pareto_shape = Param.Float(1.5, "Shape of Pareto flow sizes")
+    flow_src_ip = Param.String("10.10.10.11",
+        "Base source IP, flows use this plus up to 65535")
+    flow_dst_ip = Param.String("10.10.10.10", "Destination IP of all flows")
+    flow_dst_port = Param.UInt16(9000, "Destination UDP port of all flows")
+    rss_queues = Param.Unsigned(1, "Number of RSS queues on the paired NIC")
+    rss_reta_size = Param.Unsigned(128,
+        "RSS redirection table size on the paired NIC")
+    target_queues = VectorParam.Unsigned([],
+        "Queues flows are steered to, spread over all queues if empty")
+    search_min_rate = Param.Unsigned(1000,
+        "Search mode: lowest offered load in packets per second")
+    search_max_rate = Param.Unsigned(10000000,
+        "Search mode: highest offered load in packets per second")
+    search_loss_target = Param.Float(0.001,
+        "Search mode: highest acceptable fraction of lost packets")
+    search_p99_slo = Param.Tick(0,
+        "Search mode: highest acceptable p99 latency, 0 disables the SLO")
+    search_warmup = Param.Tick(100000000,
+        "Search mode: time at a new rate before measuring")
+    search_measure = Param.Tick(1000000000,
+        "Search mode: measurement window per step")
+    search_drain = Param.Tick(100000000,
+        "Search mode: time to wait for in-flight responses after a step")
+    search_precision = Param.Float(0.01,
+        "Search mode: stop once the search interval is this fraction of "
+        "the upper bound")
+    search_dump_stats = Param.Bool(True,
+        "Search mode: dump and reset stats after every step")
+    search_exit = Param.Bool(True,
+        "Search mode: exit the simulation once the search converges")
+    send_window = Param.Latency("0ns",
+        "Sends due within this window of the send event are batched into "
+        "it, trading timing accuracy for fewer events")
+    app = Param.String("Raw",
+        "Payload: Raw timestamped frames or Memcached UDP requests")
+    memcached_protocol = Param.String("Binary",
+        "Memcached protocol: Binary/Ascii")
+    memcached_keyspace = Param.Unsigned(2000, "Number of distinct keys")
+    memcached_populated = Param.Unsigned(1000,
+        "Keys read by GETs, expected to be on the server; SETs use the rest")
+    memcached_key_size = Param.String("10-100-0.9",
+        "Zipfian key size distribution, <min-max-skew>")
+    memcached_value_size = Param.String("100-1000-0.9",
+        "Zipfian value size distribution, <min-max-skew>")
+    memcached_get_ratio = Param.Float(0.9, "Fraction of requests that are GETs")
+    memcached_port = Param.UInt16(11211, "Destination UDP port of requests")
+    request_timeout = Param.Latency("1ms",
+        "Memcached requests without a response after this long count as "
+        "timed out")
+    match_max_flows = Param.Unsigned(16,
+        "Number of client flows with their own memcached latency stats")
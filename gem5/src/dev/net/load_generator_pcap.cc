@@ -26,10 +26,17 @@ LoadGeneratorPcap::LoadGeneratorPcapStats::LoadGeneratorPcapStats(
                "Number of Generated Packets"),
       ADD_STAT(recvPackets, statistics::units::Count::get(),
                "Number of Recieved Packets"),
+      ADD_STAT(traceLoops, statistics::units::Count::get(),
+               "Number of times the trace was restarted"),
+      ADD_STAT(unmatchedResponses, statistics::units::Count::get(),
+               "Number of responses received with no request outstanding"),
       ADD_STAT(latency, statistics::units::Second::get(),
-               "Distribution of Latency in ms") {
+               "Distribution of Latency in ms"),
+      latencyPercentiles(this) {
   sentPackets.precision(0);
   recvPackets.precision(0);
+  traceLoops.precision(0);
+  unmatchedResponses.precision(0);
   latency.init(kLatencyHistSize);
 }
 
@@ -44,9 +51,14 @@ LoadGeneratorPcap::LoadGeneratorPcap(const LoadGeneratorPcapParams &p)
       destIP(p.replace_dest_ip),
       packetRate(p.packet_rate),
       incrementInterval(p.increment_interval),
+      packetPool(p.max_packetsize),
       lastRxCount(0),
       lastTxCount(0),
+      started(false),
+      restored(false),
       pcapFilename(p.pcap_filename),
+      pcap_h(nullptr),
+      loopTrace(p.loop_trace),
       sendPacketEvent([this] { sendPacket(); }, name()),
       checkLossEvent([this] { checkLoss(); }, name()),
       loadGeneratorPcapStats(this) {
@@ -54,16 +66,14 @@ LoadGeneratorPcap::LoadGeneratorPcap(const LoadGeneratorPcapParams &p)
 
   // Setup the packet send times.
   packetSendTimes = std::queue<Tick>();
-  // Setup pcap trace file.
-  char errbuff[PCAP_ERRBUF_SIZE];
-  pcap_h = pcap_open_offline(pcapFilename.c_str(), errbuff);
-  if (pcap_h == nullptr) {
-    fatal("Failed to open %s pcap trace file, error: %s", pcapFilename.c_str(),
-          errbuff);
-  } else {
-    inform("Pcap trace file is loaded: %s", pcapFilename.c_str());
+  if (p.match_mode == "RequestId") {
+    requestMatcher.reset(new LoadgenRequestMatcher(
+        this, p.match_id_offset, p.request_timeout, p.match_max_flows));
+    DPRINTF(LoadgenDebug, "Matching responses by request ID at offset %d\n",
+            p.match_id_offset);
+  } else if (p.match_mode != "Fifo") {
+    fatal("Unknown match mode %s", p.match_mode);
   }
-
   // Stack mode.
   if (p.stack_mode == "KernelStack") {
     stackMode = StackMode::Kernel;
@@ -74,6 +84,28 @@ LoadGeneratorPcap::LoadGeneratorPcap(const LoadGeneratorPcapParams &p)
   } else
     fatal("Unknown stack mode");
 
+  // Setup pcap trace file.
+  if (p.pcap_index) {
+    PcapIndex::Config cfg;
+    cfg.portFilter = portFilter;
+    cfg.maxPacketSize = maxPcktSize;
+    cfg.kernelStack = (stackMode == StackMode::Kernel);
+    cfg.srcIP = srcIP;
+    cfg.destIP = destIP;
+    pcapIndex.reset(new PcapIndex(pcapFilename, p.pcap_index_filename, cfg));
+    fatal_if(pcapIndex->packets() == 0, "No packets left in %s after filtering",
+             pcapFilename);
+  } else {
+    char errbuff[PCAP_ERRBUF_SIZE];
+    pcap_h = pcap_open_offline(pcapFilename.c_str(), errbuff);
+    if (pcap_h == nullptr) {
+      fatal("Failed to open %s pcap trace file, error: %s",
+            pcapFilename.c_str(), errbuff);
+    } else {
+      inform("Pcap trace file is loaded: %s", pcapFilename.c_str());
+    }
+  }
+
   // Other params.
   if (p.replay_mode == "SimpleReplay") {
     replayMode = ReplayMode::SimpleReplay;
@@ -103,7 +135,7 @@ Tick LoadGeneratorPcap::frequency()
         return (1e12/packetRate);
     }
 void LoadGeneratorPcap::startup() {
-  if (curTick() > stopTick) 
+  if (restored || curTick() > stopTick)
     return;
 
   if (curTick() > startTick) {
@@ -115,6 +147,97 @@ void LoadGeneratorPcap::startup() {
   }
 }
 
+void LoadGeneratorPcap::serialize(CheckpointOut &cp) const {
+  SERIALIZE_SCALAR(started);
+
+  // The configured rate, so a restore with a different packet_rate can
+  // tell that it should move to a new load point.
+  const uint32_t packetRateParam = params().packet_rate;
+  SERIALIZE_SCALAR(packetRateParam);
+  SERIALIZE_SCALAR(packetRate);
+  SERIALIZE_SCALAR(lastRxCount);
+  SERIALIZE_SCALAR(lastTxCount);
+
+  std::vector<Tick> sendTimes;
+  std::queue<Tick> send_times = packetSendTimes;
+  for (; !send_times.empty(); send_times.pop())
+    sendTimes.push_back(send_times.front());
+  SERIALIZE_CONTAINER(sendTimes);
+
+  // Position of the next packet in the trace.
+  const bool indexed = bool(pcapIndex);
+  uint64_t traceOffset = 0;
+  if (pcapIndex)
+    traceOffset = pcapIndex->offset();
+  else if (pcap_h)
+    traceOffset = ftell(pcap_file(pcap_h));
+  SERIALIZE_SCALAR(indexed);
+  SERIALIZE_SCALAR(traceOffset);
+
+  Tick sendPacketTime =
+      sendPacketEvent.scheduled() ? sendPacketEvent.when() : 0;
+  Tick checkLossTime = checkLossEvent.scheduled() ? checkLossEvent.when() : 0;
+  SERIALIZE_SCALAR(sendPacketTime);
+  SERIALIZE_SCALAR(checkLossTime);
+
+  if (requestMatcher)
+    requestMatcher->serializeSection(cp, "requestMatcher");
+}
+
+void LoadGeneratorPcap::unserialize(CheckpointIn &cp) {
+  // Nothing was sent before the checkpoint, start afresh from the
+  // restored run's own start tick. Checkpoints that predate the key
+  // carry no load generator state either.
+  if (!UNSERIALIZE_OPT_SCALAR(started) || !started)
+    return;
+  restored = true;
+
+  uint32_t packetRateParam;
+  UNSERIALIZE_SCALAR(packetRateParam);
+  UNSERIALIZE_SCALAR(packetRate);
+  if (packetRateParam != params().packet_rate) {
+    inform("%s: restoring at %u pps instead of the checkpointed %u pps",
+           name(), params().packet_rate, packetRate);
+    packetRate = params().packet_rate;
+  }
+  UNSERIALIZE_SCALAR(lastRxCount);
+  UNSERIALIZE_SCALAR(lastTxCount);
+
+  std::vector<Tick> sendTimes;
+  UNSERIALIZE_CONTAINER(sendTimes);
+  packetSendTimes = std::queue<Tick>();
+  for (Tick t : sendTimes)
+    packetSendTimes.push(t);
+
+  bool indexed;
+  uint64_t traceOffset;
+  UNSERIALIZE_SCALAR(indexed);
+  UNSERIALIZE_SCALAR(traceOffset);
+  fatal_if(indexed != bool(pcapIndex),
+           "Checkpoint was taken with pcap_index=%d, restoring with %d",
+           indexed, bool(pcapIndex));
+  if (pcapIndex) {
+    fatal_if(!pcapIndex->seek(traceOffset),
+             "Checkpointed offset %d is outside pcap index %s", traceOffset,
+             pcapIndex->filename());
+  } else if (pcap_h) {
+    fatal_if(fseek(pcap_file(pcap_h), traceOffset, SEEK_SET) != 0,
+             "Failed to seek to %d in %s", traceOffset, pcapFilename);
+  }
+
+  Tick sendPacketTime;
+  Tick checkLossTime;
+  UNSERIALIZE_SCALAR(sendPacketTime);
+  UNSERIALIZE_SCALAR(checkLossTime);
+  if (sendPacketTime)
+    schedule(sendPacketEvent, sendPacketTime);
+  if (checkLossTime)
+    schedule(checkLossEvent, checkLossTime);
+
+  if (requestMatcher)
+    requestMatcher->unserializeSection(cp, "requestMatcher");
+}
+
 Port &LoadGeneratorPcap::getPort(const std::string &if_name, PortID idx) {
   return *interface;
 }
@@ -149,9 +272,49 @@ void LoadGeneratorPcap::buildEthernetHeader(EthPacketPtr ethpacket) const {
   memcpy(ethpacket->data, head, kEtherHeaderSize);
 }
 
-void LoadGeneratorPcap::sendPacket() {
-  DPRINTF(LoadgenDebug, "LoadGenPcap::sendPacket executed\n");
+bool LoadGeneratorPcap::endOfTrace() {
+  if (loopTrace) {
+    DPRINTF(LoadgenDebug, "End of pcap trace is reached, restarting it\n");
+    loadGeneratorPcapStats.traceLoops++;
+    if (pcapIndex) {
+      pcapIndex->rewind();
+    } else {
+      char errbuff[PCAP_ERRBUF_SIZE];
+      pcap_close(pcap_h);
+      pcap_h = pcap_open_offline(pcapFilename.c_str(), errbuff);
+      if (pcap_h == nullptr)
+        fatal("Failed to reopen %s pcap trace file, error: %s",
+              pcapFilename.c_str(), errbuff);
+    }
+    return true;
+  }
+
+  DPRINTF(LoadgenDebug, "End of pcap trace is reached!\n");
+  DPRINTF(LoadgenDebug, "Nothing will be scheduled in the loadgen, exiting here.\n");
+  DPRINTF(LoadgenDebug, "Bye!\n");
+  exitSimLoop("END OF PCAP TRACE" "\nSIM TERMINATED BY LOADGEN");
+  return false;
+}
 
+bool LoadGeneratorPcap::readIndexedPacket(EthPacketPtr &txPacket) {
+  const uint8_t *payload;
+  uint16_t len;
+  if (!pcapIndex->next(payload, len)) {
+    if (!endOfTrace())
+      return false;
+    pcapIndex->next(payload, len);
+  }
+
+  // The index holds everything past the Ethernet header, already
+  // filtered and rewritten.
+  txPacket = packetPool.get(len + kEtherHeaderSize);
+  txPacket->length = len + kEtherHeaderSize;
+  buildEthernetHeader(txPacket);
+  memcpy(txPacket->data + kEtherHeaderSize, payload, len);
+  return true;
+}
+
+bool LoadGeneratorPcap::readPcapPacket(EthPacketPtr &txPacket) {
   // Read a packet from pcap file.
   pcap_pkthdr *pcap_header;
   const u_char *pcap_data;
@@ -159,35 +322,32 @@ void LoadGeneratorPcap::sendPacket() {
     int ret = pcap_next_ex(pcap_h, &pcap_header, &pcap_data);
     if (ret < 0) {
       // Perhaps EOF.
-      DPRINTF(LoadgenDebug, "End of pcap trace is reached!\n");
-      DPRINTF(LoadgenDebug, "Nothing will be scheduled in the loadgen, exiting here.\n");
-      DPRINTF(LoadgenDebug, "Bye!\n");
-      exitSimLoop("END OF PCAP TRACE" "\nSIM TERMINATED BY LOADGEN"); 
-      // schedule(checkLossEvent, curTick() + kLossCheckWaitCycles);
-      return;
-      // TODO: can start over...
+      if (!endOfTrace())
+        return false;
+      schedule(sendPacketEvent, curTick() + 1);
+      return false;
     }
   } else {
     warn("No pcap file loaded, nothing will be scheduled next!");
-    return;
+    return false;
   }
 
   // Check we have the full packet here.
   if (pcap_header->len != pcap_header->caplen) {
     DPRINTF(LoadgenDebug, "Broken pcap trace detected, skip it...\n");
     schedule(sendPacketEvent, curTick() + 1);
-    return;
+    return false;
   }
 
   // Skip large packets.
   if (pcap_header->len > maxPcktSize) {
     DPRINTF(LoadgenDebug, "Large packet detected, skip it...\n");
     schedule(sendPacketEvent, curTick() + 1);
-    return;
+    return false;
   }
 
   // Create packet depending on the stack type.
-  EthPacketPtr txPacket = std::make_shared<EthPacketData>(pcap_header->len);
+  txPacket = packetPool.get(pcap_header->len);
   txPacket->length = pcap_header->len;
   if (stackMode == StackMode::Kernel) {
     // Check it is an IPv4 packet.
@@ -197,7 +357,7 @@ void LoadGeneratorPcap::sendPacket() {
     if (ether_type != ETHERTYPE_IP) {
       DPRINTF(LoadgenDebug, "Not an IP packet in trace detected, skip it...\n");
       schedule(sendPacketEvent, curTick() + 1);
-      return;
+      return false;
     }
 
     pcap_data += sizeof(ether_header);
@@ -206,7 +366,7 @@ void LoadGeneratorPcap::sendPacket() {
       DPRINTF(LoadgenDebug,
               "Not an IPv4 packet in trace detected, skip it...\n");
       schedule(sendPacketEvent, curTick() + 1);
-      return;
+      return false;
     }
 
     // Check if it is a UDP packet.
@@ -214,7 +374,7 @@ void LoadGeneratorPcap::sendPacket() {
       DPRINTF(LoadgenDebug,
               "Not an UDP packet in trace detected, skip it...\n");
       schedule(sendPacketEvent, curTick() + 1);
-      return;
+      return false;
     }
 
     // If needed - filter by dest port.
@@ -223,7 +383,7 @@ void LoadGeneratorPcap::sendPacket() {
     if (ntohs(udp->uh_dport) != portFilter) {
       DPRINTF(LoadgenDebug, "Packet was filter-out by port...\n");
       schedule(sendPacketEvent, curTick() + 1);
-      return;
+      return false;
     }
 
     // Replace the source and destination IP address by the one in configuration
@@ -248,13 +408,30 @@ void LoadGeneratorPcap::sendPacket() {
     memcpy(txPacket->data + kEtherHeaderSize, pcap_data,
            pcap_header->len - kEtherHeaderSize);
   }
+  return true;
+}
+
+void LoadGeneratorPcap::sendPacket() {
+  DPRINTF(LoadgenDebug, "LoadGenPcap::sendPacket executed\n");
+
+  EthPacketPtr txPacket;
+  if (pcapIndex) {
+    if (!readIndexedPacket(txPacket))
+      return;
+  } else if (!readPcapPacket(txPacket)) {
+    return;
+  }
 
   // Send packet.
   interface->sendPacket(txPacket);
   DPRINTF(LoadgenDebug, "Packet was sent!\n");
 
+  started = true;
   Tick currentTick = curTick();
-  packetSendTimes.push(currentTick);
+  if (requestMatcher)
+    requestMatcher->sent(txPacket, currentTick);
+  else
+    packetSendTimes.push(currentTick);
   // Increment stats.
   loadGeneratorPcapStats.sentPackets++;
   lastTxCount++;
@@ -318,14 +495,26 @@ bool LoadGeneratorPcap::processRxPkt(EthPacketPtr pkt) {
   loadGeneratorPcapStats.recvPackets++;
   lastRxCount++;
 
-  // assuming FIFO ordering of responses which is not necessierly true
-  uint64_t sendTick = packetSendTimes.front();
-  if (packetSendTimes.size() > 0)
+  Tick sendTick;
+  if (requestMatcher) {
+    Tick latency;
+    if (!requestMatcher->received(pkt, curTick(), latency))
+      return true;
+    sendTick = curTick() - latency;
+  } else {
+    // Assumes FIFO ordering of responses, which is not necessarily true.
+    if (packetSendTimes.empty()) {
+      loadGeneratorPcapStats.unmatchedResponses++;
+      return true;
+    }
+    sendTick = packetSendTimes.front();
     packetSendTimes.pop();
+  }
   // uint64_t sendTick;
   // memcpy(&sendTick, &(pkt->data[8]), sizeof(uint64_t));
   float delta = float((gem5::curTick() - sendTick)) / 10.0e8;
   loadGeneratorPcapStats.latency.sample(delta);
+  loadGeneratorPcapStats.latencyPercentiles.sample(gem5::curTick() - sendTick);
   DPRINTF(LoadgenLatency, "Latency %f \n", delta);
   return true;
 }
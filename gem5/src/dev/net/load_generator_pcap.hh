@@ -2,10 +2,15 @@
 #define __LOAD_GENERATOR_HH__
 
 #include <pcap/pcap.h>
+
+#include <memory>
 #include <queue>
 
 #include "base/statistics.hh"
 #include "dev/net/etherint.hh"
+#include "dev/net/loadgen_latency.hh"
+#include "dev/net/loadgen_request_matcher.hh"
+#include "dev/net/pcap_index.hh"
 #include "params/LoadGeneratorPcap.hh"
 #include "sim/eventq.hh"
 #include "sim/sim_object.hh"
@@ -41,14 +46,29 @@ class LoadGeneratorPcap : public SimObject {
   Tick incrementInterval;
   std::queue<Tick> packetSendTimes;
 
+  // Matches responses by request ID, replaces packetSendTimes when enabled.
+  std::unique_ptr<LoadgenRequestMatcher> requestMatcher;
+
+  // Recycled transmit buffers, sized for maxPcktSize.
+  EthPacketPool packetPool;
+
   // Stats for checking the loss.
   uint64_t lastRxCount;
   uint64_t lastTxCount;
 
+  // Whether any packet was sent yet, and whether the state came from a
+  // checkpoint (startup() must then leave it alone).
+  bool started;
+  bool restored;
+
   // Pcap related configuration.
   std::string pcapFilename;
   pcap_t *pcap_h;
 
+  // Pre-filtered packet cache, replaces pcap_h when enabled.
+  std::unique_ptr<PcapIndex> pcapIndex;
+  const bool loopTrace;
+
   // Scheduling events.
   EventFunctionWrapper sendPacketEvent;
   EventFunctionWrapper checkLossEvent;
@@ -57,7 +77,10 @@ class LoadGeneratorPcap : public SimObject {
     LoadGeneratorPcapStats(statistics::Group *parent);
     statistics::Scalar sentPackets;
     statistics::Scalar recvPackets;
+    statistics::Scalar traceLoops;
+    statistics::Scalar unmatchedResponses;
     statistics::Histogram latency;
+    LoadgenLatencyStats latencyPercentiles;
   } loadGeneratorPcapStats;
 
   // Scheduling event callbacks.
@@ -69,15 +92,28 @@ class LoadGeneratorPcap : public SimObject {
   // Incapsulate packet into Ethernet frame.
   void buildEthernetHeader(EthPacketPtr ethpacket) const;
 
+  // Read the next packet from the pcap with libpcap, or from the index.
+  // Both return false if nothing is to be sent now; the caller must not
+  // reschedule in that case.
+  bool readPcapPacket(EthPacketPtr &txPacket);
+  bool readIndexedPacket(EthPacketPtr &txPacket);
+
+  // Handle the end of the trace, returns true if the trace was restarted.
+  bool endOfTrace();
+
   // inline Tick pckt_freq() const { return 1e12 / packetRate; }
 
  public:
+  PARAMS(LoadGeneratorPcap);
   LoadGeneratorPcap(const LoadGeneratorPcapParams &p);
   ~LoadGeneratorPcap();
 
   Port &getPort(const std::string &if_name, PortID idx);
   void startup();
 
+  void serialize(CheckpointOut &cp) const override;
+  void unserialize(CheckpointIn &cp) override;
+
   bool processRxPkt(EthPacketPtr pkt);
 };
 
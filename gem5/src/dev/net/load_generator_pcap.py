@@ -21,3 +21,20 @@ class LoadGeneratorPcap(SimObject):
     replay_mode = Param.String("SimpleReplay", "SimpleReplay/ReplayAndAdjustThroughput/ConstThroughput")
     packet_rate = Param.Int(1, "To be used in ReplayAndAdjustThroughput/ConstThroughput")
     increment_interval = Param.Int(1, "To be used in ReplayAndAdjustThroughput")
+    pcap_index = Param.Bool(False,
+        "Replay from a pre-filtered, memory-mapped index of the pcap")
+    pcap_index_filename = Param.String("",
+        "Index file to use or build, defaults to <pcap_filename>.lgidx")
+    loop_trace = Param.Bool(False,
+        "Restart from the first packet at the end of the trace instead of "
+        "exiting")
+    match_mode = Param.String("Fifo",
+        "How responses are matched to requests for latency: Fifo assumes "
+        "in-order responses, RequestId uses the ID in the UDP payload")
+    match_id_offset = Param.Unsigned(0,
+        "Offset of the 16-bit request ID in the UDP payload, 0 is the "
+        "memcached UDP frame header")
+    request_timeout = Param.Latency("1ms",
+        "Requests without a response after this long count as timed out")
+    match_max_flows = Param.Unsigned(16,
+        "Number of client flows with their own latency stats")
@@ -0,0 +1,172 @@
+#include "dev/net/loadgen_flows.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "base/logging.hh"
+#include "dev/net/arrival_process.hh"
+
+namespace gem5
+{
+
+LoadgenFlowTable::LoadgenFlowTable(const Config &_cfg, Random &_rng)
+    : cfg(_cfg), rng(_rng), reta(_cfg.retaSize, _cfg.numQueues),
+      flows(_cfg.numFlows), cursor(0), started(0)
+{
+    fatal_if(cfg.numFlows == 0, "A flow table needs at least one flow");
+    fatal_if(cfg.numQueues == 0, "A flow table needs at least one queue");
+    fatal_if(cfg.retaSize == 0, "A flow table needs a redirection table");
+    fatal_if(cfg.meanSize < 1, "Mean flow size must be at least 1 packet");
+    fatal_if(cfg.sizeDist == SizeDist::Pareto && cfg.paretoShape <= 1,
+             "Pareto flow sizes need a shape above 1");
+    for (auto q : cfg.targetQueues) {
+        fatal_if(q >= cfg.numQueues, "Target queue %d out of range, the NIC "
+                 "has %d queues", q, cfg.numQueues);
+    }
+
+    // start() draws tuples until one hashes to the flow's queue, which
+    // never happens for a queue no RETA entry points to.
+    std::vector<bool> reachable(cfg.numQueues, false);
+    for (size_t i = 0; i < reta.size(); i++)
+        reachable[reta[i]] = true;
+    for (size_t i = 0; i < flows.size(); i++) {
+        uint16_t queue = cfg.targetQueues.empty() ?
+            i % cfg.numQueues : cfg.targetQueues[i % cfg.targetQueues.size()];
+        fatal_if(!reachable[queue], "No RETA entry maps to queue %d, the "
+                 "%d entry table cannot reach all %d queues", queue,
+                 reta.size(), cfg.numQueues);
+    }
+
+    for (size_t i = 0; i < flows.size(); i++) {
+        uint16_t queue = cfg.targetQueues.empty() ?
+            i % cfg.numQueues : cfg.targetQueues[i % cfg.targetQueues.size()];
+        start(flows[i], queue);
+    }
+}
+
+LoadgenFlowTable::SizeDist
+LoadgenFlowTable::parseSizeDist(const std::string &name)
+{
+    if (name == "Fixed")
+        return SizeDist::Fixed;
+    else if (name == "Exponential")
+        return SizeDist::Exponential;
+    else if (name == "Pareto")
+        return SizeDist::Pareto;
+    fatal("Unknown flow size distribution %s", name);
+}
+
+uint64_t
+LoadgenFlowTable::drawSize()
+{
+    double size;
+    switch (cfg.sizeDist) {
+      case SizeDist::Exponential:
+        size = exponentialSample(rng, cfg.meanSize);
+        break;
+      case SizeDist::Pareto:
+        {
+            // Scale chosen so the distribution has the configured mean.
+            const double xm =
+                cfg.meanSize * (cfg.paretoShape - 1) / cfg.paretoShape;
+            std::uniform_real_distribution<double> u(0.0, 1.0);
+            size = xm / std::pow(1.0 - u(rng.gen), 1.0 / cfg.paretoShape);
+        }
+        break;
+      default:
+        size = cfg.meanSize;
+        break;
+    }
+    return std::max<uint64_t>(1, std::llround(size));
+}
+
+void
+LoadgenFlowTable::start(LoadgenFlow &flow, uint16_t queue)
+{
+    flow.dstIP = cfg.dstIP;
+    flow.dstPort = cfg.dstPort;
+    flow.queue = queue;
+    flow.remaining = drawSize();
+
+    // Each try hits the wanted queue with probability 1/numQueues, the
+    // cap only guards against a key that never hashes to it.
+    const unsigned max_tries = 1024 * cfg.numQueues;
+    unsigned tries = 0;
+    do {
+        fatal_if(++tries > max_tries, "Found no flow tuple for queue %d "
+                 "in %d tries", queue, max_tries);
+        flow.srcIP = cfg.srcIPBase + rng.random<uint32_t>(0, 0xffff);
+        flow.srcPort = rng.random<uint16_t>(1024, 0xffff);
+    } while (reta.queue(rss::hashIPv4(rss::DefaultKey, flow.srcIP,
+                     flow.dstIP, flow.srcPort, flow.dstPort)) != queue);
+
+    started++;
+}
+
+const LoadgenFlow &
+LoadgenFlowTable::next()
+{
+    LoadgenFlow &flow = flows[cursor];
+    if (++cursor == flows.size())
+        cursor = 0;
+
+    if (flow.remaining == 0)
+        start(flow, flow.queue);
+    flow.remaining--;
+    return flow;
+}
+
+void
+LoadgenFlowTable::serialize(CheckpointOut &cp) const
+{
+    std::vector<uint32_t> src_ip, dst_ip;
+    std::vector<uint16_t> src_port, dst_port, queue;
+    std::vector<uint64_t> remaining;
+    for (const auto &flow : flows) {
+        src_ip.push_back(flow.srcIP);
+        dst_ip.push_back(flow.dstIP);
+        src_port.push_back(flow.srcPort);
+        dst_port.push_back(flow.dstPort);
+        queue.push_back(flow.queue);
+        remaining.push_back(flow.remaining);
+    }
+    SERIALIZE_CONTAINER(src_ip);
+    SERIALIZE_CONTAINER(dst_ip);
+    SERIALIZE_CONTAINER(src_port);
+    SERIALIZE_CONTAINER(dst_port);
+    SERIALIZE_CONTAINER(queue);
+    SERIALIZE_CONTAINER(remaining);
+    SERIALIZE_SCALAR(cursor);
+    SERIALIZE_SCALAR(started);
+}
+
+void
+LoadgenFlowTable::unserialize(CheckpointIn &cp)
+{
+    std::vector<uint32_t> src_ip, dst_ip;
+    std::vector<uint16_t> src_port, dst_port, queue;
+    std::vector<uint64_t> remaining;
+    UNSERIALIZE_CONTAINER(src_ip);
+    UNSERIALIZE_CONTAINER(dst_ip);
+    UNSERIALIZE_CONTAINER(src_port);
+    UNSERIALIZE_CONTAINER(dst_port);
+    UNSERIALIZE_CONTAINER(queue);
+    UNSERIALIZE_CONTAINER(remaining);
+    UNSERIALIZE_SCALAR(cursor);
+    UNSERIALIZE_SCALAR(started);
+
+    fatal_if(src_ip.size() != flows.size(),
+             "Checkpoint has %d flows, %d configured", src_ip.size(),
+             flows.size());
+    for (size_t i = 0; i < flows.size(); i++) {
+        fatal_if(queue[i] >= cfg.numQueues,
+                 "Checkpointed flow targets queue %d of %d", queue[i],
+                 cfg.numQueues);
+        flows[i] = {src_ip[i], dst_ip[i], src_port[i], dst_port[i], queue[i],
+                    remaining[i]};
+    }
+    cursor %= flows.size();
+}
+
+} // namespace gem5
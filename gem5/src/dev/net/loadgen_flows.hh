@@ -0,0 +1,90 @@
+#ifndef __DEV_NET_LOADGEN_FLOWS_HH__
+#define __DEV_NET_LOADGEN_FLOWS_HH__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "base/random.hh"
+#include "dev/net/rss.hh"
+#include "sim/serialize.hh"
+
+namespace gem5
+{
+
+/** One UDP flow emitted by the load generator. */
+struct LoadgenFlow
+{
+    uint32_t srcIP;
+    uint32_t dstIP;
+    uint16_t srcPort;
+    uint16_t dstPort;
+    /** RSS queue the flow hashes to on the receiving NIC. */
+    uint16_t queue;
+    /** Packets left before the flow ends. */
+    uint64_t remaining;
+};
+
+/**
+ * Set of concurrent flows for a single load generator. Each flow is
+ * pinned to a target receive queue: its 5-tuple is drawn at random until
+ * the Toeplitz hash, looked up in the NIC's redirection table, selects
+ * that queue. Packets are spread round-robin over the active flows, and
+ * a flow that has sent all its packets is replaced by a fresh flow for
+ * the same queue, so the per-queue load stays fixed while the flows
+ * themselves churn.
+ */
+class LoadgenFlowTable : public Serializable
+{
+  public:
+    enum class SizeDist { Fixed, Exponential, Pareto };
+
+    struct Config
+    {
+        unsigned numFlows;
+        SizeDist sizeDist;
+        /** Mean flow size in packets. */
+        double meanSize;
+        /** Shape of the Pareto size distribution, must be > 1. */
+        double paretoShape;
+        unsigned numQueues;
+        size_t retaSize;
+        /** Queues flows are directed to, all queues if empty. */
+        std::vector<unsigned> targetQueues;
+        /** Source IPs are drawn from srcIPBase + [0, 65535]. */
+        uint32_t srcIPBase;
+        uint32_t dstIP;
+        uint16_t dstPort;
+    };
+
+  private:
+    const Config cfg;
+    Random &rng;
+    rss::RedirectionTable reta;
+    std::vector<LoadgenFlow> flows;
+    size_t cursor;
+    uint64_t started;
+
+    uint64_t drawSize();
+    void start(LoadgenFlow &flow, uint16_t queue);
+
+  public:
+    LoadgenFlowTable(const Config &_cfg, Random &_rng);
+
+    /** Flow that carries the next packet, with remaining already taken. */
+    const LoadgenFlow &next();
+
+    /** Number of flows started so far, including the initial ones. */
+    uint64_t flowsStarted() const { return started; }
+
+    unsigned numQueues() const { return cfg.numQueues; }
+
+    static SizeDist parseSizeDist(const std::string &name);
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+};
+
+} // namespace gem5
+
+#endif // __DEV_NET_LOADGEN_FLOWS_HH__
@@ -0,0 +1,40 @@
+#include "dev/net/loadgen_latency.hh"
+
+namespace gem5
+{
+
+LoadgenLatencyStats::LoadgenLatencyStats(statistics::Group *parent,
+                                         const char *name)
+    : statistics::Group(parent, name),
+      ADD_STAT(samples, statistics::units::Count::get(),
+               "Number of latency samples"),
+      ADD_STAT(min, statistics::units::Tick::get(), "Minimum latency"),
+      ADD_STAT(mean, statistics::units::Tick::get(), "Mean latency"),
+      ADD_STAT(max, statistics::units::Tick::get(), "Maximum latency"),
+      ADD_STAT(p50, statistics::units::Tick::get(), "50th percentile latency"),
+      ADD_STAT(p90, statistics::units::Tick::get(), "90th percentile latency"),
+      ADD_STAT(p99, statistics::units::Tick::get(), "99th percentile latency"),
+      ADD_STAT(p999, statistics::units::Tick::get(),
+               "99.9th percentile latency"),
+      ADD_STAT(p9999, statistics::units::Tick::get(),
+               "99.99th percentile latency")
+{
+    samples.functor([this] { return hist.size(); }).precision(0);
+    min.functor([this] { return hist.min(); }).precision(0);
+    mean.functor([this] { return hist.mean(); });
+    max.functor([this] { return hist.max(); }).precision(0);
+    p50.functor([this] { return hist.percentile(0.5); }).precision(0);
+    p90.functor([this] { return hist.percentile(0.9); }).precision(0);
+    p99.functor([this] { return hist.percentile(0.99); }).precision(0);
+    p999.functor([this] { return hist.percentile(0.999); }).precision(0);
+    p9999.functor([this] { return hist.percentile(0.9999); }).precision(0);
+}
+
+void
+LoadgenLatencyStats::resetStats()
+{
+    statistics::Group::resetStats();
+    hist.reset();
+}
+
+} // namespace gem5
@@ -0,0 +1,46 @@
+#ifndef __DEV_NET_LOADGEN_LATENCY_HH__
+#define __DEV_NET_LOADGEN_LATENCY_HH__
+
+#include "base/hdr_histogram.hh"
+#include "base/statistics.hh"
+#include "base/types.hh"
+
+namespace gem5
+{
+
+/**
+ * High-resolution latency recorder shared by the load generators. Samples
+ * are kept in a log-linear HdrHistogram so tail percentiles keep a
+ * bounded relative error, and the percentiles are exported as stats.
+ * The recorder is cleared whenever the stats are reset, so each stats
+ * dump covers only its own window.
+ */
+class LoadgenLatencyStats : public statistics::Group
+{
+  private:
+    HdrHistogram hist;
+
+  public:
+    LoadgenLatencyStats(statistics::Group *parent,
+                        const char *name = "latencyPercentiles");
+
+    void sample(Tick latency) { hist.sample(latency); }
+
+    const HdrHistogram &histogram() const { return hist; }
+
+    void resetStats() override;
+
+    statistics::Value samples;
+    statistics::Value min;
+    statistics::Value mean;
+    statistics::Value max;
+    statistics::Value p50;
+    statistics::Value p90;
+    statistics::Value p99;
+    statistics::Value p999;
+    statistics::Value p9999;
+};
+
+} // namespace gem5
+
+#endif // __DEV_NET_LOADGEN_LATENCY_HH__
@@ -0,0 +1,330 @@
+#include "dev/net/loadgen_request_matcher.hh"
+
+#include <arpa/inet.h>
+
+#include <cstring>
+
+#include "base/cprintf.hh"
+#include "base/inet.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/LoadgenLatency.hh"
+#include "sim/cur_tick.hh"
+
+namespace gem5
+{
+
+namespace
+{
+
+/** Size of the memcached UDP frame header preceding the request. */
+constexpr unsigned kMemcachedUdpHeader = 8;
+
+constexpr uint8_t kBinaryMagicRequest = 0x80;
+
+LoadgenRequestMatcher::ReqType
+classify(const uint8_t *data, size_t len)
+{
+    if (len == 0)
+        return LoadgenRequestMatcher::Other;
+
+    if (data[0] == kBinaryMagicRequest && len > 1) {
+        switch (data[1]) {
+          case 0x00: // GET
+          case 0x09: // GETQ
+          case 0x0c: // GETK
+          case 0x0d: // GETKQ
+            return LoadgenRequestMatcher::Get;
+          case 0x01: // SET
+          case 0x11: // SETQ
+            return LoadgenRequestMatcher::Set;
+          default:
+            return LoadgenRequestMatcher::Other;
+        }
+    }
+
+    if ((len >= 4 && memcmp(data, "get ", 4) == 0) ||
+            (len >= 5 && memcmp(data, "gets ", 5) == 0))
+        return LoadgenRequestMatcher::Get;
+    if (len >= 4 && memcmp(data, "set ", 4) == 0)
+        return LoadgenRequestMatcher::Set;
+    return LoadgenRequestMatcher::Other;
+}
+
+uint64_t
+requestKey(uint64_t client, uint16_t id)
+{
+    return (client << 16) | id;
+}
+
+uint64_t
+requestClient(uint64_t key)
+{
+    return key >> 16;
+}
+
+} // anonymous namespace
+
+LoadgenRequestMatcher::LoadgenRequestMatcher(statistics::Group *parent,
+        unsigned id_offset, Tick _timeout, unsigned max_flows)
+    : statistics::Group(parent, "requestMatcher"),
+      idOffset(id_offset), timeout(_timeout), maxFlows(max_flows),
+      flowLatency(max_flows + 1),
+      ADD_STAT(requests, statistics::units::Count::get(),
+               "Number of requests tracked"),
+      ADD_STAT(matched, statistics::units::Count::get(),
+               "Number of responses matched to a request"),
+      ADD_STAT(unmatched, statistics::units::Count::get(),
+               "Number of responses without an outstanding request"),
+      ADD_STAT(timedOut, statistics::units::Count::get(),
+               "Number of requests that got no response in time"),
+      ADD_STAT(duplicates, statistics::units::Count::get(),
+               "Number of requests that reused an outstanding request ID"),
+      getLatency(this, "getLatency"),
+      setLatency(this, "setLatency"),
+      otherLatency(this, "otherLatency"),
+      ADD_STAT(flowRequests, statistics::units::Count::get(),
+               "Number of requests per client flow"),
+      ADD_STAT(flowResponses, statistics::units::Count::get(),
+               "Number of matched responses per client flow"),
+      ADD_STAT(flowP50, statistics::units::Tick::get(),
+               "Median latency per client flow"),
+      ADD_STAT(flowP99, statistics::units::Tick::get(),
+               "99th percentile latency per client flow")
+{
+    fatal_if(timeout == 0, "Request matching needs a non-zero timeout");
+
+    requests.precision(0);
+    matched.precision(0);
+    unmatched.precision(0);
+    timedOut.precision(0);
+    duplicates.precision(0);
+
+    // One entry per tracked flow, the last one collects all others.
+    for (auto *vec : {&flowRequests, &flowResponses, &flowP50, &flowP99}) {
+        vec->init(maxFlows + 1).precision(0);
+        for (unsigned i = 0; i < maxFlows; i++)
+            vec->subname(i, csprintf("flow%d", i));
+        vec->subname(maxFlows, "untracked");
+    }
+}
+
+bool
+LoadgenRequestMatcher::parse(const EthPacketPtr &pkt, bool response,
+                             uint64_t &client, uint16_t &id,
+                             ReqType &type) const
+{
+    networking::IpPtr ip(pkt);
+    if (!ip || ip->version() != 4 || ip.pstart() > int(pkt->length))
+        return false;
+    networking::UdpPtr udp(ip);
+    if (!udp || udp.pstart() > int(pkt->length))
+        return false;
+
+    const uint8_t *payload = pkt->data + udp.pstart();
+    const size_t len = pkt->length - udp.pstart();
+    if (idOffset + sizeof(uint16_t) > len)
+        return false;
+
+    uint16_t raw_id;
+    memcpy(&raw_id, payload + idOffset, sizeof(raw_id));
+    id = ntohs(raw_id);
+
+    if (response)
+        client = (uint64_t(ip->dst()) << 16) | udp->dport();
+    else
+        client = (uint64_t(ip->src()) << 16) | udp->sport();
+
+    type = len > kMemcachedUdpHeader ?
+        classify(payload + kMemcachedUdpHeader, len - kMemcachedUdpHeader) :
+        Other;
+    return true;
+}
+
+uint16_t
+LoadgenRequestMatcher::flowIndex(uint64_t client)
+{
+    auto it = flowIds.find(client);
+    if (it != flowIds.end())
+        return it->second;
+    if (flowIds.size() < maxFlows) {
+        uint16_t idx = flowIds.size();
+        flowIds.emplace(client, idx);
+        return idx;
+    }
+    return maxFlows;
+}
+
+void
+LoadgenRequestMatcher::sent(const EthPacketPtr &pkt, Tick now)
+{
+    expire(now);
+
+    uint64_t client;
+    uint16_t id;
+    ReqType type;
+    if (!parse(pkt, false, client, id, type))
+        return;
+
+    const uint64_t key = requestKey(client, id);
+    Pending entry{now, uint8_t(type), flowIndex(client)};
+    auto res = pending.emplace(key, entry);
+    if (!res.second) {
+        // The trace reused an ID that is still outstanding, the older
+        // request can no longer be told apart and counts as lost.
+        duplicates++;
+        res.first->second = entry;
+    }
+    sendOrder.emplace_back(now, key);
+    requests++;
+    flowRequests[entry.flow]++;
+}
+
+bool
+LoadgenRequestMatcher::received(const EthPacketPtr &pkt, Tick now,
+                                Tick &latency)
+{
+    uint64_t client;
+    uint16_t id;
+    ReqType type;
+    if (!parse(pkt, true, client, id, type)) {
+        unmatched++;
+        return false;
+    }
+
+    auto it = pending.find(requestKey(client, id));
+    if (it == pending.end()) {
+        // Responders that only swap MAC addresses keep the client as the
+        // source of the packet.
+        uint64_t src_client;
+        if (parse(pkt, false, src_client, id, type))
+            it = pending.find(requestKey(src_client, id));
+    }
+    if (it == pending.end()) {
+        unmatched++;
+        return false;
+    }
+
+    const Pending entry = it->second;
+    pending.erase(it);
+    latency = now - entry.sent;
+
+    matched++;
+    flowResponses[entry.flow]++;
+    flowLatency[entry.flow].sample(latency);
+    switch (entry.type) {
+      case Get:
+        getLatency.sample(latency);
+        break;
+      case Set:
+        setLatency.sample(latency);
+        break;
+      default:
+        otherLatency.sample(latency);
+        break;
+    }
+    DPRINTF(LoadgenLatency, "Request %d of type %d matched, latency %lu\n",
+            id, entry.type, latency);
+
+    expire(now);
+    return true;
+}
+
+void
+LoadgenRequestMatcher::expire(Tick now)
+{
+    while (!sendOrder.empty() && sendOrder.front().first + timeout <= now) {
+        auto it = pending.find(sendOrder.front().second);
+        // Skip entries that were answered or replaced by a newer request.
+        if (it != pending.end() && it->second.sent == sendOrder.front().first) {
+            pending.erase(it);
+            timedOut++;
+        }
+        sendOrder.pop_front();
+    }
+}
+
+void
+LoadgenRequestMatcher::preDumpStats()
+{
+    statistics::Group::preDumpStats();
+    expire(curTick());
+    for (unsigned i = 0; i < flowLatency.size(); i++) {
+        flowP50[i] = flowLatency[i].percentile(0.5);
+        flowP99[i] = flowLatency[i].percentile(0.99);
+    }
+}
+
+void
+LoadgenRequestMatcher::resetStats()
+{
+    statistics::Group::resetStats();
+    for (auto &hist : flowLatency)
+        hist.reset();
+}
+
+void
+LoadgenRequestMatcher::serialize(CheckpointOut &cp) const
+{
+    // Outstanding requests go out in send order, which rebuilds the
+    // expiry queue on restore.
+    std::vector<uint64_t> keys;
+    std::vector<Tick> sentTicks;
+    std::vector<uint8_t> types;
+    for (const auto &send : sendOrder) {
+        auto it = pending.find(send.second);
+        if (it == pending.end() || it->second.sent != send.first)
+            continue;
+        keys.push_back(it->first);
+        sentTicks.push_back(it->second.sent);
+        types.push_back(it->second.type);
+    }
+    SERIALIZE_CONTAINER(keys);
+    SERIALIZE_CONTAINER(sentTicks);
+    SERIALIZE_CONTAINER(types);
+
+    std::vector<uint64_t> clients;
+    std::vector<uint16_t> clientFlows;
+    for (const auto &flow : flowIds) {
+        clients.push_back(flow.first);
+        clientFlows.push_back(flow.second);
+    }
+    SERIALIZE_CONTAINER(clients);
+    SERIALIZE_CONTAINER(clientFlows);
+}
+
+void
+LoadgenRequestMatcher::unserialize(CheckpointIn &cp)
+{
+    std::vector<uint64_t> keys;
+    std::vector<Tick> sentTicks;
+    std::vector<uint8_t> types;
+    UNSERIALIZE_CONTAINER(keys);
+    UNSERIALIZE_CONTAINER(sentTicks);
+    UNSERIALIZE_CONTAINER(types);
+
+    std::vector<uint64_t> clients;
+    std::vector<uint16_t> clientFlows;
+    UNSERIALIZE_CONTAINER(clients);
+    UNSERIALIZE_CONTAINER(clientFlows);
+
+    pending.clear();
+    sendOrder.clear();
+    flowIds.clear();
+    // The checkpoint may have been taken with another max_flows. Flows
+    // are numbered in the order they were first seen, so keeping those
+    // under the limit leaves the indices dense.
+    for (size_t i = 0; i < clients.size(); i++) {
+        if (clientFlows[i] < maxFlows)
+            flowIds.emplace(clients[i], clientFlows[i]);
+    }
+    // The untracked index of the checkpoint may be a tracked flow now,
+    // look the flow of each request up again from its client
+    for (size_t i = 0; i < keys.size(); i++) {
+        const uint16_t flow = flowIndex(requestClient(keys[i]));
+        pending.emplace(keys[i], Pending{sentTicks[i], types[i], flow});
+        sendOrder.emplace_back(sentTicks[i], keys[i]);
+    }
+}
+
+} // namespace gem5
@@ -0,0 +1,103 @@
+#ifndef __DEV_NET_LOADGEN_REQUEST_MATCHER_HH__
+#define __DEV_NET_LOADGEN_REQUEST_MATCHER_HH__
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "base/hdr_histogram.hh"
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "dev/net/etherpkt.hh"
+#include "dev/net/loadgen_latency.hh"
+#include "sim/serialize.hh"
+
+namespace gem5
+{
+
+/**
+ * Matches UDP responses to the requests a load generator sent, using a
+ * 16-bit request ID carried in the UDP payload (the memcached UDP frame
+ * header by default) together with the client address and port. Unlike
+ * a FIFO of send times this stays correct when responses are reordered,
+ * dropped or spread over several queues. Requests without a response
+ * after the timeout are counted as timed out, responses without a
+ * matching request as unmatched. Latency is reported per memcached
+ * request type and for the first few client flows.
+ */
+class LoadgenRequestMatcher : public statistics::Group, public Serializable
+{
+  public:
+    enum ReqType { Get, Set, Other, NumReqTypes };
+
+  private:
+    struct Pending
+    {
+        Tick sent;
+        uint8_t type;
+        uint16_t flow;
+    };
+
+    /** Offset of the request ID within the UDP payload. */
+    const unsigned idOffset;
+    const Tick timeout;
+    const unsigned maxFlows;
+
+    std::unordered_map<uint64_t, Pending> pending;
+    /** Requests in send order, used to expire the oldest ones. */
+    std::deque<std::pair<Tick, uint64_t>> sendOrder;
+    /** Client flow to per-flow stats index. */
+    std::unordered_map<uint64_t, uint16_t> flowIds;
+    std::vector<HdrHistogram> flowLatency;
+
+    /**
+     * Extract the client flow and request ID of a packet.
+     * @param response Take the client from the destination address.
+     */
+    bool parse(const EthPacketPtr &pkt, bool response, uint64_t &client,
+               uint16_t &id, ReqType &type) const;
+
+    uint16_t flowIndex(uint64_t client);
+
+  public:
+    LoadgenRequestMatcher(statistics::Group *parent, unsigned id_offset,
+                          Tick _timeout, unsigned max_flows);
+
+    /** Record a request that was just sent. */
+    void sent(const EthPacketPtr &pkt, Tick now);
+
+    /**
+     * Match a response against the outstanding requests.
+     * @param latency Set to the request latency on a match.
+     * @return true if the response matched a request.
+     */
+    bool received(const EthPacketPtr &pkt, Tick now, Tick &latency);
+
+    /** Retire requests that have been outstanding for too long. */
+    void expire(Tick now);
+
+    size_t outstanding() const { return pending.size(); }
+
+    void preDumpStats() override;
+    void resetStats() override;
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+    statistics::Scalar requests;
+    statistics::Scalar matched;
+    statistics::Scalar unmatched;
+    statistics::Scalar timedOut;
+    statistics::Scalar duplicates;
+    LoadgenLatencyStats getLatency;
+    LoadgenLatencyStats setLatency;
+    LoadgenLatencyStats otherLatency;
+    statistics::Vector flowRequests;
+    statistics::Vector flowResponses;
+    statistics::Vector flowP50;
+    statistics::Vector flowP99;
+};
+
+} // namespace gem5
+
+#endif // __DEV_NET_LOADGEN_REQUEST_MATCHER_HH__
@@ -0,0 +1,48 @@
+#ifndef __DEV_NET_MEMCACHED_KEY_HH__
+#define __DEV_NET_MEMCACHED_KEY_HH__
+
+#include <cstdint>
+
+namespace gem5
+{
+
+namespace memcached_key
+{
+
+constexpr char Chars[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+constexpr unsigned NumChars = sizeof(Chars) - 1;
+
+/** Characters the index of every key of the keyspace takes in base 36. */
+inline unsigned
+indexChars(uint64_t keyspace)
+{
+    unsigned chars = 1;
+    for (uint64_t n = keyspace ? keyspace - 1 : 0; n >= NumChars;
+         n /= NumChars)
+        chars++;
+    return chars;
+}
+
+/**
+ * Write a key of len bytes. It starts with the key index in base 36,
+ * least significant digit first, at a fixed width of index_chars, so
+ * keys of the same length are distinct as long as len covers the
+ * index. Printable filler that still differs between keys makes up the
+ * rest.
+ */
+inline void
+write(uint8_t *dst, uint64_t key, unsigned len, unsigned index_chars)
+{
+    unsigned pos = 0;
+    for (uint64_t n = key; pos < len && pos < index_chars; pos++) {
+        dst[pos] = Chars[n % NumChars];
+        n /= NumChars;
+    }
+    for (; pos < len; pos++)
+        dst[pos] = Chars[(key * 31 + pos) % NumChars];
+}
+
+} // namespace memcached_key
+} // namespace gem5
+
+#endif // __DEV_NET_MEMCACHED_KEY_HH__
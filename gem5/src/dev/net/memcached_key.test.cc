@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+
+#include "dev/net/memcached_key.hh"
+
+using namespace gem5;
+
+namespace
+{
+
+std::string
+key(uint64_t index, unsigned len, unsigned index_chars)
+{
+    std::string k(len, '\0');
+    memcached_key::write(reinterpret_cast<uint8_t *>(k.data()), index, len,
+                         index_chars);
+    return k;
+}
+
+} // anonymous namespace
+
+TEST(MemcachedKeyTest, IndexChars)
+{
+    EXPECT_EQ(1, memcached_key::indexChars(1));
+    EXPECT_EQ(1, memcached_key::indexChars(36));
+    EXPECT_EQ(2, memcached_key::indexChars(37));
+    EXPECT_EQ(2, memcached_key::indexChars(36 * 36));
+    EXPECT_EQ(3, memcached_key::indexChars(36 * 36 + 1));
+}
+
+/** Key 0 and key 36 used to both be "ab" at two bytes. */
+TEST(MemcachedKeyTest, FixedWidthIndex)
+{
+    const unsigned chars = memcached_key::indexChars(100);
+    EXPECT_EQ("aa", key(0, 2, chars));
+    EXPECT_EQ("ab", key(36, 2, chars));
+    EXPECT_NE(key(0, 5, chars), key(36, 5, chars));
+}
+
+TEST(MemcachedKeyTest, EveryKeyDistinct)
+{
+    for (uint64_t keyspace : {1, 36, 37, 1000, 36 * 36 * 2}) {
+        const unsigned chars = memcached_key::indexChars(keyspace);
+        for (unsigned len : {chars, chars + 1, chars + 7}) {
+            std::set<std::string> keys;
+            for (uint64_t i = 0; i < keyspace; i++) {
+                const std::string k = key(i, len, chars);
+                for (char c : k) {
+                    ASSERT_NE(std::string::npos,
+                              std::string(memcached_key::Chars).find(c));
+                }
+                keys.insert(k);
+            }
+            EXPECT_EQ(keyspace, keys.size())
+                << keyspace << " keys of " << len << " bytes";
+        }
+    }
+}
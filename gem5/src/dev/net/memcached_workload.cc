@@ -0,0 +1,220 @@
+#include "dev/net/memcached_workload.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "base/cprintf.hh"
+#include "base/logging.hh"
+#include "base/zipfian_distribution.hh"
+#include "dev/net/memcached_key.hh"
+
+namespace gem5
+{
+
+namespace
+{
+
+constexpr size_t kBinaryHeaderSize = 24;
+constexpr size_t kSetExtrasSize = 8;
+constexpr uint8_t kMagicRequest = 0x80;
+constexpr uint8_t kOpcodeGet = 0x00;
+constexpr uint8_t kOpcodeSet = 0x01;
+/** Reserved frame header bytes expected by the instrumented server. */
+constexpr uint8_t kFrameMagic[2] = {0xaa, 0x33};
+
+void
+putBE(uint8_t *dst, uint64_t value, unsigned bytes)
+{
+    for (unsigned i = 0; i < bytes; i++)
+        dst[i] = value >> (8 * (bytes - 1 - i));
+}
+
+unsigned
+decimalDigits(uint64_t value)
+{
+    unsigned digits = 1;
+    for (; value >= 10; value /= 10)
+        digits++;
+    return digits;
+}
+
+} // anonymous namespace
+
+MemcachedWorkload::MemcachedWorkload(const Config &_cfg, Random &_rng)
+    : cfg(_cfg), rng(_rng),
+      indexChars(memcached_key::indexChars(_cfg.keyspace)),
+      keyLen(_cfg.keyspace), valueLen(_cfg.keyspace),
+      nextSet(0), nextRequestId(0)
+{
+    fatal_if(cfg.keyspace == 0, "Memcached workload needs at least one key");
+    fatal_if(cfg.populated > cfg.keyspace,
+             "Memcached workload populates %d of only %d keys",
+             cfg.populated, cfg.keyspace);
+    fatal_if(cfg.getRatio < 0 || cfg.getRatio > 1,
+             "Memcached GET ratio must be in [0, 1]");
+    fatal_if(cfg.getRatio > 0 && cfg.populated == 0,
+             "Memcached GETs need populated keys");
+    fatal_if(cfg.keySize.min == 0 || cfg.keySize.max > 250,
+             "Memcached keys must be 1 to 250 bytes long");
+
+    // Keys start with their index in base 36 at a fixed width, so they
+    // are unique as long as they are long enough to hold it.
+    warn_if(cfg.keySize.min < indexChars,
+            "Keys shorter than %d bytes are not unique over %d keys",
+            indexChars, cfg.keyspace);
+
+    ZipfianDistribution key_dist(cfg.keySize.min, cfg.keySize.max,
+                                 cfg.keySize.skew);
+    ZipfianDistribution value_dist(cfg.valueSize.min, cfg.valueSize.max,
+                                   cfg.valueSize.skew);
+    uint64_t truncated = 0;
+    for (uint64_t i = 0; i < cfg.keyspace; i++) {
+        keyLen[i] = key_dist(rng.gen);
+        valueLen[i] = value_dist(rng.gen);
+
+        // Shrink values until the SET fits in one datagram.
+        const size_t size = requestSize(i, Op::Set);
+        if (size > cfg.maxRequestSize) {
+            const size_t excess = size - cfg.maxRequestSize;
+            fatal_if(excess > valueLen[i],
+                     "A %d byte key does not fit in a %d byte request",
+                     keyLen[i], cfg.maxRequestSize);
+            // A shorter ASCII length field only makes the request smaller.
+            valueLen[i] -= excess;
+            truncated++;
+        }
+    }
+    warn_if(truncated, "%d of %d memcached values were shortened to fit "
+            "in %d byte requests", truncated, cfg.keyspace,
+            cfg.maxRequestSize);
+}
+
+MemcachedWorkload::Protocol
+MemcachedWorkload::parseProtocol(const std::string &name)
+{
+    if (name == "Binary")
+        return Protocol::Binary;
+    if (name == "Ascii")
+        return Protocol::Ascii;
+    fatal("Unknown memcached protocol %s", name);
+}
+
+MemcachedWorkload::SizeDist
+MemcachedWorkload::parseSizeDist(const std::string &spec)
+{
+    SizeDist dist;
+    char end;
+    fatal_if(sscanf(spec.c_str(), "%u-%u-%lf%c", &dist.min, &dist.max,
+                    &dist.skew, &end) != 3,
+             "Bad size distribution '%s', expected <min-max-skew>", spec);
+    fatal_if(dist.min > dist.max, "Bad size distribution '%s'", spec);
+    return dist;
+}
+
+size_t
+MemcachedWorkload::requestSize(uint64_t key, Op op) const
+{
+    const size_t k = keyLen[key];
+    const size_t v = valueLen[key];
+    if (cfg.protocol == Protocol::Binary) {
+        return UdpHeaderSize + kBinaryHeaderSize + k +
+            (op == Op::Set ? kSetExtrasSize + v : 0);
+    }
+    // "get <key>\r\n" or "set <key> 0 0 <bytes>\r\n<value>\r\n"
+    if (op == Op::Get)
+        return UdpHeaderSize + 4 + k + 2;
+    return UdpHeaderSize + 4 + k + 5 + decimalDigits(v) + 2 + v + 2;
+}
+
+void
+MemcachedWorkload::writeKey(uint8_t *dst, uint64_t key) const
+{
+    memcached_key::write(dst, key, keyLen[key], indexChars);
+}
+
+size_t
+MemcachedWorkload::next(uint8_t *buf, Op &op)
+{
+    uint64_t key;
+    if (rng.random<double>() < cfg.getRatio) {
+        op = Op::Get;
+        key = rng.random<uint64_t>(0, cfg.populated - 1);
+    } else {
+        op = Op::Set;
+        const uint64_t unpopulated = cfg.keyspace - cfg.populated;
+        key = unpopulated ? cfg.populated + nextSet % unpopulated :
+            nextSet % cfg.keyspace;
+        nextSet++;
+    }
+
+    // Frame header: request ID, sequence 0 of 1 datagram.
+    putBE(buf, nextRequestId++, 2);
+    putBE(buf + 2, 0, 2);
+    putBE(buf + 4, 1, 2);
+    buf[6] = kFrameMagic[0];
+    buf[7] = kFrameMagic[1];
+    uint8_t *p = buf + UdpHeaderSize;
+
+    const unsigned k = keyLen[key];
+    const uint32_t v = valueLen[key];
+    if (cfg.protocol == Protocol::Binary) {
+        memset(p, 0, kBinaryHeaderSize);
+        p[0] = kMagicRequest;
+        p[1] = op == Op::Get ? kOpcodeGet : kOpcodeSet;
+        putBE(p + 2, k, 2);
+        if (op == Op::Get) {
+            putBE(p + 8, k, 4);
+            p += kBinaryHeaderSize;
+        } else {
+            p[4] = kSetExtrasSize;
+            putBE(p + 8, kSetExtrasSize + k + v, 4);
+            p += kBinaryHeaderSize;
+            // Flags and expiration, never expire.
+            memset(p, 0, kSetExtrasSize);
+            p += kSetExtrasSize;
+        }
+        writeKey(p, key);
+        p += k;
+    } else {
+        memcpy(p, op == Op::Get ? "get " : "set ", 4);
+        p += 4;
+        writeKey(p, key);
+        p += k;
+        if (op == Op::Set) {
+            const std::string args = csprintf(" 0 0 %d", v);
+            memcpy(p, args.data(), args.size());
+            p += args.size();
+        }
+        memcpy(p, "\r\n", 2);
+        p += 2;
+    }
+
+    if (op == Op::Set) {
+        for (uint32_t i = 0; i < v; i++)
+            p[i] = 'a' + (key + i) % 26;
+        p += v;
+        if (cfg.protocol == Protocol::Ascii) {
+            memcpy(p, "\r\n", 2);
+            p += 2;
+        }
+    }
+
+    return p - buf;
+}
+
+void
+MemcachedWorkload::serialize(CheckpointOut &cp) const
+{
+    SERIALIZE_SCALAR(nextSet);
+    SERIALIZE_SCALAR(nextRequestId);
+}
+
+void
+MemcachedWorkload::unserialize(CheckpointIn &cp)
+{
+    UNSERIALIZE_SCALAR(nextSet);
+    UNSERIALIZE_SCALAR(nextRequestId);
+}
+
+} // namespace gem5
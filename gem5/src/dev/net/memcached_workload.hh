@@ -0,0 +1,94 @@
+#ifndef __DEV_NET_MEMCACHED_WORKLOAD_HH__
+#define __DEV_NET_MEMCACHED_WORKLOAD_HH__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "base/random.hh"
+#include "sim/serialize.hh"
+
+namespace gem5
+{
+
+/**
+ * Synthesises memcached UDP requests in place of a recorded pcap. The
+ * dataset is modelled on memcached_client: every key has a length and a
+ * value length drawn once from zipfian distributions, GETs go to the
+ * first `populated` keys (which the server is expected to hold) and SETs
+ * cycle through the rest. Only the sizes are stored; key and value bytes
+ * are derived from the key index when a request is written.
+ *
+ * Requests start with the 8-byte memcached UDP frame header, whose
+ * request ID increments with every request, followed by a binary or
+ * ASCII protocol GET or SET.
+ */
+class MemcachedWorkload : public Serializable
+{
+  public:
+    enum class Protocol { Binary, Ascii };
+    enum class Op { Get, Set };
+
+    /** Zipfian size distribution, as the client's <min-max-skew> flag. */
+    struct SizeDist
+    {
+        unsigned min;
+        unsigned max;
+        double skew;
+    };
+
+    struct Config
+    {
+        Protocol protocol;
+        /** Number of distinct keys. */
+        uint64_t keyspace;
+        /** Keys read by GETs; SETs use the others, or all keys if none. */
+        uint64_t populated;
+        SizeDist keySize;
+        SizeDist valueSize;
+        /** Fraction of requests that are GETs. */
+        double getRatio;
+        /** Largest request, including the UDP frame header. */
+        size_t maxRequestSize;
+    };
+
+    /** Size of the memcached UDP frame header. */
+    static constexpr size_t UdpHeaderSize = 8;
+
+  private:
+    const Config cfg;
+    Random &rng;
+    /** Characters the key index takes at the start of every key. */
+    const unsigned indexChars;
+
+    std::vector<uint8_t> keyLen;
+    std::vector<uint32_t> valueLen;
+
+    uint64_t nextSet;
+    uint16_t nextRequestId;
+
+    void writeKey(uint8_t *dst, uint64_t key) const;
+    size_t requestSize(uint64_t key, Op op) const;
+
+  public:
+    MemcachedWorkload(const Config &_cfg, Random &_rng);
+
+    /**
+     * Write the next request to buf, which must hold maxRequestSize bytes.
+     * @return The request length.
+     */
+    size_t next(uint8_t *buf, Op &op);
+
+    static Protocol parseProtocol(const std::string &name);
+
+    /** Parse a <min-max-skew> size distribution. */
+    static SizeDist parseSizeDist(const std::string &spec);
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+};
+
+} // namespace gem5
+
+#endif // __DEV_NET_MEMCACHED_WORKLOAD_HH__
@@ -0,0 +1,345 @@
+#include "dev/net/pcap_index.hh"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#include "base/cprintf.hh"
+#include "base/inet.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/LoadgenDebug.hh"
+#include "dev/net/etherpkt.hh"
+
+namespace gem5
+{
+
+namespace
+{
+
+constexpr unsigned kEtherHeaderSize = 14;
+constexpr uint32_t kLinkTypeEthernet = 1;
+constexpr char kIndexMagic[8] = {'L', 'G', 'P', 'C', 'A', 'P', 'I', '1'};
+
+struct PcapFileHeader
+{
+    uint32_t magic;
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    int32_t thisZone;
+    uint32_t sigFigs;
+    uint32_t snapLen;
+    uint32_t linkType;
+};
+
+struct PcapRecordHeader
+{
+    uint32_t tsSec;
+    uint32_t tsFrac;
+    uint32_t inclLen;
+    uint32_t origLen;
+};
+
+uint32_t
+parseIP(const std::string &ip)
+{
+    if (ip.empty())
+        return 0;
+    in_addr addr;
+    fatal_if(!inet_aton(ip.c_str(), &addr), "Bad IP address %s", ip);
+    return addr.s_addr;
+}
+
+/** Read-only mapping of a whole file, unmapped on destruction. */
+struct MappedFile
+{
+    int fd = -1;
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+
+    bool
+    map(const std::string &filename)
+    {
+        fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+            return false;
+        size = st.st_size;
+        void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+            return false;
+        data = static_cast<const uint8_t *>(p);
+        madvise(p, size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    ~MappedFile()
+    {
+        if (data)
+            munmap(const_cast<uint8_t *>(data), size);
+        if (fd >= 0)
+            ::close(fd);
+    }
+};
+
+} // anonymous namespace
+
+struct PcapIndex::Header
+{
+    char magic[8];
+    /** Identity of the source trace. */
+    uint64_t pcapSize;
+    int64_t pcapMtime;
+    /** Filter and rewrite configuration the index was built with. */
+    uint32_t maxPacketSize;
+    uint16_t portFilter;
+    uint8_t kernelStack;
+    uint8_t pad;
+    uint32_t srcIP;
+    uint32_t destIP;
+    /** Filled in once the index is complete. */
+    uint64_t numPackets;
+
+    bool
+    matches(const Header &o) const
+    {
+        return memcmp(magic, o.magic, sizeof(magic)) == 0 &&
+            pcapSize == o.pcapSize && pcapMtime == o.pcapMtime &&
+            maxPacketSize == o.maxPacketSize &&
+            portFilter == o.portFilter && kernelStack == o.kernelStack &&
+            srcIP == o.srcIP && destIP == o.destIP;
+    }
+};
+
+PcapIndex::PcapIndex(const std::string &pcap_filename,
+                     const std::string &index_filename, const Config &cfg)
+    : indexFilename(index_filename.empty() ?
+                    pcap_filename + ".lgidx" : index_filename),
+      fd(-1), base(nullptr), mapSize(0), pos(0), start(0), numPackets(0)
+{
+    fatal_if(cfg.maxPacketSize > UINT16_MAX,
+             "Pcap index records are limited to %d bytes", UINT16_MAX);
+
+    struct stat st;
+    fatal_if(stat(pcap_filename.c_str(), &st) != 0,
+             "Failed to stat pcap trace file %s", pcap_filename);
+
+    Header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, kIndexMagic, sizeof(hdr.magic));
+    hdr.pcapSize = st.st_size;
+    hdr.pcapMtime = st.st_mtime;
+    hdr.maxPacketSize = cfg.maxPacketSize;
+    hdr.portFilter = cfg.kernelStack ? cfg.portFilter : 0;
+    hdr.kernelStack = cfg.kernelStack;
+    hdr.srcIP = parseIP(cfg.srcIP);
+    hdr.destIP = parseIP(cfg.destIP);
+
+    if (!open(hdr)) {
+        inform("Building pcap index %s from %s", indexFilename,
+               pcap_filename);
+        build(pcap_filename, indexFilename, cfg, hdr);
+        fatal_if(!open(hdr), "Failed to map pcap index %s", indexFilename);
+    }
+
+    inform("Pcap index %s: %d packets", indexFilename, numPackets);
+}
+
+PcapIndex::~PcapIndex()
+{
+    close();
+}
+
+bool
+PcapIndex::open(const Header &expected)
+{
+    fd = ::open(indexFilename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+        close();
+        return false;
+    }
+
+    mapSize = st.st_size;
+    void *p = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+        close();
+        return false;
+    }
+    base = static_cast<const uint8_t *>(p);
+    madvise(p, mapSize, MADV_SEQUENTIAL);
+
+    Header hdr;
+    memcpy(&hdr, base, sizeof(hdr));
+    if (!hdr.matches(expected)) {
+        DPRINTF(LoadgenDebug, "Pcap index %s is stale\n", indexFilename);
+        close();
+        return false;
+    }
+
+    numPackets = hdr.numPackets;
+    start = pos = sizeof(Header);
+    return true;
+}
+
+void
+PcapIndex::close()
+{
+    if (base)
+        munmap(const_cast<uint8_t *>(base), mapSize);
+    if (fd >= 0)
+        ::close(fd);
+    base = nullptr;
+    fd = -1;
+    mapSize = 0;
+}
+
+void
+PcapIndex::build(const std::string &pcap_filename,
+                 const std::string &index_filename, const Config &cfg,
+                 const Header &hdr)
+{
+    MappedFile pcap;
+    fatal_if(!pcap.map(pcap_filename),
+             "Failed to map pcap trace file %s", pcap_filename);
+    fatal_if(pcap.size < sizeof(PcapFileHeader),
+             "Pcap trace file %s is truncated", pcap_filename);
+
+    PcapFileHeader fh;
+    memcpy(&fh, pcap.data, sizeof(fh));
+    bool swapped;
+    switch (fh.magic) {
+      case 0xa1b2c3d4:
+      case 0xa1b23c4d:
+        swapped = false;
+        break;
+      case 0xd4c3b2a1:
+      case 0x4d3cb2a1:
+        swapped = true;
+        break;
+      default:
+        fatal("%s is not a pcap trace file (pcapng is not supported)",
+              pcap_filename);
+    }
+    auto fix = [swapped](uint32_t v) {
+        return swapped ? __builtin_bswap32(v) : v;
+    };
+    fatal_if(fix(fh.linkType) != kLinkTypeEthernet,
+             "Pcap trace file %s is not an Ethernet capture", pcap_filename);
+
+    // Write to a temporary file and rename it at the end, so concurrent
+    // runs on the same trace never see a half-written index.
+    const std::string tmp_filename =
+        csprintf("%s.tmp.%d", index_filename, getpid());
+    std::ofstream out(tmp_filename, std::ios::binary | std::ios::trunc);
+    fatal_if(!out, "Failed to create pcap index %s", tmp_filename);
+    out.write(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+
+    // Scratch packet so the IP/UDP helpers from base/inet can be used.
+    auto scratch = std::make_shared<EthPacketData>(
+            std::max<uint32_t>(cfg.maxPacketSize, kEtherHeaderSize));
+
+    uint64_t kept = 0, skipped = 0;
+    size_t off = sizeof(PcapFileHeader);
+    while (off + sizeof(PcapRecordHeader) <= pcap.size) {
+        PcapRecordHeader rh;
+        memcpy(&rh, pcap.data + off, sizeof(rh));
+        off += sizeof(rh);
+        const uint32_t incl_len = fix(rh.inclLen);
+        const uint32_t orig_len = fix(rh.origLen);
+        if (off + incl_len > pcap.size) {
+            warn("Pcap trace file %s ends with a truncated record",
+                 pcap_filename);
+            break;
+        }
+        const uint8_t *frame = pcap.data + off;
+        off += incl_len;
+
+        // Same checks as the on-the-fly replay path.
+        if (incl_len != orig_len || orig_len > cfg.maxPacketSize ||
+                orig_len < kEtherHeaderSize) {
+            skipped++;
+            continue;
+        }
+
+        memcpy(scratch->data, frame, orig_len);
+        scratch->length = orig_len;
+
+        networking::IpPtr ip(scratch);
+        bool ipv4 = ip && ip->version() == 4 &&
+            ip.pstart() <= int(orig_len) &&
+            ip.off() + ip->len() <= int(orig_len);
+        networking::UdpPtr udp;
+        if (ipv4)
+            udp = ip;
+
+        if (cfg.kernelStack) {
+            if (!ipv4 || !udp || udp.pstart() > int(orig_len) ||
+                    udp->dport() != cfg.portFilter) {
+                skipped++;
+                continue;
+            }
+        }
+
+        if (ipv4 && (hdr.srcIP || hdr.destIP)) {
+            if (hdr.srcIP)
+                ip->ip_src = hdr.srcIP;
+            if (hdr.destIP)
+                ip->ip_dst = hdr.destIP;
+            ip->sum(0);
+            ip->sum(networking::cksum(ip));
+            // A zero UDP checksum means none was computed.
+            if (udp && udp.pstart() <= int(orig_len) && udp->sum()) {
+                udp->sum(0);
+                udp->sum(networking::cksum(udp));
+            }
+        }
+
+        const uint16_t len = orig_len - kEtherHeaderSize;
+        out.write(reinterpret_cast<const char *>(&len), sizeof(len));
+        out.write(reinterpret_cast<const char *>(scratch->data +
+                                                 kEtherHeaderSize), len);
+        kept++;
+    }
+
+    Header final_hdr = hdr;
+    final_hdr.numPackets = kept;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&final_hdr), sizeof(final_hdr));
+    out.close();
+    fatal_if(!out, "Failed to write pcap index %s", tmp_filename);
+    fatal_if(std::rename(tmp_filename.c_str(), index_filename.c_str()) != 0,
+             "Failed to rename %s to %s", tmp_filename, index_filename);
+
+    inform("Indexed %d packets from %s, %d filtered out", kept,
+           pcap_filename, skipped);
+}
+
+bool
+PcapIndex::next(const uint8_t *&data, uint16_t &len)
+{
+    if (pos + sizeof(uint16_t) > mapSize)
+        return false;
+    memcpy(&len, base + pos, sizeof(len));
+    fatal_if(pos + sizeof(len) + len > mapSize, "Pcap index %s is "
+             "truncated, the packet at offset %d ends past the end of the "
+             "file", indexFilename, pos);
+    data = base + pos + sizeof(len);
+    pos += sizeof(len) + len;
+    return true;
+}
+
+} // namespace gem5
@@ -0,0 +1,105 @@
+#ifndef __DEV_NET_PCAP_INDEX_HH__
+#define __DEV_NET_PCAP_INDEX_HH__
+
+#include <cstdint>
+#include <string>
+
+namespace gem5
+{
+
+/**
+ * Pre-filtered packet cache for pcap replay.
+ *
+ * The first time a trace is used with a given filter configuration, the
+ * pcap is memory-mapped and every packet is run through the same checks
+ * the load generator used to do on each send (truncated capture, size
+ * limit and, for the kernel stack, IPv4/UDP/destination port). Packets
+ * that survive have the configured IP rewrite applied, with the IP and
+ * UDP checksums fixed up, and are appended to a compact index file that
+ * stores only what follows the Ethernet header:
+ *
+ *   Header | (uint16_t length, payload[length])*
+ *
+ * Later runs with the same configuration map the index directly, and
+ * the generator streams packets from it without any parsing.
+ */
+class PcapIndex
+{
+  public:
+    struct Config
+    {
+        uint16_t portFilter;
+        uint32_t maxPacketSize;
+        /** Apply the kernel stack IPv4/UDP/port filter. */
+        bool kernelStack;
+        /** IPs written into every packet, left untouched when empty. */
+        std::string srcIP;
+        std::string destIP;
+    };
+
+  private:
+    struct Header;
+
+    std::string indexFilename;
+
+    int fd;
+    const uint8_t *base;
+    size_t mapSize;
+
+    /** Offset of the next record to return. */
+    size_t pos;
+    /** Offset of the first record. */
+    size_t start;
+    uint64_t numPackets;
+
+    static void build(const std::string &pcap_filename,
+                      const std::string &index_filename,
+                      const Config &cfg, const Header &hdr);
+
+    /** Map the index, returns false if it is missing or stale. */
+    bool open(const Header &expected);
+    void close();
+
+  public:
+    PcapIndex(const std::string &pcap_filename,
+              const std::string &index_filename, const Config &cfg);
+    ~PcapIndex();
+
+    PcapIndex(const PcapIndex &) = delete;
+    PcapIndex &operator=(const PcapIndex &) = delete;
+
+    /**
+     * Get the next packet, starting right after the Ethernet header.
+     * The returned data stays valid for the lifetime of the index.
+     * @return false at the end of the trace.
+     */
+    bool next(const uint8_t *&data, uint16_t &len);
+
+    /** Restart from the first packet. */
+    void rewind() { pos = start; }
+
+    /** Position of the next packet, for checkpointing. */
+    size_t offset() const { return pos; }
+
+    /**
+     * Continue from a position returned by offset().
+     * @return false if the position is outside the index.
+     */
+    bool
+    seek(size_t offset)
+    {
+        if (offset < start || offset > mapSize)
+            return false;
+        pos = offset;
+        return true;
+    }
+
+    /** Number of packets in the index. */
+    uint64_t packets() const { return numPackets; }
+
+    const std::string &filename() const { return indexFilename; }
+};
+
+} // namespace gem5
+
+#endif // __DEV_NET_PCAP_INDEX_HH__
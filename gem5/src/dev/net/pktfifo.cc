@@ -114,4 +114,48 @@ PacketFifo::unserialize(const std::string &base, CheckpointIn &cp)
     }
 }
 
+void
+PacketRing::grow()
+{
+    std::vector<EthPacketPtr> bigger(ring.size() * 2);
+    for (unsigned i = 0; i < count; i++)
+        bigger[i] = std::move(ring[slot(i)]);
+    ring.swap(bigger);
+    head = 0;
+}
+
+void
+PacketRing::serialize(const std::string &base, CheckpointOut &cp) const
+{
+    paramOut(cp, base + ".size", _size);
+    paramOut(cp, base + ".maxsize", _maxsize);
+    paramOut(cp, base + ".reserved", _reserved);
+    paramOut(cp, base + ".packets", count);
+
+    for (unsigned i = 0; i < count; i++) {
+        PacketFifoEntry entry(ring[slot(i)], _counter - count + i);
+        entry.serialize(csprintf("%s.entry%d", base, i), cp);
+    }
+}
+
+void
+PacketRing::unserialize(const std::string &base, CheckpointIn &cp)
+{
+    clear();
+
+    paramIn(cp, base + ".size", _size);
+    paramIn(cp, base + ".reserved", _reserved);
+    unsigned packets;
+    paramIn(cp, base + ".packets", packets);
+
+    for (unsigned i = 0; i < packets; ++i) {
+        PacketFifoEntry entry;
+        entry.unserialize(csprintf("%s.entry%d", base, i), cp);
+        if (count == ring.size())
+            grow();
+        ring[slot(count++)] = entry.packet;
+        _counter = entry.number + 1;
+    }
+}
+
 } // namespace gem5
@@ -32,6 +32,7 @@
 #include <iosfwd>
 #include <list>
 #include <string>
+#include <vector>
 
 #include "base/logging.hh"
 #include "dev/net/etherpkt.hh"
@@ -210,6 +211,109 @@ class PacketFifo
     void unserialize(const std::string &base, CheckpointIn &cp);
 };
 
+/**
+ * Byte bounded FIFO of packet references for devices that only ever
+ * take packets from the head. Entries live in a power of two ring of
+ * slots that is sized once for the largest number of packets seen, so
+ * pushing and popping a packet neither allocates nor copies anything
+ * beyond the packet pointer itself. Devices that need to remove packets
+ * from the middle of the FIFO or iterate over it use PacketFifo.
+ */
+class PacketRing
+{
+  protected:
+    std::vector<EthPacketPtr> ring;
+    unsigned head;
+    unsigned count;
+    uint64_t _counter;
+    unsigned _maxsize;
+    unsigned _size;
+    unsigned _reserved;
+
+    unsigned slot(unsigned i) const { return (head + i) & (ring.size() - 1); }
+
+    /** Double the ring, keeping the packets in order. */
+    void grow();
+
+  public:
+    explicit PacketRing(int max)
+        : ring(16), head(0), count(0), _counter(0), _maxsize(max),
+          _size(0), _reserved(0)
+    {}
+
+    unsigned packets() const { return count; }
+    unsigned maxsize() const { return _maxsize; }
+    unsigned size() const { return _size; }
+    unsigned reserved() const { return _reserved; }
+    unsigned avail() const { return _maxsize - _size - _reserved; }
+    bool empty() const { return size() <= 0; }
+    bool full() const { return avail() <= 0; }
+
+    unsigned
+    reserve(unsigned len = 0)
+    {
+        assert(avail() >= len);
+        _reserved += len;
+        return _reserved;
+    }
+
+    /** The packet at the head, only valid until the next pop(). */
+    const EthPacketPtr &
+    front() const
+    {
+        assert(count);
+        return ring[head];
+    }
+
+    bool
+    push(EthPacketPtr ptr)
+    {
+        assert(ptr->length);
+        assert(_reserved <= ptr->length);
+        if (avail() < ptr->length - _reserved)
+            return false;
+
+        if (count == ring.size())
+            grow();
+
+        _size += ptr->length;
+        ring[slot(count++)] = std::move(ptr);
+        _counter++;
+        _reserved = 0;
+        return true;
+    }
+
+    void
+    pop()
+    {
+        if (empty())
+            return;
+
+        _size -= ring[head]->length;
+        ring[head] = nullptr;
+        head = slot(1);
+        count--;
+    }
+
+    void
+    clear()
+    {
+        for (unsigned i = 0; i < count; i++)
+            ring[slot(i)] = nullptr;
+        head = 0;
+        count = 0;
+        _size = 0;
+        _reserved = 0;
+    }
+
+/**
+ * Serialization stuff, in the same format as PacketFifo
+ */
+  public:
+    void serialize(const std::string &base, CheckpointOut &cp) const;
+    void unserialize(const std::string &base, CheckpointIn &cp);
+};
+
 } // namespace gem5
 
 #endif // __DEV_NET_PKTFIFO_HH__
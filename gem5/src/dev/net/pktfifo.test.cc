@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "dev/net/pktfifo.hh"
+#include "sim/serialize.hh"
+
+using namespace gem5;
+
+namespace
+{
+
+/** A packet of len bytes, all of them set to fill. */
+EthPacketPtr
+packet(unsigned len, uint8_t fill)
+{
+    auto pkt = std::make_shared<EthPacketData>(len);
+    pkt->length = len;
+    pkt->simLength = len;
+    std::fill(pkt->data, pkt->data + len, fill);
+    return pkt;
+}
+
+} // anonymous namespace
+
+TEST(PacketRingTest, FullAndEmpty)
+{
+    PacketRing ring(300);
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.full());
+    EXPECT_EQ(300, ring.avail());
+
+    EXPECT_TRUE(ring.push(packet(100, 1)));
+    EXPECT_TRUE(ring.push(packet(200, 2)));
+    EXPECT_FALSE(ring.empty());
+    EXPECT_TRUE(ring.full());
+    EXPECT_EQ(2, ring.packets());
+    EXPECT_EQ(300, ring.size());
+
+    // No room left
+    EXPECT_FALSE(ring.push(packet(1, 3)));
+    EXPECT_EQ(2, ring.packets());
+
+    ring.pop();
+    EXPECT_EQ(200, ring.front()->length);
+    EXPECT_EQ(100, ring.avail());
+    ring.pop();
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(0, ring.packets());
+
+    // Popping an empty ring does nothing
+    ring.pop();
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(PacketRingTest, Reserve)
+{
+    PacketRing ring(100);
+    ring.reserve(60);
+    EXPECT_EQ(60, ring.reserved());
+    EXPECT_EQ(40, ring.avail());
+
+    // The reservation is taken by the next packet
+    EXPECT_TRUE(ring.push(packet(80, 1)));
+    EXPECT_EQ(0, ring.reserved());
+    EXPECT_EQ(20, ring.avail());
+}
+
+TEST(PacketRingTest, WrapAround)
+{
+    // Keep the ring partly full while many more packets than its slots
+    // go through, so its head wraps around many times
+    PacketRing ring(1 << 20);
+    unsigned pushed = 0, popped = 0;
+    for (unsigned i = 0; i < 1000; i++) {
+        EXPECT_TRUE(ring.push(packet(10 + pushed % 7, pushed % 256)));
+        pushed++;
+        if (ring.packets() > 5) {
+            EXPECT_EQ(popped % 256, ring.front()->data[0]);
+            EXPECT_EQ(10 + popped % 7, ring.front()->length);
+            ring.pop();
+            popped++;
+        }
+    }
+
+    // Growing past the initial slots keeps the packets in order
+    for (unsigned i = 0; i < 100; i++) {
+        EXPECT_TRUE(ring.push(packet(10 + pushed % 7, pushed % 256)));
+        pushed++;
+    }
+    while (!ring.empty()) {
+        EXPECT_EQ(popped % 256, ring.front()->data[0]);
+        ring.pop();
+        popped++;
+    }
+    EXPECT_EQ(pushed, popped);
+    EXPECT_EQ(0, ring.size());
+}
+
+TEST(PacketRingTest, Clear)
+{
+    PacketRing ring(1000);
+    ring.push(packet(100, 1));
+    ring.push(packet(100, 2));
+    ring.reserve(50);
+    ring.clear();
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(0, ring.packets());
+    EXPECT_EQ(0, ring.reserved());
+    EXPECT_EQ(1000, ring.avail());
+}
+
+TEST(PacketRingTest, Serialization)
+{
+    char dir_template[] = "/tmp/pktfifo.test.XXXXXX";
+    const char *dir = mkdtemp(dir_template);
+    ASSERT_NE(nullptr, dir);
+    const std::string cpt_file = std::string(dir) + "/" +
+        CheckpointIn::baseFilename;
+
+    // Serialize a ring whose packets wrap around the end of its slots
+    PacketRing ring(4000);
+    for (unsigned i = 0; i < 14; i++)
+        ring.push(packet(100, i));
+    for (unsigned i = 0; i < 10; i++)
+        ring.pop();
+    for (unsigned i = 14; i < 20; i++)
+        ring.push(packet(100 + i, i));
+    ring.reserve(30);
+    {
+        std::ofstream cp(cpt_file);
+        Serializable::ScopedCheckpointSection sec(cp, "ring");
+        ring.serialize("fifo", cp);
+    }
+
+    PacketRing restored(4000);
+    restored.push(packet(50, 0xff));
+    {
+        CheckpointIn cp(dir);
+        Serializable::ScopedCheckpointSection sec(cp, "ring");
+        restored.unserialize("fifo", cp);
+    }
+    std::remove(cpt_file.c_str());
+    rmdir(dir);
+
+    EXPECT_EQ(ring.packets(), restored.packets());
+    EXPECT_EQ(ring.size(), restored.size());
+    EXPECT_EQ(ring.reserved(), restored.reserved());
+    while (!ring.empty()) {
+        ASSERT_FALSE(restored.empty());
+        const EthPacketPtr &a = ring.front();
+        const EthPacketPtr &b = restored.front();
+        EXPECT_EQ(a->length, b->length);
+        EXPECT_EQ(a->simLength, b->simLength);
+        EXPECT_EQ(0, memcmp(a->data, b->data, a->length));
+        ring.pop();
+        restored.pop();
+    }
+    EXPECT_TRUE(restored.empty());
+}
@@ -0,0 +1,107 @@
+#ifndef __DEV_NET_RSS_HH__
+#define __DEV_NET_RSS_HH__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gem5
+{
+
+namespace rss
+{
+
+/** Size of the Toeplitz hash key in bytes. */
+constexpr size_t KeySize = 40;
+
+/** The default key from the Microsoft RSS specification. */
+constexpr uint8_t DefaultKey[KeySize] = {
+    0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+    0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+    0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+    0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+    0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa,
+};
+
+/**
+ * Toeplitz hash of len bytes of input, as computed by RSS capable NICs.
+ * len must be at most KeySize - 4.
+ */
+inline uint32_t
+toeplitz(const uint8_t *key, const uint8_t *input, size_t len)
+{
+    uint32_t result = 0;
+    // Sliding 32-bit window over the key, advanced one bit per input bit.
+    uint32_t window = (uint32_t(key[0]) << 24) | (uint32_t(key[1]) << 16) |
+        (uint32_t(key[2]) << 8) | key[3];
+    for (size_t i = 0; i < len; i++) {
+        const uint8_t next_key = key[i + 4];
+        for (int b = 7; b >= 0; b--) {
+            if (input[i] & (1 << b))
+                result ^= window;
+            window = (window << 1) | ((next_key >> b) & 1);
+        }
+    }
+    return result;
+}
+
+/**
+ * Hash an IPv4 flow. Addresses and ports are in host byte order; pass
+ * zero ports for an address-only hash.
+ */
+inline uint32_t
+hashIPv4(const uint8_t *key, uint32_t src_ip, uint32_t dst_ip,
+         uint16_t src_port, uint16_t dst_port, bool with_ports = true)
+{
+    uint8_t input[12] = {
+        uint8_t(src_ip >> 24), uint8_t(src_ip >> 16),
+        uint8_t(src_ip >> 8), uint8_t(src_ip),
+        uint8_t(dst_ip >> 24), uint8_t(dst_ip >> 16),
+        uint8_t(dst_ip >> 8), uint8_t(dst_ip),
+        uint8_t(src_port >> 8), uint8_t(src_port),
+        uint8_t(dst_port >> 8), uint8_t(dst_port),
+    };
+    return toeplitz(key, input, with_ports ? 12 : 8);
+}
+
+/**
+ * Redirection table mapping the low bits of an RSS hash to a queue.
+ * By default entries are filled round-robin over the queues, which is
+ * what Linux drivers program.
+ */
+class RedirectionTable
+{
+  private:
+    std::vector<uint16_t> entries;
+
+  public:
+    RedirectionTable(size_t size = 128, unsigned num_queues = 1)
+        : entries(size)
+    {
+        fill(num_queues);
+    }
+
+    /** Spread the queues round-robin over the table. */
+    void
+    fill(unsigned num_queues)
+    {
+        for (size_t i = 0; i < entries.size(); i++)
+            entries[i] = num_queues ? i % num_queues : 0;
+    }
+
+    size_t size() const { return entries.size(); }
+
+    uint16_t queue(uint32_t hash) const
+    {
+        return entries[hash % entries.size()];
+    }
+
+    uint16_t &operator[](size_t i) { return entries[i]; }
+    uint16_t operator[](size_t i) const { return entries[i]; }
+};
+
+} // namespace rss
+
+} // namespace gem5
+
+#endif // __DEV_NET_RSS_HH__
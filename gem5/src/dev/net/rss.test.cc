@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include "dev/net/rss.hh"
+
+using namespace gem5;
+
+namespace
+{
+
+uint32_t
+ip(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+    return (uint32_t(a) << 24) | (uint32_t(b) << 16) | (uint32_t(c) << 8) | d;
+}
+
+} // anonymous namespace
+
+/** Verification vectors from the Microsoft RSS specification. */
+TEST(RssTest, ToeplitzIPv4Vectors)
+{
+    EXPECT_EQ(rss::hashIPv4(rss::DefaultKey, ip(66, 9, 149, 187),
+                            ip(161, 142, 100, 80), 2794, 1766, false),
+              0x323e8fc2);
+    EXPECT_EQ(rss::hashIPv4(rss::DefaultKey, ip(199, 92, 111, 2),
+                            ip(65, 69, 140, 83), 14230, 4739, false),
+              0xd718262a);
+    EXPECT_EQ(rss::hashIPv4(rss::DefaultKey, ip(24, 19, 198, 95),
+                            ip(12, 22, 207, 184), 12898, 38024, false),
+              0xd2d0a5de);
+}
+
+TEST(RssTest, ToeplitzIPv4PortVectors)
+{
+    EXPECT_EQ(rss::hashIPv4(rss::DefaultKey, ip(66, 9, 149, 187),
+                            ip(161, 142, 100, 80), 2794, 1766),
+              0x51ccc178);
+    EXPECT_EQ(rss::hashIPv4(rss::DefaultKey, ip(199, 92, 111, 2),
+                            ip(65, 69, 140, 83), 14230, 4739),
+              0xc626b0ea);
+    EXPECT_EQ(rss::hashIPv4(rss::DefaultKey, ip(24, 19, 198, 95),
+                            ip(12, 22, 207, 184), 12898, 38024),
+              0x5c2b394a);
+}
+
+/** The default redirection table spreads hashes round-robin. */
+TEST(RssTest, RedirectionTable)
+{
+    rss::RedirectionTable reta(128, 4);
+    ASSERT_EQ(reta.size(), 128);
+    for (uint32_t h = 0; h < 256; h++)
+        EXPECT_EQ(reta.queue(h), h % 4);
+
+    reta[5] = 3;
+    EXPECT_EQ(reta.queue(5), 3);
+    EXPECT_EQ(reta.queue(128 + 5), 3);
+}
@@ -0,0 +1,100 @@
+#ifndef __DEV_NET_VF_SWITCH_HH__
+#define __DEV_NET_VF_SWITCH_HH__
+
+#include <cstdint>
+#include <vector>
+
+namespace gem5
+{
+
+/**
+ * The layer 2 switch between the physical and the virtual functions of
+ * a NIC. Each virtual function owns a unicast MAC address on one VLAN,
+ * VLAN 0 meaning untagged frames; a frame goes to the function whose
+ * address and VLAN it carries, and to the physical function otherwise,
+ * broadcast and multicast frames included.
+ */
+class VfSwitch
+{
+  public:
+    /** Lookup result for frames that belong to the physical function. */
+    static constexpr int Pf = -1;
+
+    static constexpr uint16_t VlanTpid = 0x8100;
+    static constexpr unsigned AddrLen = 6;
+    static constexpr unsigned HeaderLen = 14;
+
+  private:
+    struct Entry
+    {
+        uint64_t mac;
+        uint16_t vlan;
+    };
+
+    std::vector<Entry> entries;
+
+    static uint64_t
+    readAddr(const uint8_t *p)
+    {
+        uint64_t addr = 0;
+        for (unsigned i = 0; i < AddrLen; i++)
+            addr = addr << 8 | p[i];
+        return addr;
+    }
+
+  public:
+    /** Add the next virtual function.
+     * @param mac the address as packed by EthAddr, first byte highest
+     * @param vlan the VLAN ID the function is on, 0 for untagged
+     */
+    void
+    add(uint64_t mac, uint16_t vlan)
+    {
+        entries.push_back({mac, uint16_t(vlan & 0xfff)});
+    }
+
+    unsigned size() const { return entries.size(); }
+
+    /** The VLAN ID of a frame, 0 if it is untagged or too short. */
+    static uint16_t
+    vlan(const uint8_t *frame, unsigned len)
+    {
+        if (len < HeaderLen + 4)
+            return 0;
+        uint16_t type = frame[2 * AddrLen] << 8 | frame[2 * AddrLen + 1];
+        if (type != VlanTpid)
+            return 0;
+        return (frame[HeaderLen] << 8 | frame[HeaderLen + 1]) & 0xfff;
+    }
+
+    /** The virtual function a frame is for, Pf if none. */
+    int
+    lookup(const uint8_t *frame, unsigned len) const
+    {
+        // Group addresses have the low bit of the first byte set
+        if (len < HeaderLen || (frame[0] & 1))
+            return Pf;
+        const uint64_t dst = readAddr(frame);
+        const uint16_t vid = vlan(frame, len);
+        for (unsigned i = 0; i < entries.size(); i++) {
+            if (entries[i].mac == dst && entries[i].vlan == vid)
+                return i;
+        }
+        return Pf;
+    }
+
+    /** Is a frame for one of the functions of this NIC?
+     * @param pf_mac the address of the physical function
+     */
+    bool
+    isLocal(const uint8_t *frame, unsigned len, uint64_t pf_mac) const
+    {
+        if (lookup(frame, len) != Pf)
+            return true;
+        return len >= HeaderLen && readAddr(frame) == pf_mac;
+    }
+};
+
+} // namespace gem5
+
+#endif // __DEV_NET_VF_SWITCH_HH__
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "dev/net/vf_switch.hh"
+
+using namespace gem5;
+
+namespace
+{
+
+const uint64_t PfMac = 0x009000000001;
+
+std::vector<uint8_t>
+frame(uint64_t dst, int vlan = -1)
+{
+    std::vector<uint8_t> f(64, 0);
+    for (unsigned i = 0; i < VfSwitch::AddrLen; i++)
+        f[i] = dst >> (8 * (VfSwitch::AddrLen - 1 - i));
+    if (vlan >= 0) {
+        f[12] = 0x81;
+        f[13] = 0x00;
+        f[14] = vlan >> 8;
+        f[15] = vlan;
+    } else {
+        f[12] = 0x08;
+    }
+    return f;
+}
+
+VfSwitch
+twoVfs()
+{
+    VfSwitch s;
+    s.add(0x009000000010, 0);
+    s.add(0x009000000011, 5);
+    return s;
+}
+
+} // anonymous namespace
+
+TEST(VfSwitchTest, Lookup)
+{
+    VfSwitch s = twoVfs();
+    ASSERT_EQ(s.size(), 2);
+    auto f = frame(0x009000000010);
+    ASSERT_EQ(s.lookup(f.data(), f.size()), 0);
+    f = frame(0x009000000011, 5);
+    ASSERT_EQ(s.lookup(f.data(), f.size()), 1);
+    f = frame(PfMac);
+    ASSERT_EQ(s.lookup(f.data(), f.size()), VfSwitch::Pf);
+}
+
+/** A VF only sees its address on its own VLAN. */
+TEST(VfSwitchTest, Vlan)
+{
+    VfSwitch s = twoVfs();
+    auto f = frame(0x009000000011);
+    ASSERT_EQ(s.lookup(f.data(), f.size()), VfSwitch::Pf);
+    f = frame(0x009000000010, 5);
+    ASSERT_EQ(s.lookup(f.data(), f.size()), VfSwitch::Pf);
+    // The priority bits are not part of the VLAN ID
+    f = frame(0x009000000011, 0xe005);
+    ASSERT_EQ(VfSwitch::vlan(f.data(), f.size()), 5);
+    ASSERT_EQ(s.lookup(f.data(), f.size()), 1);
+}
+
+/** Broadcast, multicast and runt frames stay on the PF. */
+TEST(VfSwitchTest, GroupAndShort)
+{
+    VfSwitch s = twoVfs();
+    auto f = frame(0xffffffffffff);
+    ASSERT_EQ(s.lookup(f.data(), f.size()), VfSwitch::Pf);
+    f = frame(0x010000000010);
+    ASSERT_EQ(s.lookup(f.data(), f.size()), VfSwitch::Pf);
+    f = frame(0x009000000010);
+    ASSERT_EQ(s.lookup(f.data(), 10), VfSwitch::Pf);
+}
+
+TEST(VfSwitchTest, IsLocal)
+{
+    VfSwitch s = twoVfs();
+    auto f = frame(PfMac);
+    ASSERT_TRUE(s.isLocal(f.data(), f.size(), PfMac));
+    f = frame(0x009000000010);
+    ASSERT_TRUE(s.isLocal(f.data(), f.size(), PfMac));
+    f = frame(0x009000000099);
+    ASSERT_FALSE(s.isLocal(f.data(), f.size(), PfMac));
+}
@@ -18,16 +18,37 @@ class DdioBridge(ClockedObject):
     snoop_via_memside = Param.Bool(False, "Using memside for snooping")
     normal_DMA_mode = Param.Bool(False, "Off DDIO functions")
 
-    window_size = Param.UInt32(200, "Window size for Forworad select (us)")
-    threshhold_otf = Param.Float(0.75, "Thresh hold for bypass cache")
-    threshhold_gradchange = Param.Float(0.25, "Thresh hold for bypass cache")
-    threshhold_abs = Param.Float(0.03, "Send if under")
+    # Queueing, the defaults forward without delay until a destination
+    # pushes back
+    delay = Param.Latency('0ns', "Latency through the bridge")
+    req_queue_size = Param.Unsigned(16, "Requests each destination can "
+                                    "hold before the device side stalls")
+    resp_queue_size = Param.Unsigned(16, "Responses to the device side "
+                                     "that can be outstanding")
 
-    # dic option
-    ddio_option_app0 = Param.UInt32(0, "allow send to MLC")
-    ddio_option_app1 = Param.UInt32(0, "allow send to MLC")
-    ddio_option_app2 = Param.UInt32(0, "allow send to MLC")
-    ddio_option_app3 = Param.UInt32(0, "allow send to MLC")
+    # Adaptive placement, see mem/ddio_policies
+    policy = Param.BaseDdioPolicy(NULL, "Picks where each device write "
+                                  "goes among the levels the steering "
+                                  "table allows, none to follow the "
+                                  "table and the device")
+
+    # Steering table, one entry per ADQ index, see mem/ddio_steering.hh
+    # for the register layout. Destination bits are 1 for the MLC, 2 for
+    # the LLC and 4 for DRAM, an entry without any leaves the placement
+    # to the device.
+    pio = SlavePort("Steering registers, connect to an I/O bus")
+    pio_addr = Param.Addr(0, "Address of the steering registers")
+    pio_latency = Param.Latency('100ns', "Steering register access time")
+    steering_entries = Param.Unsigned(64, "Number of steering entries")
+    steering_epoch = Param.Latency('10us', "Period of the MLC share "
+                                   "limits, 0 for no period")
+    steering_dest = VectorParam.UInt32([], "Initial destination bits of "
+                                       "each entry")
+    steering_mlc = VectorParam.Int([], "Initial target MLC of each entry, "
+                                   "-1 for the MLC the ADQ index names")
+    steering_share_limit = VectorParam.UInt32([], "Initial lines each "
+                                              "entry may place in its MLC "
+                                              "per epoch, 0 for no limit")
 
     dynamic_ddio = Param.UInt32(0, "Select dest dynamic")
 
@@ -39,4 +60,20 @@ class DdioBridge(ClockedObject):
 
     send_header_only = Param.Bool(False, "Send header only")
 
+    def steer(self, adq, dest, mlc=-1, share_limit=0):
+        """Program the initial steering entry of an ADQ index."""
+        dests = list(self.steering_dest)
+        mlcs = list(self.steering_mlc)
+        limits = list(self.steering_share_limit)
+        while len(dests) <= adq:
+            dests.append(0)
+        mlcs += [-1] * (len(dests) - len(mlcs))
+        limits += [0] * (len(dests) - len(limits))
+        dests[adq] = dest
+        mlcs[adq] = mlc
+        limits[adq] = share_limit
+        self.steering_dest = dests
+        self.steering_mlc = mlcs
+        self.steering_share_limit = limits
+
     #abstract = True
\ No newline at end of file
@@ -0,0 +1,48 @@
+from m5.params import *
+from m5.objects.ClockedObject import ClockedObject
+
+class PcieLink(ClockedObject):
+    type = 'PcieLink'
+    cxx_header = "mem/pcie_link.hh"
+    cxx_class = 'gem5::PcieLink'
+
+    dev_side_port = ResponsePort("Connects to the DMA port of the device")
+    mem_side_port = RequestPort("Connects to the host I/O fabric")
+
+    gen = Param.Unsigned(3, "PCIe generation, 1 to 5")
+    lanes = Param.Unsigned(8, "Number of lanes")
+    tlp_overhead = Param.Unsigned(24, "Framing, header and CRC bytes of "
+                                  "each TLP")
+    max_payload_size = Param.Unsigned(256, "Max payload size (MPS) in bytes")
+    max_read_request_size = Param.Unsigned(512, "Max read request size "
+                                           "(MRRS) in bytes")
+
+    posted_header_credits = Param.Unsigned(32, "Posted header credits of "
+                                           "the root complex")
+    posted_data_credits = Param.Unsigned(256, "Posted data credits of the "
+                                         "root complex, 16 bytes each")
+    nonposted_header_credits = Param.Unsigned(32, "Non-posted header "
+                                              "credits of the root complex")
+
+    link_latency = Param.Latency('150ns', "Latency across the link and "
+                                 "root complex, one way")
+    credit_update_latency = Param.Latency('100ns', "Time for freed "
+                                          "credits to reach the device")
+
+    def attach(self, device, bus):
+        """Put the link between the DMA port of device and bus."""
+        device.dma = self.dev_side_port
+        self.mem_side_port = bus.cpu_side_ports
+
+    def insert(self, device, dma_ports=None):
+        """Put the link in front of the DMA port of a device that is
+        already attached. Without dma_ports the port is connected and the
+        link is spliced in. Otherwise the port is in dma_ports, the list
+        of DMA ports connected later (e.g. to Ruby), and the link takes
+        its place there."""
+        if dma_ports is None:
+            device.dma.splice(self.dev_side_port, self.mem_side_port)
+        else:
+            i = next(i for i, p in enumerate(dma_ports) if p is device.dma)
+            dma_ports[i] = self.mem_side_port
+            device.dma = self.dev_side_port
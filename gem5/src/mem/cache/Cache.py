@@ -168,6 +168,18 @@ class BaseCache(ClockedObject):
     ddio_way_part = Param.Int(-1, "way partitioning for ddio; "
                                   "-1 means all sets can be used")
 
+    ddio_bridge = Param.DdioBridge(NULL, "DDIO bridge to report the DDIO "
+                                   "blocks of the cache to")
+    ddio_report_interval = Param.Latency('10us', "How often the DDIO "
+                                         "telemetry is reported")
+    ddio_telemetry_adqs = Param.Unsigned(8, "ADQ indices the DDIO "
+                                         "telemetry counts apart")
+
+    cat = Param.CatController(NULL, "Classes of service that partition "
+                              "the ways, ddio_way_part is ignored if set")
+    cat_level = Param.CatLevel('LLC', "Which masks of the classes the "
+                               "cache uses")
+
 class Cache(BaseCache):
     type = 'Cache'
     cxx_header = 'mem/cache/cache.hh'
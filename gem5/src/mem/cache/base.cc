@@ -55,10 +55,12 @@
 #include "debug/HWPrefetch.hh"
 #include "mem/cache/compressors/base.hh"
 #include "mem/cache/mshr.hh"
+#include "mem/cache/partitioning/cat_controller.hh"
 #include "mem/cache/prefetch/base.hh"
 #include "mem/cache/queue_entry.hh"
 #include "mem/cache/tags/compressed_tags.hh"
 #include "mem/cache/tags/super_blk.hh"
+#include "mem/ddio_bridge.hh"
 #include "params/BaseCache.hh"
 #include "params/WriteAllocator.hh"
 #include "sim/cur_tick.hh"
@@ -118,7 +120,14 @@ BaseCache::BaseCache(const BaseCacheParams &p, unsigned blk_size)
       stats(*this),
       ddioEnabled(p.ddio_enabled), ddioDisabled(p.ddio_disabled),
       ddioWayPart(p.ddio_way_part),
-      isLLC(p.is_llc), mlc_ddio(p.mlc_ddio)
+      isLLC(p.is_llc), mlc_ddio(p.mlc_ddio),
+      ddioBridge(p.ddio_bridge),
+      ddioReportInterval(p.ddio_report_interval),
+      ddioTelemetry(p.ddio_telemetry_adqs),
+      ddioReportEvent([this]{ ddioReport(); }, name()),
+      ddioStats(*this, ddioTelemetry.numAdqs()),
+      cat(p.cat), catLevel(CatTable::Level(p.cat_level)),
+      catStats(*this, cat ? cat->numClasses() : 1)
 {
     // the MSHR queue has no reserve entries as we check the MSHR
     // queue on every single allocation, whereas the write queue has
@@ -142,6 +151,18 @@ BaseCache::BaseCache(const BaseCacheParams &p, unsigned blk_size)
         "Compressed cache %s does not have a compression algorithm", name());
     if (compressor)
         compressor->setCache(this);
+
+    fatal_if(ddioBridge && !ddioReportInterval,
+             "%s: the DDIO telemetry needs a report interval", name());
+    ddioInfo.cache_type = isLLC ? CACHE_TYPE_LLC :
+        isMLC ? CACHE_TYPE_MLC : CACHE_TYPE_OTHER;
+    ddioInfo.cache_id = mlc_idx;
+
+    fatal_if(cat && compressor,
+             "%s: way partitioning does not support compression", name());
+    fatal_if(cat && p.assoc > 32,
+             "%s: the masks of the classes of service cover 32 ways, the "
+             "cache has %d", name(), p.assoc);
 }
 
 BaseCache::~BaseCache()
@@ -205,6 +226,71 @@ BaseCache::init()
     forwardSnoops = cpuSidePort.isSnooping();
 }
 
+void
+BaseCache::startup()
+{
+    if (ddioBridge)
+        schedule(ddioReportEvent, curTick() + ddioReportInterval);
+}
+
+void
+BaseCache::ddioReport()
+{
+    ddioTelemetry.report(ddioInfo, curTick());
+    ddioStats.reports++;
+    ddioBridge->recvOtfInfo(ddioInfo);
+    schedule(ddioReportEvent, curTick() + ddioReportInterval);
+}
+
+void
+BaseCache::ddioTrack(CacheBlk *blk, const PacketPtr pkt)
+{
+    if (isIOCache || blk == tempBlock || !pkt->isDdioPkt())
+        return;
+
+    // New DMA data over a block still counted is not an eviction
+    if (blk->isDdioTracked()) {
+        ddioTelemetry.remove(blk->getDdioTrackedAdq(),
+                             blk->isDdioTouched());
+    }
+
+    const int adq = pkt->getDdioPrefetchId();
+    blk->trackDdio(curTick(), adq, pkt->isDdioHeader());
+    ddioTelemetry.insert(adq);
+    ddioStats.inserted[ddioTelemetry.slot(adq)]++;
+}
+
+void
+BaseCache::ddioUse(CacheBlk *blk, const PacketPtr pkt)
+{
+    if (!blk->isDdioTracked() || blk->isDdioTouched() ||
+        pkt->isBlockIO() || pkt->isPrefetchHintPkt()) {
+        return;
+    }
+
+    blk->setDdioTouched();
+    const int adq = blk->getDdioTrackedAdq();
+    const uint64_t latency_ns =
+        (curTick() - blk->getDdioInsertTick()) / sim_clock::as_int::ns;
+    ddioTelemetry.use(adq, blk->isDdioTrackedHeader(), latency_ns);
+    ddioStats.firstUses[ddioTelemetry.slot(adq)]++;
+    ddioStats.firstUseLatency[DdioTelemetry::bucket(latency_ns)]++;
+}
+
+void
+BaseCache::ddioUntrack(CacheBlk *blk)
+{
+    if (!blk->isDdioTracked())
+        return;
+
+    const int adq = blk->getDdioTrackedAdq();
+    ddioTelemetry.evict(adq, blk->isDdioTouched());
+    ddioStats.evicted[ddioTelemetry.slot(adq)]++;
+    if (!blk->isDdioTouched())
+        ddioStats.untouchedEvicted[ddioTelemetry.slot(adq)]++;
+    blk->untrackDdio();
+}
+
 Port &
 BaseCache::getPort(const std::string &if_name, PortID idx)
 {
@@ -540,6 +626,7 @@ BaseCache::recvTimingResp(PacketPtr pkt)
         // SHIN.
         if(pkt->getDdioPrefetchDestination() == -1){
             pkt->setDdioPrefetchDestination(mshr->qid_from_dev);
+            pkt->setDdioPrefetchId(mshr->adq_from_dev);
             if(mshr->is_ddio_pkt) pkt->setDdioPkt();
             if(mshr->is_header) pkt->setDdioHeader();
         }
@@ -1086,6 +1173,8 @@ BaseCache::satisfyRequest(PacketPtr pkt, CacheBlk *blk, bool, bool)
     // assert(!pkt->needsWritable() || blk->isSet(CacheBlk::WritableBit));
     assert(pkt->getOffset(blkSize) + pkt->getSize() <= blkSize);
 
+    ddioUse(blk, pkt);
+
     // Check RMW operations first since both isRead() and
     // isWrite() will be true for them
     if (pkt->cmd == MemCmd::SwapReq) {
@@ -1267,6 +1356,7 @@ BaseCache::access(PacketPtr pkt, CacheBlk *&blk, Cycles &lat,
             if(isIOCache){
                 if(pkt->cmd == MemCmd::WriteReq || pkt->cmd == MemCmd::WriteLineReq){
                     wbPkt->setDdioPrefetchDestination(pkt->getDdioPrefetchDestination());
+                    wbPkt->setDdioPrefetchId(pkt->getDdioPrefetchId());
                     if(pkt->isDdioPkt()) wbPkt->setDdioPkt();
                     if(pkt->isDdioHeader()) wbPkt->setDdioHeader();
                     //DPRINTF(AdaptiveDdioOtf, "wb_entry. pkt adq %d, pkt %s\n", pkt->getAdqQ(), pkt->print());
@@ -1381,7 +1471,10 @@ BaseCache::access(PacketPtr pkt, CacheBlk *&blk, Cycles &lat,
                 blk->setDdioPrefetchDestination(pkt->getDdioPrefetchDestination());
                 
             }
+            // The bridge steers the writeback by the queue it came from
+            blk->setDdioPrefetchId(pkt->isDdioPkt() ? pkt->getDdioPrefetchId() : -1);
         }
+        ddioTrack(blk, pkt);
 
         return true;
     } else if (pkt->cmd == MemCmd::CleanEvict) {
@@ -1470,7 +1563,9 @@ BaseCache::access(PacketPtr pkt, CacheBlk *&blk, Cycles &lat,
                 if(pkt->isDdioHeader()) blk->setDdioHeader();
                 //DPRINTF(AdaptiveDdioOtf, "Alloc blk WriteClean. pkt adq %d, pkt %s\n", pkt->getAdqQ(), pkt->print());
             }
+            blk->setDdioPrefetchId(pkt->isDdioPkt() ? pkt->getDdioPrefetchId() : -1);
         }
+        ddioTrack(blk, pkt);
 
         // If this a write-through packet it will be sent to cache below
         return !pkt->writeThrough();
@@ -1635,7 +1730,11 @@ BaseCache::handleFill(PacketPtr pkt, CacheBlk *blk, PacketList &writebacks,
                 blk->setDdioPkt();
             }
         }
+        blk->setDdioPrefetchId(pkt->isDdioPkt() ? pkt->getDdioPrefetchId() : -1);
     }
+    // DMA data reaches an MLC through the prefetch the bridge hints
+    if (isMLC)
+        ddioTrack(blk, pkt);
 
     return blk;
 }
@@ -1673,9 +1772,11 @@ BaseCache::allocateBlock(const PacketPtr pkt, PacketList &writebacks, bool is_dd
     // CacheBlk *victim = tags->findVictim(addr, is_secure, blk_size_bits,
     //                                     evict_blks);
     CacheBlk *victim;
+    int clos = -1;
 
-    if (is_ddio) {
-        victim = tags->findVictimWayPart(addr, is_secure, evict_blks, ddioWayPart);
+    if (cat || is_ddio) {
+        victim = tags->findVictimWayPart(addr, is_secure, evict_blks,
+                                         allocationMask(pkt, is_ddio, clos));
     } else {
         victim = tags->findVictim(addr, is_secure, blk_size_bits, evict_blks);
     }
@@ -1705,9 +1806,32 @@ BaseCache::allocateBlock(const PacketPtr pkt, PacketList &writebacks, bool is_dd
     // SHIN
     victim->setDdioPrefetchDestination(pkt->getDdioPrefetchDestination());
 
+    if (cat) {
+        victim->setCatClass(clos);
+        catStats.occupancies[clos]++;
+        catStats.allocations[clos]++;
+    }
+
     return victim;
 }
 
+uint64_t
+BaseCache::allocationMask(const PacketPtr pkt, bool is_ddio, int &clos) const
+{
+    if (cat) {
+        clos = cat->classOf(pkt);
+        return cat->mask(catLevel, clos);
+    }
+    // A negative partition lets DDIO use every way
+    return ddioWayPart < 0 ? ~uint64_t(0) : uint64_t(ddioWayPart);
+}
+
+void
+BaseCache::catMiss(const PacketPtr pkt)
+{
+    catStats.misses[cat->classOf(pkt)]++;
+}
+
 void
 BaseCache::invalidateBlock(CacheBlk *blk, bool is_llc_inv) // SHIN.
 {
@@ -1719,6 +1843,10 @@ BaseCache::invalidateBlock(CacheBlk *blk, bool is_llc_inv) // SHIN.
     // Notify that the data contents for this address are no longer present
     updateBlockData(blk, nullptr, blk->isValid());
 
+    ddioUntrack(blk);
+    if (blk->getCatClass() >= 0)
+        catStats.occupancies[blk->getCatClass()]--;
+
     // If handling a block present in the Tags, let it do its invalidation
     // process, which will update stats and invalidate the block itself
     if (blk != tempBlock) {
@@ -1763,11 +1891,14 @@ BaseCache::writebackBlk(CacheBlk *blk)
     PacketPtr pkt =
         new Packet(req, blk->isSet(CacheBlk::DirtyBit) ?
                    MemCmd::WritebackDirty : MemCmd::WritebackClean);
+    // Writebacks have no context, the block keeps its class of service
+    pkt->setCatClass(blk->getCatClass());
 
     // SHIN
     if(isIOCache){
         // SHIN. Adpative-DDIO ADQ
         pkt->setDdioPrefetchDestination(blk->getDdioPrefetchDestination());
+        pkt->setDdioPrefetchId(blk->getDdioPrefetchId());
         pkt->setBlockIO();
         
         
@@ -1825,6 +1956,7 @@ BaseCache::writecleanBlk(CacheBlk *blk, Request::Flags dest, PacketId id)
     req->taskId(blk->getTaskId());
 
     PacketPtr pkt = new Packet(req, MemCmd::WriteClean, blkSize, id);
+    pkt->setCatClass(blk->getCatClass());
 
     if (dest) {
         req->setFlags(dest);
@@ -2560,6 +2692,70 @@ BaseCache::CacheStats::regStats()
     dataContractions.flags(nozero | nonan);
 }
 
+BaseCache::DdioTelemetryStats::DdioTelemetryStats(BaseCache &c,
+                                                  unsigned num_adqs)
+    : statistics::Group(&c, "ddio"),
+      ADD_STAT(inserted, statistics::units::Count::get(),
+               "DDIO blocks written into the cache"),
+      ADD_STAT(firstUses, statistics::units::Count::get(),
+               "DDIO blocks read after they were written"),
+      ADD_STAT(evicted, statistics::units::Count::get(),
+               "DDIO blocks that left the cache"),
+      ADD_STAT(untouchedEvicted, statistics::units::Count::get(),
+               "DDIO blocks that left the cache before they were read"),
+      ADD_STAT(untouchedEvictRate, statistics::units::Ratio::get(),
+               "Fraction of the DDIO blocks evicted before they were "
+               "read", untouchedEvicted / evicted),
+      ADD_STAT(firstUseLatency, statistics::units::Count::get(),
+               "First reads of DDIO blocks by the time since the DMA, "
+               "bucket n from 2^(n-1) ns"),
+      ADD_STAT(reports, statistics::units::Count::get(),
+               "Reports sent to the DDIO bridge")
+{
+    using namespace statistics;
+
+    inserted.init(num_adqs).flags(nozero);
+    firstUses.init(num_adqs).flags(nozero);
+    evicted.init(num_adqs).flags(nozero);
+    untouchedEvicted.init(num_adqs).flags(nozero);
+    untouchedEvictRate.flags(nozero | nonan);
+    for (unsigned i = 0; i < num_adqs; i++) {
+        const std::string adq = csprintf("adq%d", i);
+        inserted.subname(i, adq);
+        firstUses.subname(i, adq);
+        evicted.subname(i, adq);
+        untouchedEvicted.subname(i, adq);
+    }
+
+    firstUseLatency.init(DdioLatencyBuckets).flags(nozero);
+    firstUseLatency.subname(0, "lt1ns");
+    for (unsigned b = 1; b < DdioLatencyBuckets; b++)
+        firstUseLatency.subname(b, csprintf("%dns", 1ULL << (b - 1)));
+}
+
+BaseCache::CatStats::CatStats(BaseCache &c, unsigned num_classes)
+    : statistics::Group(&c, "cat"),
+      ADD_STAT(occupancies, statistics::units::Rate<
+                  statistics::units::Count, statistics::units::Tick>::get(),
+               "Average blocks held by each class of service"),
+      ADD_STAT(misses, statistics::units::Count::get(),
+               "Misses of each class of service"),
+      ADD_STAT(allocations, statistics::units::Count::get(),
+               "Blocks filled for each class of service")
+{
+    using namespace statistics;
+
+    occupancies.init(num_classes).flags(nozero);
+    misses.init(num_classes).flags(nozero);
+    allocations.init(num_classes).flags(nozero);
+    for (unsigned i = 0; i < num_classes; i++) {
+        const std::string clos = csprintf("clos%d", i);
+        occupancies.subname(i, clos);
+        misses.subname(i, clos);
+        allocations.subname(i, clos);
+    }
+}
+
 void
 BaseCache::regProbePoints()
 {
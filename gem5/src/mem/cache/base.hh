@@ -61,9 +61,11 @@
 #include "mem/cache/cache_blk.hh"
 #include "mem/cache/compressors/base.hh"
 #include "mem/cache/mshr_queue.hh"
+#include "mem/cache/partitioning/cat_table.hh"
 #include "mem/cache/tags/base.hh"
 #include "mem/cache/write_queue.hh"
 #include "mem/cache/write_queue_entry.hh"
+#include "mem/ddio_telemetry.hh"
 #include "mem/packet.hh"
 #include "mem/packet_queue.hh"
 #include "mem/qport.hh"
@@ -84,6 +86,8 @@ namespace prefetch
 {
     class Base;
 }
+class CatController;
+class DdioBridge;
 class MSHR;
 class RequestPort;
 class QueueEntry;
@@ -1158,6 +1162,7 @@ class BaseCache : public ClockedObject
     ~BaseCache();
 
     void init() override;
+    void startup() override;
 
     Port &getPort(const std::string &if_name,
                   PortID idx=InvalidPortID) override;
@@ -1301,6 +1306,8 @@ class BaseCache : public ClockedObject
     {
         assert(pkt->req->requestorId() < system->maxRequestors());
         stats.cmdStats(pkt).misses[pkt->req->requestorId()]++;
+        if (cat)
+            catMiss(pkt);
         pkt->req->incAccessDepth();
         if (missCount) {
             --missCount;
@@ -1380,6 +1387,64 @@ class BaseCache : public ClockedObject
     int32_t ddioWayPart;
     bool isLLC;
     bool mlc_ddio;
+
+  protected:
+    /** The DDIO bridge the DDIO telemetry goes to, if any */
+    DdioBridge *ddioBridge;
+    const Tick ddioReportInterval;
+    DdioTelemetry ddioTelemetry;
+    /** The report, filled in place every interval */
+    OnTheFlyInfo ddioInfo;
+    EventFunctionWrapper ddioReportEvent;
+
+    /** Send the DDIO telemetry of the last interval to the bridge. */
+    void ddioReport();
+
+    /** Start counting a block DMA data landed in. */
+    void ddioTrack(CacheBlk *blk, const PacketPtr pkt);
+
+    /** Count the first read of a DDIO block. */
+    void ddioUse(CacheBlk *blk, const PacketPtr pkt);
+
+    /** Count a DDIO block that leaves the cache. */
+    void ddioUntrack(CacheBlk *blk);
+
+    struct DdioTelemetryStats : public statistics::Group
+    {
+        DdioTelemetryStats(BaseCache &c, unsigned num_adqs);
+
+        /** Per ADQ index, the last one also counts untagged data */
+        statistics::Vector inserted;
+        statistics::Vector firstUses;
+        statistics::Vector evicted;
+        statistics::Vector untouchedEvicted;
+        statistics::Formula untouchedEvictRate;
+
+        /** First uses by DMA-to-use latency, in log2 ns buckets */
+        statistics::Vector firstUseLatency;
+
+        statistics::Scalar reports;
+    } ddioStats;
+
+    /** The classes of service partitioning the ways, if any */
+    CatController *cat;
+    const CatTable::Level catLevel;
+
+    /** The ways a block filled for a packet may go to. */
+    uint64_t allocationMask(const PacketPtr pkt, bool is_ddio,
+                            int &clos) const;
+
+    void catMiss(const PacketPtr pkt);
+
+    struct CatStats : public statistics::Group
+    {
+        CatStats(BaseCache &c, unsigned num_classes);
+
+        /** Blocks held by each class of service */
+        statistics::AverageVector occupancies;
+        statistics::Vector misses;
+        statistics::Vector allocations;
+    } catStats;
 };
 
 /**
@@ -163,6 +163,16 @@ class CacheBlk : public TaggedEntry
     bool is_prefetch_hint_pkt = false;
     bool is_block_io;
 
+    // DDIO telemetry, see DdioTelemetry
+    bool ddio_tracked = false;
+    bool ddio_touched = false;
+    bool ddio_tracked_header = false;
+    int ddio_tracked_adq = -1;
+    Tick ddio_insert_tick = 0;
+
+    /** Class of service the block was filled for, -1 without CAT */
+    int cat_class = -1;
+
   public:
     // SHIN
     void setDdioPrefetchId(int ddio_id){ddio_prefetch_id = ddio_id;}
@@ -179,6 +189,27 @@ class CacheBlk : public TaggedEntry
     bool isPrefetchHintPkt(){return is_prefetch_hint_pkt;}
     bool isBlockIO(){return is_block_io;}
 
+    /** DMA data landed in the block, count it until it is read. */
+    void
+    trackDdio(Tick when, int adq, bool header)
+    {
+        ddio_tracked = true;
+        ddio_touched = false;
+        ddio_tracked_header = header;
+        ddio_tracked_adq = adq;
+        ddio_insert_tick = when;
+    }
+    void setDdioTouched() { ddio_touched = true; }
+    void untrackDdio() { ddio_tracked = false; }
+    bool isDdioTracked() const { return ddio_tracked; }
+    bool isDdioTouched() const { return ddio_touched; }
+    bool isDdioTrackedHeader() const { return ddio_tracked_header; }
+    int getDdioTrackedAdq() const { return ddio_tracked_adq; }
+    Tick getDdioInsertTick() const { return ddio_insert_tick; }
+
+    void setCatClass(int clos) { cat_class = clos; }
+    int getCatClass() const { return cat_class; }
+
     
     CacheBlk() : TaggedEntry(), data(nullptr), _tickInserted(0)
     {
@@ -215,6 +246,12 @@ class CacheBlk : public TaggedEntry
         setRefCount(other.getRefCount());
         setSrcRequestorId(other.getSrcRequestorId());
         std::swap(lockList, other.lockList);
+        ddio_tracked = other.ddio_tracked;
+        ddio_touched = other.ddio_touched;
+        ddio_tracked_header = other.ddio_tracked_header;
+        ddio_tracked_adq = other.ddio_tracked_adq;
+        ddio_insert_tick = other.ddio_insert_tick;
+        cat_class = other.cat_class;
 
         other.invalidate();
 
@@ -237,6 +274,8 @@ class CacheBlk : public TaggedEntry
         setRefCount(0);
         setSrcRequestorId(Request::invldRequestorId);
         lockList.clear();
+        ddio_tracked = false;
+        cat_class = -1;
     }
 
     /**
@@ -319,6 +319,7 @@ MSHR::allocate(Addr blk_addr, unsigned blk_size, PacketPtr target,
     // SHIN
     wasBlockIO = target->isBlockIO();
     qid_from_dev = target->getDdioPrefetchDestination();
+    adq_from_dev = target->getDdioPrefetchId();
     is_header = target->isDdioHeader();
     is_ddio_pkt = target->isDdioPkt();
     
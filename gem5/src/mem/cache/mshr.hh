@@ -132,6 +132,7 @@ class MSHR : public QueueEntry, public Printable
 
     // SHIN. adq
     int qid_from_dev;
+    int adq_from_dev;
     bool mlc_ddio_allow;
     bool is_ddio_pkt;
     bool is_header;
@@ -0,0 +1,38 @@
+from m5.params import *
+from m5.proxy import *
+from m5.SimObject import SimObject
+
+class CatLevel(Enum): vals = ['L2', 'LLC']
+
+class CatController(SimObject):
+    type = 'CatController'
+    cxx_class = 'gem5::CatController'
+    cxx_header = "mem/cache/partitioning/cat_controller.hh"
+
+    system = Param.System(Parent.any, "System the requestors belong to")
+
+    num_classes = Param.Unsigned(16, "Classes of service")
+    num_contexts = Param.Unsigned(64, "Hardware contexts with a class "
+                                  "register")
+    num_adqs = Param.Unsigned(64, "DMA queues with a class register")
+
+    l2_masks = VectorParam.UInt32([], "Ways each class may fill in the "
+                                  "L2s, from class 0, all ways if not "
+                                  "given")
+    llc_masks = VectorParam.UInt32([], "Ways each class may fill in the "
+                                   "LLC, from class 0, all ways if not "
+                                   "given")
+
+    context_classes = VectorParam.Unsigned([], "Class of each hardware "
+                                           "context, from context 0")
+    adq_classes = VectorParam.Unsigned([], "Class of each DMA queue, "
+                                       "from queue 0")
+    requestors = VectorParam.String([], "Requestors with a class of "
+                                    "their own, by name")
+    requestor_classes = VectorParam.Unsigned([], "Class of each of the "
+                                             "requestors")
+
+    pio = ResponsePort("Class of service registers, connect to an I/O "
+                       "bus")
+    pio_addr = Param.Addr(0, "Address of the class of service registers")
+    pio_latency = Param.Latency('100ns', "Register access time")
@@ -0,0 +1,174 @@
+#include "mem/cache/partitioning/cat_controller.hh"
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/Cat.hh"
+#include "sim/serialize.hh"
+#include "sim/system.hh"
+
+namespace gem5
+{
+
+CatController::CatController(const Params &p)
+    : SimObject(p), table(p.num_classes, p.num_contexts, p.num_adqs),
+      system(p.system), requestors(p.requestors),
+      requestorClasses(p.requestor_classes), pioAddr(p.pio_addr),
+      pioDelay(p.pio_latency), pioPort(this)
+{
+    fatal_if(!p.num_classes || p.num_classes > CatTable::MaxClasses,
+             "%s: num_classes must be in [1, %d]", name(),
+             CatTable::MaxClasses);
+    fatal_if(p.num_contexts > CatTable::MaxContexts,
+             "%s: at most %d contexts have a class register", name(),
+             CatTable::MaxContexts);
+    fatal_if(p.num_adqs > CatTable::MaxAdqs,
+             "%s: at most %d DMA queues have a class register", name(),
+             CatTable::MaxAdqs);
+
+    fatal_if(p.l2_masks.size() > p.num_classes ||
+             p.llc_masks.size() > p.num_classes,
+             "%s: more masks than classes", name());
+    for (unsigned i = 0; i < p.l2_masks.size(); ++i) {
+        fatal_if(!table.setMask(CatTable::L2, i, p.l2_masks[i]),
+                 "%s: the L2 mask of class %d is empty", name(), i);
+    }
+    for (unsigned i = 0; i < p.llc_masks.size(); ++i) {
+        fatal_if(!table.setMask(CatTable::Llc, i, p.llc_masks[i]),
+                 "%s: the LLC mask of class %d is empty", name(), i);
+    }
+
+    fatal_if(p.context_classes.size() > p.num_contexts,
+             "%s: %d context classes given, %d contexts have a class",
+             name(), p.context_classes.size(), p.num_contexts);
+    for (unsigned i = 0; i < p.context_classes.size(); ++i)
+        table.setContext(i, p.context_classes[i]);
+
+    fatal_if(p.adq_classes.size() > p.num_adqs,
+             "%s: %d DMA queue classes given, %d queues have a class",
+             name(), p.adq_classes.size(), p.num_adqs);
+    for (unsigned i = 0; i < p.adq_classes.size(); ++i)
+        table.setAdq(i, p.adq_classes[i]);
+
+    fatal_if(requestors.size() != requestorClasses.size(),
+             "%s: requestors and requestor_classes differ in size",
+             name());
+}
+
+unsigned
+CatController::classOf(const PacketPtr pkt) const
+{
+    // Writebacks are made by the cache, not the context that filled the
+    // block, and carry the class of service of the block instead
+    const int clos = pkt->getCatClass();
+    if (clos >= 0 && (unsigned)clos < numClasses())
+        return clos;
+
+    const int adq = pkt->isDdioPkt() ? pkt->getDdioPrefetchId() : -1;
+    const int ctx = pkt->req->hasContextId() ? pkt->req->contextId() : -1;
+    return table.classOf(adq, ctx, pkt->req->requestorId());
+}
+
+Tick
+CatController::read(PacketPtr pkt)
+{
+    const Addr daddr = pkt->getAddr() - pioAddr;
+    if (pkt->getSize() != 4) {
+        warn_once("%s: %d byte class of service register read, registers "
+                  "are 32 bits\n", name(), pkt->getSize());
+        pkt->setBadAddress();
+        return pioDelay;
+    }
+
+    pkt->setLE<uint32_t>(table.readReg(daddr));
+    DPRINTF(Cat, "Register %#x read: %#x\n", daddr,
+            pkt->getLE<uint32_t>());
+    pkt->makeAtomicResponse();
+    return pioDelay;
+}
+
+Tick
+CatController::write(PacketPtr pkt)
+{
+    const Addr daddr = pkt->getAddr() - pioAddr;
+    if (pkt->getSize() != 4) {
+        warn_once("%s: %d byte class of service register write, "
+                  "registers are 32 bits\n", name(), pkt->getSize());
+        pkt->setBadAddress();
+        return pioDelay;
+    }
+
+    DPRINTF(Cat, "Register %#x written: %#x\n", daddr,
+            pkt->getLE<uint32_t>());
+    table.writeReg(daddr, pkt->getLE<uint32_t>());
+    pkt->makeAtomicResponse();
+    return pioDelay;
+}
+
+AddrRangeList
+CatController::getAddrRanges() const
+{
+    return { RangeSize(pioAddr, table.regSize()) };
+}
+
+Port &
+CatController::getPort(const std::string &if_name, PortID idx)
+{
+    if (if_name == "pio")
+        return pioPort;
+    return SimObject::getPort(if_name, idx);
+}
+
+void
+CatController::init()
+{
+    SimObject::init();
+
+    // The requestor IDs are all handed out by now
+    for (unsigned i = 0; i < requestors.size(); ++i) {
+        const RequestorID id = system->lookupRequestorId(requestors[i]);
+        fatal_if(id == Request::invldRequestorId,
+                 "%s: no requestor named %s", name(), requestors[i]);
+        table.setRequestor(id, requestorClasses[i]);
+        DPRINTF(Cat, "Requestor %s (%d) is in class %d\n", requestors[i],
+                id, requestorClasses[i]);
+    }
+
+    // The registers are only reachable when the pio port is connected to
+    // an I/O bus
+    if (pioPort.isConnected())
+        pioPort.sendRangeChange();
+}
+
+void
+CatController::serialize(CheckpointOut &cp) const
+{
+    for (Addr reg : registers())
+        paramOut(cp, csprintf("reg%#x", reg), table.readReg(reg));
+}
+
+void
+CatController::unserialize(CheckpointIn &cp)
+{
+    // Checkpoints taken without a controller have no registers, keep
+    // the configured ones then
+    for (Addr reg : registers()) {
+        uint32_t val;
+        if (optParamIn(cp, csprintf("reg%#x", reg), val, false))
+            table.writeReg(reg, val);
+    }
+}
+
+std::vector<Addr>
+CatController::registers() const
+{
+    std::vector<Addr> regs;
+    for (unsigned i = 0; i < CatTable::NumLevels * numClasses(); ++i)
+        regs.push_back(CatTable::MaskBase + 4 * i);
+    for (unsigned i = 0; i < table.numContexts(); ++i)
+        regs.push_back(CatTable::ContextBase + 4 * i);
+    for (unsigned i = 0; i < table.numAdqs(); ++i)
+        regs.push_back(CatTable::AdqBase + 4 * i);
+    return regs;
+}
+
+} // namespace gem5
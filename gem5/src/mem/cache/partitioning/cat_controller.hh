@@ -0,0 +1,73 @@
+#ifndef __MEM_CACHE_PARTITIONING_CAT_CONTROLLER_HH__
+#define __MEM_CACHE_PARTITIONING_CAT_CONTROLLER_HH__
+
+#include <string>
+#include <vector>
+
+#include "dev/io_device.hh"
+#include "mem/cache/partitioning/cat_table.hh"
+#include "mem/packet.hh"
+#include "params/CatController.hh"
+#include "sim/sim_object.hh"
+
+namespace gem5
+{
+
+class System;
+
+/**
+ * Holds the cache allocation classes of service the L2s and the LLC
+ * share, see CatTable. The configuration sets the initial masks and
+ * classes, the guest can change them at any time through the registers
+ * on the pio port. A changed mask only applies to later fills, blocks
+ * already in ways a class lost stay until they are replaced.
+ */
+class CatController : public SimObject
+{
+  private:
+    CatTable table;
+    System *system;
+
+    const std::vector<std::string> requestors;
+    const std::vector<unsigned> requestorClasses;
+
+    const Addr pioAddr;
+    const Tick pioDelay;
+    PioPort<CatController> pioPort;
+
+    /** The registers a checkpoint holds. */
+    std::vector<Addr> registers() const;
+
+  public:
+    PARAMS(CatController);
+    CatController(const Params &p);
+
+    unsigned numClasses() const { return table.numClasses(); }
+
+    /** The class of service of an access. */
+    unsigned classOf(const PacketPtr pkt) const;
+
+    /** The ways a class may fill at a level. */
+    uint32_t
+    mask(CatTable::Level level, unsigned clos) const
+    {
+        return table.mask(level, clos);
+    }
+
+    /** Class of service register accesses. */
+    Tick read(PacketPtr pkt);
+    Tick write(PacketPtr pkt);
+    AddrRangeList getAddrRanges() const;
+
+    Port &getPort(const std::string &if_name,
+                  PortID idx=InvalidPortID) override;
+
+    void init() override;
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+};
+
+} // namespace gem5
+
+#endif // __MEM_CACHE_PARTITIONING_CAT_CONTROLLER_HH__
@@ -0,0 +1,188 @@
+#ifndef __MEM_CACHE_PARTITIONING_CAT_TABLE_HH__
+#define __MEM_CACHE_PARTITIONING_CAT_TABLE_HH__
+
+#include <cstdint>
+#include <vector>
+
+#include "base/types.hh"
+
+namespace gem5
+{
+
+/**
+ * Cache allocation classes of service in the style of Intel CAT. Each
+ * class has a capacity bitmask per cache level: a cache of that level
+ * only replaces blocks in the ways of the mask of the class that misses.
+ * Hits are not restricted, so a class can read data in any way.
+ *
+ * An access gets the class of its DMA queue when it comes from a device,
+ * else the class of its hardware context, else the class of its
+ * requestor, else class 0.
+ *
+ * The table is programmed through a register block:
+ *   0x000           INFO   classes | levels << 8 (RO)
+ *   0x100 + 4(lC+c) MASK   ways class c may fill at level l, not 0
+ *   0x400 + 4n      CTX    class of hardware context n
+ *   0x800 + 4n      ADQ    class of DMA queue n
+ * Writing a class at or past the number of classes unassigns the
+ * context or queue, the registers read ~0 then.
+ */
+class CatTable
+{
+  public:
+    enum Level
+    {
+        L2,
+        Llc,
+        NumLevels
+    };
+
+    static constexpr Addr RegInfo = 0x000;
+    static constexpr Addr MaskBase = 0x100;
+    static constexpr Addr ContextBase = 0x400;
+    static constexpr Addr AdqBase = 0x800;
+    static constexpr Addr RegEnd = 0xc00;
+
+    static constexpr unsigned MaxClasses = (ContextBase - MaskBase) / 4 /
+                                           NumLevels;
+    static constexpr unsigned MaxContexts = (AdqBase - ContextBase) / 4;
+    static constexpr unsigned MaxAdqs = (RegEnd - AdqBase) / 4;
+
+    static constexpr int Unassigned = -1;
+
+  private:
+    const unsigned classes;
+    /** Per level, then per class */
+    std::vector<uint32_t> masks;
+    std::vector<int> contextClass;
+    std::vector<int> adqClass;
+    std::vector<int> requestorClass;
+
+    int
+    lookup(const std::vector<int> &map, int key) const
+    {
+        if (key < 0 || key >= int(map.size()))
+            return Unassigned;
+        return map[key];
+    }
+
+    bool
+    assign(std::vector<int> &map, int key, unsigned clos)
+    {
+        if (key < 0 || key >= int(map.size()))
+            return false;
+        map[key] = clos < classes ? int(clos) : Unassigned;
+        return true;
+    }
+
+  public:
+    /**
+     * @param _classes the number of classes of service
+     * @param contexts the hardware contexts with a class register
+     * @param adqs the DMA queues with a class register
+     */
+    CatTable(unsigned _classes, unsigned contexts, unsigned adqs)
+        : classes(_classes), masks(NumLevels * _classes, ~uint32_t(0)),
+          contextClass(contexts, Unassigned), adqClass(adqs, Unassigned)
+    {}
+
+    unsigned numClasses() const { return classes; }
+    unsigned numContexts() const { return contextClass.size(); }
+    unsigned numAdqs() const { return adqClass.size(); }
+
+    uint32_t
+    mask(Level level, unsigned clos) const
+    {
+        return masks[level * classes + clos];
+    }
+
+    /** Set the mask of a class, an empty mask is refused. */
+    bool
+    setMask(Level level, unsigned clos, uint32_t mask)
+    {
+        if (clos >= classes || !mask)
+            return false;
+        masks[level * classes + clos] = mask;
+        return true;
+    }
+
+    bool
+    setContext(int ctx, unsigned clos)
+    {
+        return assign(contextClass, ctx, clos);
+    }
+
+    bool
+    setAdq(int adq, unsigned clos)
+    {
+        return assign(adqClass, adq, clos);
+    }
+
+    /** Requestor IDs are only known once the system is built, so their
+     * classes are not registers and the map grows as needed. */
+    void
+    setRequestor(int id, unsigned clos)
+    {
+        if (id < 0)
+            return;
+        if (id >= int(requestorClass.size()))
+            requestorClass.resize(id + 1, Unassigned);
+        assign(requestorClass, id, clos);
+    }
+
+    int contextOf(int ctx) const { return lookup(contextClass, ctx); }
+    int adqOf(int adq) const { return lookup(adqClass, adq); }
+
+    /**
+     * The class of an access.
+     * @param adq the DMA queue of a device access, -1 otherwise
+     * @param ctx the hardware context, -1 if there is none
+     */
+    unsigned
+    classOf(int adq, int ctx, int requestor) const
+    {
+        int clos = lookup(adqClass, adq);
+        if (clos == Unassigned)
+            clos = lookup(contextClass, ctx);
+        if (clos == Unassigned)
+            clos = lookup(requestorClass, requestor);
+        return clos == Unassigned ? 0 : clos;
+    }
+
+    Addr regSize() const { return RegEnd; }
+
+    uint32_t
+    readReg(Addr offset) const
+    {
+        if (offset == RegInfo)
+            return classes | NumLevels << 8;
+        if (offset >= MaskBase && offset < ContextBase) {
+            const unsigned n = (offset - MaskBase) / 4;
+            return n < masks.size() ? masks[n] : 0;
+        }
+        if (offset >= ContextBase && offset < AdqBase)
+            return lookup(contextClass, (offset - ContextBase) / 4);
+        if (offset >= AdqBase && offset < RegEnd)
+            return lookup(adqClass, (offset - AdqBase) / 4);
+        return 0;
+    }
+
+    /** Write a register, writes the table refuses are ignored. */
+    void
+    writeReg(Addr offset, uint32_t val)
+    {
+        if (offset >= MaskBase && offset < ContextBase) {
+            const unsigned n = (offset - MaskBase) / 4;
+            if (n < masks.size())
+                setMask(Level(n / classes), n % classes, val);
+        } else if (offset >= ContextBase && offset < AdqBase) {
+            setContext((offset - ContextBase) / 4, val);
+        } else if (offset >= AdqBase && offset < RegEnd) {
+            setAdq((offset - AdqBase) / 4, val);
+        }
+    }
+};
+
+} // namespace gem5
+
+#endif // __MEM_CACHE_PARTITIONING_CAT_TABLE_HH__
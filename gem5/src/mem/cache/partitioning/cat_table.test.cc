@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include "mem/cache/partitioning/cat_table.hh"
+
+using namespace gem5;
+
+TEST(CatTableTest, DefaultsToClassZeroWithAllWays)
+{
+    CatTable table(4, 8, 8);
+    EXPECT_EQ(0, table.classOf(-1, -1, 3));
+    EXPECT_EQ(0, table.classOf(2, 5, 3));
+    EXPECT_EQ(~uint32_t(0), table.mask(CatTable::L2, 3));
+    EXPECT_EQ(~uint32_t(0), table.mask(CatTable::Llc, 0));
+}
+
+TEST(CatTableTest, ClassPrecedence)
+{
+    CatTable table(4, 8, 8);
+    table.setRequestor(3, 1);
+    EXPECT_EQ(1, table.classOf(-1, -1, 3));
+
+    table.setContext(5, 2);
+    EXPECT_EQ(2, table.classOf(-1, 5, 3));
+
+    table.setAdq(2, 3);
+    EXPECT_EQ(3, table.classOf(2, 5, 3));
+    // Queues without a class fall back on the context and requestor
+    EXPECT_EQ(2, table.classOf(4, 5, 3));
+}
+
+TEST(CatTableTest, MasksPerLevel)
+{
+    CatTable table(2, 1, 1);
+    EXPECT_TRUE(table.setMask(CatTable::L2, 1, 0x3));
+    EXPECT_TRUE(table.setMask(CatTable::Llc, 1, 0xf0));
+    EXPECT_EQ(0x3, table.mask(CatTable::L2, 1));
+    EXPECT_EQ(0xf0, table.mask(CatTable::Llc, 1));
+    EXPECT_EQ(~uint32_t(0), table.mask(CatTable::L2, 0));
+
+    // A class without any way could not allocate at all
+    EXPECT_FALSE(table.setMask(CatTable::L2, 1, 0));
+    EXPECT_FALSE(table.setMask(CatTable::L2, 2, 0x1));
+    EXPECT_EQ(0x3, table.mask(CatTable::L2, 1));
+}
+
+TEST(CatTableTest, Registers)
+{
+    CatTable table(4, 8, 8);
+    EXPECT_EQ(4 | CatTable::NumLevels << 8,
+              table.readReg(CatTable::RegInfo));
+
+    // Class 1 of the LLC
+    const Addr llc_mask = CatTable::MaskBase + 4 * (4 + 1);
+    table.writeReg(llc_mask, 0xc);
+    EXPECT_EQ(0xc, table.mask(CatTable::Llc, 1));
+    EXPECT_EQ(0xc, table.readReg(llc_mask));
+    table.writeReg(llc_mask, 0);
+    EXPECT_EQ(0xc, table.readReg(llc_mask));
+
+    table.writeReg(CatTable::ContextBase + 4 * 2, 3);
+    EXPECT_EQ(3, table.readReg(CatTable::ContextBase + 4 * 2));
+    EXPECT_EQ(3, table.classOf(-1, 2, 0));
+    table.writeReg(CatTable::ContextBase + 4 * 2, 4);
+    EXPECT_EQ(~uint32_t(0), table.readReg(CatTable::ContextBase + 4 * 2));
+
+    table.writeReg(CatTable::AdqBase + 4 * 7, 2);
+    EXPECT_EQ(2, table.classOf(7, -1, 0));
+    EXPECT_EQ(~uint32_t(0), table.readReg(CatTable::AdqBase + 4 * 8));
+}
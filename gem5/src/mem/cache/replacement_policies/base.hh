@@ -33,6 +33,7 @@
 
 #include "base/compiler.hh"
 #include "mem/cache/replacement_policies/replaceable_entry.hh"
+#include "mem/cache/replacement_policies/way_mask.hh"
 #include "mem/packet.hh"
 #include "params/BaseReplacementPolicy.hh"
 #include "sim/sim_object.hh"
@@ -112,13 +113,22 @@ class Base : public SimObject
     virtual ReplaceableEntry* getVictim(
                            const ReplacementCandidates& candidates) const = 0;
 
-    // SHIN
-    virtual ReplaceableEntry* getVictimWayPart(
-                               const ReplacementCandidates& candidates,
-                               int32_t way_part = -1) const {
-            // this should be implemented in lru or others that want to implement
-            // cache partiotioning
-            return nullptr;
+    /**
+     * Find replacement victim among the candidates in the ways of a mask,
+     * as way partitioning uses. A policy that only scans its candidates
+     * does this by running its own getVictim() over the candidates in the
+     * mask, all of them if none is. A policy that picks candidates by
+     * their position must override this.
+     *
+     * @param candidates Replacement candidates, selected by indexing policy.
+     * @param way_mask The ways the victim may be in.
+     * @return Replacement entry to be replaced.
+     */
+    virtual ReplaceableEntry*
+    getVictimWayPart(const ReplacementCandidates& candidates,
+                     uint64_t way_mask) const
+    {
+        return getVictim(candidatesInMask(candidates, way_mask));
     }
 
     /**
@@ -108,6 +108,21 @@ Dueling::reset(const std::shared_ptr<ReplacementData>& replacement_data) const
 
 ReplaceableEntry*
 Dueling::getVictim(const ReplacementCandidates& candidates) const
+{
+    return duel(candidates, false, 0);
+}
+
+ReplaceableEntry*
+Dueling::getVictimWayPart(const ReplacementCandidates& candidates,
+                          uint64_t way_mask) const
+{
+    // The whole set goes to the team, which applies the mask itself
+    return duel(candidates, true, way_mask);
+}
+
+ReplaceableEntry*
+Dueling::duel(const ReplacementCandidates& candidates, bool masked,
+              uint64_t way_mask) const
 {
     // This function assumes that all candidates are either part of the same
     // sampled set, or are not samples.
@@ -162,8 +177,10 @@ Dueling::getVictim(const ReplacementCandidates& candidates) const
     }
 
     // Use the selected replacement policy to find the victim
-    ReplaceableEntry* victim = team_a ? replPolicyA->getVictim(candidates) :
-        replPolicyB->getVictim(candidates);
+    const Base* policy = team_a ? replPolicyA : replPolicyB;
+    ReplaceableEntry* victim = masked ?
+        policy->getVictimWayPart(candidates, way_mask) :
+        policy->getVictim(candidates);
 
     // Search for entry within the original candidates and clean-up duplicates
     for (int i = 0; i < candidates.size(); i++) {
@@ -110,7 +110,21 @@ class Dueling : public Base
                                                                      override;
     ReplaceableEntry* getVictim(const ReplacementCandidates& candidates) const
                                                                      override;
+    ReplaceableEntry* getVictimWayPart(const ReplacementCandidates& candidates,
+                                       uint64_t way_mask) const override;
     std::shared_ptr<ReplacementData> instantiateEntry() override;
+
+  private:
+    /**
+     * Find the victim with the policy of the team that currently wins.
+     *
+     * @param candidates Replacement candidates, selected by indexing policy.
+     * @param masked Whether the victim must be in the ways of way_mask.
+     * @param way_mask The ways the victim may be in.
+     * @return Replacement entry to be replaced.
+     */
+    ReplaceableEntry* duel(const ReplacementCandidates& candidates,
+                           bool masked, uint64_t way_mask) const;
 };
 
 } // namespace replacement_policy
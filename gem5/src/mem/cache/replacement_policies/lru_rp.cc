@@ -114,59 +114,26 @@ LRU::getVictim(const ReplacementCandidates& candidates) const
 }
 
 
-// SHIN
 ReplaceableEntry*
 LRU::getVictimWayPart(const ReplacementCandidates& candidates,
-                        int32_t way_part) const
+                      uint64_t way_mask) const
 {
     // There must be at least one replacement candidate
     assert(candidates.size() > 0);
 
-     uint32_t mask = 0x01;
-    bool is_in_part = false;
-    bool is_io_invalidated = false;
-    if(is_io_invalidated){}
-    int way = 0;
-    // Visit all candidates to find victim
-    ReplaceableEntry* victim = candidates[0];
-    //sanity check
-    assert(victim->getWay() == 0);
     for (const auto& candidate : candidates) {
-        assert(candidate->getWay() == way);
-        if (std::static_pointer_cast<LRUReplData>(
-                        candidate->replacementData)->ioInvalidated) {
-            victim = candidate;
-            is_io_invalidated = true;
-            std::static_pointer_cast<LRUReplData>(
-                        candidate->replacementData)->ioInvalidated = false;
-            break;
-        }
-
-         if (mask & way_part) {
-            if (is_in_part == false) {
-                victim = candidate;
-                is_in_part = true;
-            }
-
-             // Update victim entry if necessary
-            if (std::static_pointer_cast<LRUReplData>(
-                        candidate->replacementData)->lastTouchTick <
-                    std::static_pointer_cast<LRUReplData>(
-                        victim->replacementData)->lastTouchTick) {
-                victim = candidate;
-            }
+        std::shared_ptr<LRUReplData> data =
+            std::static_pointer_cast<LRUReplData>(candidate->replacementData);
+        // Taking a way outside the mask would break the partition
+        if (data->ioInvalidated && inWayMask(candidate, way_mask)) {
+            data->ioInvalidated = false;
+            return candidate;
         }
-        way ++;
-        mask = mask << 1;
-        assert(way < 32);
     }
-    //DPRINTF(DDIO, "%s: victim way %d is_in_part %d is_io_invalidated %d\n", __func__, victim->getWay(), is_in_part, is_io_invalidated);
-    //printf("getVictimWayPart: victim way %d is_in_part %d\n", victim->getWay(), is_in_part);
 
-     return victim;
+    return Base::getVictimWayPart(candidates, way_mask);
 }
 
-
 std::shared_ptr<ReplacementData>
 LRU::instantiateEntry()
 {
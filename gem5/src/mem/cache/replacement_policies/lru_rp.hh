@@ -112,9 +112,17 @@ class LRU : public Base
      */
     ReplaceableEntry* getVictim(const ReplacementCandidates& candidates) const
                                                                      override;
-    // SHIN
+
+    /**
+     * Find replacement victim in the ways of a mask, taking a block the
+     * IO invalidated in the mask first.
+     *
+     * @param candidates Replacement candidates, selected by indexing policy.
+     * @param way_mask The ways the victim may be in.
+     * @return Replacement entry to be replaced.
+     */
     ReplaceableEntry* getVictimWayPart(const ReplacementCandidates& candidates,
-                                    int32_t way_part = -1) const override;
+                                       uint64_t way_mask) const override;
 
 
     /**
@@ -196,6 +196,18 @@ TreePLRU::getVictim(const ReplacementCandidates& candidates) const
     return candidates[tree_index - (numLeaves - 1)];
 }
 
+ReplaceableEntry*
+TreePLRU::getVictimWayPart(const ReplacementCandidates& candidates,
+                           uint64_t way_mask) const
+{
+    // There must be at least one replacement candidate
+    assert(candidates.size() > 0);
+
+    const PLRUTree* tree = std::static_pointer_cast<TreePLRUReplData>(
+            candidates[0]->replacementData)->tree.get();
+    return plruVictimInMask(*tree, candidates, way_mask);
+}
+
 std::shared_ptr<ReplacementData>
 TreePLRU::instantiateEntry()
 {
@@ -197,6 +197,18 @@ class TreePLRU : public Base
     ReplaceableEntry* getVictim(const ReplacementCandidates& candidates) const
                                                                      override;
 
+    /**
+     * Find replacement victim using the tree, skipping the subtrees
+     * without a way in the mask. The leaves are picked by position, so
+     * running getVictim() over a subset of the candidates would not work.
+     *
+     * @param candidates Replacement candidates, selected by indexing policy.
+     * @param way_mask The ways the victim may be in.
+     * @return Replacement entry to be replaced.
+     */
+    ReplaceableEntry* getVictimWayPart(const ReplacementCandidates& candidates,
+                                       uint64_t way_mask) const override;
+
     /**
      * Instantiate a replacement data entry. Consecutive calls to this
      * function use the same tree up to numLeaves. When numLeaves replacement
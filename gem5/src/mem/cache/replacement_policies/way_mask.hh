@@ -0,0 +1,84 @@
+#ifndef __MEM_CACHE_REPLACEMENT_POLICIES_WAY_MASK_HH__
+#define __MEM_CACHE_REPLACEMENT_POLICIES_WAY_MASK_HH__
+
+#include <cstdint>
+#include <vector>
+
+#include "mem/cache/replacement_policies/replaceable_entry.hh"
+
+namespace gem5
+{
+
+namespace replacement_policy
+{
+
+/** Is the way of an entry in a way partitioning mask? */
+inline bool
+inWayMask(const ReplaceableEntry *entry, uint64_t way_mask)
+{
+    const uint32_t way = entry->getWay();
+    return way < 64 && (way_mask >> way) & 1;
+}
+
+/**
+ * The candidates in the ways of a mask, all of them if none is, so that
+ * a policy that scans its candidates can pick a victim among them.
+ */
+inline std::vector<ReplaceableEntry*>
+candidatesInMask(const std::vector<ReplaceableEntry*> &candidates,
+                 uint64_t way_mask)
+{
+    std::vector<ReplaceableEntry*> in_mask;
+    in_mask.reserve(candidates.size());
+    for (const auto &candidate : candidates) {
+        if (inWayMask(candidate, way_mask))
+            in_mask.push_back(candidate);
+    }
+    return in_mask.empty() ? candidates : in_mask;
+}
+
+/**
+ * Walk a tree PLRU to a victim in the ways of a mask. The tree holds the
+ * nodes that are not leaves in BFS order and leaf n is candidate n, see
+ * TreePLRU. A node whose preferred subtree has no way in the mask leads
+ * to the other one, so the victim is the one the tree would pick if it
+ * only had the ways of the mask. Any way goes if none is in the mask.
+ */
+inline ReplaceableEntry*
+plruVictimInMask(const std::vector<bool> &tree,
+                 const std::vector<ReplaceableEntry*> &candidates,
+                 uint64_t way_mask)
+{
+    const uint64_t internal = tree.size();
+
+    auto any_in_mask = [&](uint64_t node) {
+        uint64_t first = node, last = node;
+        while (first < internal) {
+            first = 2 * first + 1;
+            last = 2 * last + 2;
+        }
+        for (uint64_t leaf = first; leaf <= last; leaf++) {
+            if (inWayMask(candidates[leaf - internal], way_mask))
+                return true;
+        }
+        return false;
+    };
+
+    if (!any_in_mask(0))
+        way_mask = ~uint64_t(0);
+
+    uint64_t node = 0;
+    while (node < internal) {
+        const uint64_t left = 2 * node + 1;
+        const uint64_t right = 2 * node + 2;
+        const uint64_t preferred = tree[node] ? right : left;
+        node = any_in_mask(preferred) ? preferred :
+            (tree[node] ? left : right);
+    }
+    return candidates[node - internal];
+}
+
+} // namespace replacement_policy
+} // namespace gem5
+
+#endif // __MEM_CACHE_REPLACEMENT_POLICIES_WAY_MASK_HH__
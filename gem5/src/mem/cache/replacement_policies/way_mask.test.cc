@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "mem/cache/replacement_policies/way_mask.hh"
+
+using namespace gem5;
+using namespace gem5::replacement_policy;
+
+namespace
+{
+
+class Way : public ReplaceableEntry
+{
+  public:
+    explicit Way(uint32_t way) { setPosition(0, way); }
+};
+
+class WayMaskTest : public testing::Test
+{
+  protected:
+    std::vector<Way> ways;
+    std::vector<ReplaceableEntry*> candidates;
+
+    void
+    setWays(unsigned num_ways)
+    {
+        ways.clear();
+        candidates.clear();
+        for (unsigned w = 0; w < num_ways; w++)
+            ways.emplace_back(w);
+        for (auto &way : ways)
+            candidates.push_back(&way);
+    }
+
+    /** The victim of TreePLRU::getVictim() */
+    ReplaceableEntry*
+    plainVictim(const std::vector<bool> &tree) const
+    {
+        uint64_t node = 0;
+        while (node < tree.size())
+            node = tree[node] ? 2 * node + 2 : 2 * node + 1;
+        return candidates[node - tree.size()];
+    }
+};
+
+} // anonymous namespace
+
+TEST_F(WayMaskTest, InWayMask)
+{
+    setWays(8);
+    EXPECT_TRUE(inWayMask(candidates[0], 0x1));
+    EXPECT_FALSE(inWayMask(candidates[1], 0x1));
+    EXPECT_TRUE(inWayMask(candidates[7], 0x80));
+}
+
+TEST_F(WayMaskTest, CandidatesInMask)
+{
+    setWays(8);
+    auto in_mask = candidatesInMask(candidates, 0x0c);
+    ASSERT_EQ(2, in_mask.size());
+    EXPECT_EQ(candidates[2], in_mask[0]);
+    EXPECT_EQ(candidates[3], in_mask[1]);
+
+    // No way in the mask, any way goes
+    EXPECT_EQ(candidates.size(),
+              candidatesInMask(candidates, 0x100).size());
+}
+
+/** The walk leaves the preferred subtree when it has no way in the mask. */
+TEST_F(WayMaskTest, PlruAvoidsSubtree)
+{
+    setWays(4);
+    // Root and its left child prefer the left, which is way 0
+    std::vector<bool> tree = {false, false, false};
+    EXPECT_EQ(candidates[0], plruVictimInMask(tree, candidates, 0xf));
+    EXPECT_EQ(candidates[1], plruVictimInMask(tree, candidates, 0xe));
+    // The left half is out, the right subtree prefers its left way
+    EXPECT_EQ(candidates[2], plruVictimInMask(tree, candidates, 0xc));
+    EXPECT_EQ(candidates[3], plruVictimInMask(tree, candidates, 0x8));
+}
+
+TEST_F(WayMaskTest, PlruFullMaskMatchesPlainWalk)
+{
+    std::mt19937 rng(1);
+    for (unsigned num_ways : {2, 4, 16, 64}) {
+        setWays(num_ways);
+        std::vector<bool> tree(num_ways - 1);
+        for (int i = 0; i < 50; i++) {
+            for (unsigned n = 0; n < tree.size(); n++)
+                tree[n] = rng() & 1;
+            EXPECT_EQ(plainVictim(tree),
+                      plruVictimInMask(tree, candidates, ~uint64_t(0)));
+            // No way in the mask, the tree picks as usual
+            EXPECT_EQ(plainVictim(tree),
+                      plruVictimInMask(tree, candidates, 0));
+        }
+    }
+}
+
+TEST_F(WayMaskTest, PlruVictimAlwaysInMask)
+{
+    std::mt19937_64 rng(2);
+    for (unsigned num_ways : {2, 8, 16, 32}) {
+        setWays(num_ways);
+        const uint64_t all = (uint64_t(1) << num_ways) - 1;
+        std::vector<bool> tree(num_ways - 1);
+        for (int i = 0; i < 200; i++) {
+            for (unsigned n = 0; n < tree.size(); n++)
+                tree[n] = rng() & 1;
+            const uint64_t mask = rng() & all;
+            if (!mask)
+                continue;
+            const ReplaceableEntry *victim =
+                plruVictimInMask(tree, candidates, mask);
+            EXPECT_TRUE(inWayMask(victim, mask))
+                << "way " << victim->getWay() << " mask " << mask;
+        }
+    }
+}
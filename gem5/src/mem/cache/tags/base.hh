@@ -289,11 +289,21 @@ class BaseTags : public ClockedObject
                                  std::vector<CacheBlk*>& evict_blks) = 0;
 
 
-    // SHIN
+    /**
+     * Find replacement victim based on address among the ways of a mask,
+     * for way partitioning. The list of evicted blocks only contains the
+     * victim.
+     *
+     * @param addr Address to find a victim for.
+     * @param is_secure True if the target memory space is secure.
+     * @param evict_blks Cache blocks to be evicted.
+     * @param way_mask The ways the victim may be in.
+     * @return Cache block to be replaced.
+     */
     virtual CacheBlk* findVictimWayPart(Addr addr, const bool is_secure,
                                  std::vector<CacheBlk*>& evict_blks,
-                                 int32_t way_part = -1) const {
-        panic("you should only use way partitioning with LRU tags");
+                                 uint64_t way_mask) const {
+        panic("Way partitioning needs set associative tags");
     }
 
     /**
@@ -186,31 +186,33 @@ class BaseSetAssoc : public BaseTags
         return victim;
     }
 
-    // SHIN
+    /**
+     * Find replacement victim based on address among the ways of a mask.
+     * The entries of a set are its ways, so the replacement policy only
+     * has to look at the ones in the mask.
+     *
+     * @param addr Address to find a victim for.
+     * @param is_secure True if the target memory space is secure.
+     * @param evict_blks Cache blocks to be evicted.
+     * @param way_mask The ways the victim may be in.
+     * @return Cache block to be replaced.
+     */
     CacheBlk* findVictimWayPart(Addr addr, const bool is_secure,
                          std::vector<CacheBlk*>& evict_blks,
-                         int32_t way_part) const override
+                         uint64_t way_mask) const override
     {
         // Get possible entries to be victimized
-
-         // FOR DDIO, we need to add some fileds to replaceable entry that 
-        // indicates which ways are for ddio and which ways are not
-        // ** for set assoc indexing policy, "entries" are all the ways in
-        // one set
         const std::vector<ReplaceableEntry*> entries =
             indexingPolicy->getPossibleEntries(addr);
 
-         // Choose replacement victim from replacement candidates
-
-         // FOR DDIO - then in getVictim, if we are in ddio mode and this entry is 
-        // going to hold ddio data, then we only choose between the taged entries. 
-        CacheBlk* victim = static_cast<CacheBlk*>(replacementPolicy->getVictimWayPart(
-                                entries, way_part));
+        // Choose replacement victim from replacement candidates
+        CacheBlk* victim = static_cast<CacheBlk*>(
+            replacementPolicy->getVictimWayPart(entries, way_mask));
 
-         // There is only one eviction for this replacement
+        // There is only one eviction for this replacement
         evict_blks.push_back(victim);
 
-         return victim;
+        return victim;
     }
 
     /**
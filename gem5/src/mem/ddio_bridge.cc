@@ -2,6 +2,10 @@
 
 #include "mem/ddio_bridge.hh"
 
+#include <algorithm>
+
+#include "base/cprintf.hh"
+
 #include "debug/AdaptiveDdioOtf.hh"
 #include "debug/AdaptiveDdioOtfInfo.hh"
 #include "debug/AdaptiveDdioBridgeHint.hh"
@@ -30,6 +34,8 @@ DdioBridge::getSlavePort(const std::string &if_name, PortID idx)
 {
     if (if_name == "cpuside"){
         return cpusidePort;
+    } else if (if_name == "pio") {
+        return pioPort;
     } else if (if_name == "otfport") {
         return *onTheFlySlavePort[idx];
     }
@@ -52,6 +58,8 @@ DdioBridge::getPort(const std::string &if_name, PortID idx)
         return memsidePort;
     } else if (if_name == "cpuside"){
         return cpusidePort;
+    } else if (if_name == "pio") {
+        return pioPort;
     } else if (if_name == "otfport") {
         return *onTheFlySlavePort[idx];
     }
@@ -62,7 +70,9 @@ DdioBridge::getPort(const std::string &if_name, PortID idx)
 
 
 DdioBridge::DdioBridgeSlavePort::DdioBridgeSlavePort(const std::string& _name, DdioBridge& _bridge)
-:SlavePort(_name, &_bridge), bridge(_bridge)
+:SlavePort(_name, &_bridge), bridge(_bridge), outstandingResponses(0),
+ retryReq(false), stallStart(0), blocked(false), blockedSince(0),
+ sendEvent([this]{ trySendTiming(); }, _name)
 {
     
 }
@@ -72,7 +82,115 @@ bool
 DdioBridge::DdioBridgeSlavePort::recvTimingReq(PacketPtr pkt){
     if(pkt->cmd == MemCmd::WritebackDirty)
         DPRINTF(AdaptiveDdioBridge, "recvTimingReq, pkt %s\n", pkt->print());
-    return bridge.getDestinationMasterPort(pkt).sendTimingReq(pkt);
+
+    // Once a request was refused, wait for the retry before taking more
+    if (retryReq)
+        return false;
+
+    const auto stall = [this, pkt]() {
+        DPRINTF(AdaptiveDdioBridge, "Queues full, stalling %s\n",
+                pkt->print());
+        bridge.stats.stalledReqs++;
+        retryReq = true;
+        stallStart = curTick();
+        return false;
+    };
+
+    const auto steered = bridge.steer(pkt);
+    DdioBridgeMasterPort &dest = bridge.getDestinationMasterPort(pkt);
+
+    // The cache above gave up the line of a writeback once the bridge
+    // took it, and timing snoops do not look into the queues. So a
+    // writeback only goes through when the destination takes it right
+    // away, it waits in the cache above otherwise where snoops find it.
+    if (pkt->isWriteback()) {
+        if (!dest.trySendNow(pkt))
+            return stall();
+        bridge.accountSteering(pkt, steered);
+        return true;
+    }
+
+    if (dest.reqQueueFull() || (pkt->needsResponse() && respQueueFull()))
+        return stall();
+
+    bridge.accountSteering(pkt, steered);
+
+    // Keep room for the response so it never has to be refused
+    if (pkt->needsResponse())
+        ++outstandingResponses;
+
+    dest.schedTimingReq(pkt, curTick() + bridge.delay);
+    return true;
+}
+
+void
+DdioBridge::DdioBridgeSlavePort::retryStalledReq()
+{
+    if (retryReq) {
+        DPRINTF(AdaptiveDdioBridge, "Retrying the stalled request\n");
+        bridge.stats.stallCycles +=
+            bridge.ticksToCycles(curTick() - stallStart);
+        retryReq = false;
+        sendRetryReq();
+    }
+}
+
+void
+DdioBridge::DdioBridgeSlavePort::schedTimingResp(PacketPtr pkt, Tick when)
+{
+    bridge.stats.respPackets++;
+    bridge.stats.respQueueOccupancy.sample(transmitList.size());
+
+    if (transmitList.empty())
+        bridge.schedule(sendEvent, when);
+    transmitList.emplace_back(pkt, when);
+}
+
+void
+DdioBridge::DdioBridgeSlavePort::trySendTiming()
+{
+    assert(!transmitList.empty());
+    DeferredPacket resp = transmitList.front();
+    assert(resp.tick <= curTick());
+
+    if (!sendTimingResp(resp.pkt)) {
+        DPRINTF(AdaptiveDdioBridge, "Device side refused %s\n",
+                resp.pkt->print());
+        if (!blocked) {
+            blocked = true;
+            blockedSince = curTick();
+        }
+        return;
+    }
+
+    if (blocked) {
+        bridge.stats.respBlockedCycles +=
+            bridge.ticksToCycles(curTick() - blockedSince);
+        blocked = false;
+    }
+
+    transmitList.pop_front();
+    --outstandingResponses;
+
+    if (!transmitList.empty()) {
+        bridge.schedule(sendEvent,
+                        std::max(transmitList.front().tick,
+                                 bridge.clockEdge()));
+    }
+
+    // A response slot is free, the stalled request may fit now
+    retryStalledReq();
+    bridge.checkDrained();
+}
+
+bool
+DdioBridge::DdioBridgeSlavePort::trySatisfyFunctional(PacketPtr pkt)
+{
+    for (auto &resp : transmitList) {
+        if (pkt->trySatisfyFunctional(resp.pkt))
+            return true;
+    }
+    return false;
 }
 
 
@@ -80,13 +198,21 @@ DdioBridge::DdioBridgeSlavePort::recvTimingReq(PacketPtr pkt){
 Tick
 DdioBridge::DdioBridgeSlavePort::recvAtomic(PacketPtr pkt){
     //DPRINTF(AdaptiveDdioBridge, "recvAtomic, pkt %s\n", pkt->print());
+    bridge.accountSteering(pkt, bridge.steer(pkt));
     return bridge.getDestinationMasterPort(pkt).sendAtomic(pkt);
 }
 
 void
 DdioBridge::DdioBridgeSlavePort::recvFunctional(PacketPtr pkt){
     //DPRINTF(AdaptiveDdioBridge, "recvFunctional, pkt %s\n", pkt->print());
-    return bridge.getDestinationMasterPort(pkt).sendFunctional(pkt);
+    pkt->pushLabel(name());
+    if (bridge.trySatisfyQueued(pkt, true)) {
+        pkt->popLabel();
+        pkt->makeResponse();
+        return;
+    }
+    pkt->popLabel();
+    bridge.getDestinationMasterPort(pkt).sendFunctional(pkt);
     //bridge.llcsidePort.sendFunctional(pkt);
 }
 
@@ -106,27 +232,111 @@ DdioBridge::DdioBridgeSlavePort::recvTimingSnoopResp(PacketPtr pkt){
 void 
 DdioBridge::DdioBridgeSlavePort::recvRespRetry(){
     DPRINTF(AdaptiveDdioBridge, "recvRespRetry!\n");
-    panic("DdioBridge::DdioBridgeSlavePort::recvRespRetry()");
-    //bridge.getDestinationMasterPort(nullptr).sendRetryResp();
+    if (blocked)
+        trySendTiming();
 }
 
+DdioBridge::DdioBridgeMasterPort::DdioBridgeMasterPort(const std::string& _name, DdioBridge& _bridge,
+                                                       unsigned dest_idx)
+:MasterPort(_name, &_bridge), bridge(_bridge), destIdx(dest_idx),
+ blocked(false), blockedSince(0),
+ sendEvent([this]{ trySendTiming(); }, _name)
+{
 
-void
-DdioBridge::DdioBridgeSlavePort::sendRetryReq(){
-    DPRINTF(AdaptiveDdioBridge, "sendRetryReq!\n");
-    panic("DdioBridge::DdioBridgeSlavePort::sendRetryReq()");
 }
 
 void
-DdioBridge::DdioBridgeSlavePort::sendRetrySnoopResp(){
-    DPRINTF(AdaptiveDdioBridge, "sendRetrySnoopResp!\n");
-    panic("DdioBridge::DdioBridgeSlavePort::sendRetrySnoopResp()");
+DdioBridge::DdioBridgeMasterPort::schedTimingReq(PacketPtr pkt, Tick when)
+{
+    bridge.stats.reqPackets[destIdx]++;
+    bridge.stats.reqQueueOccupancy[destIdx].sample(transmitList.size());
+
+    // Nothing ahead of it and no delay to model, so go straight through
+    // as an unbuffered bridge would
+    if (transmitList.empty() && when <= curTick()) {
+        if (sendTimingReq(pkt))
+            return;
+        DPRINTF(AdaptiveDdioBridge, "Destination refused %s\n",
+                pkt->print());
+        blocked = true;
+        blockedSince = curTick();
+        bridge.stats.destBlocked[destIdx]++;
+        bridge.stats.reqQueued[destIdx]++;
+        transmitList.emplace_back(pkt, when);
+        return;
+    }
+
+    bridge.stats.reqQueued[destIdx]++;
+    if (transmitList.empty())
+        bridge.schedule(sendEvent, when);
+    transmitList.emplace_back(pkt, when);
+}
+
+bool
+DdioBridge::DdioBridgeMasterPort::trySendNow(PacketPtr pkt)
+{
+    if (!transmitList.empty())
+        return false;
+
+    if (sendTimingReq(pkt)) {
+        bridge.stats.reqPackets[destIdx]++;
+        return true;
+    }
+
+    // Nothing is queued, the retry only wakes up the stalled request
+    DPRINTF(AdaptiveDdioBridge, "Destination refused %s\n", pkt->print());
+    if (!blocked) {
+        blocked = true;
+        blockedSince = curTick();
+        bridge.stats.destBlocked[destIdx]++;
+    }
+    return false;
 }
 
-DdioBridge::DdioBridgeMasterPort::DdioBridgeMasterPort(const std::string& _name, DdioBridge& _bridge)
-:MasterPort(_name, &_bridge), bridge(_bridge)
+void
+DdioBridge::DdioBridgeMasterPort::trySendTiming()
 {
+    assert(!transmitList.empty());
+    DeferredPacket req = transmitList.front();
+    assert(req.tick <= curTick());
+
+    if (!sendTimingReq(req.pkt)) {
+        DPRINTF(AdaptiveDdioBridge, "Destination refused %s\n",
+                req.pkt->print());
+        if (!blocked) {
+            blocked = true;
+            blockedSince = curTick();
+            bridge.stats.destBlocked[destIdx]++;
+        }
+        return;
+    }
+
+    if (blocked) {
+        bridge.stats.destBlockedCycles[destIdx] +=
+            bridge.ticksToCycles(curTick() - blockedSince);
+        blocked = false;
+    }
+
+    transmitList.pop_front();
+    if (!transmitList.empty()) {
+        bridge.schedule(sendEvent,
+                        std::max(transmitList.front().tick,
+                                 bridge.clockEdge()));
+    }
+
+    // There is room in this queue now
+    bridge.cpusidePort.retryStalledReq();
+    bridge.checkDrained();
+}
 
+bool
+DdioBridge::DdioBridgeMasterPort::trySatisfyFunctional(PacketPtr pkt)
+{
+    for (auto &req : transmitList) {
+        if (pkt->trySatisfyFunctional(req.pkt))
+            return true;
+    }
+    return false;
 }
 
 
@@ -143,20 +353,18 @@ DdioBridge::DdioBridgeMasterPort::recvAtomicSnoop(PacketPtr pkt){
 
 void
 DdioBridge::DdioBridgeMasterPort::recvFunctionalSnoop(PacketPtr pkt){
-    if(1){
-        //DPRINTF(AdaptiveDdioBridge, "recvFunctionalSnoop, pkt %s\n", pkt->print());
-        bridge.getDestinationSlavePort(pkt).sendFunctionalSnoop(pkt);
+    //DPRINTF(AdaptiveDdioBridge, "recvFunctionalSnoop, pkt %s\n", pkt->print());
+    // Writebacks still in the queues hold the latest copy of their line
+    if (bridge.trySatisfyQueued(pkt, false))
         return;
-    }
+    bridge.getDestinationSlavePort(pkt).sendFunctionalSnoop(pkt);
 }
 
 bool
 DdioBridge::DdioBridgeMasterPort::recvTimingResp(PacketPtr pkt){
-    if(isSnooping()){
-        //DPRINTF(AdaptiveDdioBridge, "recvTimingResp, pkt %s\n", pkt->print());
-        return bridge.getDestinationSlavePort(pkt).sendTimingResp(pkt);
-    }
-    panic("recvTimingResp! port typ %s, pkt %s\n", getPortType()==PORT_TYPE_FOR_MLC?"MLC":"MEM", pkt->print());
+    //DPRINTF(AdaptiveDdioBridge, "recvTimingResp, pkt %s\n", pkt->print());
+    // Space was reserved when the request went through
+    bridge.cpusidePort.schedTimingResp(pkt, curTick() + bridge.delay);
     return true;
 }
 
@@ -177,9 +385,18 @@ DdioBridge::DdioBridgeMasterPort::recvTimingSnoopReq(PacketPtr pkt){
 void
 DdioBridge::DdioBridgeMasterPort::recvReqRetry(){
     DPRINTF(AdaptiveDdioBridge, "recvReqRetry\n");
-    if(bridge.send_prefetch_hint && port_type == PORT_TYPE_FOR_MLC) return;
-    bridge.getDestinationSlavePort(nullptr).sendRetryReq();
-    return;
+    if (!blocked)
+        return;
+    if (!transmitList.empty()) {
+        trySendTiming();
+        return;
+    }
+
+    // A writeback was refused, the device side sends it again
+    bridge.stats.destBlockedCycles[destIdx] +=
+        bridge.ticksToCycles(curTick() - blockedSince);
+    blocked = false;
+    bridge.cpusidePort.retryStalledReq();
 }
 
 void
@@ -202,26 +419,46 @@ DdioBridge::DdioBridge(const DdioBridgeParams &p)
      do_not_pass_to_mlc(p.do_not_pass_to_mlc),
      snoop_via_memside(p.snoop_via_memside),
      normal_DMA_mode(p.normal_DMA_mode),
+     steering(p.steering_entries, p.steering_epoch),
+     pioAddr(p.pio_addr), pioDelay(p.pio_latency), pioPort(this),
+     policy(p.policy),
+     delay(p.delay), reqQueueLimit(p.req_queue_size),
+     respQueueLimit(p.resp_queue_size),
      cpusidePort(p.name + ".cpuside", *this), 
-     llcsidePort(p.name + ".llcside", *this), 
-     memsidePort(p.name + ".memside", *this)
+     llcsidePort(p.name + ".llcside", *this,
+                 p.port_mlcside_connection_count),
+     memsidePort(p.name + ".memside", *this,
+                 p.port_mlcside_connection_count + 1),
+     stats(*this)
 {
+    fatal_if(reqQueueLimit == 0 || respQueueLimit == 0,
+             "%s: the request and response queues need at least one "
+             "entry", name());
+
     for (int i = 0; i < p.port_mlcside_connection_count; ++i) {
-        DdioBridgeMasterPort* memp = new DdioBridgeMasterPort(p.name + ".mlcside", *this);
+        DdioBridgeMasterPort* memp = new DdioBridgeMasterPort(p.name + ".mlcside", *this, i);
         mlcsidePorts.push_back(memp);
-        OnTheFlySlavePort* otfp = new OnTheFlySlavePort(p.name + ".otfport", *this, p);
+        OnTheFlySlavePort* otfp = new OnTheFlySlavePort(p.name + ".otfport", *this);
+        otfp->Init(CACHE_TYPE_MLC, i);
         onTheFlySlavePort.push_back(otfp);
     }
-    OnTheFlySlavePort* otfp = new OnTheFlySlavePort(p.name + ".otfport", *this, p);
+    OnTheFlySlavePort* otfp = new OnTheFlySlavePort(p.name + ".otfport", *this);
+    otfp->Init(CACHE_TYPE_LLC, -1);
     onTheFlySlavePort.push_back(otfp);
     
     llcsidePort.setPortType(PORT_TYPE_FOR_LLC);
     memsidePort.setPortType(PORT_TYPE_FOR_MEM);
 
-    ddio_option[0] = p.ddio_option_app0;
-    ddio_option[1] = p.ddio_option_app1;
-    ddio_option[2] = p.ddio_option_app2;
-    ddio_option[3] = p.ddio_option_app3;
+    fatal_if(p.steering_dest.size() > steering.size(),
+             "%s: %d steering entries given, the table has %d", name(),
+             p.steering_dest.size(), steering.size());
+    for (int i = 0; i < p.steering_dest.size(); ++i) {
+        steering.set(i, p.steering_dest[i],
+                     i < p.steering_mlc.size() ? p.steering_mlc[i] : -1,
+                     i < p.steering_share_limit.size() ?
+                         p.steering_share_limit[i] : 0,
+                     0);
+    }
 
     dynamic = p.dynamic_ddio;
     mlc_share = p.mlc_share;
@@ -252,7 +489,7 @@ DdioBridge::~DdioBridge(){
  * 
  * SHIN.
  */
-MasterPort& 
+DdioBridge::DdioBridgeMasterPort& 
 DdioBridge::getDestinationMasterPort(PacketPtr pkt){
     
     int mlc_idx = pkt->getDdioPrefetchDestination();
@@ -263,6 +500,10 @@ DdioBridge::getDestinationMasterPort(PacketPtr pkt){
     // if(mlc_idx != -1)
     //     DPRINTF(AdaptiveDdioBridge, "On MLC %d, pkt %s\n", mlc_idx, pkt->print());
 
+    // Placed in memory by the device, keep it out of the caches
+    if (mlc_idx == Packet::DdioMemoryDestination)
+        return memsidePort;
+
     if(do_not_pass_to_mlc){
         DPRINTF(AdaptiveDdioBridge, "LLC ddio mode. mlc %d, pkt %s\n", mlc_idx, pkt->print());
         return llcsidePort;
@@ -396,16 +637,277 @@ DdioBridge::getDestinationSlavePort(PacketPtr pkt){
     return cpusidePort;
 }
 
-OnTheFlySlavePort::OnTheFlySlavePort(const std::string& _name, DdioBridge& _bridge, const DdioBridgeParams &p)
+DdioSteeringTable::Decision
+DdioBridge::steer(PacketPtr pkt)
+{
+    if (!pkt->isDdioPkt() || !pkt->isWrite())
+        return {DdioSteeringTable::Target::Device, -1};
+
+    const int adq = pkt->getDdioPrefetchId();
+    auto d = steering.steer(adq, curTick());
+    if (policy) {
+        // The policy picks among the levels the table allows, all of
+        // them for a queue without an entry, but not an MLC once the
+        // share of the queue is used up
+        unsigned allowed = steering.allowed(adq);
+        int mlc = d.mlc;
+        if (!allowed) {
+            allowed = DdioSteeringTable::AllowMask;
+            mlc = adq;
+        } else if (d.target != DdioSteeringTable::Target::Mlc) {
+            allowed &= ~DdioSteeringTable::AllowMlc;
+        }
+        if (mlc < 0)
+            allowed &= ~DdioSteeringTable::AllowMlc;
+
+        if (allowed) {
+            switch (policy->choose(adq, allowed)) {
+              case ddio_policy::Mlc:
+                d = {DdioSteeringTable::Target::Mlc, mlc};
+                break;
+              case ddio_policy::Llc:
+                d = {DdioSteeringTable::Target::Llc, -1};
+                break;
+              default:
+                d = {DdioSteeringTable::Target::Dram, -1};
+                break;
+            }
+        }
+    }
+
+    if (d.target == DdioSteeringTable::Target::Mlc &&
+        d.mlc >= int(mlcsidePorts.size())) {
+        warn_once("%s: steering entry %d targets MLC %d, which is not "
+                  "connected, using the LLC\n", name(),
+                  adq, d.mlc);
+        d.target = DdioSteeringTable::Target::Llc;
+    }
+
+    switch (d.target) {
+      case DdioSteeringTable::Target::Mlc:
+        pkt->setDdioPrefetchDestination(d.mlc);
+        pkt->setPrefetchHintPkt();
+        break;
+      case DdioSteeringTable::Target::Llc:
+        pkt->setDdioPrefetchDestination(-1);
+        pkt->unsetPrefetchHintPkt();
+        break;
+      case DdioSteeringTable::Target::Dram:
+        pkt->setDdioPrefetchDestination(Packet::DdioMemoryDestination);
+        pkt->unsetPrefetchHintPkt();
+        break;
+      default:
+        break;
+    }
+    return d;
+}
+
+void
+DdioBridge::accountSteering(PacketPtr pkt,
+                            const DdioSteeringTable::Decision &d)
+{
+    if (d.target == DdioSteeringTable::Target::Device)
+        return;
+    const int level = int(d.target) - int(DdioSteeringTable::Target::Mlc);
+    steering.account(pkt->getDdioPrefetchId(), d);
+    if (policy)
+        policy->placed(pkt->getDdioPrefetchId(), ddio_policy::Level(level));
+    stats.steered[level]++;
+}
+
+void
+DdioBridge::recvOtfInfo(const OnTheFlyInfo &info)
+{
+    OnTheFlySlavePort *port = findOtfPort(info.cache_id, info.cache_type);
+    if (port)
+        port->recvOtfInfo(info);
+
+    if (!policy)
+        return;
+    policy->feedback({info.cache_type == CACHE_TYPE_LLC, info.cache_id,
+                      info.otf_rate, info.untouched_evict_rate, &info});
+}
+
+Tick
+DdioBridge::read(PacketPtr pkt)
+{
+    const Addr daddr = pkt->getAddr() - pioAddr;
+    if (pkt->getSize() != 4) {
+        warn_once("%s: %d byte steering register read, registers are "
+                  "32 bits\n", name(), pkt->getSize());
+        pkt->setBadAddress();
+        return pioDelay;
+    }
+
+    pkt->setLE<uint32_t>(steering.readReg(daddr, curTick()));
+    DPRINTF(AdaptiveDdioBridge, "Steering register %#x read: %#x\n",
+            daddr, pkt->getLE<uint32_t>());
+    pkt->makeAtomicResponse();
+    return pioDelay;
+}
+
+Tick
+DdioBridge::write(PacketPtr pkt)
+{
+    const Addr daddr = pkt->getAddr() - pioAddr;
+    if (pkt->getSize() != 4) {
+        warn_once("%s: %d byte steering register write, registers are "
+                  "32 bits\n", name(), pkt->getSize());
+        pkt->setBadAddress();
+        return pioDelay;
+    }
+
+    DPRINTF(AdaptiveDdioBridge, "Steering register %#x written: %#x\n",
+            daddr, pkt->getLE<uint32_t>());
+    steering.writeReg(daddr, pkt->getLE<uint32_t>(), curTick());
+    pkt->makeAtomicResponse();
+    return pioDelay;
+}
+
+AddrRangeList
+DdioBridge::getAddrRanges() const
+{
+    return { RangeSize(pioAddr, steering.regSize()) };
+}
+
+void
+DdioBridge::init()
+{
+    ClockedObject::init();
+
+    // The steering registers are only reachable when the pio port is
+    // connected to an I/O bus
+    if (pioPort.isConnected())
+        pioPort.sendRangeChange();
+}
+
+void
+DdioBridge::serialize(CheckpointOut &cp) const
+{
+    for (unsigned i = 0; i < steering.size(); ++i) {
+        ScopedCheckpointSection sec(cp, csprintf("steering%d", i));
+        const auto &e = steering.entry(i);
+        paramOut(cp, "allow", e.allow);
+        paramOut(cp, "mlc", e.mlc);
+        paramOut(cp, "shareLimit", e.shareLimit);
+        paramOut(cp, "used", e.used);
+        paramOut(cp, "epochStart", e.epochStart);
+    }
+}
+
+void
+DdioBridge::unserialize(CheckpointIn &cp)
+{
+    // Checkpoints from before the steering table, or with a smaller one,
+    // leave the missing entries unprogrammed
+    for (unsigned i = 0; i < steering.size(); ++i) {
+        ScopedCheckpointSection sec(cp, csprintf("steering%d", i));
+        auto &e = steering.entry(i);
+        if (!optParamIn(cp, "allow", e.allow, false))
+            continue;
+        paramIn(cp, "mlc", e.mlc);
+        paramIn(cp, "shareLimit", e.shareLimit);
+        paramIn(cp, "used", e.used);
+        paramIn(cp, "epochStart", e.epochStart);
+    }
+}
+
+bool
+DdioBridge::queuesEmpty() const
+{
+    if (!cpusidePort.empty() || !llcsidePort.empty() || !memsidePort.empty())
+        return false;
+    for (auto m: mlcsidePorts) {
+        if (!m->empty())
+            return false;
+    }
+    return true;
+}
+
+bool
+DdioBridge::trySatisfyQueued(PacketPtr pkt, bool responses)
+{
+    if (responses && cpusidePort.trySatisfyFunctional(pkt))
+        return true;
+    if (llcsidePort.trySatisfyFunctional(pkt) ||
+        memsidePort.trySatisfyFunctional(pkt))
+        return true;
+    for (auto m: mlcsidePorts) {
+        if (m->trySatisfyFunctional(pkt))
+            return true;
+    }
+    return false;
+}
+
+void
+DdioBridge::checkDrained()
+{
+    if (drainState() == DrainState::Draining && queuesEmpty())
+        signalDrainDone();
+}
+
+DrainState
+DdioBridge::drain()
+{
+    return queuesEmpty() ? DrainState::Drained : DrainState::Draining;
+}
+
+DdioBridge::DdioBridgeStats::DdioBridgeStats(DdioBridge &bridge)
+    : statistics::Group(&bridge),
+      ADD_STAT(reqPackets, statistics::units::Count::get(),
+               "Number of requests sent to each destination"),
+      ADD_STAT(reqQueued, statistics::units::Count::get(),
+               "Number of requests that had to wait in a queue"),
+      ADD_STAT(reqQueueOccupancy, statistics::units::Count::get(),
+               "Requests ahead in the queue when one arrives"),
+      ADD_STAT(destBlocked, statistics::units::Count::get(),
+               "Number of times a destination refused a request"),
+      ADD_STAT(destBlockedCycles, statistics::units::Cycle::get(),
+               "Cycles a destination kept the head of its queue waiting"),
+      ADD_STAT(respPackets, statistics::units::Count::get(),
+               "Number of responses sent to the device side"),
+      ADD_STAT(respQueueOccupancy, statistics::units::Count::get(),
+               "Responses ahead in the queue when one arrives"),
+      ADD_STAT(respBlockedCycles, statistics::units::Cycle::get(),
+               "Cycles the device side kept a response waiting"),
+      ADD_STAT(stalledReqs, statistics::units::Count::get(),
+               "Number of requests refused because a queue was full"),
+      ADD_STAT(stallCycles, statistics::units::Cycle::get(),
+               "Cycles the device side waited for a retry"),
+      ADD_STAT(steered, statistics::units::Count::get(),
+               "Device writes placed by the steering table")
+{
+    const DdioBridgeParams &p = bridge.params();
+    const unsigned dests = p.port_mlcside_connection_count + 2;
+
+    reqPackets.init(dests);
+    reqQueued.init(dests);
+    reqQueueOccupancy.init(dests, 0, p.req_queue_size, 1);
+    destBlocked.init(dests);
+    destBlockedCycles.init(dests);
+    respQueueOccupancy.init(0, p.resp_queue_size, 1);
+
+    auto name_dest = [this](unsigned idx, const std::string &dest) {
+        reqPackets.subname(idx, dest);
+        reqQueued.subname(idx, dest);
+        reqQueueOccupancy.subname(idx, dest);
+        destBlocked.subname(idx, dest);
+        destBlockedCycles.subname(idx, dest);
+    };
+    for (int i = 0; i < p.port_mlcside_connection_count; ++i)
+        name_dest(i, csprintf("mlc%d", i));
+    name_dest(dests - 2, "llc");
+    name_dest(dests - 1, "mem");
+
+    steered.init(3);
+    steered.subname(0, "mlc");
+    steered.subname(1, "llc");
+    steered.subname(2, "mem");
+}
+
+OnTheFlySlavePort::OnTheFlySlavePort(const std::string& _name, DdioBridge& _bridge)
 :SlavePort(_name, &_bridge), bridge(_bridge), otfinfo()
 {
-    prev_grad =1;
-    threshhold_otf = p.threshhold_otf;
-    threshhold_gradchange = p.threshhold_gradchange;
-    window_size = p.window_size;
-    grad_counter = 0;
-    local_max_otf = -1;
-    threshhold_abs = p.threshhold_abs;
 }
 
 bool 
@@ -456,83 +958,24 @@ OnTheFlySlavePort::sendRetrySnoopResp()
 
 }
 
-double
-OnTheFlySlavePort::calcAndUpdateGradient(OnTheFlyInfo* newinfo)
-{
-    double grad = (newinfo->otf_rate - prev_otf_rate) / window_size;
-    prev_otf_rate = newinfo->otf_rate;
-    if(grad == 0){
-        if(grad < 0) prev_grad = -0.000001;
-        else prev_grad = 0.000001;
-    }
-    prev_grad = grad;
-
-    return grad;
-}
-
-double
-OnTheFlySlavePort::calcGradChange(OnTheFlyInfo* newinfo)
-{
-    double prev_grad_ = prev_grad;
-    calcAndUpdateGradient(newinfo);
-    double cur_grad = prev_grad;
-
-    //double relative_increase_ = (cur_grad - prev_grad_) / prev_grad_;
-    double relative_increase_ = (cur_grad) / prev_grad_;
-    return relative_increase_;
-}
-
 void 
-OnTheFlySlavePort::recvOtfInfo(OnTheFlyInfo* info)
+OnTheFlySlavePort::recvOtfInfo(const OnTheFlyInfo &info)
 {
-    //DPRINTF(AdaptiveDdioOtf, "recvOnTheFlyInfo\n");
-    int qid = info->cache_id;
-
-    grad_counter++;
-    if(local_max_otf < info->otf_rate) local_max_otf = info->otf_rate;
-    if(info->otf_rate < local_max_otf * 0.7) local_max_otf = info->otf_rate;
-    if(grad_counter >= window_size)
-    {
-        grad_counter = 0;
-        relative_increase = (calcGradChange(info));
-        DPRINTF(AdaptiveDdioOtf, "recvOnTheFlyInfo; relative_increase %f\n", relative_increase);
-        
-        if(relative_increase < threshhold_gradchange && !lock_incrrate){
-            //local_max_otf = info->otf_rate;
-            lock_incrrate = true;
-        }
-        // else{
-        //     local_max_otf = 1;
-        //     //lock_incrrate = false;
-        // }
-    }
-    if(boost_cnt == 1000)
-    {
-        boost_cnt = 0;
-        local_max_otf *= 2;
-    }
-    boost_cnt++;
+    // Copies into the vector the port already holds once it has seen a
+    // report, so the steady state does not allocate
+    otfinfo = info;
 
-    otfinfo.otf_rate = info->otf_rate;
-    otfinfo.untouched_evict_rate = info->untouched_evict_rate;
-
-    // DPRINTF(AdaptiveDdioOtfInfo, "AdaptiveDdioOtfInfo; Cache %s, OtfRate %f, untouched-evict %f, time %lld\n", 
-    //     info->cache_type == CACHE_TYPE_MLC ? "MLC" + std::to_string(qid) : "LLC",
-    //     otfinfo.otf_rate, otfinfo.untouched_evict_rate, curTick() / SimClock::Int::ns);
-
-    DPRINTF(AdaptiveDdioOtfInfo, "AdaptiveDdioOtfInfo; Cache %s, OtfRate %f, untouched-evict %f, relative_increase %f, local_max %f, time %lld\n", 
-        info->cache_type == CACHE_TYPE_MLC ? "MLC" + std::to_string(qid) : "LLC",
-        otfinfo.otf_rate, otfinfo.untouched_evict_rate, relative_increase, local_max_otf, curTick() / SimClock::Int::ns);
-
-    delete info;
+    DPRINTF(AdaptiveDdioOtfInfo, "AdaptiveDdioOtfInfo; Cache %s, OtfRate %f, untouched-evict %f, blks %llu, time %lld\n",
+        cache_type == CACHE_TYPE_MLC ? "MLC" + std::to_string(cache_id) : "LLC",
+        otfinfo.otf_rate, otfinfo.untouched_evict_rate,
+        otfinfo.num_ddio_blks, curTick() / SimClock::Int::ns);
 }
 
 void 
-OnTheFlySlavePort::Init(OnTheFlyInfo* info)
+OnTheFlySlavePort::Init(int type, int id)
 {
-    cache_id = info->cache_id;
-    cache_type = info->cache_type;
-    delete info;
+    cache_type = type;
+    cache_id = id;
 }
 
 OnTheFlySlavePort* 
@@ -550,73 +993,17 @@ DdioBridge::findOtfPort(int mlcid, int type)
     return nullptr;
 }
 
-bool
-OnTheFlySlavePort::canSendToCache()
-{
-    // 1. under otf th
-    if(boost_cnt < 500) return true;
-    float th = local_max_otf * threshhold_otf;
-    DPRINTF(AdaptiveDdioOtfInfo, "canSendToCache th %f\n", th);
-    if (prev_otf_rate < th)
-    {
-        //local_max_otf = prev_otf_rate;
-        lock_incrrate = false;
-        return true;
-    }
-
-    DPRINTF(AdaptiveDdioOtfInfo, "canSendToCache relative_increase %f\n", relative_increase);
-    if(relative_increase > threshhold_gradchange)
-    {
-        //local_max_otf = prev_otf_rate;
-        lock_incrrate = false;
-        return true;
-    }
-
-    DPRINTF(AdaptiveDdioOtfInfo, "canSendToCache otfrate is %f\n", prev_otf_rate);
-    if(prev_otf_rate < threshhold_abs)
-    {
-        //local_max_otf = prev_otf_rate;
-        lock_incrrate = false;
-        return true;
-    }
-
-    // 2. 
-    return false;
-}
-
 bool 
 DdioBridge::canSendToObj(int adq, int dest)
 {
     if(adq > -1)
     {
-        DPRINTF(AdaptiveDdioOtfInfo, "canSendToObj; adq %d, dest %d, ddio_option %d\n", adq, dest, ddio_option[adq]);
-        return ddio_option[adq] & dest;
+        DPRINTF(AdaptiveDdioOtfInfo, "canSendToObj; adq %d, dest %d, steering %d\n", adq, dest, steering.allowed(adq));
+        return steering.allowed(adq) & dest;
     }
-    if(dest == allow_dram_only) return true;
+    if(dest == DdioSteeringTable::AllowDram) return true;
     return false;
 }
 
 
-void
-OnTheFlySlavePort::updateSendStatus()
-{
-    // 1. OnTheFly > 10% --> TO_LLC
-    if(prev_otf_rate > 0.1){
-        send_status = TO_LLC;
-    }
-
-    // 2. dataUsage < 10% --> TO_DRAM
-    else if(dataUsage < 0.1){
-        send_status = TO_DRAM;
-    }
-    
-    // 3. data
-    else if(dataUsage > 0.9){
-        send_status = TO_MLC;
-    }
-
-    else{
-        send_status = TO_LLC;
-    }
-}
 }
\ No newline at end of file
@@ -5,7 +5,12 @@
 #include <deque>
 #include <unordered_map>
 
+#include "base/statistics.hh"
 #include "base/types.hh"
+#include "dev/io_device.hh"
+#include "mem/ddio_policies/base.hh"
+#include "mem/ddio_steering.hh"
+#include "mem/ddio_telemetry.hh"
 #include "mem/qport.hh"
 #include "mem/port.hh"
 #include "params/DdioBridge.hh"
@@ -18,29 +23,8 @@
 #define PORT_TYPE_FOR_LLC 1
 #define PORT_TYPE_FOR_MEM 2
 
-#define CACHE_TYPE_MLC 0
-#define CACHE_TYPE_LLC 1
-#define CACHE_TYPE_OTHER -1
-
-#define TO_MLC    1
-#define TO_LLC    2
-#define TO_DRAM   3
-
 namespace gem5 {
 
-typedef struct 
-{
-  int cache_type = CACHE_TYPE_OTHER;
-  int cache_id = -1;
-  float untouched_evict_rate = -1;
-  float otf_rate = -1;
-
-  uint64_t num_ddio_blks;
-  uint64_t num_ref_ddio_header;
-  uint64_t num_ref_ddio_body;
-  
-} OnTheFlyInfo;
-
 //class DdioBridgeParams;
 class DdioBridge;
 class OnTheFlySlavePort;
@@ -58,16 +42,39 @@ class DdioBridge : public ClockedObject
     bool snoop_via_memside;
     bool normal_DMA_mode;
 
-    const int allow_mlc = 1;
-    const int allow_llc = 2;
-    const int allow_dram_only = 4;
-    int ddio_option[8];
+    /** Where the writes of each device queue go, programmed by the
+     * guest through the pio port. */
+    DdioSteeringTable steering;
+    const Addr pioAddr;
+    const Tick pioDelay;
+    PioPort<DdioBridge> pioPort;
+
+    /** Picks among the levels the steering table allows, nullptr to
+     * follow the table alone. */
+    ddio_policy::Base *policy;
+
     bool dynamic;
     bool mlc_share;
 
     bool send_prefetch_hint;
     bool send_header_only;
 
+    // Queueing between the device side and the destinations
+    const Tick delay;
+    const unsigned reqQueueLimit;
+    const unsigned respQueueLimit;
+
+    /** A packet waiting in one of the queues until its time. */
+    class DeferredPacket
+    {
+      public:
+        const Tick tick;
+        const PacketPtr pkt;
+
+        DeferredPacket(PacketPtr _pkt, Tick _tick) : tick(_tick), pkt(_pkt)
+        { }
+    };
+
   protected:
     //class DdioBridgeMasterPort;
     class DdioBridgeSlavePort : public SlavePort
@@ -77,10 +84,42 @@ class DdioBridge : public ClockedObject
         DdioBridge& bridge;
         const AddrRangeList ranges;
 
+        /** Responses on their way back to the device side, and the
+         * number of requests that will have one, space is reserved for
+         * them when the request is accepted.
+         */
+        std::deque<DeferredPacket> transmitList;
+        unsigned outstandingResponses;
+
+        /** We refused a request and owe the device side a retry. */
+        bool retryReq;
+        Tick stallStart;
+
+        /** The device side refused the head of transmitList */
+        bool blocked;
+        Tick blockedSince;
+
+        EventFunctionWrapper sendEvent;
+
+        void trySendTiming();
+
       public:
         DdioBridgeSlavePort(const std::string& _name, DdioBridge& _bridge);
 
-        
+        bool respQueueFull() const
+        {
+            return outstandingResponses == bridge.respQueueLimit;
+        }
+
+        /** Queue a response to the device side for the given time. */
+        void schedTimingResp(PacketPtr pkt, Tick when);
+
+        /** Retry a refused request if there is room for it now. */
+        void retryStalledReq();
+
+        bool trySatisfyFunctional(PacketPtr pkt);
+
+        bool empty() const { return transmitList.empty(); }
 
       protected:
         virtual bool recvTimingReq(PacketPtr pkt);
@@ -91,9 +130,6 @@ class DdioBridge : public ClockedObject
         virtual bool recvTimingSnoopResp(PacketPtr pkt);
         virtual void recvRespRetry();
 
-        void sendRetryReq();
-        void sendRetrySnoopResp();
-
         bool isSnooping() const { return true; }
 
         /**
@@ -130,12 +166,45 @@ class DdioBridge : public ClockedObject
         DdioBridge& bridge;       
         int port_type = PORT_TYPE_FOR_MLC;
 
-        //ReqPacketQueue reqQueue;
+        /** Index of this destination in the stats */
+        unsigned destIdx;
+
+        /** Requests waiting to go to this destination */
+        std::deque<DeferredPacket> transmitList;
+
+        /** The destination refused the head of transmitList */
+        bool blocked;
+        Tick blockedSince;
+
+        EventFunctionWrapper sendEvent;
+
+        void trySendTiming();
 
       public:
-        DdioBridgeMasterPort(const std::string& _name, DdioBridge& _bridge);
+        DdioBridgeMasterPort(const std::string& _name, DdioBridge& _bridge,
+                             unsigned dest_idx);
         void setPortType(int type){port_type = type;}
         int getPortType(){return port_type;}
+
+        bool reqQueueFull() const
+        {
+            return transmitList.size() == bridge.reqQueueLimit;
+        }
+
+        /** Send a request now if nothing is ahead of it and the
+         * destination takes it, queue it for the given time otherwise.
+         */
+        void schedTimingReq(PacketPtr pkt, Tick when);
+
+        /** Send a request now if nothing is ahead of it and the
+         * destination takes it, never queue it.
+         * @return true if the destination took it
+         */
+        bool trySendNow(PacketPtr pkt);
+
+        bool trySatisfyFunctional(PacketPtr pkt);
+
+        bool empty() const { return transmitList.empty(); }
         
       protected:
         Tick recvAtomicSnoop(PacketPtr pkt);
@@ -171,7 +240,14 @@ class DdioBridge : public ClockedObject
 
     DdioBridge(const Params &p);
 
-    MasterPort& getDestinationMasterPort(PacketPtr pkt);
+    DdioBridgeMasterPort& getDestinationMasterPort(PacketPtr pkt);
+
+    /** Look up the steering entry of a device write and point the
+     * packet at the level it picks. */
+    DdioSteeringTable::Decision steer(PacketPtr pkt);
+    /** Charge a write that was accepted to its steering entry. */
+    void accountSteering(PacketPtr pkt,
+                         const DdioSteeringTable::Decision &d);
     SlavePort& getDestinationSlavePort(PacketPtr pkt);
 
     // For test options
@@ -181,6 +257,55 @@ class DdioBridge : public ClockedObject
     bool canSendToObj(int adp, int dest);
 
     void sendPrefetchHint(PacketPtr pkt, int mlcid);
+
+    /** Keep what a cache reported and pass it to the policy. */
+    void recvOtfInfo(const OnTheFlyInfo &info);
+
+    /** Steering register accesses. */
+    Tick read(PacketPtr pkt);
+    Tick write(PacketPtr pkt);
+    AddrRangeList getAddrRanges() const;
+
+    void init() override;
+    DrainState drain() override;
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+  private:
+    /** Are all the request and response queues empty? */
+    bool queuesEmpty() const;
+
+    /** Signal the end of a drain once every queue is empty. */
+    void checkDrained();
+
+    /** Let a functional access see the queued packets.
+     * @param responses look at the responses to the device side too
+     * @return true if the access was satisfied
+     */
+    bool trySatisfyQueued(PacketPtr pkt, bool responses);
+
+    struct DdioBridgeStats : public statistics::Group
+    {
+        DdioBridgeStats(DdioBridge &bridge);
+
+        /** Per destination: the MLCs, the LLC and memory */
+        statistics::Vector reqPackets;
+        statistics::Vector reqQueued;
+        statistics::VectorDistribution reqQueueOccupancy;
+        statistics::Vector destBlocked;
+        statistics::Vector destBlockedCycles;
+
+        statistics::Scalar respPackets;
+        statistics::Distribution respQueueOccupancy;
+        statistics::Scalar respBlockedCycles;
+
+        statistics::Scalar stalledReqs;
+        statistics::Scalar stallCycles;
+
+        /** Device writes the steering table sent to each level */
+        statistics::Vector steered;
+    } stats;
 };
 
 class OnTheFlySlavePort : public SlavePort
@@ -193,36 +318,11 @@ class OnTheFlySlavePort : public SlavePort
     // SHIN Adaptive-DDIO w ADQ
     OnTheFlyInfo otfinfo;
 
-      // For find grad
-    int window_size;
-    int grad_counter;
-    // For relative grad
-    float prev_grad = 0;
-    float prev_otf_rate = 1;
-
-    float local_max_otf = -1; // Send To MLC For init
-    float threshhold_gradchange;
-    float threshhold_otf;
-    float threshhold_abs;
-
-    float relative_increase = 10;
-
-    int cache_type;
-    int cache_id;
-    bool lock_incrrate = false;
-    int boost_cnt = 0;
-
-    int send_status = TO_MLC;
-    float dataUsage;
+    int cache_type = CACHE_TYPE_OTHER;
+    int cache_id = -1;
 
   public:
-    OnTheFlySlavePort(const std::string& _name,  DdioBridge& _bridge, const DdioBridgeParams &p);
-    double calcAndUpdateGradient(OnTheFlyInfo* newinfo);
-    double calcGradChange(OnTheFlyInfo* newinfo);
-
-    // IDIO
-    void updateSendStatus();
-
+    OnTheFlySlavePort(const std::string& _name,  DdioBridge& _bridge);
 
   protected:
     virtual bool recvTimingReq(PacketPtr pkt);
@@ -237,13 +337,11 @@ class OnTheFlySlavePort : public SlavePort
     bool isSnooping() const { return true; }
 
   public:
-    void Init(OnTheFlyInfo* info);
-    void recvOtfInfo(OnTheFlyInfo* info);
+    void Init(int type, int id);
+    void recvOtfInfo(const OnTheFlyInfo &info);
     int getCacheId(){return cache_id;}
     int getCacheType(){return cache_type;}
 
-    bool canSendToCache();
-
 
     // SHIN Adaptive-DDIO ADQ
     OnTheFlyInfo* getOnTheFlyInfo(){return &otfinfo;}
@@ -0,0 +1,66 @@
+from m5.params import *
+from m5.proxy import *
+from m5.SimObject import SimObject
+
+class BaseDdioPolicy(SimObject):
+    type = 'BaseDdioPolicy'
+    abstract = True
+    cxx_class = 'gem5::ddio_policy::Base'
+    cxx_header = "mem/ddio_policies/base.hh"
+
+    num_adqs = Param.Unsigned(8, "ADQ indices with state of their own, "
+                              "the others share the last")
+
+class StaticDdioPolicy(BaseDdioPolicy):
+    type = 'StaticDdioPolicy'
+    cxx_class = 'gem5::ddio_policy::Static'
+    cxx_header = "mem/ddio_policies/static.hh"
+
+    level = Param.DdioTarget('LLC', "Level of the queues not listed")
+    adq_levels = VectorParam.DdioTarget([], "Level of each ADQ")
+
+class GradientDdioPolicy(BaseDdioPolicy):
+    type = 'GradientDdioPolicy'
+    cxx_class = 'gem5::ddio_policy::Gradient'
+    cxx_header = "mem/ddio_policies/gradient.hh"
+
+    window_size = Param.UInt32(200, "Reports per gradient window")
+    threshhold_otf = Param.Float(0.75, "Fraction of the maximum "
+                                 "on-the-fly rate a cache stays usable at")
+    threshhold_gradchange = Param.Float(0.25, "Gradient growth over a "
+                                        "window that keeps a cache usable")
+    threshhold_abs = Param.Float(0.03, "On-the-fly rate a cache is always "
+                                 "usable under")
+    max_decay = Param.Float(0.7, "The maximum on-the-fly rate drops to "
+                            "the current one under this fraction of it")
+    boost_period = Param.Unsigned(1000, "Reports between doublings of the "
+                                  "maximum on-the-fly rate")
+    boost_hold = Param.Unsigned(500, "Reports after a doubling during "
+                                "which a cache is always usable")
+    llc_otf_cutoff = Param.Float(0.1, "LLC on-the-fly rate over which "
+                                 "writes stay in the LLC")
+    dram_usage_cutoff = Param.Float(0.1, "LLC data usage under which "
+                                    "writes go to DRAM")
+    mlc_usage_cutoff = Param.Float(0.9, "LLC data usage over which writes "
+                                   "go to the MLC after all")
+
+class PiDdioPolicy(BaseDdioPolicy):
+    type = 'PiDdioPolicy'
+    cxx_class = 'gem5::ddio_policy::Pi'
+    cxx_header = "mem/ddio_policies/pi.hh"
+
+    setpoint = Param.Float(0.05, "Target fraction of DDIO blocks evicted "
+                           "before they are read")
+    kp = Param.Float(1.0, "Proportional gain")
+    ki = Param.Float(0.1, "Integral gain")
+
+class BanditDdioPolicy(BaseDdioPolicy):
+    type = 'BanditDdioPolicy'
+    cxx_class = 'gem5::ddio_policy::Bandit'
+    cxx_header = "mem/ddio_policies/bandit.hh"
+
+    epsilon = Param.Float(0.05, "Probability of picking a random level")
+    alpha = Param.Float(0.2, "Weight of a new cost sample")
+    mlc_latency = Param.Latency('5ns', "Read latency of a line in the MLC")
+    llc_latency = Param.Latency('20ns', "Read latency of a line in the LLC")
+    dram_latency = Param.Latency('80ns', "Read latency of a line in DRAM")
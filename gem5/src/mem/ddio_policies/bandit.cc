@@ -0,0 +1,91 @@
+#include "mem/ddio_policies/bandit.hh"
+
+#include "base/logging.hh"
+#include "base/random.hh"
+#include "base/trace.hh"
+#include "debug/DdioPolicy.hh"
+#include "params/BanditDdioPolicy.hh"
+
+namespace gem5
+{
+
+namespace ddio_policy
+{
+
+Bandit::Bandit(const Params &p)
+    : Base(p), epsilon(p.epsilon), alpha(p.alpha),
+      latency{p.mlc_latency, p.llc_latency, p.dram_latency},
+      queues(numAdqs, BanditArms(p.dram_latency)), banditStats(*this)
+{
+    fatal_if(epsilon < 0 || epsilon > 1, "%s: epsilon must be in [0, 1]",
+             name());
+    fatal_if(alpha <= 0 || alpha > 1, "%s: alpha must be in (0, 1]",
+             name());
+}
+
+void
+Bandit::reconsider(BanditArms &q)
+{
+    Level next;
+    if (random_mt.random<double>() < epsilon) {
+        // choose() maps a level the queue may not use to the best one
+        next = Level(random_mt.random<unsigned>(0, NumLevels - 1));
+        banditStats.explorations++;
+    } else {
+        next = q.best(AllLevels);
+    }
+
+    const Level prev = q.current();
+    if (q.moveTo(next)) {
+        DPRINTF(DdioPolicy, "Queue moves from level %d to %d, cost %f\n",
+                prev, next, q.arm(next).cost);
+        banditStats.switches++;
+    }
+}
+
+Level
+Bandit::choose(int adq, unsigned allowed)
+{
+    const BanditArms &q = queues[adqSlot(adq)];
+    if (allowed & levelBit(q.current()))
+        return q.current();
+    return q.best(allowed);
+}
+
+void
+Bandit::feedback(const Feedback &fb)
+{
+    Base::feedback(fb);
+
+    if (fb.llc) {
+        for (unsigned i = 0; i < queues.size(); i++) {
+            // Use what the queue itself lost in the LLC when the report
+            // says, the LLC is shared
+            double rate = fb.untouchedEvictRate;
+            if (fb.info && i < fb.info->adqs.size() &&
+                fb.info->adqs[i].evicted) {
+                rate = fb.info->adqs[i].untouched_evict_rate;
+            }
+            queues[i].sample(Llc, rate, latency[Llc], latency[Dram], alpha);
+            reconsider(queues[i]);
+        }
+    } else if (fb.cacheId >= 0 && fb.cacheId < int(numAdqs)) {
+        // The MLC of a queue is the one with its index
+        BanditArms &q = queues[fb.cacheId];
+        q.sample(Mlc, fb.untouchedEvictRate, latency[Mlc], latency[Dram],
+                 alpha);
+        reconsider(q);
+    }
+}
+
+Bandit::BanditStats::BanditStats(Bandit &policy)
+    : statistics::Group(&policy),
+      ADD_STAT(explorations, statistics::units::Count::get(),
+               "Arms picked at random"),
+      ADD_STAT(switches, statistics::units::Count::get(),
+               "Times a queue moved to another level")
+{
+}
+
+} // namespace ddio_policy
+} // namespace gem5
@@ -0,0 +1,61 @@
+#ifndef __MEM_DDIO_POLICIES_BANDIT_HH__
+#define __MEM_DDIO_POLICIES_BANDIT_HH__
+
+#include <array>
+#include <vector>
+
+#include "mem/ddio_policies/base.hh"
+
+namespace gem5
+{
+
+struct BanditDdioPolicyParams;
+
+namespace ddio_policy
+{
+
+/**
+ * An epsilon-greedy bandit per queue whose arms are the levels. The cost
+ * of an arm is the expected latency of reading back a line written
+ * there, weighted by the untouched eviction rate the cache of the level
+ * reports: the rate of the queue itself where the report has it, the
+ * rate of the whole cache otherwise, which is what the queue would see
+ * if it wrote there. Every report on a level a queue can use updates the
+ * arm and moves the queue to the cheapest arm, or a random one with
+ * probability epsilon, so a queue that went to DRAM comes back once the
+ * caches drain. A queue plays its arm when the steering table allows it
+ * and the cheapest allowed one otherwise.
+ */
+class Bandit : public Base
+{
+  protected:
+    const double epsilon;
+    /** Weight of a new cost sample */
+    const double alpha;
+    std::array<Tick, NumLevels> latency;
+
+    std::vector<BanditArms> queues;
+
+    /** Move a queue to the arm its costs say, or explore. */
+    void reconsider(BanditArms &q);
+
+    struct BanditStats : public statistics::Group
+    {
+        BanditStats(Bandit &policy);
+
+        statistics::Scalar explorations;
+        statistics::Scalar switches;
+    } banditStats;
+
+  public:
+    typedef BanditDdioPolicyParams Params;
+    Bandit(const Params &p);
+
+    Level choose(int adq, unsigned allowed) override;
+    void feedback(const Feedback &fb) override;
+};
+
+} // namespace ddio_policy
+} // namespace gem5
+
+#endif // __MEM_DDIO_POLICIES_BANDIT_HH__
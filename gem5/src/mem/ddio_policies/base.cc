@@ -0,0 +1,77 @@
+#include "mem/ddio_policies/base.hh"
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/DdioPolicy.hh"
+
+namespace gem5
+{
+
+namespace ddio_policy
+{
+
+Base::Base(const Params &p)
+    : SimObject(p), numAdqs(p.num_adqs), stats(*this)
+{
+    fatal_if(numAdqs == 0, "%s: the policy needs at least one ADQ",
+             name());
+}
+
+Level
+Base::firstAllowed(unsigned allowed)
+{
+    for (int level = Mlc; level < NumLevels; level++) {
+        if (allowed & levelBit(Level(level)))
+            return Level(level);
+    }
+    panic("No DDIO level allowed");
+}
+
+unsigned
+Base::adqSlot(int adq) const
+{
+    // Untagged writes and the queues past the last share the last slot
+    if (adq < 0 || adq >= int(numAdqs))
+        return numAdqs - 1;
+    return adq;
+}
+
+void
+Base::placed(int adq, Level level)
+{
+    stats.decisions[level]++;
+    stats.adqDecisions[adqSlot(adq)][level]++;
+}
+
+void
+Base::feedback(const Feedback &fb)
+{
+    DPRINTF(DdioPolicy, "%s %d reports otf %f, untouched evictions %f\n",
+            fb.llc ? "LLC" : "MLC", fb.cacheId, fb.otfRate,
+            fb.untouchedEvictRate);
+    stats.feedbacks++;
+}
+
+Base::DdioPolicyStats::DdioPolicyStats(Base &policy)
+    : statistics::Group(&policy),
+      ADD_STAT(decisions, statistics::units::Count::get(),
+               "Device writes placed in each level"),
+      ADD_STAT(adqDecisions, statistics::units::Count::get(),
+               "Device writes of each ADQ placed in each level"),
+      ADD_STAT(feedbacks, statistics::units::Count::get(),
+               "Reports received from the caches")
+{
+    decisions.init(NumLevels);
+    adqDecisions.init(policy.numAdqs, NumLevels);
+
+    const char *names[NumLevels] = {"mlc", "llc", "dram"};
+    for (int level = Mlc; level < NumLevels; level++) {
+        decisions.subname(level, names[level]);
+        adqDecisions.ysubname(level, names[level]);
+    }
+    for (unsigned i = 0; i < policy.numAdqs; i++)
+        adqDecisions.subname(i, csprintf("adq%d", i));
+}
+
+} // namespace ddio_policy
+} // namespace gem5
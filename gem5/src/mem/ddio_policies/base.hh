@@ -0,0 +1,82 @@
+#ifndef __MEM_DDIO_POLICIES_BASE_HH__
+#define __MEM_DDIO_POLICIES_BASE_HH__
+
+#include "base/statistics.hh"
+#include "mem/ddio_policies/control.hh"
+#include "mem/ddio_telemetry.hh"
+#include "params/BaseDdioPolicy.hh"
+#include "sim/sim_object.hh"
+
+namespace gem5
+{
+
+namespace ddio_policy
+{
+
+/** What a cache reports about the DDIO data it holds. */
+struct Feedback
+{
+    /** The report is from the LLC, from MLC cacheId otherwise */
+    bool llc;
+    int cacheId;
+    /** Fraction of the DDIO blocks written but not read yet */
+    double otfRate;
+    /** Fraction of the DDIO blocks evicted before they were read */
+    double untouchedEvictRate;
+    /** The whole report with the per ADQ counts, if there is one */
+    const OnTheFlyInfo *info = nullptr;
+};
+
+/**
+ * A common base class of the adaptive DDIO policies. The DDIO bridge
+ * asks the policy where each device write goes, among the levels the
+ * steering table allows for its queue, and passes it what the caches
+ * report about the DDIO data they hold.
+ */
+class Base : public SimObject
+{
+  public:
+    typedef BaseDdioPolicyParams Params;
+    Base(const Params &p);
+    virtual ~Base() = default;
+
+    /**
+     * Pick the level a write of a queue goes to. This is asked again
+     * when a write is refused and retried, so it should not change any
+     * state, placed() tells the policy what happened.
+     *
+     * @param adq the ADQ index of the write
+     * @param allowed mask of the levels allowed, never empty
+     */
+    virtual Level choose(int adq, unsigned allowed) = 0;
+
+    /** A write was placed in a level. */
+    virtual void placed(int adq, Level level);
+
+    /** A cache reported on its DDIO data. */
+    virtual void feedback(const Feedback &fb);
+
+  protected:
+    /** Number of ADQ indices the policy keeps state for */
+    const unsigned numAdqs;
+
+    /** The first level of a mask, from the MLC down. */
+    static Level firstAllowed(unsigned allowed);
+
+    /** Clamp an ADQ index to the ones with state of their own. */
+    unsigned adqSlot(int adq) const;
+
+    struct DdioPolicyStats : public statistics::Group
+    {
+        DdioPolicyStats(Base &policy);
+
+        statistics::Vector decisions;
+        statistics::Vector2d adqDecisions;
+        statistics::Scalar feedbacks;
+    } stats;
+};
+
+} // namespace ddio_policy
+} // namespace gem5
+
+#endif // __MEM_DDIO_POLICIES_BASE_HH__
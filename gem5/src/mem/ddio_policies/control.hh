@@ -0,0 +1,249 @@
+#ifndef __MEM_DDIO_POLICIES_CONTROL_HH__
+#define __MEM_DDIO_POLICIES_CONTROL_HH__
+
+#include <algorithm>
+#include <array>
+
+#include "base/types.hh"
+
+namespace gem5
+{
+
+namespace ddio_policy
+{
+
+/** The levels a device write can be placed in. */
+enum Level
+{
+    Mlc,
+    Llc,
+    Dram,
+    NumLevels
+};
+
+/** Mask bit of a level, as the DDIO steering table uses them. */
+constexpr unsigned
+levelBit(Level level)
+{
+    return 1 << level;
+}
+
+constexpr unsigned AllLevels = levelBit(Mlc) | levelBit(Llc) | levelBit(Dram);
+
+/**
+ * A proportional-integral loop whose output is a share in [0, 1]. The
+ * integral stops while the output is saturated, so the loop leaves the
+ * limit as soon as the error changes sign.
+ */
+struct PiLoop
+{
+    double integral = 0;
+    double share = 1;
+
+    /** A loop that starts at a share of 1. */
+    static PiLoop
+    saturated(double ki)
+    {
+        PiLoop loop;
+        loop.integral = 1 / ki;
+        return loop;
+    }
+
+    void
+    update(double error, double kp, double ki)
+    {
+        const double out = kp * error + ki * (integral + error);
+
+        // Stop integrating while the output is saturated, unless the
+        // error brings it back
+        if ((out < 1 || error < 0) && (out > 0 || error > 0))
+            integral += error;
+
+        share = std::clamp(kp * error + ki * integral, 0.0, 1.0);
+    }
+};
+
+/**
+ * Spread a share over the writes by error diffusion: a level is taken
+ * once its credit reaches 1.
+ */
+inline void
+spendCredit(double &credit, double share, bool taken)
+{
+    credit += share - (taken ? 1 : 0);
+    // Levels that are not allowed for a while must not build up a debt
+    credit = std::clamp(credit, -1.0, 1.0);
+}
+
+/**
+ * What the gradient heuristic keeps per cache: the highest on-the-fly
+ * rate reported lately and how fast the rate grows from one window of
+ * reports to the next.
+ */
+class OtfGradient
+{
+  public:
+    struct Config
+    {
+        /** Reports per gradient window */
+        unsigned windowSize;
+        /** Fraction of the maximum on-the-fly rate a cache stays usable
+         * at */
+        double thresholdOtf;
+        /** Growth of the gradient over a window that keeps a cache
+         * usable */
+        double thresholdGradChange;
+        /** On-the-fly rate a cache is always usable under */
+        double thresholdAbs;
+        /** The maximum drops to the current rate once it falls under
+         * this fraction of it */
+        double maxDecay;
+        /** Reports between doublings of the maximum */
+        unsigned boostPeriod;
+        /** Reports after a doubling during which a cache is always
+         * usable */
+        unsigned boostHold;
+        /** On-the-fly rate of the LLC over which writes stay in the LLC */
+        double llcOtfCutoff;
+        /** LLC data usage under which writes go to DRAM */
+        double dramUsageCutoff;
+        /** LLC data usage over which writes go to the MLC after all */
+        double mlcUsageCutoff;
+    };
+
+    unsigned gradCounter = 0;
+    double prevGrad = 1;
+    double prevOtfRate = 1;
+    double localMaxOtf = -1;
+    double relativeIncrease = 10;
+    unsigned boostCnt = 0;
+    double usage = 1;
+
+    void
+    update(const Config &cfg, double otf_rate, double untouched_evict_rate)
+    {
+        gradCounter++;
+        if (localMaxOtf < otf_rate)
+            localMaxOtf = otf_rate;
+        if (otf_rate < localMaxOtf * cfg.maxDecay)
+            localMaxOtf = otf_rate;
+
+        if (gradCounter >= cfg.windowSize) {
+            gradCounter = 0;
+            double grad = (otf_rate - prevOtfRate) / cfg.windowSize;
+            // Keep the next relative increase finite
+            if (grad == 0)
+                grad = prevGrad < 0 ? -1e-6 : 1e-6;
+            relativeIncrease = grad / prevGrad;
+            prevGrad = grad;
+            prevOtfRate = otf_rate;
+        }
+
+        if (boostCnt == cfg.boostPeriod) {
+            boostCnt = 0;
+            localMaxOtf *= 2;
+        }
+        boostCnt++;
+
+        usage = 1 - untouched_evict_rate;
+    }
+
+    /** Whether the data of the cache is used fast enough to add more. */
+    bool
+    canSendToCache(const Config &cfg) const
+    {
+        if (boostCnt < cfg.boostHold)
+            return true;
+        if (prevOtfRate < localMaxOtf * cfg.thresholdOtf)
+            return true;
+        if (relativeIncrease > cfg.thresholdGradChange)
+            return true;
+        return prevOtfRate < cfg.thresholdAbs;
+    }
+
+    /** Where the reports of an LLC say writes that miss the MLC go. */
+    Level
+    sendStatus(const Config &cfg) const
+    {
+        if (prevOtfRate > cfg.llcOtfCutoff)
+            return Llc;
+        if (usage < cfg.dramUsageCutoff)
+            return Dram;
+        if (usage > cfg.mlcUsageCutoff)
+            return Mlc;
+        return Llc;
+    }
+};
+
+/**
+ * The arms of the bandit of a queue. The cost of an arm is the expected
+ * latency of reading back a line written there: the hit latency of the
+ * level if the line is read before it is evicted, the DRAM latency
+ * otherwise.
+ */
+class BanditArms
+{
+  public:
+    struct Arm
+    {
+        double cost = 0;
+        unsigned samples = 0;
+    };
+
+  private:
+    std::array<Arm, NumLevels> arms;
+    Level _current = Mlc;
+
+  public:
+    /** Nothing in DRAM is evicted, its cost is known up front. */
+    explicit BanditArms(Tick dram_latency)
+    {
+        arms[Dram].cost = dram_latency;
+        arms[Dram].samples = 1;
+    }
+
+    const Arm &arm(Level level) const { return arms[level]; }
+    Level current() const { return _current; }
+
+    /** Fold the untouched eviction rate of a level into its cost. */
+    void
+    sample(Level level, double untouched_evict_rate, Tick hit_latency,
+           Tick dram_latency, double alpha)
+    {
+        Arm &a = arms[level];
+        const double cost = untouched_evict_rate * dram_latency +
+            (1 - untouched_evict_rate) * hit_latency;
+        a.cost = a.samples ? (1 - alpha) * a.cost + alpha * cost : cost;
+        a.samples++;
+    }
+
+    /** The cheapest allowed arm, one without samples first. */
+    Level
+    best(unsigned allowed) const
+    {
+        int pick = -1;
+        for (int level = Mlc; level < NumLevels; level++) {
+            if (!(allowed & levelBit(Level(level))))
+                continue;
+            if (!arms[level].samples)
+                return Level(level);
+            if (pick < 0 || arms[level].cost < arms[pick].cost)
+                pick = level;
+        }
+        return pick < 0 ? Dram : Level(pick);
+    }
+
+    /** Play another arm, returns whether it changed. */
+    bool
+    moveTo(Level level)
+    {
+        const bool moved = level != _current;
+        _current = level;
+        return moved;
+    }
+};
+
+} // namespace ddio_policy
+} // namespace gem5
+
+#endif // __MEM_DDIO_POLICIES_CONTROL_HH__
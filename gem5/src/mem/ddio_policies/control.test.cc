@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include "mem/ddio_policies/control.hh"
+
+using namespace gem5;
+using namespace gem5::ddio_policy;
+
+TEST(PiLoopTest, StartsSaturated)
+{
+    PiLoop loop = PiLoop::saturated(0.1);
+    EXPECT_DOUBLE_EQ(1.0, loop.share);
+    loop.update(0, 1.0, 0.1);
+    EXPECT_DOUBLE_EQ(1.0, loop.share);
+}
+
+/** A long saturated stretch must not delay the way back. */
+TEST(PiLoopTest, AntiWindup)
+{
+    const double kp = 0.5, ki = 0.1;
+    PiLoop loop = PiLoop::saturated(ki);
+    const double integral = loop.integral;
+    for (int i = 0; i < 1000; i++)
+        loop.update(0.05, kp, ki);
+    EXPECT_DOUBLE_EQ(1.0, loop.share);
+    EXPECT_DOUBLE_EQ(integral, loop.integral);
+
+    // The first negative error leaves the limit
+    loop.update(-0.2, kp, ki);
+    EXPECT_LT(loop.share, 1.0);
+
+    // The integral stops once a step would take the output under 0
+    for (int i = 0; i < 1000; i++)
+        loop.update(-0.5, kp, ki);
+    const double low = loop.integral;
+    EXPECT_GT(low, 0.0);
+    EXPECT_LT(loop.share, 0.1);
+    loop.update(-0.5, kp, ki);
+    EXPECT_DOUBLE_EQ(low, loop.integral);
+
+    loop.update(0.5, kp, ki);
+    EXPECT_GT(loop.share, 0.5);
+}
+
+TEST(PiLoopTest, CreditsSpreadShare)
+{
+    double credit = 0;
+    unsigned taken = 0;
+    for (int i = 0; i < 100; i++) {
+        const bool take = credit + 0.25 >= 1;
+        spendCredit(credit, 0.25, take);
+        taken += take;
+    }
+    EXPECT_EQ(25, taken);
+
+    // Not being allowed for a while does not build up a debt
+    for (int i = 0; i < 100; i++)
+        spendCredit(credit, 0.0, true);
+    EXPECT_DOUBLE_EQ(-1.0, credit);
+}
+
+namespace
+{
+
+OtfGradient::Config
+gradientConfig()
+{
+    OtfGradient::Config cfg;
+    cfg.windowSize = 2;
+    cfg.thresholdOtf = 0.75;
+    cfg.thresholdGradChange = 0.25;
+    cfg.thresholdAbs = 0.03;
+    cfg.maxDecay = 0.7;
+    cfg.boostPeriod = 1000;
+    cfg.boostHold = 0;
+    cfg.llcOtfCutoff = 0.1;
+    cfg.dramUsageCutoff = 0.1;
+    cfg.mlcUsageCutoff = 0.9;
+    return cfg;
+}
+
+} // anonymous namespace
+
+TEST(OtfGradientTest, SendStatusCutoffs)
+{
+    const auto cfg = gradientConfig();
+    OtfGradient s;
+
+    s.prevOtfRate = 0.5;
+    s.usage = 0;
+    EXPECT_EQ(Llc, s.sendStatus(cfg));
+
+    s.prevOtfRate = 0.05;
+    s.usage = 0.05;
+    EXPECT_EQ(Dram, s.sendStatus(cfg));
+    s.usage = 0.5;
+    EXPECT_EQ(Llc, s.sendStatus(cfg));
+    s.usage = 0.95;
+    EXPECT_EQ(Mlc, s.sendStatus(cfg));
+}
+
+TEST(OtfGradientTest, CanSendToCache)
+{
+    auto cfg = gradientConfig();
+    OtfGradient s;
+
+    // Under the absolute threshold a cache is always usable
+    s.prevOtfRate = 0.01;
+    s.localMaxOtf = 0.01;
+    s.relativeIncrease = 0;
+    EXPECT_TRUE(s.canSendToCache(cfg));
+
+    // Close to the maximum and not growing fast
+    s.prevOtfRate = 0.5;
+    s.localMaxOtf = 0.6;
+    EXPECT_FALSE(s.canSendToCache(cfg));
+
+    // Well under the maximum
+    s.localMaxOtf = 1.0;
+    EXPECT_TRUE(s.canSendToCache(cfg));
+
+    // Still growing fast
+    s.localMaxOtf = 0.6;
+    s.relativeIncrease = 0.5;
+    EXPECT_TRUE(s.canSendToCache(cfg));
+
+    // Held after a boost
+    s.relativeIncrease = 0;
+    cfg.boostHold = 10;
+    s.boostCnt = 5;
+    EXPECT_TRUE(s.canSendToCache(cfg));
+}
+
+TEST(OtfGradientTest, WindowsAndDecay)
+{
+    const auto cfg = gradientConfig();
+    OtfGradient s;
+
+    s.update(cfg, 0.4, 0.2);
+    EXPECT_DOUBLE_EQ(0.4, s.localMaxOtf);
+    EXPECT_DOUBLE_EQ(1, s.prevOtfRate);
+    EXPECT_DOUBLE_EQ(0.8, s.usage);
+
+    // The window closes on the second report
+    s.update(cfg, 0.6, 0.2);
+    EXPECT_DOUBLE_EQ(0.6, s.prevOtfRate);
+    EXPECT_DOUBLE_EQ(0.6, s.localMaxOtf);
+    EXPECT_DOUBLE_EQ(-0.2, s.prevGrad);
+
+    // A rate well under the maximum resets it
+    s.update(cfg, 0.1, 0.2);
+    EXPECT_DOUBLE_EQ(0.1, s.localMaxOtf);
+}
+
+TEST(BanditArmsTest, TriesEveryArmFirst)
+{
+    BanditArms q(80);
+    EXPECT_EQ(Mlc, q.best(AllLevels));
+    q.sample(Mlc, 1.0, 5, 80, 0.5);
+    EXPECT_EQ(Llc, q.best(AllLevels));
+    q.sample(Llc, 0.0, 20, 80, 0.5);
+    EXPECT_EQ(Llc, q.best(AllLevels));
+    EXPECT_EQ(Mlc, q.best(levelBit(Mlc) | levelBit(Dram)));
+    q.sample(Mlc, 1.0, 5, 80, 0.5);
+    q.sample(Mlc, 1.0, 5, 80, 0.5);
+    EXPECT_EQ(Llc, q.best(AllLevels));
+    EXPECT_EQ(Dram, q.best(levelBit(Dram)));
+}
+
+TEST(BanditArmsTest, SamplesBlend)
+{
+    BanditArms q(80);
+    q.sample(Llc, 0.5, 20, 80, 0.5);
+    EXPECT_DOUBLE_EQ(50, q.arm(Llc).cost);
+    q.sample(Llc, 0.0, 20, 80, 0.5);
+    EXPECT_DOUBLE_EQ(35, q.arm(Llc).cost);
+}
+
+/**
+ * A queue that explored DRAM comes back once the caches drain, they
+ * keep reporting while the queue does not write there.
+ */
+TEST(BanditArmsTest, LeavesDram)
+{
+    BanditArms q(80);
+    q.sample(Mlc, 1.0, 5, 80, 0.5);
+    q.sample(Llc, 0.9, 20, 80, 0.5);
+    EXPECT_EQ(Llc, q.best(AllLevels));
+    EXPECT_TRUE(q.moveTo(Dram));
+    EXPECT_FALSE(q.moveTo(Dram));
+
+    q.sample(Llc, 0.0, 20, 80, 0.5);
+    q.sample(Mlc, 0.0, 5, 80, 0.5);
+    EXPECT_TRUE(q.moveTo(q.best(AllLevels)));
+    EXPECT_EQ(Mlc, q.current());
+}
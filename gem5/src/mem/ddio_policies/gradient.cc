@@ -0,0 +1,54 @@
+#include "mem/ddio_policies/gradient.hh"
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/DdioPolicy.hh"
+#include "params/GradientDdioPolicy.hh"
+
+namespace gem5
+{
+
+namespace ddio_policy
+{
+
+Gradient::Gradient(const Params &p)
+    : Base(p),
+      cfg{p.window_size, p.threshhold_otf, p.threshhold_gradchange,
+          p.threshhold_abs, p.max_decay, p.boost_period, p.boost_hold,
+          p.llc_otf_cutoff, p.dram_usage_cutoff, p.mlc_usage_cutoff},
+      mlcs(numAdqs)
+{
+    fatal_if(cfg.windowSize == 0, "%s: window_size must not be 0", name());
+}
+
+Level
+Gradient::choose(int adq, unsigned allowed)
+{
+    if ((allowed & levelBit(Mlc)) &&
+        mlcs[adqSlot(adq)].canSendToCache(cfg)) {
+        return Mlc;
+    }
+
+    const Level status = llc.sendStatus(cfg);
+    if (allowed & levelBit(status))
+        return status;
+    if (allowed & levelBit(Llc))
+        return Llc;
+    return firstAllowed(allowed);
+}
+
+void
+Gradient::feedback(const Feedback &fb)
+{
+    Base::feedback(fb);
+
+    OtfGradient &s = fb.llc ? llc : mlcs[adqSlot(fb.cacheId)];
+    s.update(cfg, fb.otfRate, fb.untouchedEvictRate);
+
+    DPRINTF(DdioPolicy, "%s %d: relative increase %f, local max %f\n",
+            fb.llc ? "LLC" : "MLC", fb.cacheId, s.relativeIncrease,
+            s.localMaxOtf);
+}
+
+} // namespace ddio_policy
+} // namespace gem5
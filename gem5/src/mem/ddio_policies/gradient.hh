@@ -0,0 +1,43 @@
+#ifndef __MEM_DDIO_POLICIES_GRADIENT_HH__
+#define __MEM_DDIO_POLICIES_GRADIENT_HH__
+
+#include <vector>
+
+#include "mem/ddio_policies/base.hh"
+
+namespace gem5
+{
+
+struct GradientDdioPolicyParams;
+
+namespace ddio_policy
+{
+
+/**
+ * The on-the-fly gradient heuristic the bridge first shipped with. Each
+ * cache tracks the highest on-the-fly rate it reported lately and how
+ * fast the rate grows from one window of reports to the next; a queue
+ * keeps writing to its MLC while the rate stays well under that maximum
+ * or is still growing fast. Otherwise the data usage the LLC reports
+ * picks between the LLC and DRAM.
+ */
+class Gradient : public Base
+{
+  protected:
+    const OtfGradient::Config cfg;
+
+    std::vector<OtfGradient> mlcs;
+    OtfGradient llc;
+
+  public:
+    typedef GradientDdioPolicyParams Params;
+    Gradient(const Params &p);
+
+    Level choose(int adq, unsigned allowed) override;
+    void feedback(const Feedback &fb) override;
+};
+
+} // namespace ddio_policy
+} // namespace gem5
+
+#endif // __MEM_DDIO_POLICIES_GRADIENT_HH__
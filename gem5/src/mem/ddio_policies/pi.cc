@@ -0,0 +1,66 @@
+#include "mem/ddio_policies/pi.hh"
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/DdioPolicy.hh"
+#include "params/PiDdioPolicy.hh"
+
+namespace gem5
+{
+
+namespace ddio_policy
+{
+
+Pi::Pi(const Params &p)
+    : Base(p), setpoint(p.setpoint), kp(p.kp), ki(p.ki), credits(numAdqs)
+{
+    fatal_if(ki <= 0, "%s: ki must be positive", name());
+
+    // Start with everything in the caches, as plain DDIO does
+    llc = PiLoop::saturated(ki);
+    mlcs.assign(numAdqs, llc);
+}
+
+Level
+Pi::choose(int adq, unsigned allowed)
+{
+    const Credits &c = credits[adqSlot(adq)];
+
+    if ((allowed & levelBit(Mlc)) &&
+        c.mlc + mlcs[adqSlot(adq)].share >= 1) {
+        return Mlc;
+    }
+    if ((allowed & levelBit(Llc)) &&
+        (!(allowed & levelBit(Dram)) || c.llc + llc.share >= 1)) {
+        return Llc;
+    }
+    if (allowed & levelBit(Dram))
+        return Dram;
+    return firstAllowed(allowed);
+}
+
+void
+Pi::placed(int adq, Level level)
+{
+    Base::placed(adq, level);
+
+    Credits &c = credits[adqSlot(adq)];
+    spendCredit(c.mlc, mlcs[adqSlot(adq)].share, level == Mlc);
+    if (level != Mlc)
+        spendCredit(c.llc, llc.share, level == Llc);
+}
+
+void
+Pi::feedback(const Feedback &fb)
+{
+    Base::feedback(fb);
+
+    PiLoop &loop = fb.llc ? llc : mlcs[adqSlot(fb.cacheId)];
+    loop.update(setpoint - fb.untouchedEvictRate, kp, ki);
+
+    DPRINTF(DdioPolicy, "%s %d: share %f\n", fb.llc ? "LLC" : "MLC",
+            fb.cacheId, loop.share);
+}
+
+} // namespace ddio_policy
+} // namespace gem5
@@ -0,0 +1,53 @@
+#ifndef __MEM_DDIO_POLICIES_PI_HH__
+#define __MEM_DDIO_POLICIES_PI_HH__
+
+#include <vector>
+
+#include "mem/ddio_policies/base.hh"
+
+namespace gem5
+{
+
+struct PiDdioPolicyParams;
+
+namespace ddio_policy
+{
+
+/**
+ * A proportional-integral controller per cache that holds the fraction
+ * of DDIO blocks evicted before they are read at a setpoint. The output
+ * of the controller of an MLC is the share of the writes of its queue
+ * that go to it, the output of the LLC controller the share of the
+ * remaining writes that go to the LLC rather than DRAM. The shares are
+ * spread over the writes by error diffusion.
+ */
+class Pi : public Base
+{
+  protected:
+    struct Credits
+    {
+        double mlc = 0;
+        double llc = 0;
+    };
+
+    const double setpoint;
+    const double kp;
+    const double ki;
+
+    std::vector<PiLoop> mlcs;
+    PiLoop llc;
+    std::vector<Credits> credits;
+
+  public:
+    typedef PiDdioPolicyParams Params;
+    Pi(const Params &p);
+
+    Level choose(int adq, unsigned allowed) override;
+    void placed(int adq, Level level) override;
+    void feedback(const Feedback &fb) override;
+};
+
+} // namespace ddio_policy
+} // namespace gem5
+
+#endif // __MEM_DDIO_POLICIES_PI_HH__
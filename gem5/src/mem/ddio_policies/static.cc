@@ -0,0 +1,30 @@
+#include "mem/ddio_policies/static.hh"
+
+#include "base/logging.hh"
+#include "params/StaticDdioPolicy.hh"
+
+namespace gem5
+{
+
+namespace ddio_policy
+{
+
+Static::Static(const Params &p)
+    : Base(p), levels(numAdqs, Level(p.level))
+{
+    fatal_if(p.adq_levels.size() > numAdqs,
+             "%s: %d ADQ levels given for %d ADQs", name(),
+             p.adq_levels.size(), numAdqs);
+    for (unsigned i = 0; i < p.adq_levels.size(); i++)
+        levels[i] = Level(p.adq_levels[i]);
+}
+
+Level
+Static::choose(int adq, unsigned allowed)
+{
+    const Level level = levels[adqSlot(adq)];
+    return allowed & levelBit(level) ? level : firstAllowed(allowed);
+}
+
+} // namespace ddio_policy
+} // namespace gem5
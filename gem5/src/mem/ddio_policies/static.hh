@@ -0,0 +1,37 @@
+#ifndef __MEM_DDIO_POLICIES_STATIC_HH__
+#define __MEM_DDIO_POLICIES_STATIC_HH__
+
+#include <vector>
+
+#include "mem/ddio_policies/base.hh"
+
+namespace gem5
+{
+
+struct StaticDdioPolicyParams;
+
+namespace ddio_policy
+{
+
+/**
+ * Places the writes of each queue in a fixed level, falling back to the
+ * first level allowed from the MLC down. The baseline to compare the
+ * adaptive policies with.
+ */
+class Static : public Base
+{
+  protected:
+    /** Level of each ADQ */
+    std::vector<Level> levels;
+
+  public:
+    typedef StaticDdioPolicyParams Params;
+    Static(const Params &p);
+
+    Level choose(int adq, unsigned allowed) override;
+};
+
+} // namespace ddio_policy
+} // namespace gem5
+
+#endif // __MEM_DDIO_POLICIES_STATIC_HH__
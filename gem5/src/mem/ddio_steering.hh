@@ -0,0 +1,223 @@
+#ifndef __MEM_DDIO_STEERING_HH__
+#define __MEM_DDIO_STEERING_HH__
+
+#include <cstdint>
+#include <vector>
+
+#include "base/types.hh"
+
+namespace gem5
+{
+
+/**
+ * The table the DDIO bridge uses to decide where the writes of each
+ * device queue go. Entries are indexed by the ADQ index the device tags
+ * its DMA with, so a flow or PASID can get an entry of its own once the
+ * device tags packets with it.
+ *
+ * An entry holds the levels a queue may write to, the MLC it targets
+ * and how many lines it may place in that MLC per epoch, after which
+ * its writes spill to the next level allowed. An entry with no level
+ * allowed leaves the placement to the device.
+ *
+ * The table is programmed through a register block:
+ *   0x00        INFO   number of entries (RO)
+ *   0x10 + 16n  DEST   allowed levels, AllowMlc | AllowLlc | AllowDram
+ *   0x14 + 16n  MLC    target MLC, ~0 for the one the ADQ index names
+ *   0x18 + 16n  LIMIT  lines placed in the MLC per epoch, 0 for no limit
+ *   0x1c + 16n  USED   lines placed in the MLC this epoch (RO)
+ * Writing any register of an entry restarts its epoch.
+ */
+class DdioSteeringTable
+{
+  public:
+    enum Allow : uint32_t
+    {
+        AllowMlc = 1,
+        AllowLlc = 2,
+        AllowDram = 4,
+        AllowMask = 7,
+    };
+
+    enum class Target
+    {
+        Device,
+        Mlc,
+        Llc,
+        Dram,
+    };
+
+    struct Decision
+    {
+        Target target;
+        int mlc;
+    };
+
+    static constexpr Addr RegInfo = 0x00;
+    static constexpr Addr EntryBase = 0x10;
+    static constexpr Addr EntryStride = 0x10;
+
+    enum EntryReg : Addr
+    {
+        RegDest = 0x0,
+        RegMlc = 0x4,
+        RegLimit = 0x8,
+        RegUsed = 0xc,
+    };
+
+    struct Entry
+    {
+        uint32_t allow = 0;
+        int mlc = -1;
+        uint32_t shareLimit = 0;
+        uint32_t used = 0;
+        Tick epochStart = 0;
+    };
+
+  private:
+    std::vector<Entry> entries;
+    const Tick epoch;
+
+    /** The entry of a key, nullptr if the table has none. */
+    Entry *
+    find(int key)
+    {
+        if (key < 0 || key >= int(entries.size()))
+            return nullptr;
+        return &entries[key];
+    }
+
+    void
+    refresh(Entry &e, Tick now)
+    {
+        if (epoch && now >= e.epochStart + epoch) {
+            e.used = 0;
+            e.epochStart = now - (now - e.epochStart) % epoch;
+        }
+    }
+
+  public:
+    /**
+     * @param size the number of entries
+     * @param _epoch how often the MLC share limits start over, 0 for
+     *        never
+     */
+    DdioSteeringTable(unsigned size, Tick _epoch)
+        : entries(size), epoch(_epoch)
+    {}
+
+    unsigned size() const { return entries.size(); }
+
+    /** Raw access for checkpointing. */
+    Entry &entry(unsigned key) { return entries[key]; }
+    const Entry &entry(unsigned key) const { return entries[key]; }
+
+    /** Size of the register block. */
+    Addr regSize() const { return EntryBase + size() * EntryStride; }
+
+    /** Program an entry, restarting its epoch. */
+    void
+    set(int key, uint32_t allow, int mlc, uint32_t share_limit, Tick now)
+    {
+        Entry *e = find(key);
+        if (!e)
+            return;
+        e->allow = allow & AllowMask;
+        e->mlc = mlc < 0 ? -1 : mlc;
+        e->shareLimit = share_limit;
+        e->used = 0;
+        e->epochStart = now;
+    }
+
+    uint32_t
+    allowed(int key) const
+    {
+        if (key < 0 || key >= int(entries.size()))
+            return 0;
+        return entries[key].allow;
+    }
+
+    /**
+     * Where a write of a queue should go. Nothing is charged to the
+     * queue until the write is accepted, see account().
+     */
+    Decision
+    steer(int key, Tick now)
+    {
+        Entry *e = find(key);
+        if (!e || !e->allow)
+            return {Target::Device, -1};
+
+        refresh(*e, now);
+        const int mlc = e->mlc < 0 ? key : e->mlc;
+        if ((e->allow & AllowMlc) &&
+            (!e->shareLimit || e->used < e->shareLimit)) {
+            return {Target::Mlc, mlc};
+        }
+        if (e->allow & AllowDram && !(e->allow & AllowLlc))
+            return {Target::Dram, -1};
+        // The LLC is where DDIO falls back to once the MLC share is used
+        return {Target::Llc, -1};
+    }
+
+    /** Charge an accepted write to its queue. */
+    void
+    account(int key, const Decision &d)
+    {
+        Entry *e = find(key);
+        if (e && d.target == Target::Mlc)
+            e->used++;
+    }
+
+    uint32_t
+    readReg(Addr offset, Tick now)
+    {
+        if (offset == RegInfo)
+            return size();
+        if (offset < EntryBase || offset >= regSize())
+            return 0;
+
+        Entry &e = entries[(offset - EntryBase) / EntryStride];
+        refresh(e, now);
+        switch ((offset - EntryBase) % EntryStride) {
+          case RegDest:
+            return e.allow;
+          case RegMlc:
+            return uint32_t(e.mlc);
+          case RegLimit:
+            return e.shareLimit;
+          case RegUsed:
+            return e.used;
+          default:
+            return 0;
+        }
+    }
+
+    /** Write a register, read only registers ignore the write. */
+    void
+    writeReg(Addr offset, uint32_t val, Tick now)
+    {
+        if (offset < EntryBase || offset >= regSize())
+            return;
+
+        const int key = (offset - EntryBase) / EntryStride;
+        Entry &e = entries[key];
+        switch ((offset - EntryBase) % EntryStride) {
+          case RegDest:
+            set(key, val, e.mlc, e.shareLimit, now);
+            break;
+          case RegMlc:
+            set(key, e.allow, int32_t(val), e.shareLimit, now);
+            break;
+          case RegLimit:
+            set(key, e.allow, e.mlc, val, now);
+            break;
+          default:
+            break;
+        }
+    }
+};
+
+} // namespace gem5
+
+#endif // __MEM_DDIO_STEERING_HH__
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include "mem/ddio_steering.hh"
+
+using namespace gem5;
+
+using Target = DdioSteeringTable::Target;
+
+TEST(DdioSteeringTableTest, UnprogrammedLeavesDevice)
+{
+    DdioSteeringTable table(4, 1000);
+    EXPECT_EQ(Target::Device, table.steer(0, 0).target);
+    EXPECT_EQ(Target::Device, table.steer(-1, 0).target);
+    EXPECT_EQ(Target::Device, table.steer(4, 0).target);
+}
+
+TEST(DdioSteeringTableTest, TargetsMlc)
+{
+    DdioSteeringTable table(4, 1000);
+    table.set(2, DdioSteeringTable::AllowMlc, -1, 0, 0);
+    auto d = table.steer(2, 0);
+    EXPECT_EQ(Target::Mlc, d.target);
+    EXPECT_EQ(2, d.mlc);
+
+    table.set(2, DdioSteeringTable::AllowMlc, 5, 0, 0);
+    d = table.steer(2, 0);
+    EXPECT_EQ(Target::Mlc, d.target);
+    EXPECT_EQ(5, d.mlc);
+}
+
+TEST(DdioSteeringTableTest, ShareLimitSpills)
+{
+    DdioSteeringTable table(1, 1000);
+    table.set(0, DdioSteeringTable::AllowMlc | DdioSteeringTable::AllowDram,
+              1, 2, 0);
+    for (int i = 0; i < 2; i++) {
+        auto d = table.steer(0, 10);
+        EXPECT_EQ(Target::Mlc, d.target);
+        table.account(0, d);
+    }
+    EXPECT_EQ(Target::Dram, table.steer(0, 10).target);
+
+    // The share comes back with the next epoch
+    EXPECT_EQ(Target::Mlc, table.steer(0, 1000).target);
+}
+
+TEST(DdioSteeringTableTest, Registers)
+{
+    DdioSteeringTable table(2, 0);
+    EXPECT_EQ(2, table.readReg(DdioSteeringTable::RegInfo, 0));
+    EXPECT_EQ(0x30, table.regSize());
+
+    const Addr e1 = DdioSteeringTable::EntryBase +
+        DdioSteeringTable::EntryStride;
+    table.writeReg(e1 + DdioSteeringTable::RegDest,
+                   DdioSteeringTable::AllowLlc, 0);
+    table.writeReg(e1 + DdioSteeringTable::RegMlc, 3, 0);
+    table.writeReg(e1 + DdioSteeringTable::RegLimit, 8, 0);
+    table.writeReg(e1 + DdioSteeringTable::RegUsed, 5, 0);
+
+    EXPECT_EQ(DdioSteeringTable::AllowLlc,
+              table.readReg(e1 + DdioSteeringTable::RegDest, 0));
+    EXPECT_EQ(3, table.readReg(e1 + DdioSteeringTable::RegMlc, 0));
+    EXPECT_EQ(8, table.readReg(e1 + DdioSteeringTable::RegLimit, 0));
+    EXPECT_EQ(0, table.readReg(e1 + DdioSteeringTable::RegUsed, 0));
+    EXPECT_EQ(Target::Llc, table.steer(1, 0).target);
+    EXPECT_EQ(0, table.allowed(0));
+
+    table.writeReg(e1 + DdioSteeringTable::RegMlc, ~0U, 0);
+    EXPECT_EQ(~0U, table.readReg(e1 + DdioSteeringTable::RegMlc, 0));
+}
@@ -0,0 +1,215 @@
+#ifndef __MEM_DDIO_TELEMETRY_HH__
+#define __MEM_DDIO_TELEMETRY_HH__
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "base/intmath.hh"
+#include "base/types.hh"
+
+#define CACHE_TYPE_MLC 0
+#define CACHE_TYPE_LLC 1
+#define CACHE_TYPE_OTHER -1
+
+namespace gem5
+{
+
+/** Number of DMA-to-first-use latency buckets in a report */
+constexpr unsigned DdioLatencyBuckets = 16;
+
+/**
+ * What a cache reports to the DDIO bridge about the DDIO blocks it
+ * holds. The resident and on-the-fly counts are a snapshot, the other
+ * counts cover the interval since the previous report.
+ */
+struct OnTheFlyInfo
+{
+    struct Adq
+    {
+        uint64_t resident = 0;
+        uint64_t on_the_fly = 0;
+        uint64_t inserted = 0;
+        uint64_t first_uses = 0;
+        uint64_t evicted = 0;
+        uint64_t untouched_evicted = 0;
+        float otf_rate = 0;
+        float untouched_evict_rate = 0;
+    };
+
+    int cache_type = CACHE_TYPE_OTHER;
+    int cache_id = -1;
+    float untouched_evict_rate = -1;
+    float otf_rate = -1;
+
+    uint64_t num_ddio_blks = 0;
+    uint64_t num_ref_ddio_header = 0;
+    uint64_t num_ref_ddio_body = 0;
+
+    /** Ticks covered by the report */
+    Tick interval = 0;
+
+    /** Per ADQ index, untagged blocks and the ones past the last share
+     * the last entry */
+    std::vector<Adq> adqs;
+
+    /** First uses by the DMA-to-use latency: bucket 0 counts the ones
+     * under 1ns, bucket b the ones in [2^(b-1), 2^b) ns, the last one
+     * everything above */
+    std::array<uint64_t, DdioLatencyBuckets> first_use_latency{};
+};
+
+/**
+ * Counts what happens to the DDIO blocks of a cache between two reports
+ * to the DDIO bridge. A block is inserted when DMA data lands in the
+ * cache, is on the fly until the first access from the CPU side, and
+ * counts as an untouched eviction if it leaves before that.
+ * Nothing is allocated after construction, the report is filled in
+ * place.
+ */
+class DdioTelemetry
+{
+  private:
+    struct Counters
+    {
+        uint64_t resident = 0;
+        uint64_t onTheFly = 0;
+        uint64_t inserted = 0;
+        uint64_t firstUses = 0;
+        uint64_t evicted = 0;
+        uint64_t untouchedEvicted = 0;
+    };
+
+    std::vector<Counters> adqs;
+    uint64_t headerUses = 0;
+    uint64_t bodyUses = 0;
+    std::array<uint64_t, DdioLatencyBuckets> latency{};
+    Tick lastReport = 0;
+
+    static float
+    rate(uint64_t part, uint64_t whole)
+    {
+        return whole ? float(part) / whole : 0;
+    }
+
+  public:
+    /** @param num_adqs ADQ indices counted apart, at least one */
+    explicit DdioTelemetry(unsigned num_adqs)
+        : adqs(num_adqs ? num_adqs : 1)
+    {}
+
+    unsigned numAdqs() const { return adqs.size(); }
+
+    /** The counters an ADQ index goes to. */
+    unsigned
+    slot(int adq) const
+    {
+        if (adq < 0 || adq >= int(adqs.size()))
+            return adqs.size() - 1;
+        return adq;
+    }
+
+    /** The latency bucket of a first use. */
+    static unsigned
+    bucket(uint64_t latency_ns)
+    {
+        if (!latency_ns)
+            return 0;
+        const unsigned b = floorLog2(latency_ns) + 1;
+        return b < DdioLatencyBuckets ? b : DdioLatencyBuckets - 1;
+    }
+
+    void
+    insert(int adq)
+    {
+        Counters &c = adqs[slot(adq)];
+        c.resident++;
+        c.onTheFly++;
+        c.inserted++;
+    }
+
+    /** The first read of a block since it was inserted. */
+    void
+    use(int adq, bool header, uint64_t latency_ns)
+    {
+        Counters &c = adqs[slot(adq)];
+        if (c.onTheFly)
+            c.onTheFly--;
+        c.firstUses++;
+        if (header)
+            headerUses++;
+        else
+            bodyUses++;
+        latency[bucket(latency_ns)]++;
+    }
+
+    /** A block stops counting without leaving, as when DMA data
+     * overwrites it. */
+    void
+    remove(int adq, bool touched)
+    {
+        Counters &c = adqs[slot(adq)];
+        if (c.resident)
+            c.resident--;
+        if (!touched && c.onTheFly)
+            c.onTheFly--;
+    }
+
+    void
+    evict(int adq, bool touched)
+    {
+        remove(adq, touched);
+        Counters &c = adqs[slot(adq)];
+        c.evicted++;
+        if (!touched)
+            c.untouchedEvicted++;
+    }
+
+    /**
+     * Fill a report and start a new interval. The rates are 0 when there
+     * is nothing to divide by, an idle cache is not losing any data.
+     */
+    void
+    report(OnTheFlyInfo &info, Tick now)
+    {
+        info.interval = now - lastReport;
+        info.adqs.resize(adqs.size());
+
+        uint64_t resident = 0, on_the_fly = 0;
+        uint64_t evicted = 0, untouched = 0;
+        for (unsigned i = 0; i < adqs.size(); i++) {
+            Counters &c = adqs[i];
+            OnTheFlyInfo::Adq &a = info.adqs[i];
+            a.resident = c.resident;
+            a.on_the_fly = c.onTheFly;
+            a.inserted = c.inserted;
+            a.first_uses = c.firstUses;
+            a.evicted = c.evicted;
+            a.untouched_evicted = c.untouchedEvicted;
+            a.otf_rate = rate(c.onTheFly, c.resident);
+            a.untouched_evict_rate = rate(c.untouchedEvicted, c.evicted);
+
+            resident += c.resident;
+            on_the_fly += c.onTheFly;
+            evicted += c.evicted;
+            untouched += c.untouchedEvicted;
+
+            c.inserted = c.firstUses = c.evicted = c.untouchedEvicted = 0;
+        }
+
+        info.num_ddio_blks = resident;
+        info.otf_rate = rate(on_the_fly, resident);
+        info.untouched_evict_rate = rate(untouched, evicted);
+        info.num_ref_ddio_header = headerUses;
+        info.num_ref_ddio_body = bodyUses;
+        info.first_use_latency = latency;
+
+        headerUses = bodyUses = 0;
+        latency.fill(0);
+        lastReport = now;
+    }
+};
+
+} // namespace gem5
+
+#endif // __MEM_DDIO_TELEMETRY_HH__
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "mem/ddio_telemetry.hh"
+
+using namespace gem5;
+
+TEST(DdioTelemetryTest, Buckets)
+{
+    EXPECT_EQ(0, DdioTelemetry::bucket(0));
+    EXPECT_EQ(1, DdioTelemetry::bucket(1));
+    EXPECT_EQ(2, DdioTelemetry::bucket(2));
+    EXPECT_EQ(2, DdioTelemetry::bucket(3));
+    EXPECT_EQ(11, DdioTelemetry::bucket(1024));
+    EXPECT_EQ(DdioLatencyBuckets - 1, DdioTelemetry::bucket(~0ULL));
+}
+
+TEST(DdioTelemetryTest, Rates)
+{
+    DdioTelemetry t(2);
+    OnTheFlyInfo info;
+
+    for (int i = 0; i < 4; i++)
+        t.insert(0);
+    t.insert(1);
+    t.use(0, true, 100);
+    t.evict(0, true);
+    t.evict(0, false);
+    t.report(info, 1000);
+
+    ASSERT_EQ(2, info.adqs.size());
+    EXPECT_EQ(1000, info.interval);
+    EXPECT_EQ(3, info.num_ddio_blks);
+    EXPECT_EQ(1, info.num_ref_ddio_header);
+    EXPECT_EQ(0, info.num_ref_ddio_body);
+    // Two of queue 0 and the one of queue 1 are still waiting
+    EXPECT_FLOAT_EQ(1.0, info.otf_rate);
+    EXPECT_FLOAT_EQ(0.5, info.untouched_evict_rate);
+
+    EXPECT_EQ(2, info.adqs[0].resident);
+    EXPECT_EQ(4, info.adqs[0].inserted);
+    EXPECT_EQ(1, info.adqs[0].untouched_evicted);
+    EXPECT_FLOAT_EQ(0.5, info.adqs[0].untouched_evict_rate);
+    EXPECT_FLOAT_EQ(1.0, info.adqs[1].otf_rate);
+    EXPECT_EQ(1, info.first_use_latency[DdioTelemetry::bucket(100)]);
+}
+
+TEST(DdioTelemetryTest, IntervalsStartOver)
+{
+    DdioTelemetry t(1);
+    OnTheFlyInfo info;
+
+    t.insert(0);
+    t.evict(0, false);
+    t.insert(0);
+    t.report(info, 500);
+    t.report(info, 800);
+
+    EXPECT_EQ(300, info.interval);
+    EXPECT_EQ(1, info.num_ddio_blks);
+    EXPECT_EQ(0, info.adqs[0].inserted);
+    EXPECT_EQ(0, info.adqs[0].evicted);
+    EXPECT_FLOAT_EQ(0, info.untouched_evict_rate);
+    EXPECT_FLOAT_EQ(1.0, info.otf_rate);
+}
+
+TEST(DdioTelemetryTest, UntaggedShareLastSlot)
+{
+    DdioTelemetry t(3);
+    EXPECT_EQ(2, t.slot(-1));
+    EXPECT_EQ(2, t.slot(7));
+    EXPECT_EQ(1, t.slot(1));
+
+    OnTheFlyInfo info;
+    t.insert(-1);
+    t.report(info, 10);
+    EXPECT_EQ(1, info.adqs[2].resident);
+}
+
+TEST(DdioTelemetryTest, OverwriteIsNotEviction)
+{
+    DdioTelemetry t(1);
+    OnTheFlyInfo info;
+
+    t.insert(0);
+    t.remove(0, false);
+    t.insert(0);
+    t.report(info, 10);
+    EXPECT_EQ(1, info.num_ddio_blks);
+    EXPECT_EQ(2, info.adqs[0].inserted);
+    EXPECT_EQ(0, info.adqs[0].evicted);
+    EXPECT_FLOAT_EQ(1.0, info.otf_rate);
+}
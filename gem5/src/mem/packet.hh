@@ -1466,7 +1466,14 @@ class Packet : public Printable
     bool is_prefetch_hint_pkt = false;
     bool is_block_io;
 
+    // Class of service of the block a writeback carries
+    int cat_class = -1;
+
   public:
+    // Destination of DDIO writes that are to go to memory, skipping the
+    // LLC as well as the MLCs
+    static constexpr int DdioMemoryDestination = -2;
+
     void setDdioPrefetchId(int ddio_id){ddio_prefetch_id = ddio_id;}
     void setDdioPrefetchDestination(int ddio_dest){ddio_prefetch_destination = ddio_dest;}
     void setDdioHeader() {is_ddio_header = true; flags.set(DDIO_PREFETCH_HEADER);}
@@ -1489,6 +1496,9 @@ class Packet : public Printable
     bool isBlockIO() const     { return flags.isSet(BLOCK_IO); }
     void clearBlockIO()        { flags.clear(BLOCK_IO); }
 
+    void setCatClass(int clos) { cat_class = clos; }
+    int getCatClass() const    { return cat_class; }
+
     // hardware transactional memory
 
     /**
@@ -0,0 +1,368 @@
+#include "mem/pcie_link.hh"
+
+#include <algorithm>
+
+#include "base/intmath.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/PcieLink.hh"
+#include "sim/stats.hh"
+
+namespace gem5
+{
+
+namespace
+{
+
+/** Bytes per second of one lane of each generation, after encoding. */
+double
+laneRate(unsigned gen)
+{
+    switch (gen) {
+      case 1:
+        return 2.5e9 * 8 / 10 / 8;
+      case 2:
+        return 5e9 * 8 / 10 / 8;
+      case 3:
+        return 8e9 * 128 / 130 / 8;
+      case 4:
+        return 16e9 * 128 / 130 / 8;
+      case 5:
+        return 32e9 * 128 / 130 / 8;
+      default:
+        fatal("Unsupported PCIe generation %d\n", gen);
+    }
+}
+
+/** Size of a data credit. */
+const unsigned CreditBytes = 16;
+
+} // anonymous namespace
+
+PcieLink::PcieLink(const Params &p)
+    : ClockedObject(p),
+      devSidePort(p.name + ".dev_side_port", *this),
+      memSidePort(p.name + ".mem_side_port", *this),
+      ticksPerByte(sim_clock::as_float::s / (laneRate(p.gen) * p.lanes)),
+      tlpOverhead(p.tlp_overhead), maxPayload(p.max_payload_size),
+      maxReadRequest(p.max_read_request_size), linkLatency(p.link_latency),
+      creditLatency(p.credit_update_latency),
+      postedHeaderCredits(p.posted_header_credits),
+      postedDataCredits(p.posted_data_credits),
+      nonPostedHeaderCredits(p.nonposted_header_credits),
+      postedHeaders(postedHeaderCredits), postedData(postedDataCredits),
+      nonPostedHeaders(nonPostedHeaderCredits),
+      upFree(0), upBlocked(false), retryDev(false),
+      downFree(0), downBlocked(false),
+      upEvent([this]{ sendUp(); }, name()),
+      downEvent([this]{ sendDown(); }, name()),
+      creditEvent([this]{ returnCredits(); }, name()),
+      stats(*this)
+{
+    fatal_if(p.lanes == 0 || p.lanes > 32 || !isPowerOf2(p.lanes),
+             "%s: lanes must be a power of two up to 32", name());
+    fatal_if(!isPowerOf2(maxPayload) || maxPayload < 128 ||
+             maxPayload > 4096,
+             "%s: max_payload_size must be a power of two from 128 to 4096",
+             name());
+    fatal_if(!isPowerOf2(maxReadRequest) || maxReadRequest < 128 ||
+             maxReadRequest > 4096,
+             "%s: max_read_request_size must be a power of two from 128 "
+             "to 4096", name());
+    fatal_if(postedHeaderCredits == 0 || nonPostedHeaderCredits == 0 ||
+             postedDataCredits < maxPayload / CreditBytes,
+             "%s: the root complex must advertise header credits and data "
+             "credits for at least one max payload TLP", name());
+}
+
+Port &
+PcieLink::getPort(const std::string &if_name, PortID idx)
+{
+    if (if_name == "dev_side_port")
+        return devSidePort;
+    else if (if_name == "mem_side_port")
+        return memSidePort;
+    else
+        return ClockedObject::getPort(if_name, idx);
+}
+
+void
+PcieLink::init()
+{
+    if (!devSidePort.isConnected() || !memSidePort.isConnected())
+        fatal("Both ports of a PCIe link must be connected.\n");
+
+    devSidePort.sendRangeChange();
+}
+
+PcieLink::Tlp
+PcieLink::requestTlp(PacketPtr pkt) const
+{
+    Tlp tlp;
+    const unsigned size = pkt->getSize();
+    if (pkt->isWrite()) {
+        tlp.posted = true;
+        tlp.headers = divCeil(size, maxPayload);
+        tlp.data = divCeil(size, CreditBytes);
+        tlp.bytes = size + tlp.headers * tlpOverhead;
+    } else {
+        tlp.posted = false;
+        tlp.headers = std::max(divCeil(size, maxReadRequest), 1U);
+        tlp.data = 0;
+        tlp.bytes = tlp.headers * tlpOverhead;
+    }
+    return tlp;
+}
+
+unsigned
+PcieLink::completionBytes(PacketPtr pkt) const
+{
+    if (!pkt->isRead() || !pkt->hasData())
+        return 0;
+    const unsigned size = pkt->getSize();
+    return size + divCeil(size, maxPayload) * tlpOverhead;
+}
+
+bool
+PcieLink::recvTimingReq(PacketPtr pkt)
+{
+    const Tlp tlp = requestTlp(pkt);
+    if (tlp.posted) {
+        panic_if(tlp.headers > postedHeaderCredits ||
+                 tlp.data > postedDataCredits,
+                 "%s: %s needs more posted credits than the root complex "
+                 "has", name(), pkt->print());
+        if (tlp.headers > postedHeaders || tlp.data > postedData) {
+            DPRINTF(PcieLink, "No posted credits for %s\n", pkt->print());
+            stats.postedCreditStalls++;
+            retryDev = true;
+            return false;
+        }
+        postedHeaders -= tlp.headers;
+        postedData -= tlp.data;
+    } else {
+        panic_if(tlp.headers > nonPostedHeaderCredits,
+                 "%s: %s needs more non-posted credits than the root "
+                 "complex has", name(), pkt->print());
+        if (tlp.headers > nonPostedHeaders) {
+            DPRINTF(PcieLink, "No non-posted credits for %s\n",
+                    pkt->print());
+            stats.nonPostedCreditStalls++;
+            retryDev = true;
+            return false;
+        }
+        nonPostedHeaders -= tlp.headers;
+    }
+
+    const Tick wire = wireTime(tlp.bytes);
+    upFree = std::max(upFree, curTick()) + wire;
+    stats.upTlps += tlp.headers;
+    stats.upBytes += tlp.bytes;
+    stats.upBusy += wire;
+
+    DPRINTF(PcieLink, "Sending %s upstream as %d TLPs, %d bytes\n",
+            pkt->print(), tlp.headers, tlp.bytes);
+
+    upQueue.push_back({upFree + linkLatency, pkt, tlp});
+    if (!upBlocked && !upEvent.scheduled())
+        schedule(upEvent, upQueue.front().ready);
+    return true;
+}
+
+void
+PcieLink::sendUp()
+{
+    while (!upQueue.empty() && upQueue.front().ready <= curTick()) {
+        InFlight &head = upQueue.front();
+        if (!memSidePort.sendTimingReq(head.pkt)) {
+            DPRINTF(PcieLink, "Root complex blocked on %s\n",
+                    head.pkt->print());
+            upBlocked = true;
+            return;
+        }
+
+        // The request left the root complex buffers, its credits go back
+        // to the device with the next update
+        creditReturns.push_back({curTick() + creditLatency, head.tlp});
+        if (!creditEvent.scheduled())
+            schedule(creditEvent, creditReturns.front().when);
+        upQueue.pop_front();
+    }
+
+    if (!upQueue.empty())
+        schedule(upEvent, upQueue.front().ready);
+    checkDrained();
+}
+
+void
+PcieLink::returnCredits()
+{
+    while (!creditReturns.empty() &&
+           creditReturns.front().when <= curTick()) {
+        const Tlp &tlp = creditReturns.front().tlp;
+        if (tlp.posted) {
+            postedHeaders += tlp.headers;
+            postedData += tlp.data;
+        } else {
+            nonPostedHeaders += tlp.headers;
+        }
+        creditReturns.pop_front();
+    }
+
+    if (!creditReturns.empty())
+        schedule(creditEvent, creditReturns.front().when);
+
+    if (retryDev) {
+        retryDev = false;
+        devSidePort.sendRetryReq();
+    }
+    checkDrained();
+}
+
+bool
+PcieLink::recvTimingResp(PacketPtr pkt)
+{
+    const unsigned bytes = completionBytes(pkt);
+    Tick ready = curTick() + linkLatency;
+    if (bytes) {
+        const Tick wire = wireTime(bytes);
+        downFree = std::max(downFree, curTick()) + wire;
+        ready = downFree + linkLatency;
+        stats.downTlps += divCeil(pkt->getSize(), maxPayload);
+        stats.downBytes += bytes;
+        stats.downBusy += wire;
+    }
+
+    // Responses reach the device in the order they left the root complex
+    if (!downQueue.empty())
+        ready = std::max(ready, downQueue.back().ready);
+
+    DPRINTF(PcieLink, "Sending %s downstream, %d bytes\n", pkt->print(),
+            bytes);
+
+    downQueue.push_back({ready, pkt, Tlp()});
+    if (!downBlocked && !downEvent.scheduled())
+        schedule(downEvent, downQueue.front().ready);
+    return true;
+}
+
+void
+PcieLink::sendDown()
+{
+    while (!downQueue.empty() && downQueue.front().ready <= curTick()) {
+        if (!devSidePort.sendTimingResp(downQueue.front().pkt)) {
+            downBlocked = true;
+            return;
+        }
+        downQueue.pop_front();
+    }
+
+    if (!downQueue.empty())
+        schedule(downEvent, downQueue.front().ready);
+    checkDrained();
+}
+
+Tick
+PcieLink::recvAtomic(PacketPtr pkt)
+{
+    const Tlp tlp = requestTlp(pkt);
+    Tick lat = wireTime(tlp.bytes) + linkLatency;
+    lat += memSidePort.sendAtomic(pkt);
+    return lat + wireTime(completionBytes(pkt)) + linkLatency;
+}
+
+void
+PcieLink::checkDrained()
+{
+    if (drainState() == DrainState::Draining && upQueue.empty() &&
+        downQueue.empty() && creditReturns.empty()) {
+        signalDrainDone();
+    }
+}
+
+DrainState
+PcieLink::drain()
+{
+    return upQueue.empty() && downQueue.empty() && creditReturns.empty() ?
+        DrainState::Drained : DrainState::Draining;
+}
+
+bool
+PcieLink::DevSidePort::recvTimingReq(PacketPtr pkt)
+{
+    return link.recvTimingReq(pkt);
+}
+
+void
+PcieLink::DevSidePort::recvRespRetry()
+{
+    link.downBlocked = false;
+    link.sendDown();
+}
+
+Tick
+PcieLink::DevSidePort::recvAtomic(PacketPtr pkt)
+{
+    return link.recvAtomic(pkt);
+}
+
+void
+PcieLink::DevSidePort::recvFunctional(PacketPtr pkt)
+{
+    link.memSidePort.sendFunctional(pkt);
+}
+
+AddrRangeList
+PcieLink::DevSidePort::getAddrRanges() const
+{
+    return link.memSidePort.getAddrRanges();
+}
+
+bool
+PcieLink::MemSidePort::recvTimingResp(PacketPtr pkt)
+{
+    return link.recvTimingResp(pkt);
+}
+
+void
+PcieLink::MemSidePort::recvReqRetry()
+{
+    link.upBlocked = false;
+    link.sendUp();
+}
+
+void
+PcieLink::MemSidePort::recvRangeChange()
+{
+    link.devSidePort.sendRangeChange();
+}
+
+PcieLink::PcieLinkStats::PcieLinkStats(PcieLink &link)
+    : statistics::Group(&link),
+      ADD_STAT(upTlps, statistics::units::Count::get(),
+               "Number of TLPs sent from the device"),
+      ADD_STAT(upBytes, statistics::units::Byte::get(),
+               "Bytes sent from the device, with TLP overhead"),
+      ADD_STAT(upBusy, statistics::units::Tick::get(),
+               "Time the device to host direction was busy"),
+      ADD_STAT(upUtilization, statistics::units::Ratio::get(),
+               "Utilization of the device to host direction",
+               upBusy / simTicks),
+      ADD_STAT(downTlps, statistics::units::Count::get(),
+               "Number of completion TLPs sent to the device"),
+      ADD_STAT(downBytes, statistics::units::Byte::get(),
+               "Bytes sent to the device, with TLP overhead"),
+      ADD_STAT(downBusy, statistics::units::Tick::get(),
+               "Time the host to device direction was busy"),
+      ADD_STAT(downUtilization, statistics::units::Ratio::get(),
+               "Utilization of the host to device direction",
+               downBusy / simTicks),
+      ADD_STAT(postedCreditStalls, statistics::units::Count::get(),
+               "Number of writes held at the device for posted credits"),
+      ADD_STAT(nonPostedCreditStalls, statistics::units::Count::get(),
+               "Number of reads held at the device for non-posted "
+               "credits")
+{
+}
+
+} // namespace gem5
@@ -0,0 +1,188 @@
+#ifndef __MEM_PCIE_LINK_HH__
+#define __MEM_PCIE_LINK_HH__
+
+#include <deque>
+
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "mem/port.hh"
+#include "params/PcieLink.hh"
+#include "sim/clocked_object.hh"
+#include "sim/eventq.hh"
+
+namespace gem5
+{
+
+/**
+ * A PCIe link and root complex between the DMA port of a device and the
+ * host I/O fabric.
+ *
+ * Requests from the device are turned into TLPs: writes are posted and
+ * split at the max payload size, reads are non-posted and split at the
+ * max read request size. Every TLP pays the framing, header and CRC
+ * overhead on the wire, and the wire runs at the rate of the generation
+ * and lane count. The root complex advertises posted and non-posted
+ * header/data credits; a request waits at the device until there are
+ * credits for it, and credits come back some time after the root
+ * complex has passed the request on to the fabric, so a slow fabric
+ * pushes back on the device.
+ *
+ * Read data comes back as completions split at the max payload size
+ * and pays for the wire in the other direction. Posted writes have no
+ * completion, their gem5 response only pays the link latency.
+ */
+class PcieLink : public ClockedObject
+{
+  private:
+    /** Credit and wire cost of a request. */
+    struct Tlp
+    {
+        bool posted;
+        unsigned headers;
+        unsigned data;
+        unsigned bytes;
+    };
+
+    /** A packet on its way across the link. */
+    struct InFlight
+    {
+        Tick ready;
+        PacketPtr pkt;
+        Tlp tlp;
+    };
+
+    /** Credits released by the root complex at some time. */
+    struct CreditReturn
+    {
+        Tick when;
+        Tlp tlp;
+    };
+
+    class DevSidePort : public ResponsePort
+    {
+      private:
+        PcieLink &link;
+
+      public:
+        DevSidePort(const std::string &_name, PcieLink &_link)
+            : ResponsePort(_name, &_link), link(_link)
+        {}
+
+      protected:
+        bool recvTimingReq(PacketPtr pkt) override;
+        void recvRespRetry() override;
+        Tick recvAtomic(PacketPtr pkt) override;
+        void recvFunctional(PacketPtr pkt) override;
+        AddrRangeList getAddrRanges() const override;
+    };
+
+    class MemSidePort : public RequestPort
+    {
+      private:
+        PcieLink &link;
+
+      public:
+        MemSidePort(const std::string &_name, PcieLink &_link)
+            : RequestPort(_name, &_link), link(_link)
+        {}
+
+      protected:
+        bool recvTimingResp(PacketPtr pkt) override;
+        void recvReqRetry() override;
+        void recvRangeChange() override;
+    };
+
+    DevSidePort devSidePort;
+    MemSidePort memSidePort;
+
+    /** Time to put one byte on the wire. */
+    const double ticksPerByte;
+    const unsigned tlpOverhead;
+    const unsigned maxPayload;
+    const unsigned maxReadRequest;
+    const Tick linkLatency;
+    const Tick creditLatency;
+
+    const unsigned postedHeaderCredits;
+    const unsigned postedDataCredits;
+    const unsigned nonPostedHeaderCredits;
+
+    // Credits the root complex has free
+    unsigned postedHeaders;
+    unsigned postedData;
+    unsigned nonPostedHeaders;
+
+    // Requests on the way to, or waiting in, the root complex
+    std::deque<InFlight> upQueue;
+    // When the device to host direction of the wire is free
+    Tick upFree;
+    // The fabric refused the request at the head of upQueue
+    bool upBlocked;
+    // We refused a request of the device for lack of credits
+    bool retryDev;
+
+    // Responses on the way back to the device
+    std::deque<InFlight> downQueue;
+    Tick downFree;
+    bool downBlocked;
+
+    std::deque<CreditReturn> creditReturns;
+
+    EventFunctionWrapper upEvent;
+    EventFunctionWrapper downEvent;
+    EventFunctionWrapper creditEvent;
+
+    /** Credits and wire bytes of a request from the device. */
+    Tlp requestTlp(PacketPtr pkt) const;
+
+    /** Wire bytes of the completions of a response, 0 for none. */
+    unsigned completionBytes(PacketPtr pkt) const;
+
+    /** Time to serialize bytes on one direction of the link. */
+    Tick
+    wireTime(unsigned bytes) const
+    {
+        return (Tick)(bytes * ticksPerByte + 0.5);
+    }
+
+    bool recvTimingReq(PacketPtr pkt);
+    bool recvTimingResp(PacketPtr pkt);
+    Tick recvAtomic(PacketPtr pkt);
+
+    void sendUp();
+    void sendDown();
+    void returnCredits();
+
+    void checkDrained();
+
+    struct PcieLinkStats : public statistics::Group
+    {
+        PcieLinkStats(PcieLink &link);
+
+        statistics::Scalar upTlps;
+        statistics::Scalar upBytes;
+        statistics::Scalar upBusy;
+        statistics::Formula upUtilization;
+        statistics::Scalar downTlps;
+        statistics::Scalar downBytes;
+        statistics::Scalar downBusy;
+        statistics::Formula downUtilization;
+        statistics::Scalar postedCreditStalls;
+        statistics::Scalar nonPostedCreditStalls;
+    } stats;
+
+  public:
+    PARAMS(PcieLink);
+    PcieLink(const Params &p);
+
+    Port &getPort(const std::string &if_name,
+                  PortID idx=InvalidPortID) override;
+
+    void init() override;
+
+    DrainState drain() override;
+};
+
+} // namespace gem5
+
+#endif // __MEM_PCIE_LINK_HH__
@@ -0,0 +1,3 @@
+ifconfig eth0 up
+sleep 1
+m5 exit
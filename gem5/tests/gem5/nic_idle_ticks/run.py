@@ -0,0 +1,58 @@
+'''
+Boot two identical Arm systems side by side, each with an IGbE driven by
+its own load generator. Only skip_idle_ticks differs between them, so
+the stats of system and system_skip must match apart from skippedTicks.
+The systems share nothing but the simulated time, and the first m5 exit
+ends both at the same tick.
+
+Usage: run.py <M5_PATH> <gem5 root>
+'''
+
+import sys
+import os
+from os.path import join as joinpath
+
+import m5
+from m5.objects import *
+
+os.environ['M5_PATH'] = sys.argv[1]
+gem5_root = sys.argv[2]
+
+sys.path.append(joinpath(gem5_root, 'configs'))
+sys.path.append(joinpath(gem5_root, 'tests', 'gem5', 'configs'))
+
+from arm_generic import LinuxArmFSSystemUniprocessor
+
+def make_system(skip_idle_ticks, dtb_name):
+    system = LinuxArmFSSystemUniprocessor(mem_mode='timing',
+                                          mem_class=DDR3_1600_8x8,
+                                          cpu_class=TimingSimpleCPU
+                                          ).create_system()
+    system.readfile = joinpath(os.path.dirname(os.path.abspath(__file__)),
+                               'eth-up.sh')
+    system.cpu.createThreads()
+
+    system.nics[0].skip_idle_ticks = skip_idle_ticks
+    system.loadgen = LoadGenerator(mode='Static', packet_rate=20000,
+                                   packet_size=64, start_tick=1,
+                                   stop_tick=m5.MaxTick)
+    system.loadgen_link = EtherLink(speed='1000Gbps')
+    system.loadgen_link.int0 = system.nics[0].interface
+    system.loadgen_link.int1 = system.loadgen.interface
+
+    # Both systems would write the same file otherwise
+    system.workload.dtb_filename = joinpath(m5.options.outdir, dtb_name)
+    system.generateDtb(system.workload.dtb_filename)
+    return system
+
+m5.ticks.setGlobalFrequency('1THz')
+root = Root(full_system=True)
+root.system = make_system(False, 'system.dtb')
+root.system_skip = make_system(True, 'system_skip.dtb')
+
+# Since we're in batch mode, don't allow tcp socket connections
+m5.disableAllListeners()
+
+m5.instantiate()
+exit_event = m5.simulate()
+print('Exiting @ tick', m5.curTick(), 'because', exit_event.getCause())
@@ -0,0 +1,69 @@
+'''
+Regression test for IGbE skip_idle_ticks: skipping the state machine
+ticks that find nothing to do must not change any stat. run.py boots a
+system with skipping off and one with it on in the same simulation, and
+the stats of the two are compared here.
+'''
+
+import re
+
+from testlib import *
+
+tarball = 'aarch-system-20210904.tar.bz2'
+url = config.resource_url + "/arm/" + tarball
+path = joinpath(config.bin_path, 'arm')
+arm_fs_binaries = DownloadedArchive(url, path, tarball)
+
+class MatchSystemStats(verifier.Verifier):
+    '''
+    Passes if every stat of one system has the same value in the other,
+    but for the stats matched by ignore. The NIC must have received
+    packets, so the comparison covers the ticks that are skipped.
+    '''
+    _stat = re.compile(r'^(\S+)\s+(\S+)')
+
+    def __init__(self, system, other, ignore):
+        super(MatchSystemStats, self).__init__()
+        self.system = system + '.'
+        self.other = other + '.'
+        self.ignore = re.compile(ignore)
+
+    def _stats(self, fname):
+        stats = ({}, {})
+        with open(fname, 'r') as f:
+            for line in f:
+                m = self._stat.match(line)
+                if not m or self.ignore.search(m.group(1)):
+                    continue
+                name, value = m.groups()
+                for prefix, found in zip((self.system, self.other), stats):
+                    if name.startswith(prefix):
+                        found[name[len(prefix):]] = value
+        return stats
+
+    def test(self, params):
+        tempdir = params.fixtures[constants.tempdir_fixture_name].path
+        stats, other = self._stats(
+            joinpath(tempdir, constants.gem5_simulation_stats))
+
+        if not any(name.endswith('rxPackets') and float(value) > 0
+                   for name, value in stats.items()):
+            test_util.fail('The NIC received no packets, see %s' % tempdir)
+
+        diff = ['%s: %s vs %s' % (name, stats.get(name), other.get(name))
+                for name in sorted(set(stats) | set(other))
+                if stats.get(name) != other.get(name)]
+        if diff:
+            test_util.fail('Stats differ with skip_idle_ticks:\n%s\n'
+                           'See %s for full results' %
+                           ('\n'.join(diff), tempdir))
+
+gem5_verify_config(
+    name='nic_idle_ticks',
+    verifiers=(MatchSystemStats('system', 'system_skip', r'skippedTicks'),),
+    config=joinpath(getcwd(), 'run.py'),
+    config_args=[path, config.base_dir],
+    valid_isas=(constants.arm_tag,),
+    length=constants.long_tag,
+    fixtures=(arm_fs_binaries,)
+)